@@ -0,0 +1,57 @@
+cmake_minimum_required(VERSION 3.16.3)
+
+function(generateZeekAgentBenchmark)
+  if(NOT ZEEK_AGENT_ENABLE_BENCHMARKS)
+    return()
+  endif()
+
+  cmake_parse_arguments(
+    "ARGS"
+    ""
+    "SOURCE_TARGET;NAME"
+    "SOURCES"
+    ${ARGN}
+  )
+
+  if(NOT "${ARGS_UNPARSED_ARGUMENTS}" STREQUAL "" OR "${ARGS_NAME}" STREQUAL "")
+    message(FATAL_ERROR "Invalid call to generateZeekAgentBenchmark(). One or more arguments are missing")
+  endif()
+
+  get_target_property(main_target_sources "${ARGS_SOURCE_TARGET}" SOURCES)
+  if("${main_target_sources}" STREQUAL "main_target_sources-NOTFOUND")
+    message(FATAL_ERROR "Failed to import the source list from the main target")
+  endif()
+
+  list(REMOVE_ITEM main_target_sources "src/main.cpp")
+
+  add_executable("${ARGS_NAME}"
+    ${ARGS_SOURCES}
+    ${main_target_sources}
+  )
+
+  get_target_property(source_target_folder ${ARGS_SOURCE_TARGET} SOURCE_DIR)
+
+  target_include_directories("${ARGS_NAME}" PRIVATE
+    "${source_target_folder}/src"
+  )
+
+  set(property_list
+    INCLUDE_DIRECTORIES
+    INTERFACE_INCLUDE_DIRECTORIES
+
+    LINK_LIBRARIES
+    INTERFACE_LINK_LIBRARIES
+
+    COMPILE_DEFINITIONS
+    INTERFACE_COMPILE_DEFINITIONS
+
+    COMPILE_OPTIONS
+    INTERFACE_COMPILE_OPTIONS
+  )
+
+  foreach(property_name ${property_list})
+    migrateProperty("${ARGS_NAME}" "${ARGS_SOURCE_TARGET}" "${property_name}")
+  endforeach()
+
+  message(STATUS "zeek-agent: Generating the ${ARGS_NAME} benchmark")
+endfunction()
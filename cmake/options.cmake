@@ -10,6 +10,7 @@ endif()
 
 option(ZEEK_AGENT_ENABLE_TESTS "Set to ON to build the tests")
 option(ZEEK_AGENT_ENABLE_INSTALL "Set to ON to generate the install directives")
+option(ZEEK_AGENT_ENABLE_BENCHMARKS "Set to ON to build the benchmarks")
 
 if(NOT "${CMAKE_SYSTEM_NAME}" STREQUAL "Windows")
   option(ZEEK_AGENT_ENABLE_SANITIZERS "Set to ON to enable sanitizers. Only available when compiling with Clang")
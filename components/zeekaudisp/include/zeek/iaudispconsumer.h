@@ -1,7 +1,11 @@
 #pragma once
 
-#include <map>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include <zeek/status.h>
@@ -23,7 +27,11 @@ public:
       Connect,
       Open,
       OpenAt,
-      Create
+      Create,
+
+      /// \brief exit_group(); this syscall never returns, so the success
+      ///        and exit_code fields are not set
+      Exit
     };
 
     /// \brief Event type
@@ -68,8 +76,19 @@ public:
     /// \brief Parameter count
     int argc{0};
 
-    /// \brief Parameter list
-    std::map<std::string, std::string> argument_list;
+    /// \brief Decoded parameter list, indexed by parameter position. The
+    ///        chunks of long parameters are appended in place
+    std::vector<std::string> argument_list;
+
+    /// \brief How many parameters have been started so far, including the
+    ///        ones that have been discarded
+    std::size_t received_argument_count{0U};
+
+    /// \brief The total size of the stored parameters, in bytes
+    std::size_t command_line_size{0U};
+
+    /// \brief True if parameters (or parts of them) have been discarded
+    bool truncated{false};
   };
 
   /// \brief EXECVE record data
@@ -79,6 +98,25 @@ public:
 
     /// \brief parameter list
     std::vector<std::string> argument_list;
+
+    /// \brief True if the parameter list has been truncated
+    bool truncated{false};
+  };
+
+  /// \brief How much of each execve command line is kept
+  struct ExecveLimits final {
+    /// \brief Constructor; the default values are set here rather than with
+    ///        member initializers, so that the default-constructed object
+    ///        can be used as a default argument inside this class
+    ExecveLimits()
+        : max_argument_count(4096U), max_command_line_size(131072U) {}
+
+    /// \brief Maximum amount of parameters (0 disables the limit)
+    std::size_t max_argument_count;
+
+    /// \brief Maximum size of all the parameters, in bytes (0 disables the
+    ///        limit)
+    std::size_t max_command_line_size;
   };
 
   /// \brief PATH record data
@@ -110,8 +148,25 @@ public:
     /// \brief Port
     std::int64_t port{0};
 
-    /// \brief IP address
+    /// \brief IP address, in the canonical text form (RFC 5952 for IPv6),
+    ///        or the socket path for local sockets
     std::string address;
+
+    /// \brief The binary IP address, in network order; only the first 4
+    ///        bytes are used for IPv4. Not set for other families
+    std::optional<std::array<std::uint8_t, 16>> address_bytes;
+  };
+
+  /// \brief The image of a process, as seen by its most recent execve
+  struct ProcessImageData final {
+    /// \brief Executable path
+    std::string exe;
+
+    /// \brief Command line
+    std::string cmdline;
+
+    /// \brief Working directory
+    std::string cwd;
   };
 
   /// \brief A single Audit event, built from multiple records
@@ -130,19 +185,157 @@ public:
 
     /// \brief SOCKADDR record data (optional)
     std::optional<SockaddrRecordData> sockaddr_data;
+
+    /// \brief The image of the parent process at the time of the event.
+    ///        Not set by the consumer; filled in by the process tracking
+    ///        of the tables, and null when the parent is not known
+    std::shared_ptr<const ProcessImageData> parent_image;
+
+    /// \brief The serial number of the event, as found in the
+    ///        msg=audit(<time>:<serial>) header of its records. Unique
+    ///        among the events that share the same timestamp
+    std::uint64_t serial{0U};
   };
 
   /// \brief A list of Audit events
   using AuditEventList = std::vector<AuditEvent>;
 
+  /// \brief An event filter rule. An event matches the rule when all the
+  ///        conditions that have been set match
+  struct FilterRule final {
+    /// \brief What happens to the matching events
+    enum class Action {
+      /// \brief The event is kept
+      Include,
+
+      /// \brief The event is discarded
+      Exclude
+    };
+
+    /// \brief What happens to the matching events
+    Action action{Action::Exclude};
+
+    /// \brief The executable path, compared as a whole
+    std::optional<std::string> exe;
+
+    /// \brief Matches when any of the PATH records starts with this prefix
+    std::optional<std::string> path_prefix;
+
+    /// \brief The user id
+    std::optional<std::int64_t> uid;
+
+    /// \brief The audit (login) user id
+    std::optional<std::int64_t> auid;
+
+    /// \brief The syscall type
+    std::optional<SyscallRecordData::Type> syscall;
+
+    /// \brief The SOCKADDR address, either a single address or a CIDR block
+    std::optional<std::string> address;
+  };
+
+  /// \brief A list of filter rules; the first matching rule decides
+  ///        whether an event is kept, and events that match no rule are kept
+  using FilterRuleList = std::vector<FilterRule>;
+
+  /// \brief How many events a filter rule has matched
+  struct FilterRuleCounter final {
+    /// \brief The rule, in the same format accepted by parseFilterRule
+    std::string rule;
+
+    /// \brief How many events the rule has decided on
+    std::uint64_t match_count{0U};
+  };
+
+  /// \brief The counters of all the filter rules, in rule order
+  using FilterRuleCounterList = std::vector<FilterRuleCounter>;
+
+  /// \brief Parses a filter rule, in the form
+  ///        "<include|exclude> key=value [key=value...]". The keys are exe,
+  ///        path_prefix, uid, auid, syscall and address
+  /// \param rule Where the parsed rule is stored
+  /// \param rule_string The rule to parse
+  /// \return A Status object
+  static Status parseFilterRule(FilterRule &rule,
+                                const std::string &rule_string);
+
   /// \brief A unique_ptr to an IAudispConsumer interface
   using Ref = std::unique_ptr<IAudispConsumer>;
 
+  /// \brief How the audisp text stream is parsed
+  enum class Parser {
+    /// \brief libauparse
+    Auparse,
+
+    /// \brief The built-in parser, which does not depend on libauparse
+    Native
+  };
+
+  /// \brief What the parser stage does with new events when the queue
+  ///        towards the table stage is full
+  enum class OverflowPolicy {
+    /// \brief The events are discarded, and counted as dropped
+    Drop,
+
+    /// \brief The parser stage waits for room in the queue. Once the read
+    ///        buffer fills up, the socket is no longer drained and audispd
+    ///        starts buffering (and eventually dropping) the events
+    Block
+  };
+
+  /// \brief Counters for a single stage of the pipeline
+  struct PipelineStageMetrics final {
+    /// \brief The stage name: "reader", "parser" or "tables"
+    std::string name;
+
+    /// \brief How much data is waiting in the input queue of the stage;
+    ///        bytes for the parser, event batches for the tables
+    std::size_t queue_depth{0U};
+
+    /// \brief The size of the input queue, in the same unit as queue_depth
+    std::size_t queue_capacity{0U};
+
+    /// \brief How many items the stage has processed so far; bytes for the
+    ///        reader, events for the parser and the tables
+    std::uint64_t processed_count{0U};
+
+    /// \brief How many events have been discarded at the input of the stage
+    std::uint64_t dropped_count{0U};
+  };
+
+  /// \brief The metrics of all the pipeline stages, in pipeline order
+  using PipelineMetrics = std::vector<PipelineStageMetrics>;
+
   /// \brief Factory method
   /// \param obj where the created object is stored
   /// \param audisp_socket_path The path to the unix domain socket of Audisp
+  /// \param parser The parser used for the audisp text stream
+  /// \param overflow_policy What to do when the table stage falls behind
+  /// \param filter_rule_list The rules used to discard unwanted events
+  /// \param execve_limits How much of each execve command line is kept
+  /// \return A Status object
+  static Status
+  create(Ref &obj, const std::string &audisp_socket_path,
+         Parser parser = Parser::Auparse,
+         OverflowPolicy overflow_policy = OverflowPolicy::Drop,
+         const FilterRuleList &filter_rule_list = FilterRuleList(),
+         const ExecveLimits &execve_limits = ExecveLimits());
+
+  /// \brief Factory method, replaying a captured audisp stream instead of
+  ///        reading from the Audisp socket
+  /// \param obj where the created object is stored
+  /// \param stream_file_path The path to the captured audisp stream
+  /// \param parser The parser used for the audisp text stream
+  /// \param overflow_policy What to do when the table stage falls behind
+  /// \param filter_rule_list The rules used to discard unwanted events
+  /// \param execve_limits How much of each execve command line is kept
   /// \return A Status object
-  static Status create(Ref &obj, const std::string &audisp_socket_path);
+  static Status
+  createFromFile(Ref &obj, const std::string &stream_file_path,
+                 Parser parser = Parser::Auparse,
+                 OverflowPolicy overflow_policy = OverflowPolicy::Drop,
+                 const FilterRuleList &filter_rule_list = FilterRuleList(),
+                 const ExecveLimits &execve_limits = ExecveLimits());
 
   /// \brief Constructor
   IAudispConsumer() = default;
@@ -151,14 +344,51 @@ public:
   virtual ~IAudispConsumer() = default;
 
   /// \brief Call this method in a loop to read and process the Audisp events
+  ///        on a single thread. This is the same as calling readData() and
+  ///        parseData() one after the other
   /// \return A Status object
   virtual Status processEvents() = 0;
 
-  /// \brief Returns a list of processed events
+  /// \brief Reader stage: acquires new data from the Audisp socket. Call
+  ///        this method in a loop, from a single thread. It blocks until
+  ///        there is new data, or until the parser stage makes room for it
+  /// \return A Status object
+  virtual Status readData() = 0;
+
+  /// \brief Parser stage: turns the data acquired by readData() into
+  ///        events. Call this method in a loop, from a single thread. It
+  ///        blocks until the reader stage acquires new data
+  /// \return A Status object
+  virtual Status parseData() = 0;
+
+  /// \brief Table stage: blocks until the parser stage has queued new
+  ///        events for getEvents(), interrupt() is called, or the timeout
+  ///        expires
+  /// \param timeout How long to wait at most
+  virtual void waitForEvents(const std::chrono::milliseconds &timeout) = 0;
+
+  /// \brief Returns a list of processed events. Only one thread at a time
+  ///        should call this method
   /// \param event_list Where the event list is stored
   /// \return A Status object
   virtual Status getEvents(AuditEventList &event_list) = 0;
 
+  /// \brief Returns the depth and throughput counters of each stage. This
+  ///        method can be called from any thread
+  /// \param metrics Where the metrics are stored
+  virtual void getPipelineMetrics(PipelineMetrics &metrics) const = 0;
+
+  /// \brief Returns how many events each filter rule has matched. This
+  ///        method can be called from any thread
+  /// \param counter_list Where the counters are stored
+  virtual void
+  getFilterRuleCounters(FilterRuleCounterList &counter_list) const = 0;
+
+  /// \brief Wakes up the processEvents(), readData(), parseData() and
+  ///        waitForEvents() calls that are waiting for data. This method can
+  ///        be called from any thread
+  virtual void interrupt() = 0;
+
   IAudispConsumer(const IAudispConsumer &other) = delete;
   IAudispConsumer &operator=(const IAudispConsumer &other) = delete;
 };
@@ -1,14 +1,19 @@
 #include "audispconsumer.h"
+#include "audispfilereader.h"
+#include "audispnativeparser.h"
 #include "audispsocketreader.h"
 #include "audit_utils.h"
+#include "auditeventfilter.h"
 #include "auparseinterface.h"
+#include "stagesignal.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cstddef>
 #include <cstring>
-#include <iomanip>
-#include <mutex>
-#include <sstream>
-#include <unordered_map>
+#include <limits>
+#include <string_view>
 
 #include <asm/unistd.h>
 #include <libaudit_wrapper.h>
@@ -17,24 +22,282 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 
+#include <zeek/spscqueue.h>
+
 namespace zeek {
+namespace {
+/// \brief How much data the producer can buffer before it stops reading
+///        from the socket and lets the parser catch up
+const std::size_t kReadBufferSize{MAX_AUDIT_MESSAGE_LENGTH * 32U};
+
+/// \brief How many event batches can wait for the table stage
+const std::size_t kEventQueueCapacity{1024U};
+
+/// \brief How long the reader and parser stages wait for each other before
+///        checking again. Both parsers need to be fed from time to time
+///        even when there is no new data, so that they can deliver the
+///        events that have timed out
+const std::chrono::milliseconds kMaxStageWaitTime{500};
+
+/// \brief The SYSCALL record fields used by parseSyscallRecord
+enum class SyscallRecordField {
+  Unknown,
+  Syscall,
+  Success,
+  Exit,
+  ProcessId,
+  ParentProcessId,
+  Auid,
+  Uid,
+  Euid,
+  Gid,
+  Egid,
+  Exe,
+  A0
+};
+
+/// \brief The number of fields in SyscallRecordField, excluding Unknown
+const std::size_t kSyscallRecordFieldCount{12U};
+
+/// \brief The PATH record fields used by parsePathRecord
+enum class PathRecordField { Unknown, Name, Item, Mode, Inode, Ouid, Ogid };
+
+/// \brief The number of fields in PathRecordField, excluding Unknown
+const std::size_t kPathRecordFieldCount{6U};
+
+/// \brief How many execve parameters are reserved up front at most; argc
+///        comes from the record, and the list can still grow past this
+const std::size_t kMaxReservedExecveArgumentCount{4096U};
+
+// Field names are dispatched on their length first, so that each one is
+// compared against at most a handful of candidates of the same size
+
+SyscallRecordField getSyscallRecordField(std::string_view field_name) {
+  switch (field_name.size()) {
+  case 2U:
+    if (field_name == "a0") {
+      return SyscallRecordField::A0;
+    }
+
+    break;
+
+  case 3U:
+    if (field_name == "pid") {
+      return SyscallRecordField::ProcessId;
+    } else if (field_name == "uid") {
+      return SyscallRecordField::Uid;
+    } else if (field_name == "gid") {
+      return SyscallRecordField::Gid;
+    } else if (field_name == "exe") {
+      return SyscallRecordField::Exe;
+    }
+
+    break;
+
+  case 4U:
+    if (field_name == "exit") {
+      return SyscallRecordField::Exit;
+    } else if (field_name == "ppid") {
+      return SyscallRecordField::ParentProcessId;
+    } else if (field_name == "auid") {
+      return SyscallRecordField::Auid;
+    } else if (field_name == "euid") {
+      return SyscallRecordField::Euid;
+    } else if (field_name == "egid") {
+      return SyscallRecordField::Egid;
+    }
+
+    break;
+
+  case 7U:
+    if (field_name == "syscall") {
+      return SyscallRecordField::Syscall;
+    } else if (field_name == "success") {
+      return SyscallRecordField::Success;
+    }
+
+    break;
+  }
+
+  return SyscallRecordField::Unknown;
+}
+
+PathRecordField getPathRecordField(std::string_view field_name) {
+  switch (field_name.size()) {
+  case 4U:
+    if (field_name == "name") {
+      return PathRecordField::Name;
+    } else if (field_name == "item") {
+      return PathRecordField::Item;
+    } else if (field_name == "mode") {
+      return PathRecordField::Mode;
+    } else if (field_name == "ouid") {
+      return PathRecordField::Ouid;
+    } else if (field_name == "ogid") {
+      return PathRecordField::Ogid;
+    }
+
+    break;
+
+  case 5U:
+    if (field_name == "inode") {
+      return PathRecordField::Inode;
+    }
+
+    break;
+  }
+
+  return PathRecordField::Unknown;
+}
+
+bool getSyscallType(IAudispConsumer::SyscallRecordData::Type &type,
+                    std::int64_t syscall_number) {
+
+  using Type = IAudispConsumer::SyscallRecordData::Type;
+
+  switch (syscall_number) {
+  case __NR_execve:
+    type = Type::Execve;
+    return true;
+
+  case __NR_execveat:
+    type = Type::ExecveAt;
+    return true;
+
+#ifndef __aarch64__
+  case __NR_fork:
+    type = Type::Fork;
+    return true;
+
+  case __NR_vfork:
+    type = Type::VFork;
+    return true;
+#endif
+
+  case __NR_clone:
+    type = Type::Clone;
+    return true;
+
+  case __NR_bind:
+    type = Type::Bind;
+    return true;
+
+  case __NR_connect:
+    type = Type::Connect;
+    return true;
+
+  case __NR_open:
+    type = Type::Open;
+    return true;
+
+  case __NR_openat:
+    type = Type::OpenAt;
+    return true;
+
+  case __NR_creat:
+    type = Type::Create;
+    return true;
+
+  case __NR_exit_group:
+    type = Type::Exit;
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/// \brief Decodes an Audit string and appends it to the given output,
+///        without going through a temporary buffer
+/// \param output Where the decoded string is appended
+/// \param buffer Either a quoted string or a hex string; any other value
+///        is appended as it is, like convertAuditString callers do
+/// \param max_size How many bytes can be appended at most
+/// \return False if the string has been truncated
+bool appendAuditString(std::string &output, std::string_view buffer,
+                       std::size_t max_size) {
+  if (!buffer.empty() && buffer.front() == '"') {
+    if (buffer.size() >= 2U) {
+      buffer = buffer.substr(1U, buffer.size() - 2U);
+    }
+
+    auto size = std::min(buffer.size(), max_size);
+    output.append(buffer.data(), size);
+
+    return size == buffer.size();
+  }
+
+  bool is_hex_string = (buffer.size() % 2U) == 0U;
+  for (auto it = buffer.begin(); is_hex_string && it != buffer.end(); ++it) {
+    char nibble{};
+    is_hex_string = convertHexDigitToByte(nibble, *it);
+  }
+
+  if (!is_hex_string) {
+    auto size = std::min(buffer.size(), max_size);
+    output.append(buffer.data(), size);
+
+    return size == buffer.size();
+  }
+
+  auto byte_count = std::min(buffer.size() / 2U, max_size);
+  for (std::size_t i = 0U; i < byte_count; ++i) {
+    char high_nibble{};
+    char low_nibble{};
+    convertHexDigitToByte(high_nibble, buffer[i * 2U]);
+    convertHexDigitToByte(low_nibble, buffer[i * 2U + 1U]);
+
+    output.push_back(static_cast<char>((high_nibble << 4U) | low_nibble));
+  }
+
+  return byte_count == buffer.size() / 2U;
+}
+} // namespace
+
 struct AudispConsumer::PrivateData final {
   IAudispProducer::Ref audisp_producer;
   IAuparseInterface::Ref auparse_interface;
 
-  std::mutex processed_event_list_mutex;
-  AuditEventList processed_event_list;
+  OverflowPolicy overflow_policy{OverflowPolicy::Drop};
+  ExecveLimits execve_limits;
+
+  // Only allocated when there are filter rules
+  AuditEventFilter::Ref event_filter;
+
+  // Reader -> parser
+  RingBuffer read_buffer{kReadBufferSize};
+
+  // Parser -> tables. Events are moved in batches, one for each chunk of
+  // data that has been parsed
+  SPSCQueue<AuditEventList> event_queue{kEventQueueCapacity};
+  AuditEventList parsed_event_list;
+
+  // Each stage waits on its own signal when it has nothing to do: the
+  // reader for room in the read buffer, the parser for new data (or for
+  // room in the event queue) and the tables for new events
+  StageSignal reader_signal;
+  StageSignal parser_signal;
+  StageSignal table_signal;
+
+  std::atomic<std::uint64_t> parsed_event_count{0U};
+  std::atomic<std::uint64_t> dropped_event_count{0U};
+  std::atomic<std::uint64_t> delivered_event_count{0U};
 
   std::atomic_bool parser_error{false};
 };
 
-Status
-AudispConsumer::createWithProducer(Ref &obj,
-                                   IAudispProducer::Ref audisp_producer) {
+Status AudispConsumer::createWithProducer(
+    Ref &obj, IAudispProducer::Ref audisp_producer,
+    Parser parser, OverflowPolicy overflow_policy,
+    const FilterRuleList &filter_rule_list,
+    const ExecveLimits &execve_limits) {
+
   obj.reset();
 
   try {
-    auto ptr = new AudispConsumer(std::move(audisp_producer));
+    auto ptr = new AudispConsumer(std::move(audisp_producer), parser,
+                                  overflow_policy, filter_rule_list,
+                                  execve_limits);
     audisp_producer = {};
 
     obj.reset(ptr);
@@ -52,24 +315,79 @@ AudispConsumer::createWithProducer(Ref &obj,
 AudispConsumer::~AudispConsumer() { d->auparse_interface->flushFeed(); }
 
 Status AudispConsumer::processEvents() {
-  std::string buffer;
-  auto status = d->audisp_producer->read(buffer);
+  // Both stages run on this thread, so a full read buffer is drained by
+  // the parseBufferedData() call below
+  if (d->read_buffer.freeSpace() != 0U) {
+    auto status = d->audisp_producer->read(d->read_buffer);
+    if (!status.succeeded()) {
+      return status;
+    }
+  }
+
+  parseBufferedData();
+  return Status::success();
+}
+
+Status AudispConsumer::readData() {
+  // Wait for the parser to catch up instead of spinning on a socket that
+  // can't be drained
+  if (d->read_buffer.freeSpace() == 0U) {
+    d->reader_signal.wait(kMaxStageWaitTime);
+    return Status::success();
+  }
+
+  auto committed_byte_count = d->read_buffer.committedByteCount();
+
+  auto status = d->audisp_producer->read(d->read_buffer);
   if (!status.succeeded()) {
     return status;
   }
 
-  d->auparse_interface->feed(buffer.data(), buffer.size());
+  if (d->read_buffer.committedByteCount() != committed_byte_count) {
+    d->parser_signal.notify();
+  }
+
   return Status::success();
 }
 
+Status AudispConsumer::parseData() {
+  if (!parseBufferedData()) {
+    d->parser_signal.wait(kMaxStageWaitTime);
+  }
+
+  return Status::success();
+}
+
+void AudispConsumer::waitForEvents(const std::chrono::milliseconds &timeout) {
+  if (d->event_queue.size() != 0U) {
+    return;
+  }
+
+  d->table_signal.wait(timeout);
+}
+
 Status AudispConsumer::getEvents(AuditEventList &event_list) {
   event_list = {};
 
-  {
-    std::lock_guard<std::mutex> lock(d->processed_event_list_mutex);
+  AuditEventList event_batch;
+  while (d->event_queue.tryPop(event_batch)) {
+    if (event_list.empty()) {
+      event_list = std::move(event_batch);
+
+    } else {
+      event_list.insert(event_list.end(),
+                        std::make_move_iterator(event_batch.begin()),
+                        std::make_move_iterator(event_batch.end()));
+    }
+
+    event_batch = {};
+  }
+
+  d->delivered_event_count += event_list.size();
 
-    event_list = std::move(d->processed_event_list);
-    d->processed_event_list = {};
+  // With the Block policy, the parser may be waiting for room in the queue
+  if (!event_list.empty()) {
+    d->parser_signal.notify();
   }
 
   Status status;
@@ -86,12 +404,75 @@ Status AudispConsumer::getEvents(AuditEventList &event_list) {
   return status;
 }
 
-AudispConsumer::AudispConsumer(IAudispProducer::Ref audisp_producer)
+void AudispConsumer::getPipelineMetrics(PipelineMetrics &metrics) const {
+  metrics = {};
+
+  PipelineStageMetrics reader_metrics;
+  reader_metrics.name = "reader";
+  reader_metrics.processed_count = d->read_buffer.committedByteCount();
+  metrics.push_back(std::move(reader_metrics));
+
+  PipelineStageMetrics parser_metrics;
+  parser_metrics.name = "parser";
+  parser_metrics.queue_depth = d->read_buffer.size();
+  parser_metrics.queue_capacity = d->read_buffer.capacity();
+  parser_metrics.processed_count = d->parsed_event_count;
+  metrics.push_back(std::move(parser_metrics));
+
+  PipelineStageMetrics table_metrics;
+  table_metrics.name = "tables";
+  table_metrics.queue_depth = d->event_queue.size();
+  table_metrics.queue_capacity = d->event_queue.capacity();
+  table_metrics.processed_count = d->delivered_event_count;
+  table_metrics.dropped_count = d->dropped_event_count;
+  metrics.push_back(std::move(table_metrics));
+}
+
+void AudispConsumer::getFilterRuleCounters(
+    FilterRuleCounterList &counter_list) const {
+
+  if (!d->event_filter) {
+    counter_list = {};
+    return;
+  }
+
+  d->event_filter->getCounters(counter_list);
+}
+
+void AudispConsumer::interrupt() {
+  d->audisp_producer->interrupt();
+
+  d->reader_signal.notify();
+  d->parser_signal.notify();
+  d->table_signal.notify();
+}
+
+AudispConsumer::AudispConsumer(IAudispProducer::Ref audisp_producer,
+                               Parser parser, OverflowPolicy overflow_policy,
+                               const FilterRuleList &filter_rule_list,
+                               const ExecveLimits &execve_limits)
     : d(new PrivateData) {
   d->audisp_producer = std::move(audisp_producer);
   audisp_producer = {};
 
-  auto status = AuparseInterface::create(d->auparse_interface);
+  d->overflow_policy = overflow_policy;
+  d->execve_limits = execve_limits;
+
+  Status status;
+  if (!filter_rule_list.empty()) {
+    status = AuditEventFilter::create(d->event_filter, filter_rule_list);
+    if (!status.succeeded()) {
+      throw status;
+    }
+  }
+
+  if (parser == Parser::Native) {
+    status = AudispNativeParser::create(d->auparse_interface,
+                                        AudispNativeParser::Configuration{});
+  } else {
+    status = AuparseInterface::create(d->auparse_interface);
+  }
+
   if (!status.succeeded()) {
     throw status;
   }
@@ -99,6 +480,68 @@ AudispConsumer::AudispConsumer(IAudispProducer::Ref audisp_producer)
   d->auparse_interface->addCallback(auparseCallbackDispatcher, this, nullptr);
 }
 
+bool AudispConsumer::parseBufferedData() {
+  // With the Block policy, nothing else is parsed until the previous
+  // events have been queued; the read buffer then fills up and the reader
+  // stops draining the socket
+  if (!flushParsedEvents()) {
+    return false;
+  }
+
+  // Both parsers keep incomplete records around until the rest of the line
+  // arrives, so a record spanning the wrap point can be fed as two chunks.
+  // The parser is fed even when there is no data, so that it can deliver
+  // the events that have timed out
+  RingBuffer::RegionList region_list;
+  auto region_count = d->read_buffer.readableRegions(region_list);
+  if (region_count == 0U) {
+    d->auparse_interface->feed("", 0U);
+  }
+
+  std::size_t parsed_byte_count{0U};
+
+  for (std::size_t i = 0U; i < region_count; ++i) {
+    const auto &region = region_list[i];
+    d->auparse_interface->feed(static_cast<const char *>(region.iov_base),
+                               region.iov_len);
+
+    parsed_byte_count += region.iov_len;
+  }
+
+  if (parsed_byte_count != 0U) {
+    d->read_buffer.consume(parsed_byte_count);
+    d->reader_signal.notify();
+  }
+
+  auto new_events = !d->parsed_event_list.empty();
+  flushParsedEvents();
+
+  return parsed_byte_count != 0U || new_events;
+}
+
+bool AudispConsumer::flushParsedEvents() {
+  if (d->parsed_event_list.empty()) {
+    return true;
+  }
+
+  auto event_count = d->parsed_event_list.size();
+  if (d->event_queue.tryPush(d->parsed_event_list)) {
+    d->parsed_event_list = {};
+    d->table_signal.notify();
+
+    return true;
+  }
+
+  if (d->overflow_policy == OverflowPolicy::Block) {
+    return false;
+  }
+
+  d->dropped_event_count += event_count;
+  d->parsed_event_list = {};
+
+  return true;
+}
+
 void AudispConsumer::auparseCallbackDispatcher(auparse_state_t *,
                                                auparse_cb_event_t event_type,
                                                void *user_data) {
@@ -120,6 +563,8 @@ void AudispConsumer::auparseCallback(auparse_cb_event_t event_type) {
   }
 
   AuditEvent audit_event;
+  audit_event.serial = d->auparse_interface->getSerial();
+
   std::optional<SyscallRecordData> syscall_data;
   auto status = parseSyscallRecord(syscall_data, d->auparse_interface);
   if (!status.succeeded()) {
@@ -131,6 +576,16 @@ void AudispConsumer::auparseCallback(auparse_cb_event_t event_type) {
     return;
   }
 
+  // Most of the unwanted events can be discarded before the remaining
+  // records are parsed
+  auto filter_decision = AuditEventFilter::Decision::Accept;
+  if (d->event_filter) {
+    filter_decision = d->event_filter->matchSyscall(syscall_data.value());
+    if (filter_decision == AuditEventFilter::Decision::Reject) {
+      return;
+    }
+  }
+
   audit_event.syscall_data = std::move(syscall_data.value());
   syscall_data = {};
 
@@ -145,7 +600,8 @@ void AudispConsumer::auparseCallback(auparse_cb_event_t event_type) {
 
     switch (record_type) {
     case AUDIT_EXECVE:
-      status = parseRawExecveRecord(raw_execve_data, d->auparse_interface);
+      status = parseRawExecveRecord(raw_execve_data, d->auparse_interface,
+                                    d->execve_limits);
       is_execve_syscall = true;
       break;
 
@@ -189,7 +645,7 @@ void AudispConsumer::auparseCallback(auparse_cb_event_t event_type) {
   d->auparse_interface->nextEvent();
 
   if (is_execve_syscall) {
-    if (raw_execve_data.argument_list.empty()) {
+    if (raw_execve_data.received_argument_count == 0U) {
       d->parser_error = true;
       return;
     }
@@ -213,14 +669,19 @@ void AudispConsumer::auparseCallback(auparse_cb_event_t event_type) {
     path_data = {};
   }
 
-  {
-    std::lock_guard<std::mutex> lock(d->processed_event_list_mutex);
-    d->processed_event_list.push_back(std::move(audit_event));
+  if (filter_decision == AuditEventFilter::Decision::Undecided &&
+      !d->event_filter->matchEvent(audit_event)) {
+    return;
   }
+
+  d->parsed_event_list.push_back(std::move(audit_event));
+  ++d->parsed_event_count;
 }
 
-Status IAudispConsumer::create(Ref &obj,
-                               const std::string &audisp_socket_path) {
+Status IAudispConsumer::create(Ref &obj, const std::string &audisp_socket_path,
+                               Parser parser, OverflowPolicy overflow_policy,
+                               const FilterRuleList &filter_rule_list,
+                               const ExecveLimits &execve_limits) {
   obj.reset();
 
   try {
@@ -232,7 +693,37 @@ Status IAudispConsumer::create(Ref &obj,
       return status;
     }
 
-    return AudispConsumer::createWithProducer(obj, std::move(audisp_producer));
+    return AudispConsumer::createWithProducer(obj, std::move(audisp_producer),
+                                              parser, overflow_policy,
+                                              filter_rule_list, execve_limits);
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+Status IAudispConsumer::createFromFile(Ref &obj,
+                                       const std::string &stream_file_path,
+                                       Parser parser,
+                                       OverflowPolicy overflow_policy,
+                                       const FilterRuleList &filter_rule_list,
+                                       const ExecveLimits &execve_limits) {
+  obj.reset();
+
+  try {
+    IAudispProducer::Ref audisp_producer;
+    auto status = AudispFileReader::create(audisp_producer, stream_file_path);
+
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    return AudispConsumer::createWithProducer(obj, std::move(audisp_producer),
+                                              parser, overflow_policy,
+                                              filter_rule_list, execve_limits);
 
   } catch (const std::bad_alloc &) {
     return Status::failure("Memory allocation failure");
@@ -244,29 +735,11 @@ Status IAudispConsumer::create(Ref &obj,
 
 Status
 AudispConsumer::parseSyscallRecord(std::optional<SyscallRecordData> &data,
-                                   IAuparseInterface::Ref auparse) {
-  // clang-format off
-  std::unordered_map<int, SyscallRecordData::Type> kNumberToSyscallType = {
-    { __NR_execve, SyscallRecordData::Type::Execve },
-    { __NR_execveat, SyscallRecordData::Type::ExecveAt },
-
- #ifndef __aarch64__
-    { __NR_fork, SyscallRecordData::Type::Fork },
-    { __NR_vfork, SyscallRecordData::Type::VFork },
- #endif
-
-    { __NR_clone, SyscallRecordData::Type::Clone },
-    { __NR_bind, SyscallRecordData::Type::Bind },
-    { __NR_connect, SyscallRecordData::Type::Connect },
-    { __NR_open, SyscallRecordData::Type::Open },
-    { __NR_openat, SyscallRecordData::Type::OpenAt },
-    { __NR_creat, SyscallRecordData::Type::Create },
-  };
-  // clang-format on
-
-  data.reset();
-
-  SyscallRecordData output;
+                                   const IAuparseInterface::Ref &auparse) {
+
+  // The record is parsed in place, without going through a temporary
+  data.emplace();
+  auto &output = data.value();
 
   std::int64_t syscall_number{0};
   std::size_t field_count{0U};
@@ -277,82 +750,103 @@ AudispConsumer::parseSyscallRecord(std::optional<SyscallRecordData> &data,
     auto field_name = auparse->getFieldName();
     auto field_value = auparse->getFieldStr();
 
-    if (std::strcmp(field_name, "syscall") == 0) {
-      syscall_number = std::strtoll(field_value, nullptr, 10);
+    switch (getSyscallRecordField(field_name)) {
+    case SyscallRecordField::Unknown:
+      continue;
+
+    case SyscallRecordField::Syscall:
+      convertAuditInteger(syscall_number, field_value);
 
-      auto syscall_type_it = kNumberToSyscallType.find(syscall_number);
-      if (syscall_type_it == kNumberToSyscallType.end()) {
+      if (!getSyscallType(output.type, syscall_number)) {
+        data.reset();
         return Status::success();
       }
 
-      output.type = syscall_type_it->second;
-
-      ++field_count;
+      break;
 
-    } else if (std::strcmp(field_name, "success") == 0) {
+    case SyscallRecordField::Success:
       output.succeeded = std::strcmp(field_value, "yes") == 0;
-      ++field_count;
+      break;
 
-    } else if (std::strcmp(field_name, "exit") == 0) {
-      output.exit_code = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Exit:
+      convertAuditInteger(output.exit_code, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "pid") == 0) {
-      output.process_id = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::ProcessId:
+      convertAuditInteger(output.process_id, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "ppid") == 0) {
-      output.parent_process_id = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::ParentProcessId:
+      convertAuditInteger(output.parent_process_id, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "auid") == 0) {
-      output.auid = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Auid:
+      convertAuditInteger(output.auid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "uid") == 0) {
-      output.uid = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Uid:
+      convertAuditInteger(output.uid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "euid") == 0) {
-      output.euid = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Euid:
+      convertAuditInteger(output.euid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "gid") == 0) {
-      output.gid = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Gid:
+      convertAuditInteger(output.gid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "egid") == 0) {
-      output.egid = std::strtoll(field_value, nullptr, 10);
-      ++field_count;
+    case SyscallRecordField::Egid:
+      convertAuditInteger(output.egid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "exe") == 0) {
+    case SyscallRecordField::Exe:
       if (!convertAuditString(output.exe, field_value)) {
         output.exe = field_value;
       }
 
-      ++field_count;
+      break;
 
-    } else if (std::strcmp(field_name, "a0") == 0) {
+    case SyscallRecordField::A0:
       output.a0 = field_value;
-      ++field_count;
+      break;
     }
 
-    if (field_count == 12U) {
+    ++field_count;
+    if (field_count == kSyscallRecordFieldCount) {
       break;
     }
 
   } while (auparse->nextField() > 0);
 
-  if (field_count != 12U) {
+  // The kernel logs exit_group() while the process is being torn down,
+  // without the success and exit fields
+  auto expected_field_count = kSyscallRecordFieldCount;
+  if (syscall_number == __NR_exit_group) {
+    expected_field_count -= 2U;
+  }
+
+  if (field_count < expected_field_count) {
+    data.reset();
     return Status::failure("One or more fields are missing");
   }
 
-  data = std::move(output);
   return Status::success();
 }
 
-Status AudispConsumer::parseRawExecveRecord(RawExecveRecordData &raw_data,
-                                            IAuparseInterface::Ref auparse) {
+Status
+AudispConsumer::parseRawExecveRecord(RawExecveRecordData &raw_data,
+                                     const IAuparseInterface::Ref &auparse,
+                                     const ExecveLimits &execve_limits) {
+
+  auto max_argument_count = execve_limits.max_argument_count != 0U
+                                ? execve_limits.max_argument_count
+                                : std::numeric_limits<std::size_t>::max();
+
+  auto max_command_line_size = execve_limits.max_command_line_size != 0U
+                                   ? execve_limits.max_command_line_size
+                                   : std::numeric_limits<std::size_t>::max();
+
   auparse->firstField();
 
   do {
@@ -360,91 +854,112 @@ Status AudispConsumer::parseRawExecveRecord(RawExecveRecordData &raw_data,
     auto field_value = auparse->getFieldStr();
 
     if (std::strcmp(field_name, "argc") == 0) {
-      raw_data.argc = std::strtol(field_value, nullptr, 10);
+      std::int64_t argc{0};
+      if (!convertAuditInteger(argc, field_value) || argc < 0 ||
+          argc > std::numeric_limits<int>::max()) {
+        return Status::failure("Invalid execve parameter count");
+      }
+
+      raw_data.argc = static_cast<int>(argc);
       if (raw_data.argc == 0) {
         break;
       }
 
-      continue;
-
-    } else if (field_name[0] != 'a' ||
-               std::strstr(field_name, "_len") != nullptr) {
+      raw_data.argument_list.reserve(
+          std::min({static_cast<std::size_t>(raw_data.argc),
+                    max_argument_count, kMaxReservedExecveArgumentCount}));
 
       continue;
     }
 
-    raw_data.argument_list.insert({field_name, field_value});
-  } while (auparse->nextField() > 0);
-
-  return Status::success();
-}
-
-Status AudispConsumer::processExecveRecords(ExecveRecordData &data,
-                                            RawExecveRecordData &raw_data) {
-  data = {};
+    // Parameters are named aN; long ones are split into aN[0], aN[1], ...
+    // chunks, preceded by an aN_len field. The kernel emits them in order,
+    // so only the last parameter can still receive data
+    if (field_name[0] != 'a' ||
+        !std::isdigit(static_cast<unsigned char>(field_name[1]))) {
+      continue;
+    }
 
-  ExecveRecordData output;
-  output.argc = raw_data.argc;
+    char *index_end{nullptr};
+    auto argument_index = std::strtoull(field_name + 1, &index_end, 10);
 
-  for (auto &p : raw_data.argument_list) {
-    auto &field_name = p.first;
-    auto &field_value = p.second;
+    bool is_length_field = std::strcmp(index_end, "_len") == 0;
+    bool is_chunk_field = *index_end == '[';
 
-    if (field_name.find("_len") != std::string::npos) {
+    if (*index_end != '\0' && !is_length_field && !is_chunk_field) {
       continue;
     }
 
-    auto separator_index = field_name.find("[");
-    if (separator_index == std::string::npos) {
-      continue;
-
-    } else {
-      auto base_field_name = field_name.substr(0, separator_index);
-      auto chunk_index =
-          std::strtol(field_name.data() + separator_index, nullptr, 10U);
-      auto base_field_it = raw_data.argument_list.find(base_field_name);
-
-      if (chunk_index != 0 && base_field_it == raw_data.argument_list.end()) {
-        return Status::failure("Missing execve argument");
+    if (argument_index == raw_data.received_argument_count) {
+      if (argument_index >= static_cast<std::size_t>(raw_data.argc)) {
+        return Status::failure("Unexpected execve parameter: " +
+                               std::string(field_name));
       }
 
-      if (base_field_it == raw_data.argument_list.end()) {
-        raw_data.argument_list.insert({base_field_name, field_value});
+      ++raw_data.received_argument_count;
+
+      if (argument_index < max_argument_count) {
+        raw_data.argument_list.emplace_back();
       } else {
-        auto &base_field_value = base_field_it->second;
-        base_field_value.append(field_value);
+        raw_data.truncated = true;
       }
-    }
-  }
 
-  for (auto &p : raw_data.argument_list) {
-    const auto &field_name = p.first;
-    const auto &field_value = p.second;
+    } else if (argument_index + 1U != raw_data.received_argument_count ||
+               !is_chunk_field) {
+      return Status::failure("Unexpected execve parameter: " +
+                             std::string(field_name));
+    }
 
-    if (field_name.find('[') != std::string::npos) {
+    // Parameters past the limit are only counted
+    if (argument_index >= raw_data.argument_list.size()) {
       continue;
     }
 
-    if (field_name.find("_len") != std::string::npos) {
+    auto &argument = raw_data.argument_list.back();
+    auto remaining_size = max_command_line_size - raw_data.command_line_size;
+
+    if (is_length_field) {
+      // The length of the encoded value; hex strings are twice as large
+      std::int64_t encoded_length{0};
+      if (convertAuditInteger(encoded_length, field_value) &&
+          encoded_length > 0) {
+        argument.reserve(std::min(static_cast<std::size_t>(encoded_length),
+                                  remaining_size));
+      }
+
       continue;
     }
 
-    std::string value;
-    if (!convertAuditString(value, field_value)) {
-      value = field_value;
+    auto previous_size = argument.size();
+    if (!appendAuditString(argument, field_value, remaining_size)) {
+      raw_data.truncated = true;
     }
 
-    output.argument_list.push_back(std::move(value));
-  }
+    raw_data.command_line_size += argument.size() - previous_size;
+  } while (auparse->nextField() > 0);
 
-  raw_data = {};
-  data = std::move(output);
+  return Status::success();
+}
+
+Status AudispConsumer::processExecveRecords(ExecveRecordData &data,
+                                            RawExecveRecordData &raw_data) {
+  data = {};
+
+  data.argc = raw_data.argc;
+  data.argument_list = std::move(raw_data.argument_list);
 
+  // Parameters that never arrived are reported the same way as the ones
+  // that have been discarded
+  data.truncated = raw_data.truncated ||
+                   raw_data.received_argument_count !=
+                       static_cast<std::size_t>(raw_data.argc);
+
+  raw_data = {};
   return Status::success();
 }
 
 Status AudispConsumer::parseCwdRecord(std::string &data,
-                                      IAuparseInterface::Ref auparse) {
+                                      const IAuparseInterface::Ref &auparse) {
   data = {};
 
   auparse->firstField();
@@ -471,7 +986,7 @@ Status AudispConsumer::parseCwdRecord(std::string &data,
 }
 
 Status AudispConsumer::parsePathRecord(PathRecordData &data,
-                                       IAuparseInterface::Ref auparse) {
+                                       const IAuparseInterface::Ref &auparse) {
   auparse->firstField();
 
   std::string path_value;
@@ -487,41 +1002,48 @@ Status AudispConsumer::parsePathRecord(PathRecordData &data,
     auto field_name = auparse->getFieldName();
     auto field_value = auparse->getFieldStr();
 
-    if (std::strcmp(field_name, "name") == 0) {
+    switch (getPathRecordField(field_name)) {
+    case PathRecordField::Unknown:
+      continue;
+
+    case PathRecordField::Name:
       if (!convertAuditString(path_value, field_value)) {
         path_value = field_value;
       }
-      ++parsed_field_count;
 
-    } else if (std::strcmp(field_name, "item") == 0) {
+      break;
+
+    case PathRecordField::Item:
       if (std::strcmp(field_value, "0") == 0) {
         first_record = true;
       }
-      ++parsed_field_count;
 
-    } else if (std::strcmp(field_name, "mode") == 0) {
-      mode = std::strtoll(field_value, nullptr, 8);
-      ++parsed_field_count;
+      break;
+
+    case PathRecordField::Mode:
+      convertAuditInteger(mode, field_value, 8);
+      break;
 
-    } else if (std::strcmp(field_name, "inode") == 0) {
-      inode = std::strtoll(field_value, nullptr, 8);
-      ++parsed_field_count;
+    case PathRecordField::Inode:
+      convertAuditInteger(inode, field_value, 8);
+      break;
 
-    } else if (std::strcmp(field_name, "ouid") == 0) {
-      ouid = std::strtoll(field_value, nullptr, 10);
-      ++parsed_field_count;
+    case PathRecordField::Ouid:
+      convertAuditInteger(ouid, field_value);
+      break;
 
-    } else if (std::strcmp(field_name, "ogid") == 0) {
-      ogid = std::strtoll(field_value, nullptr, 10);
-      ++parsed_field_count;
+    case PathRecordField::Ogid:
+      convertAuditInteger(ogid, field_value);
+      break;
     }
 
-    if (parsed_field_count == 6U) {
+    ++parsed_field_count;
+    if (parsed_field_count == kPathRecordFieldCount) {
       break;
     }
   } while (auparse->nextField() > 0);
 
-  if (parsed_field_count != 6U) {
+  if (parsed_field_count != kPathRecordFieldCount) {
     return Status::failure(
         "One or more fields are missing from the AUDIT_PATH record");
   }
@@ -534,99 +1056,100 @@ Status AudispConsumer::parsePathRecord(PathRecordData &data,
   return Status::success();
 }
 
-Status AudispConsumer::parseSockaddrRecord(SockaddrRecordData &data,
-                                           IAuparseInterface::Ref auparse) {
+Status
+AudispConsumer::parseSockaddrRecord(SockaddrRecordData &data,
+                                    const IAuparseInterface::Ref &auparse) {
   data = {};
 
   auparse->firstField();
 
-  std::string hex_encoded_address;
+  const char *hex_encoded_address{nullptr};
 
   do {
-    auto field_name = auparse->getFieldName();
-    auto field_value = auparse->getFieldStr();
-
-    if (std::strcmp(field_name, "saddr") == 0) {
-      hex_encoded_address = field_value;
+    if (std::strcmp(auparse->getFieldName(), "saddr") == 0) {
+      hex_encoded_address = auparse->getFieldStr();
       break;
     }
   } while (auparse->nextField() > 0);
 
-  if (hex_encoded_address.empty()) {
+  if (hex_encoded_address == nullptr || *hex_encoded_address == 0) {
     return Status::failure(
         "One or more fields are missing from the AUDIT_SOCKADDR record");
   }
 
-  std::string buffer;
-  if (!convertHexString(buffer, hex_encoded_address)) {
+  struct sockaddr_storage address {};
+  std::size_t address_size{0U};
+
+  if (!decodeSockaddr(address, address_size, hex_encoded_address)) {
     return Status::failure(
         "Failed to parse the hex encoded sockaddr structure");
   }
 
-  SockaddrRecordData output;
+  if (address_size < sizeof(address.ss_family)) {
+    return Status::failure("Unrecognized sockaddr structure of size " +
+                           std::to_string(address_size));
+  }
 
-  switch (buffer.size()) {
-  case sizeof(struct sockaddr_in): {
-    struct sockaddr_in addr {};
-    std::memcpy(&addr, buffer.data(), sizeof(addr));
+  // The structure is logged with the size passed to the syscall, so the
+  // family is used to tell the address types apart
+  NetworkAddressBuffer address_buffer;
 
-    output.family = static_cast<std::int64_t>(addr.sin_family);
-    output.port = static_cast<std::int64_t>(htons(addr.sin_port));
+  switch (address.ss_family) {
+  case AF_INET: {
+    if (address_size < offsetof(struct sockaddr_in, sin_zero)) {
+      return Status::failure("Truncated AF_INET sockaddr structure");
+    }
 
-    std::uint8_t numeric_address_bytes[4];
-    std::memcpy(numeric_address_bytes, &addr.sin_addr.s_addr,
-                sizeof(numeric_address_bytes));
+    const auto &addr = reinterpret_cast<const struct sockaddr_in &>(address);
 
-    for (std::size_t i = 0U; i < 4U; ++i) {
-      output.address += std::to_string(numeric_address_bytes[i]);
+    std::array<std::uint8_t, 16> address_bytes{};
+    std::memcpy(address_bytes.data(), &addr.sin_addr, sizeof(addr.sin_addr));
 
-      if (i < 3) {
-        output.address.push_back('.');
-      }
-    }
+    data.family = static_cast<std::int64_t>(addr.sin_family);
+    data.port = static_cast<std::int64_t>(ntohs(addr.sin_port));
+    data.address = formatIPv4Address(address_buffer, address_bytes.data());
+    data.address_bytes = address_bytes;
 
     break;
   }
 
-  case sizeof(struct sockaddr_in6): {
-    struct sockaddr_in6 addr {};
-    std::memcpy(&addr, buffer.data(), sizeof(addr));
+  case AF_INET6: {
+    if (address_size < offsetof(struct sockaddr_in6, sin6_scope_id)) {
+      return Status::failure("Truncated AF_INET6 sockaddr structure");
+    }
 
-    output.family = static_cast<std::int64_t>(addr.sin6_family);
-    output.port = static_cast<std::int64_t>(htons(addr.sin6_port));
+    const auto &addr = reinterpret_cast<const struct sockaddr_in6 &>(address);
 
-    std::stringstream str_stream;
-    for (std::size_t i = 0U; i < 16U; ++i) {
-      str_stream << std::hex << std::setw(2) << std::setfill('0')
-                 << static_cast<int>(addr.sin6_addr.s6_addr[i]);
+    std::array<std::uint8_t, 16> address_bytes{};
+    std::memcpy(address_bytes.data(), &addr.sin6_addr,
+                sizeof(addr.sin6_addr));
 
-      if (i < 15U) {
-        str_stream << ":";
-      }
-    }
+    data.family = static_cast<std::int64_t>(addr.sin6_family);
+    data.port = static_cast<std::int64_t>(ntohs(addr.sin6_port));
+    data.address = formatIPv6Address(address_buffer, address_bytes.data());
+    data.address_bytes = address_bytes;
 
-    output.address = str_stream.str();
     break;
   }
 
-  case sizeof(struct sockaddr_un): {
-    struct sockaddr_un addr {};
-    std::memcpy(&addr, buffer.data(), sizeof(addr));
+  case AF_UNIX: {
+    const auto &addr = reinterpret_cast<const struct sockaddr_un &>(address);
+
+    auto max_path_size = std::min(address_size - sizeof(addr.sun_family),
+                                  sizeof(addr.sun_path));
 
-    output.family = static_cast<std::int64_t>(addr.sun_family);
-    output.address = addr.sun_path;
+    data.family = static_cast<std::int64_t>(addr.sun_family);
+    data.address.assign(addr.sun_path,
+                        strnlen(addr.sun_path, max_path_size));
 
     break;
   }
 
-  default: {
-    auto saddr_field_size = buffer.size();
-    return Status::failure("Unrecognized sockaddr structure of size " +
-                           std::to_string(saddr_field_size));
-  }
+  default:
+    return Status::failure("Unrecognized sockaddr structure of family " +
+                           std::to_string(address.ss_family));
   }
 
-  data = std::move(output);
   return Status::success();
 }
 } // namespace zeek
@@ -21,9 +21,17 @@ public:
   /// \brief Factory method
   /// \param obj Where the created object is stored
   /// \param audisp_producer An initialized Audisp socket reader
+  /// \param parser The parser used for the audisp text stream
+  /// \param overflow_policy What to do when the table stage falls behind
+  /// \param filter_rule_list The rules used to discard unwanted events
+  /// \param execve_limits How much of each execve command line is kept
   /// \return A Status object
-  static Status createWithProducer(Ref &obj,
-                                   IAudispProducer::Ref audisp_producer);
+  static Status
+  createWithProducer(Ref &obj, IAudispProducer::Ref audisp_producer,
+                     Parser parser = Parser::Auparse,
+                     OverflowPolicy overflow_policy = OverflowPolicy::Drop,
+                     const FilterRuleList &filter_rule_list = FilterRuleList(),
+                     const ExecveLimits &execve_limits = ExecveLimits());
 
   /// \brief Destructor
   virtual ~AudispConsumer() override;
@@ -32,17 +40,61 @@ public:
   /// producer \return A Status object
   virtual Status processEvents() override;
 
+  /// \brief Acquires new data from the audisp producer, waiting for the
+  ///        parser stage if the read buffer is full
+  /// \return A Status object
+  virtual Status readData() override;
+
+  /// \brief Parses the acquired data, waiting for the reader stage if
+  ///        there is nothing to do
+  /// \return A Status object
+  virtual Status parseData() override;
+
+  /// \brief Waits until new events have been queued
+  /// \param timeout How long to wait at most
+  virtual void
+  waitForEvents(const std::chrono::milliseconds &timeout) override;
+
   /// \brief Returns the processed events
   /// \param event_list Where the event list is stored
   /// \return A Status object
   virtual Status getEvents(AuditEventList &event_list) override;
 
+  /// \brief Returns the depth and throughput counters of each stage
+  /// \param metrics Where the metrics are stored
+  virtual void getPipelineMetrics(PipelineMetrics &metrics) const override;
+
+  /// \brief Returns how many events each filter rule has matched
+  /// \param counter_list Where the counters are stored
+  virtual void
+  getFilterRuleCounters(FilterRuleCounterList &counter_list) const override;
+
+  /// \brief Wakes up the stages that are waiting for data
+  virtual void interrupt() override;
+
 protected:
   /// \brief Constructor
   /// \param audisp_producer An initialized Audisp socket reader
-  AudispConsumer(IAudispProducer::Ref audisp_producer);
+  /// \param parser The parser used for the audisp text stream
+  /// \param overflow_policy What to do when the table stage falls behind
+  /// \param filter_rule_list The rules used to discard unwanted events
+  /// \param execve_limits How much of each execve command line is kept
+  AudispConsumer(IAudispProducer::Ref audisp_producer, Parser parser,
+                 OverflowPolicy overflow_policy,
+                 const FilterRuleList &filter_rule_list,
+                 const ExecveLimits &execve_limits);
 
 private:
+  /// \brief Feeds the acquired data to the parser, and queues the new
+  ///        events for the table stage
+  /// \return True if any data or event has been processed
+  bool parseBufferedData();
+
+  /// \brief Moves the events parsed so far to the queue towards the table
+  ///        stage, applying the overflow policy when it is full
+  /// \return False if the events are still waiting for room in the queue
+  bool flushParsedEvents();
+
   /// \brief Callback dispatcher for libauparse
   /// \param event_type Contains the reason for the invocation
   /// \param user_data Contains a reference to an AudispConsumer instance
@@ -60,18 +112,23 @@ public:
   /// \param auparse The auparse library interface
   /// \return A Status object
   static Status parseSyscallRecord(std::optional<SyscallRecordData> &data,
-                                   IAuparseInterface::Ref auparse);
+                                   const IAuparseInterface::Ref &auparse);
 
-  /// \brief Parses an EXECVE record
-  /// \param data Where the parsed data is stored
+  /// \brief Parses an EXECVE record. Long command lines are split across
+  ///        multiple records, which must all be parsed into the same
+  ///        raw_data object, in order
+  /// \param raw_data Where the decoded parameters are accumulated
   /// \param auparse The auparse library interface
+  /// \param execve_limits How much of the command line is kept
   /// \return A Status object
-  static Status parseRawExecveRecord(RawExecveRecordData &raw_data,
-                                     IAuparseInterface::Ref auparse);
+  static Status
+  parseRawExecveRecord(RawExecveRecordData &raw_data,
+                       const IAuparseInterface::Ref &auparse,
+                       const ExecveLimits &execve_limits = ExecveLimits());
 
-  /// \brief Assembles multiple raw EXECVE records into one
+  /// \brief Completes the parameters accumulated by parseRawExecveRecord
   /// \param data Where the processed data is stored
-  /// \param raw_data The list of raw EXECVE records
+  /// \param raw_data The accumulated EXECVE records; reset on return
   /// \return A Status object
   static Status processExecveRecords(ExecveRecordData &data,
                                      RawExecveRecordData &raw_data);
@@ -81,21 +138,21 @@ public:
   /// \param auparse The auparse library interface
   /// \return A Status object
   static Status parseCwdRecord(std::string &data,
-                               IAuparseInterface::Ref auparse);
+                               const IAuparseInterface::Ref &auparse);
 
   /// \brief Parses a PATH record
   /// \param data Where the parsed data is stored
   /// \param auparse The auparse library interface
   /// \return A Status object
   static Status parsePathRecord(PathRecordData &data,
-                                IAuparseInterface::Ref auparse);
+                                const IAuparseInterface::Ref &auparse);
 
   /// \brief Parses a SOCKADDR record
   /// \param data Where the parsed data is stored
   /// \param auparse The auparse library interface
   /// \return A Status object
   static Status parseSockaddrRecord(SockaddrRecordData &data,
-                                    IAuparseInterface::Ref auparse);
+                                    const IAuparseInterface::Ref &auparse);
 
   friend class IAudispConsumer;
 };
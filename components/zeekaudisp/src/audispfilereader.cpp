@@ -0,0 +1,106 @@
+#include "audispfilereader.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+namespace zeek {
+namespace {
+/// \brief How long read() waits once the whole stream has been copied
+const std::chrono::milliseconds kEndOfStreamDelay{100};
+} // namespace
+
+struct AudispFileReader::PrivateData final {
+  // The whole stream is loaded upfront, so that disk reads do not show up
+  // in the pipeline measurements
+  std::string stream_data;
+
+  std::size_t read_offset{0U};
+
+  std::mutex interrupt_mutex;
+  std::condition_variable interrupt_cv;
+  bool interrupted{false};
+};
+
+Status AudispFileReader::create(IAudispProducer::Ref &obj,
+                                const std::string &file_path) {
+  obj.reset();
+
+  try {
+    auto ptr = new AudispFileReader(file_path);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AudispFileReader::~AudispFileReader() {}
+
+Status AudispFileReader::read(RingBuffer &buffer) {
+  if (d->read_offset == d->stream_data.size()) {
+    std::unique_lock<std::mutex> lock(d->interrupt_mutex);
+    d->interrupt_cv.wait_for(lock, kEndOfStreamDelay,
+                             [&]() { return d->interrupted; });
+
+    d->interrupted = false;
+    return Status::success();
+  }
+
+  RingBuffer::RegionList region_list;
+  auto region_count = buffer.writableRegions(region_list);
+
+  std::size_t copied_byte_count{0U};
+
+  for (std::size_t i = 0U; i < region_count; ++i) {
+    const auto &region = region_list[i];
+
+    auto byte_count =
+        std::min(region.iov_len, d->stream_data.size() - d->read_offset);
+
+    std::memcpy(region.iov_base, d->stream_data.data() + d->read_offset,
+                byte_count);
+
+    copied_byte_count += byte_count;
+    d->read_offset += byte_count;
+  }
+
+  buffer.commit(copied_byte_count);
+  return Status::success();
+}
+
+void AudispFileReader::interrupt() {
+  {
+    std::lock_guard<std::mutex> lock(d->interrupt_mutex);
+    d->interrupted = true;
+  }
+
+  d->interrupt_cv.notify_all();
+}
+
+AudispFileReader::AudispFileReader(const std::string &file_path)
+    : d(new PrivateData) {
+
+  std::ifstream input_file(file_path, std::ios::binary);
+  if (!input_file) {
+    throw Status::failure("Failed to open the audisp stream file: " +
+                          file_path);
+  }
+
+  d->stream_data.assign(std::istreambuf_iterator<char>(input_file),
+                        std::istreambuf_iterator<char>());
+
+  if (input_file.bad()) {
+    throw Status::failure("Failed to read the audisp stream file: " +
+                          file_path);
+  }
+}
+} // namespace zeek
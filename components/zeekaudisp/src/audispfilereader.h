@@ -0,0 +1,41 @@
+#pragma once
+
+#include "iaudispproducer.h"
+
+#include <memory>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief Replays a captured audisp stream from a file (implementation)
+class AudispFileReader final : public IAudispProducer {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param file_path Path to the captured audisp stream
+  /// \return A Status object
+  static Status create(IAudispProducer::Ref &obj,
+                       const std::string &file_path);
+
+  /// \brief Destructor
+  virtual ~AudispFileReader() override;
+
+  /// \brief Copies as much of the stream as fits in the buffer. Once the
+  ///        whole stream has been copied, it waits for a short time like an
+  ///        idle socket would
+  /// \param buffer Where the read data is appended
+  /// \return A Status object
+  virtual Status read(RingBuffer &buffer) override;
+
+  /// \brief Wakes up a read() call that is waiting for data
+  virtual void interrupt() override;
+
+protected:
+  /// \brief Constructor
+  /// \param file_path Path to the captured audisp stream
+  AudispFileReader(const std::string &file_path);
+};
+} // namespace zeek
@@ -0,0 +1,502 @@
+#include "audispnativeparser.h"
+#include "audit_utils.h"
+
+#include <cstring>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include <libaudit_wrapper.h>
+
+namespace zeek {
+namespace {
+const std::string_view kRecordTypePrefix{"type="};
+const std::string_view kAuditMessagePrefix{"msg=audit("};
+const std::string_view kUnknownRecordTypePrefix{"UNKNOWN["};
+
+/// \brief Separates the raw fields from the ones enriched by auditd
+const char kEnrichedFieldSeparator{'\x1d'};
+
+/// \brief Lines longer than this are discarded; the kernel never sends
+///        records this large
+const std::size_t kMaxLineSize{65536U};
+
+/// \brief How many records are kept around to be reused
+const std::size_t kMaxRecycledRecordCount{256U};
+
+int getRecordType(std::string_view record_name) {
+  switch (record_name.size()) {
+  case 3U:
+    if (record_name == "CWD") {
+      return AUDIT_CWD;
+    } else if (record_name == "EOE") {
+      return AUDIT_EOE;
+    }
+
+    break;
+
+  case 4U:
+    if (record_name == "PATH") {
+      return AUDIT_PATH;
+    }
+
+    break;
+
+  case 6U:
+    if (record_name == "EXECVE") {
+      return AUDIT_EXECVE;
+    }
+
+    break;
+
+  case 7U:
+    if (record_name == "SYSCALL") {
+      return AUDIT_SYSCALL;
+    }
+
+    break;
+
+  case 8U:
+    if (record_name == "SOCKADDR") {
+      return AUDIT_SOCKADDR;
+    }
+
+    break;
+
+  case 9U:
+    if (record_name == "PROCTITLE") {
+      return AUDIT_PROCTITLE;
+    }
+
+    break;
+  }
+
+  // Types that have no name are printed as UNKNOWN[<type>]; the other
+  // named types are not used by the record parsers
+  if (record_name.size() > kUnknownRecordTypePrefix.size() &&
+      record_name.substr(0U, kUnknownRecordTypePrefix.size()) ==
+          kUnknownRecordTypePrefix) {
+
+    std::int64_t record_type{0};
+    convertAuditInteger(record_type,
+                        record_name.data() + kUnknownRecordTypePrefix.size());
+
+    return static_cast<int>(record_type);
+  }
+
+  return 0;
+}
+} // namespace
+
+struct AudispNativeParser::Record final {
+  /// \brief Record type, as returned by getType()
+  int type{0};
+
+  /// \brief The record text. Field names and values are null-terminated
+  ///        in place, so that no per-field string is needed
+  std::string buffer;
+
+  /// \brief Offsets of each field name and value inside the buffer
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> field_list;
+};
+
+struct AudispNativeParser::PendingEvent final {
+  std::vector<Record> record_list;
+  std::chrono::steady_clock::time_point last_update;
+};
+
+struct AudispNativeParser::PrivateData final {
+  Configuration configuration;
+
+  auparse_callback_ptr callback{nullptr};
+  void *callback_user_data{nullptr};
+  user_destroy callback_user_data_destructor{nullptr};
+
+  std::string partial_line;
+  bool discard_partial_line{false};
+
+  // Serials increase monotonically, so the oldest events are always at the
+  // front of the map
+  std::map<std::uint64_t, PendingEvent> pending_event_map;
+  std::vector<Record> recycled_record_list;
+
+  const PendingEvent *current_event{nullptr};
+  std::uint64_t current_serial{0U};
+  std::size_t current_record{0U};
+  std::size_t current_field{0U};
+
+  const Record *currentRecord() const {
+    if (current_event == nullptr ||
+        current_record >= current_event->record_list.size()) {
+      return nullptr;
+    }
+
+    return &current_event->record_list.at(current_record);
+  }
+};
+
+Status AudispNativeParser::create(Ref &obj,
+                                  const Configuration &configuration) {
+  obj.reset();
+
+  try {
+    auto ptr = new AudispNativeParser(configuration);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AudispNativeParser::~AudispNativeParser() {
+  if (d->callback_user_data_destructor != nullptr) {
+    d->callback_user_data_destructor(d->callback_user_data);
+  }
+}
+
+int AudispNativeParser::flushFeed() {
+  if (!d->partial_line.empty() && !d->discard_partial_line) {
+    processLine(d->partial_line.data(), d->partial_line.size());
+  }
+
+  d->partial_line.clear();
+  d->discard_partial_line = false;
+
+  while (!d->pending_event_map.empty()) {
+    deliverEvent(d->pending_event_map.begin()->first);
+  }
+
+  return 0;
+}
+
+int AudispNativeParser::feed(const char *data, size_t data_len) {
+  auto data_end = data + data_len;
+
+  while (data < data_end) {
+    // memchr is vectorized by the C library, so finding the record
+    // boundaries costs far less than going through the stream byte by byte
+    auto line_end = static_cast<const char *>(
+        std::memchr(data, '\n', static_cast<std::size_t>(data_end - data)));
+
+    if (line_end == nullptr) {
+      if (d->partial_line.size() + static_cast<std::size_t>(data_end - data) >
+          kMaxLineSize) {
+        d->partial_line.clear();
+        d->discard_partial_line = true;
+      }
+
+      if (!d->discard_partial_line) {
+        d->partial_line.append(data, data_end);
+      }
+
+      break;
+    }
+
+    // Complete lines are parsed straight from the input buffer
+    if (d->discard_partial_line) {
+      d->discard_partial_line = false;
+
+    } else if (d->partial_line.empty()) {
+      processLine(data, static_cast<std::size_t>(line_end - data));
+
+    } else {
+      d->partial_line.append(data, line_end);
+      processLine(d->partial_line.data(), d->partial_line.size());
+
+      d->partial_line.clear();
+    }
+
+    data = line_end + 1;
+  }
+
+  deliverExpiredEvents();
+  return 0;
+}
+
+int AudispNativeParser::firstField() {
+  auto record = d->currentRecord();
+  if (record == nullptr) {
+    return 0;
+  }
+
+  d->current_field = 0U;
+  return record->field_list.empty() ? 0 : 1;
+}
+
+const char *AudispNativeParser::getFieldName() {
+  auto record = d->currentRecord();
+  if (record == nullptr || d->current_field >= record->field_list.size()) {
+    return nullptr;
+  }
+
+  return record->buffer.c_str() + record->field_list[d->current_field].first;
+}
+
+const char *AudispNativeParser::getFieldStr() {
+  auto record = d->currentRecord();
+  if (record == nullptr || d->current_field >= record->field_list.size()) {
+    return nullptr;
+  }
+
+  return record->buffer.c_str() + record->field_list[d->current_field].second;
+}
+
+int AudispNativeParser::nextField() {
+  auto record = d->currentRecord();
+  if (record == nullptr || d->current_field + 1U >= record->field_list.size()) {
+    return 0;
+  }
+
+  ++d->current_field;
+  return 1;
+}
+
+int AudispNativeParser::firstRecord() {
+  if (d->current_event == nullptr || d->current_event->record_list.empty()) {
+    return 0;
+  }
+
+  d->current_record = 0U;
+  d->current_field = 0U;
+
+  return 1;
+}
+
+int AudispNativeParser::getType() {
+  auto record = d->currentRecord();
+  if (record == nullptr) {
+    return 0;
+  }
+
+  return record->type;
+}
+
+unsigned long AudispNativeParser::getSerial() {
+  if (d->current_event == nullptr) {
+    return 0U;
+  }
+
+  return static_cast<unsigned long>(d->current_serial);
+}
+
+int AudispNativeParser::nextRecord() {
+  if (d->current_event == nullptr ||
+      d->current_record + 1U >= d->current_event->record_list.size()) {
+    return 0;
+  }
+
+  ++d->current_record;
+  d->current_field = 0U;
+
+  return 1;
+}
+
+int AudispNativeParser::nextEvent() {
+  // Events are pushed to the callback as soon as they are complete
+  return 0;
+}
+
+void AudispNativeParser::addCallback(auparse_callback_ptr callback,
+                                     void *user_data,
+                                     user_destroy user_destroy_func) {
+  d->callback = callback;
+  d->callback_user_data = user_data;
+  d->callback_user_data_destructor = user_destroy_func;
+}
+
+AudispNativeParser::AudispNativeParser(const Configuration &configuration)
+    : d(new PrivateData) {
+
+  if (configuration.max_pending_event_count == 0U) {
+    throw Status::failure("The pending event limit must be greater than 0");
+  }
+
+  d->configuration = configuration;
+}
+
+void AudispNativeParser::processLine(const char *line,
+                                     std::size_t line_size) {
+  // Format: [node=<name> ]type=<type> msg=audit(<time>:<serial>): <fields>
+  std::string_view line_view(line, line_size);
+
+  auto type_index = line_view.find(kRecordTypePrefix);
+  if (type_index == std::string_view::npos) {
+    return;
+  }
+
+  line_view.remove_prefix(type_index + kRecordTypePrefix.size());
+
+  auto separator_index = line_view.find(' ');
+  if (separator_index == std::string_view::npos) {
+    return;
+  }
+
+  auto record_name = line_view.substr(0U, separator_index);
+  line_view.remove_prefix(separator_index + 1U);
+
+  if (line_view.substr(0U, kAuditMessagePrefix.size()) !=
+      kAuditMessagePrefix) {
+    return;
+  }
+
+  line_view.remove_prefix(kAuditMessagePrefix.size());
+
+  auto header_end = line_view.find("):");
+  auto serial_index = line_view.find(':');
+  if (header_end == std::string_view::npos || serial_index >= header_end) {
+    return;
+  }
+
+  std::int64_t serial{0};
+  if (!convertAuditInteger(serial, line_view.data() + serial_index + 1U)) {
+    return;
+  }
+
+  line_view.remove_prefix(header_end + 2U);
+
+  auto event_serial = static_cast<std::uint64_t>(serial);
+  auto &pending_event = d->pending_event_map[event_serial];
+  pending_event.last_update = std::chrono::steady_clock::now();
+
+  auto record_type = getRecordType(record_name);
+  if (record_type == AUDIT_EOE) {
+    deliverEvent(event_serial);
+    return;
+  }
+
+  Record record;
+  if (!d->recycled_record_list.empty()) {
+    record = std::move(d->recycled_record_list.back());
+    d->recycled_record_list.pop_back();
+  }
+
+  record.type = record_type;
+  record.field_list.clear();
+
+  // Like auparse, the record type is returned as the first field
+  record.buffer.assign("type");
+  record.buffer.push_back('\0');
+  record.buffer.append(record_name.data(), record_name.size());
+  record.buffer.push_back('\0');
+  record.field_list.push_back({0U, 5U});
+
+  auto index = record.buffer.size();
+  record.buffer.append(line_view.data(), line_view.size());
+
+  auto buffer = &record.buffer[0];
+  auto buffer_size = record.buffer.size();
+
+  while (index < buffer_size) {
+    if (buffer[index] == ' ') {
+      ++index;
+      continue;
+    }
+
+    if (buffer[index] == kEnrichedFieldSeparator) {
+      break;
+    }
+
+    auto name_offset = index;
+    while (index < buffer_size && buffer[index] != '=' &&
+           buffer[index] != ' ' && buffer[index] != kEnrichedFieldSeparator) {
+      ++index;
+    }
+
+    // Skip the tokens that are not in the key=value form
+    if (index >= buffer_size || buffer[index] != '=') {
+      continue;
+    }
+
+    buffer[index] = '\0';
+    ++index;
+
+    auto value_offset = index;
+
+    // Messages from userspace wrap their own fields in single quotes
+    if (index < buffer_size && buffer[index] == '\'') {
+      auto quote_end = record.buffer.find('\'', index + 1U);
+      index = quote_end == std::string::npos ? buffer_size : quote_end + 1U;
+    }
+
+    while (index < buffer_size && buffer[index] != ' ' &&
+           buffer[index] != kEnrichedFieldSeparator) {
+      ++index;
+    }
+
+    record.field_list.push_back({static_cast<std::uint32_t>(name_offset),
+                                 static_cast<std::uint32_t>(value_offset)});
+
+    // The last value is terminated by the string itself
+    if (index >= buffer_size) {
+      break;
+    }
+
+    auto terminator = buffer[index];
+    buffer[index] = '\0';
+    ++index;
+
+    if (terminator == kEnrichedFieldSeparator) {
+      break;
+    }
+  }
+
+  pending_event.record_list.push_back(std::move(record));
+}
+
+void AudispNativeParser::deliverExpiredEvents() {
+  // Only the front of the map is inspected. An expired event that sits
+  // behind an older, still active one is delivered as soon as the latter
+  // completes or expires, so that the events keep their serial order
+  auto current_time = std::chrono::steady_clock::now();
+
+  while (!d->pending_event_map.empty()) {
+    auto oldest_event_it = d->pending_event_map.begin();
+
+    if (current_time - oldest_event_it->second.last_update <
+        d->configuration.event_timeout) {
+      break;
+    }
+
+    deliverEvent(oldest_event_it->first);
+  }
+
+  while (d->pending_event_map.size() >
+         d->configuration.max_pending_event_count) {
+    deliverEvent(d->pending_event_map.begin()->first);
+  }
+}
+
+void AudispNativeParser::deliverEvent(std::uint64_t serial) {
+  auto pending_event_it = d->pending_event_map.find(serial);
+  if (pending_event_it == d->pending_event_map.end()) {
+    return;
+  }
+
+  auto pending_event = std::move(pending_event_it->second);
+  d->pending_event_map.erase(pending_event_it);
+
+  if (!pending_event.record_list.empty() && d->callback != nullptr) {
+    d->current_event = &pending_event;
+    d->current_serial = serial;
+    d->current_record = 0U;
+    d->current_field = 0U;
+
+    d->callback(nullptr, AUPARSE_CB_EVENT_READY, d->callback_user_data);
+
+    d->current_event = nullptr;
+  }
+
+  for (auto &record : pending_event.record_list) {
+    if (d->recycled_record_list.size() >= kMaxRecycledRecordCount) {
+      break;
+    }
+
+    d->recycled_record_list.push_back(std::move(record));
+  }
+}
+} // namespace zeek
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "iauparseinterface.h"
+
+#include <chrono>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief A native parser for the audisp text stream, used in place of
+///        libauparse. Records are reassembled into events by their serial
+///        number, and exposed through the same interface used for auparse
+class AudispNativeParser final : public IAuparseInterface {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief Parser settings
+  struct Configuration final {
+    /// \brief How long an event without an EOE record is kept waiting for
+    ///        more records before being delivered
+    std::chrono::milliseconds event_timeout{2000};
+
+    /// \brief How many events can be assembled at the same time; when the
+    ///        limit is reached, the oldest one is delivered
+    std::size_t max_pending_event_count{1024U};
+  };
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param configuration The parser settings
+  /// \return A Status object
+  static Status create(Ref &obj, const Configuration &configuration);
+
+  /// \brief Destructor
+  virtual ~AudispNativeParser() override;
+
+  /// \brief Delivers all the events that are still being assembled
+  virtual int flushFeed() override;
+
+  /// \brief Parses the given chunk of the audisp text stream. Records can
+  ///        be split across multiple calls
+  virtual int feed(const char *data, size_t data_len) override;
+
+  virtual int firstField() override;
+  virtual const char *getFieldName() override;
+  virtual const char *getFieldStr() override;
+  virtual int nextField() override;
+  virtual int firstRecord() override;
+  virtual int getType() override;
+  virtual unsigned long getSerial() override;
+  virtual int nextRecord() override;
+  virtual int nextEvent() override;
+
+  virtual void addCallback(auparse_callback_ptr callback, void *user_data,
+                           user_destroy user_destroy_func) override;
+
+protected:
+  /// \brief Constructor
+  /// \param configuration The parser settings
+  AudispNativeParser(const Configuration &configuration);
+
+private:
+  /// \brief A single record
+  struct Record;
+
+  /// \brief An event that is still being assembled
+  struct PendingEvent;
+
+  /// \brief Parses a single line of the audisp text stream
+  /// \param line A full record, without the line terminator
+  /// \param line_size The size of the record
+  void processLine(const char *line, std::size_t line_size);
+
+  /// \brief Delivers the events that have timed out, and the oldest ones
+  ///        when there are too many pending events
+  void deliverExpiredEvents();
+
+  /// \brief Delivers the event with the given serial number to the
+  ///        callback, and recycles its records
+  /// \param serial The serial number of the event
+  void deliverEvent(std::uint64_t serial);
+};
+} // namespace zeek
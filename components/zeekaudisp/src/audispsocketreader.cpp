@@ -1,25 +1,27 @@
 #include "audispsocketreader.h"
 
 #include <cstring>
-#include <vector>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <libaudit_wrapper.h>
-#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <zeek/reactor.h>
+
 namespace zeek {
 namespace {
-const int kPollTimeout{1000};
-const std::size_t kReadBufferSize{MAX_AUDIT_MESSAGE_LENGTH};
+const std::chrono::milliseconds kReadTimeout{1000};
 } // namespace
 
 struct AudispSocketReader::PrivateData final {
   std::string unix_socket_path;
   int socket{-1};
-  std::vector<char> read_buffer;
+
+  Reactor::Ref reactor;
+  EventNotifier::Ref interrupt_notifier;
 };
 
 Status AudispSocketReader::create(IAudispProducer::Ref &obj,
@@ -42,44 +44,65 @@ Status AudispSocketReader::create(IAudispProducer::Ref &obj,
 
 AudispSocketReader::~AudispSocketReader() { close(d->socket); }
 
-Status AudispSocketReader::read(std::string &buffer) {
-  buffer.reserve(kReadBufferSize);
+Status AudispSocketReader::read(RingBuffer &buffer) {
+  Reactor::DescriptorList ready_list;
+  auto status = d->reactor->wait(ready_list, kReadTimeout);
+  if (!status.succeeded()) {
+    return status;
+  }
 
-  struct pollfd pfd = {};
-  pfd.events = POLLIN;
-  pfd.fd = d->socket;
+  bool socket_ready{false};
 
-  auto err = poll(&pfd, 1, kPollTimeout);
-  if (err < 0) {
-    if (errno == EINTR) {
+  for (auto fd : ready_list) {
+    if (fd == d->interrupt_notifier->fd()) {
+      d->interrupt_notifier->reset();
       return Status::success();
     }
 
-    return Status::failure("poll() has failed with error " +
-                           std::to_string(err) + "/" + std::to_string(errno));
-
-  } else if (err == 0) {
-    return Status::success();
+    if (fd == d->socket) {
+      socket_ready = true;
+    }
   }
 
-  if ((pfd.revents & POLLIN) == 0) {
+  if (!socket_ready) {
     return Status::success();
   }
 
-  err = ::read(pfd.fd, d->read_buffer.data(), kReadBufferSize);
-  if (err <= 0) {
-    return Status::failure("read() has failed with error " +
+  // Batch the reads: keep going until the socket would block, so that
+  // bursts are acquired with as few reactor wakeups as possible
+  for (;;) {
+    RingBuffer::RegionList region_list;
+    auto region_count = buffer.writableRegions(region_list);
+    if (region_count == 0U) {
+      break;
+    }
+
+    auto err = ::readv(d->socket, region_list, static_cast<int>(region_count));
+    if (err > 0) {
+      buffer.commit(static_cast<std::size_t>(err));
+      continue;
+    }
+
+    if (err == -1 && errno == EINTR) {
+      continue;
+    }
+
+    if (err == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+
+    return Status::failure("readv() has failed with error " +
                            std::to_string(err) + "/" + std::to_string(errno));
   }
 
-  buffer.assign(d->read_buffer.data(), 0U, static_cast<std::size_t>(err));
   return Status::success();
 }
 
+void AudispSocketReader::interrupt() { d->interrupt_notifier->notify(); }
+
 AudispSocketReader::AudispSocketReader(const std::string &socket_path)
     : d(new PrivateData) {
   d->unix_socket_path = socket_path;
-  d->read_buffer.resize(kReadBufferSize + 1U);
 
   d->socket = socket(AF_UNIX, SOCK_STREAM, 0);
   if (d->socket == -1) {
@@ -94,5 +117,31 @@ AudispSocketReader::AudispSocketReader(const std::string &socket_path)
               sizeof(address)) != 0) {
     throw Status::failure("Connection failure");
   }
+
+  auto socket_flags = fcntl(d->socket, F_GETFL);
+  if (socket_flags == -1 ||
+      fcntl(d->socket, F_SETFL, socket_flags | O_NONBLOCK) == -1) {
+    throw Status::failure("Failed to make the socket non-blocking");
+  }
+
+  auto status = Reactor::create(d->reactor);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = EventNotifier::create(d->interrupt_notifier);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = d->reactor->addDescriptor(d->socket);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = d->reactor->addDescriptor(d->interrupt_notifier->fd());
+  if (!status.succeeded()) {
+    throw status;
+  }
 }
 } // namespace zeek
@@ -23,10 +23,15 @@ public:
   /// \brief Destructor
   virtual ~AudispSocketReader() override;
 
-  /// \brief Acquires new data from the Audisp socket
-  /// \param buffer Where the read data is stored
+  /// \brief Acquires new data from the Audisp socket. Once the socket is
+  ///        readable, it is drained until it would block or until the
+  ///        buffer is full
+  /// \param buffer Where the read data is appended
   /// \return A Status object
-  virtual Status read(std::string &buffer) override;
+  virtual Status read(RingBuffer &buffer) override;
+
+  /// \brief Wakes up a read() call that is waiting for data
+  virtual void interrupt() override;
 
 protected:
   /// \brief Constructor
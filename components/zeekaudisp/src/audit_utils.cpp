@@ -1,5 +1,8 @@
 #include "audit_utils.h"
 
+#include <cstring>
+#include <limits>
+
 namespace zeek {
 bool convertHexDigitToByte(char &output, const char &input) {
   if (input >= '0' && input <= '9') {
@@ -67,4 +70,203 @@ bool convertAuditString(std::string &output, const std::string &buffer) {
     return convertHexString(output, buffer);
   }
 }
+
+bool convertAuditInteger(std::int64_t &output, const char *buffer,
+                         int base) {
+  output = 0;
+
+  bool negative{false};
+  if (*buffer == '-') {
+    negative = true;
+    ++buffer;
+  }
+
+  // Out of range values are clamped, like std::strtoll does when it
+  // reports ERANGE; the magnitude of the lowest value is one higher
+  auto limit =
+      static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+
+  if (negative) {
+    ++limit;
+  }
+
+  auto max_digit = static_cast<char>('0' + base);
+  auto unsigned_base = static_cast<std::uint64_t>(base);
+  std::uint64_t value{0U};
+
+  auto first_digit = buffer;
+  for (; *buffer >= '0' && *buffer < max_digit; ++buffer) {
+    auto digit = static_cast<std::uint64_t>(*buffer - '0');
+
+    if (value > (limit - digit) / unsigned_base) {
+      value = limit;
+    } else {
+      value = value * unsigned_base + digit;
+    }
+  }
+
+  if (buffer == first_digit) {
+    return false;
+  }
+
+  if (!negative) {
+    output = static_cast<std::int64_t>(value);
+
+  } else if (value == limit) {
+    output = std::numeric_limits<std::int64_t>::min();
+
+  } else {
+    output = -static_cast<std::int64_t>(value);
+  }
+
+  return true;
+}
+
+bool decodeSockaddr(sockaddr_storage &output, std::size_t &size,
+                    std::string_view buffer) {
+  std::memset(&output, 0, sizeof(output));
+  size = 0U;
+
+  if ((buffer.size() % 2U) != 0U ||
+      buffer.size() / 2U > sizeof(sockaddr_storage)) {
+    return false;
+  }
+
+  auto output_buffer = reinterpret_cast<std::uint8_t *>(&output);
+  auto byte_count = buffer.size() / 2U;
+
+  for (std::size_t i = 0U; i < byte_count; ++i) {
+    char high_nibble{};
+    char low_nibble{};
+
+    if (!convertHexDigitToByte(high_nibble, buffer[i * 2U]) ||
+        !convertHexDigitToByte(low_nibble, buffer[i * 2U + 1U])) {
+      std::memset(&output, 0, sizeof(output));
+      return false;
+    }
+
+    output_buffer[i] = static_cast<std::uint8_t>((high_nibble << 4U) |
+                                                 low_nibble);
+  }
+
+  size = byte_count;
+  return true;
+}
+
+std::string_view formatIPv4Address(NetworkAddressBuffer &buffer,
+                                   const std::uint8_t *address) {
+  std::size_t size{0U};
+
+  for (std::size_t i = 0U; i < 4U; ++i) {
+    if (i != 0U) {
+      buffer[size++] = '.';
+    }
+
+    auto value = address[i];
+    if (value >= 100U) {
+      buffer[size++] = static_cast<char>('0' + value / 100U);
+    }
+
+    if (value >= 10U) {
+      buffer[size++] = static_cast<char>('0' + (value / 10U) % 10U);
+    }
+
+    buffer[size++] = static_cast<char>('0' + value % 10U);
+  }
+
+  return std::string_view(buffer.data(), size);
+}
+
+std::string_view formatIPv6Address(NetworkAddressBuffer &buffer,
+                                   const std::uint8_t *address) {
+  static const char kHexDigitList[] = "0123456789abcdef";
+
+  std::array<std::uint16_t, 8> group_list{};
+  for (std::size_t i = 0U; i < group_list.size(); ++i) {
+    group_list[i] = static_cast<std::uint16_t>((address[i * 2U] << 8U) |
+                                               address[i * 2U + 1U]);
+  }
+
+  // ::ffff:0:0/96 is printed with the IPv4 address in the last 32 bits
+  static const std::uint8_t kIPv4MappedPrefix[12] = {0, 0, 0, 0, 0, 0,
+                                                     0, 0, 0, 0, 0xFF, 0xFF};
+
+  bool ipv4_mapped =
+      std::memcmp(address, kIPv4MappedPrefix, sizeof(kIPv4MappedPrefix)) == 0;
+
+  auto group_count = ipv4_mapped ? 6U : 8U;
+
+  // Find the longest run of zero groups; the first one wins ties, and a
+  // single zero group is never shortened
+  std::size_t zero_run_start{group_count};
+  std::size_t zero_run_length{0U};
+
+  for (std::size_t i = 0U; i < group_count;) {
+    if (group_list[i] != 0U) {
+      ++i;
+      continue;
+    }
+
+    auto run_start = i;
+    while (i < group_count && group_list[i] == 0U) {
+      ++i;
+    }
+
+    auto run_length = i - run_start;
+    if (run_length > zero_run_length) {
+      zero_run_start = run_start;
+      zero_run_length = run_length;
+    }
+  }
+
+  if (zero_run_length < 2U) {
+    zero_run_start = group_count;
+    zero_run_length = 0U;
+  }
+
+  std::size_t size{0U};
+
+  for (std::size_t i = 0U; i < group_count; ++i) {
+    if (i == zero_run_start) {
+      buffer[size++] = ':';
+      buffer[size++] = ':';
+
+      i += zero_run_length - 1U;
+      continue;
+    }
+
+    if (size != 0U && buffer[size - 1U] != ':') {
+      buffer[size++] = ':';
+    }
+
+    auto group = group_list[i];
+    bool leading_zero{true};
+
+    for (int shift = 12; shift >= 0; shift -= 4) {
+      auto digit = (group >> shift) & 0x0FU;
+      if (digit == 0U && leading_zero && shift != 0) {
+        continue;
+      }
+
+      leading_zero = false;
+      buffer[size++] = kHexDigitList[digit];
+    }
+  }
+
+  if (ipv4_mapped) {
+    if (buffer[size - 1U] != ':') {
+      buffer[size++] = ':';
+    }
+
+    NetworkAddressBuffer ipv4_buffer;
+    auto ipv4_address = formatIPv4Address(ipv4_buffer, address + 12U);
+
+    std::memcpy(buffer.data() + size, ipv4_address.data(),
+                ipv4_address.size());
+
+    size += ipv4_address.size();
+  }
+
+  return std::string_view(buffer.data(), size);
+}
 } // namespace zeek
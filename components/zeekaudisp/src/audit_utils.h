@@ -1,6 +1,11 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
+
+#include <sys/socket.h>
 
 namespace zeek {
 /// \brief Converts a single hex digit to a byte value
@@ -20,4 +25,45 @@ bool convertHexString(std::string &output, const std::string &buffer);
 /// \param buffer Either a normal (but quoted) string, or a hex string
 /// \return True in case of success or false otherwise
 bool convertAuditString(std::string &output, const std::string &buffer);
+
+/// \brief Converts an Audit integer field. Like std::strtoll, conversion
+///        stops at the first character that is not a valid digit, and
+///        values out of range are clamped to the std::int64_t limits
+/// \param output Where the output value is stored; 0 if no digit was found
+/// \param buffer A null-terminated string, with an optional minus sign
+/// \param base Either 8 or 10
+/// \return True if at least one digit has been converted
+bool convertAuditInteger(std::int64_t &output, const char *buffer,
+                         int base = 10);
+
+/// \brief A buffer large enough for any address printed by
+///        formatIPv4Address and formatIPv6Address
+using NetworkAddressBuffer = std::array<char, 48>;
+
+/// \brief Decodes a hex encoded sockaddr structure, such as the saddr field
+///        of a SOCKADDR record, without going through a temporary string
+/// \param output Where the decoded structure is stored; the bytes past the
+///        decoded size are set to zero
+/// \param size Where the size of the decoded structure is stored
+/// \param buffer A hex string, at most twice as large as sockaddr_storage
+/// \return True in case of success or false otherwise
+bool decodeSockaddr(sockaddr_storage &output, std::size_t &size,
+                    std::string_view buffer);
+
+/// \brief Formats an IPv4 address in dotted decimal notation
+/// \param buffer Where the address is printed
+/// \param address The 4 address bytes, in network order
+/// \return A view over the printed address
+std::string_view formatIPv4Address(NetworkAddressBuffer &buffer,
+                                   const std::uint8_t *address);
+
+/// \brief Formats an IPv6 address in the canonical text representation
+///        defined by RFC 5952: lowercase digits, no leading zeros, the
+///        longest run of zero groups shortened to "::", and IPv4-mapped
+///        addresses printed with a dotted decimal suffix
+/// \param buffer Where the address is printed
+/// \param address The 16 address bytes, in network order
+/// \return A view over the printed address
+std::string_view formatIPv6Address(NetworkAddressBuffer &buffer,
+                                   const std::uint8_t *address);
 } // namespace zeek
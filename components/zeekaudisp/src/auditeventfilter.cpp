@@ -0,0 +1,491 @@
+#include "auditeventfilter.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+namespace zeek {
+namespace {
+using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+/// \brief The syscall names accepted by the filter rules, matching the
+///        ones shown in the tables
+// clang-format off
+const std::array<std::pair<const char *, SyscallType>, 11> kSyscallNameList = {{
+  { "execve", SyscallType::Execve },
+  { "execveat", SyscallType::ExecveAt },
+  { "fork", SyscallType::Fork },
+  { "vfork", SyscallType::VFork },
+  { "clone", SyscallType::Clone },
+  { "bind", SyscallType::Bind },
+  { "connect", SyscallType::Connect },
+  { "open", SyscallType::Open },
+  { "openat", SyscallType::OpenAt },
+  { "create", SyscallType::Create },
+  { "exit_group", SyscallType::Exit }
+}};
+// clang-format on
+
+/// \brief An IPv4 or IPv6 address, in network order
+struct NetworkAddress final {
+  /// \brief Either AF_INET or AF_INET6
+  int family{AF_UNSPEC};
+
+  /// \brief The address bytes; only the first 4 are used for IPv4
+  std::array<std::uint8_t, 16> bytes{};
+};
+
+/// \brief A compiled address condition
+struct AddressBlock final {
+  /// \brief The network address
+  NetworkAddress address;
+
+  /// \brief How many leading bits have to match
+  std::size_t prefix_length{0U};
+};
+
+/// \brief A rule, with its address condition already parsed
+struct CompiledRule final {
+  /// \brief The source rule
+  IAudispConsumer::FilterRule rule;
+
+  /// \brief The parsed address condition
+  std::optional<AddressBlock> address_block;
+
+  /// \brief True if the rule also needs the PATH or SOCKADDR records
+  bool needs_full_event{false};
+};
+
+/// \brief Parses the address of a filter rule. IPv6 addresses are also
+///        accepted as 16 colon-separated bytes, the format used by the
+///        socket_events table in earlier versions
+/// \param address Where the parsed address is stored
+/// \param buffer The address to parse
+/// \return True in case of success
+bool parseNetworkAddress(NetworkAddress &address, const std::string &buffer) {
+  address = {};
+
+  if (inet_pton(AF_INET, buffer.c_str(), address.bytes.data()) == 1) {
+    address.family = AF_INET;
+    return true;
+  }
+
+  if (inet_pton(AF_INET6, buffer.c_str(), address.bytes.data()) == 1) {
+    address.family = AF_INET6;
+    return true;
+  }
+
+  if (buffer.size() != 47U) {
+    return false;
+  }
+
+  for (std::size_t i = 0U; i < 16U; ++i) {
+    auto byte_string = buffer.substr(i * 3U, 2U);
+    if (i < 15U && buffer[i * 3U + 2U] != ':') {
+      return false;
+    }
+
+    char *end_ptr{nullptr};
+    auto value = std::strtoul(byte_string.c_str(), &end_ptr, 16);
+    if (end_ptr != byte_string.c_str() + 2U) {
+      return false;
+    }
+
+    address.bytes[i] = static_cast<std::uint8_t>(value);
+  }
+
+  address.family = AF_INET6;
+  return true;
+}
+
+/// \brief Parses an address condition, either a single address or a CIDR
+///        block
+/// \param address_block Where the parsed condition is stored
+/// \param buffer The condition to parse
+/// \return A Status object
+Status parseAddressBlock(AddressBlock &address_block,
+                         const std::string &buffer) {
+
+  address_block = {};
+
+  auto separator = buffer.find('/');
+  if (!parseNetworkAddress(address_block.address,
+                           buffer.substr(0U, separator))) {
+    return Status::failure("Invalid address in filter rule: " + buffer);
+  }
+
+  std::size_t max_prefix_length =
+      address_block.address.family == AF_INET ? 32U : 128U;
+
+  if (separator == std::string::npos) {
+    address_block.prefix_length = max_prefix_length;
+    return Status::success();
+  }
+
+  auto prefix_string = buffer.substr(separator + 1U);
+
+  char *end_ptr{nullptr};
+  auto prefix_length = std::strtoul(prefix_string.c_str(), &end_ptr, 10);
+  if (prefix_string.empty() || *end_ptr != 0 ||
+      prefix_length > max_prefix_length) {
+    return Status::failure("Invalid prefix length in filter rule: " + buffer);
+  }
+
+  address_block.prefix_length = prefix_length;
+  return Status::success();
+}
+
+/// \brief Matches an address against an address condition
+/// \param address_block The address condition
+/// \param address The address to match
+/// \return True if the address is inside the block
+bool matchAddressBlock(const AddressBlock &address_block,
+                       const NetworkAddress &address) {
+
+  if (address.family != address_block.address.family) {
+    return false;
+  }
+
+  auto full_byte_count = address_block.prefix_length / 8U;
+  if (std::memcmp(address.bytes.data(), address_block.address.bytes.data(),
+                  full_byte_count) != 0) {
+    return false;
+  }
+
+  auto remaining_bit_count = address_block.prefix_length % 8U;
+  if (remaining_bit_count == 0U) {
+    return true;
+  }
+
+  auto mask = static_cast<std::uint8_t>(0xFFU << (8U - remaining_bit_count));
+
+  return (address.bytes[full_byte_count] & mask) ==
+         (address_block.address.bytes[full_byte_count] & mask);
+}
+
+/// \brief Matches the conditions that only need the SYSCALL record
+/// \param rule The filter rule
+/// \param syscall_data The parsed SYSCALL record
+/// \return True if all the SYSCALL conditions match
+bool matchSyscallConditions(
+    const IAudispConsumer::FilterRule &rule,
+    const IAudispConsumer::SyscallRecordData &syscall_data) {
+
+  if (rule.syscall.has_value() && rule.syscall.value() != syscall_data.type) {
+    return false;
+  }
+
+  if (rule.uid.has_value() && rule.uid.value() != syscall_data.uid) {
+    return false;
+  }
+
+  if (rule.auid.has_value() && rule.auid.value() != syscall_data.auid) {
+    return false;
+  }
+
+  if (rule.exe.has_value() && rule.exe.value() != syscall_data.exe) {
+    return false;
+  }
+
+  return true;
+}
+
+/// \brief Matches the conditions on the PATH and SOCKADDR records
+/// \param compiled_rule The filter rule
+/// \param audit_event The parsed event
+/// \return True if all the record conditions match
+bool matchRecordConditions(const CompiledRule &compiled_rule,
+                           const IAudispConsumer::AuditEvent &audit_event) {
+
+  const auto &rule = compiled_rule.rule;
+
+  if (rule.path_prefix.has_value()) {
+    if (!audit_event.path_data.has_value()) {
+      return false;
+    }
+
+    const auto &path_prefix = rule.path_prefix.value();
+
+    bool path_found{false};
+    for (const auto &path_record : audit_event.path_data.value()) {
+      if (path_record.path.compare(0U, path_prefix.size(), path_prefix) ==
+          0) {
+        path_found = true;
+        break;
+      }
+    }
+
+    if (!path_found) {
+      return false;
+    }
+  }
+
+  if (compiled_rule.address_block.has_value()) {
+    if (!audit_event.sockaddr_data.has_value() ||
+        !audit_event.sockaddr_data->address_bytes.has_value()) {
+      return false;
+    }
+
+    const auto &sockaddr_data = audit_event.sockaddr_data.value();
+
+    NetworkAddress address;
+    address.family = static_cast<int>(sockaddr_data.family);
+    address.bytes = sockaddr_data.address_bytes.value();
+
+    if (!matchAddressBlock(compiled_rule.address_block.value(), address)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+} // namespace
+
+struct AuditEventFilter::PrivateData final {
+  PrivateData(std::size_t rule_count) : match_counter_list(rule_count) {}
+
+  std::vector<CompiledRule> rule_list;
+  std::vector<std::atomic<std::uint64_t>> match_counter_list;
+};
+
+Status
+AuditEventFilter::create(Ref &obj,
+                         const IAudispConsumer::FilterRuleList &rule_list) {
+  obj.reset();
+
+  try {
+    auto ptr = new AuditEventFilter(rule_list);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AuditEventFilter::~AuditEventFilter() {}
+
+AuditEventFilter::Decision AuditEventFilter::matchSyscall(
+    const IAudispConsumer::SyscallRecordData &syscall_data) {
+
+  for (std::size_t i = 0U; i < d->rule_list.size(); ++i) {
+    const auto &compiled_rule = d->rule_list[i];
+    if (!matchSyscallConditions(compiled_rule.rule, syscall_data)) {
+      continue;
+    }
+
+    // This rule may still match; the ones that follow can't be evaluated
+    // before knowing whether it does
+    if (compiled_rule.needs_full_event) {
+      return Decision::Undecided;
+    }
+
+    d->match_counter_list[i].fetch_add(1U, std::memory_order_relaxed);
+
+    return compiled_rule.rule.action ==
+                   IAudispConsumer::FilterRule::Action::Include
+               ? Decision::Accept
+               : Decision::Reject;
+  }
+
+  return Decision::Accept;
+}
+
+bool AuditEventFilter::matchEvent(
+    const IAudispConsumer::AuditEvent &audit_event) {
+
+  for (std::size_t i = 0U; i < d->rule_list.size(); ++i) {
+    const auto &compiled_rule = d->rule_list[i];
+
+    if (!matchSyscallConditions(compiled_rule.rule,
+                                audit_event.syscall_data) ||
+        !matchRecordConditions(compiled_rule, audit_event)) {
+      continue;
+    }
+
+    d->match_counter_list[i].fetch_add(1U, std::memory_order_relaxed);
+
+    return compiled_rule.rule.action ==
+           IAudispConsumer::FilterRule::Action::Include;
+  }
+
+  return true;
+}
+
+void AuditEventFilter::getCounters(
+    IAudispConsumer::FilterRuleCounterList &counter_list) const {
+
+  counter_list = {};
+
+  for (std::size_t i = 0U; i < d->rule_list.size(); ++i) {
+    IAudispConsumer::FilterRuleCounter counter;
+    counter.rule = describeFilterRule(d->rule_list[i].rule);
+    counter.match_count =
+        d->match_counter_list[i].load(std::memory_order_relaxed);
+
+    counter_list.push_back(std::move(counter));
+  }
+}
+
+AuditEventFilter::AuditEventFilter(
+    const IAudispConsumer::FilterRuleList &rule_list)
+    : d(new PrivateData(rule_list.size())) {
+
+  for (const auto &rule : rule_list) {
+    CompiledRule compiled_rule;
+    compiled_rule.rule = rule;
+
+    if (rule.address.has_value()) {
+      AddressBlock address_block;
+      auto status = parseAddressBlock(address_block, rule.address.value());
+      if (!status.succeeded()) {
+        throw status;
+      }
+
+      compiled_rule.address_block = std::move(address_block);
+    }
+
+    compiled_rule.needs_full_event =
+        rule.path_prefix.has_value() || rule.address.has_value();
+
+    d->rule_list.push_back(std::move(compiled_rule));
+  }
+}
+
+std::string describeFilterRule(const IAudispConsumer::FilterRule &rule) {
+  std::stringstream output;
+  output << (rule.action == IAudispConsumer::FilterRule::Action::Include
+                 ? "include"
+                 : "exclude");
+
+  if (rule.syscall.has_value()) {
+    for (const auto &p : kSyscallNameList) {
+      if (p.second == rule.syscall.value()) {
+        output << " syscall=" << p.first;
+        break;
+      }
+    }
+  }
+
+  if (rule.exe.has_value()) {
+    output << " exe=" << rule.exe.value();
+  }
+
+  if (rule.path_prefix.has_value()) {
+    output << " path_prefix=" << rule.path_prefix.value();
+  }
+
+  if (rule.uid.has_value()) {
+    output << " uid=" << rule.uid.value();
+  }
+
+  if (rule.auid.has_value()) {
+    output << " auid=" << rule.auid.value();
+  }
+
+  if (rule.address.has_value()) {
+    output << " address=" << rule.address.value();
+  }
+
+  return output.str();
+}
+
+Status IAudispConsumer::parseFilterRule(FilterRule &rule,
+                                        const std::string &rule_string) {
+  rule = {};
+
+  std::stringstream input(rule_string);
+
+  std::string action;
+  input >> action;
+
+  if (action == "include") {
+    rule.action = FilterRule::Action::Include;
+
+  } else if (action == "exclude") {
+    rule.action = FilterRule::Action::Exclude;
+
+  } else {
+    return Status::failure("Invalid action in filter rule: " + rule_string);
+  }
+
+  bool condition_found{false};
+
+  for (std::string condition; input >> condition;) {
+    auto separator = condition.find('=');
+    if (separator == std::string::npos || separator == 0U ||
+        separator + 1U == condition.size()) {
+      return Status::failure("Invalid condition in filter rule: " +
+                             rule_string);
+    }
+
+    auto key = condition.substr(0U, separator);
+    auto value = condition.substr(separator + 1U);
+
+    if (key == "exe") {
+      rule.exe = value;
+
+    } else if (key == "path_prefix") {
+      rule.path_prefix = value;
+
+    } else if (key == "uid" || key == "auid") {
+      char *end_ptr{nullptr};
+      auto id = std::strtoll(value.c_str(), &end_ptr, 10);
+      if (*end_ptr != 0) {
+        return Status::failure("Invalid " + key +
+                               " value in filter rule: " + rule_string);
+      }
+
+      if (key == "uid") {
+        rule.uid = static_cast<std::int64_t>(id);
+      } else {
+        rule.auid = static_cast<std::int64_t>(id);
+      }
+
+    } else if (key == "syscall") {
+      for (const auto &p : kSyscallNameList) {
+        if (value == p.first) {
+          rule.syscall = p.second;
+          break;
+        }
+      }
+
+      if (!rule.syscall.has_value()) {
+        return Status::failure("Invalid syscall name in filter rule: " +
+                               rule_string);
+      }
+
+    } else if (key == "address") {
+      AddressBlock address_block;
+      auto status = parseAddressBlock(address_block, value);
+      if (!status.succeeded()) {
+        return status;
+      }
+
+      rule.address = value;
+
+    } else {
+      return Status::failure("Invalid condition in filter rule: " +
+                             rule_string);
+    }
+
+    condition_found = true;
+  }
+
+  if (!condition_found) {
+    return Status::failure("The filter rule has no conditions: " +
+                           rule_string);
+  }
+
+  return Status::success();
+}
+} // namespace zeek
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+
+#include <zeek/iaudispconsumer.h>
+
+namespace zeek {
+/// \brief Applies the event filter rules. Events are first matched against
+///        the SYSCALL record alone, so that most of them can be discarded
+///        before the remaining records are parsed
+class AuditEventFilter final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to an AuditEventFilter object
+  using Ref = std::unique_ptr<AuditEventFilter>;
+
+  /// \brief The result of matching the SYSCALL record
+  enum class Decision {
+    /// \brief The event is kept
+    Accept,
+
+    /// \brief The event is discarded
+    Reject,
+
+    /// \brief The first candidate rule also needs the PATH or SOCKADDR
+    ///        records; call matchEvent() once the event has been parsed
+    Undecided
+  };
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param rule_list The filter rules, in evaluation order
+  /// \return A Status object
+  static Status create(Ref &obj,
+                       const IAudispConsumer::FilterRuleList &rule_list);
+
+  /// \brief Destructor
+  ~AuditEventFilter();
+
+  /// \brief Matches the rules against the SYSCALL record
+  /// \param syscall_data The parsed SYSCALL record
+  /// \return The filter decision
+  Decision matchSyscall(const IAudispConsumer::SyscallRecordData &syscall_data);
+
+  /// \brief Matches the rules against a fully parsed event
+  /// \param audit_event The event to match
+  /// \return True if the event should be kept
+  bool matchEvent(const IAudispConsumer::AuditEvent &audit_event);
+
+  /// \brief Returns how many events each rule has matched. This method can
+  ///        be called from any thread
+  /// \param counter_list Where the counters are stored
+  void getCounters(IAudispConsumer::FilterRuleCounterList &counter_list) const;
+
+  AuditEventFilter(const AuditEventFilter &) = delete;
+  AuditEventFilter &operator=(const AuditEventFilter &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param rule_list The filter rules, in evaluation order
+  AuditEventFilter(const IAudispConsumer::FilterRuleList &rule_list);
+};
+
+/// \brief Returns the text form of the given filter rule
+/// \param rule The filter rule
+/// \return The rule, in the same format accepted by parseFilterRule
+std::string describeFilterRule(const IAudispConsumer::FilterRule &rule);
+} // namespace zeek
@@ -57,6 +57,10 @@ int AuparseInterface::firstRecord() {
 
 int AuparseInterface::getType() { return auparse_get_type(d->auparse_state); }
 
+unsigned long AuparseInterface::getSerial() {
+  return auparse_get_serial(d->auparse_state);
+}
+
 int AuparseInterface::nextRecord() {
   return auparse_next_record(d->auparse_state);
 }
@@ -24,6 +24,7 @@ public:
   virtual int nextField() override;
   virtual int firstRecord() override;
   virtual int getType() override;
+  virtual unsigned long getSerial() override;
   virtual int nextRecord() override;
   virtual int nextEvent() override;
 
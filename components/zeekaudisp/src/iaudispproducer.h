@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ringbuffer.h"
+
 #include <memory>
 
 #include <auparse.h>
@@ -19,9 +21,13 @@ public:
   virtual ~IAudispProducer() = default;
 
   /// \brief Acquires new data from the Audisp socket
-  /// \param buffer Where the read data is stored
+  /// \param buffer Where the read data is appended
   /// \return A Status object
-  virtual Status read(std::string &buffer) = 0;
+  virtual Status read(RingBuffer &buffer) = 0;
+
+  /// \brief Wakes up a read() call that is waiting for data. This method
+  ///        can be called from any thread
+  virtual void interrupt() = 0;
 
   IAudispProducer(const IAudispProducer &other) = delete;
   IAudispProducer &operator=(const IAudispProducer &other) = delete;
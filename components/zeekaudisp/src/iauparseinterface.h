@@ -19,6 +19,7 @@ public:
   virtual int nextField() = 0;
   virtual int firstRecord() = 0;
   virtual int getType() = 0;
+  virtual unsigned long getSerial() = 0;
   virtual int nextRecord() = 0;
   virtual int nextEvent() = 0;
 
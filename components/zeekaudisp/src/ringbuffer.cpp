@@ -0,0 +1,112 @@
+#include "ringbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <zeek/status.h>
+
+namespace zeek {
+RingBuffer::RingBuffer(std::size_t capacity) {
+  if (capacity == 0U) {
+    throw Status::failure("Invalid ring buffer capacity");
+  }
+
+  buffer.resize(capacity);
+}
+
+std::size_t RingBuffer::capacity() const { return buffer.size(); }
+
+std::size_t RingBuffer::size() const {
+  return static_cast<std::size_t>(
+      write_position.load(std::memory_order_acquire) -
+      read_position.load(std::memory_order_acquire));
+}
+
+std::size_t RingBuffer::freeSpace() const { return buffer.size() - size(); }
+
+std::size_t RingBuffer::writableRegions(RegionList &region_list) {
+  auto current_write_position = write_position.load(std::memory_order_relaxed);
+  auto used_size = static_cast<std::size_t>(
+      current_write_position - read_position.load(std::memory_order_acquire));
+
+  auto free_space = buffer.size() - used_size;
+  if (free_space == 0U) {
+    return 0U;
+  }
+
+  auto write_index =
+      static_cast<std::size_t>(current_write_position % buffer.size());
+  auto first_size = std::min(free_space, buffer.size() - write_index);
+
+  region_list[0].iov_base = buffer.data() + write_index;
+  region_list[0].iov_len = first_size;
+
+  if (first_size == free_space) {
+    return 1U;
+  }
+
+  region_list[1].iov_base = buffer.data();
+  region_list[1].iov_len = free_space - first_size;
+
+  return 2U;
+}
+
+void RingBuffer::commit(std::size_t size) {
+  size = std::min(size, freeSpace());
+  write_position.fetch_add(size, std::memory_order_release);
+}
+
+std::size_t RingBuffer::readableRegions(RegionList &region_list) const {
+  auto current_read_position = read_position.load(std::memory_order_relaxed);
+  auto used_size = static_cast<std::size_t>(
+      write_position.load(std::memory_order_acquire) - current_read_position);
+
+  if (used_size == 0U) {
+    return 0U;
+  }
+
+  // iovec has no const variant; the regions are only meant to be read
+  auto data = const_cast<char *>(buffer.data());
+  auto read_index =
+      static_cast<std::size_t>(current_read_position % buffer.size());
+  auto first_size = std::min(used_size, buffer.size() - read_index);
+
+  region_list[0].iov_base = data + read_index;
+  region_list[0].iov_len = first_size;
+
+  if (first_size == used_size) {
+    return 1U;
+  }
+
+  region_list[1].iov_base = data;
+  region_list[1].iov_len = used_size - first_size;
+
+  return 2U;
+}
+
+std::uint64_t RingBuffer::committedByteCount() const {
+  return write_position.load(std::memory_order_acquire);
+}
+
+void RingBuffer::consume(std::size_t size) {
+  size = std::min(size, this->size());
+  read_position.fetch_add(size, std::memory_order_release);
+}
+
+std::size_t RingBuffer::write(const char *data, std::size_t size) {
+  RegionList region_list;
+  auto region_count = writableRegions(region_list);
+
+  std::size_t written_bytes{0U};
+
+  for (std::size_t i = 0U; i < region_count && written_bytes < size; ++i) {
+    auto chunk_size = std::min(region_list[i].iov_len, size - written_bytes);
+    std::memcpy(region_list[i].iov_base, data + written_bytes, chunk_size);
+
+    written_bytes += chunk_size;
+  }
+
+  commit(written_bytes);
+  return written_bytes;
+}
+} // namespace zeek
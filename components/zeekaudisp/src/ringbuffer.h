@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace zeek {
+/// \brief A fixed-size byte ring buffer. Both the free and the used space
+///        are exposed as (at most) two contiguous regions, so that they can
+///        be filled with readv() and consumed in place. One thread can
+///        write (writableRegions, commit, write) while another one reads
+///        (readableRegions, consume) without locking
+class RingBuffer final {
+public:
+  /// \brief A list of contiguous regions; only the first entries returned
+  ///        by writableRegions() and readableRegions() are valid
+  using RegionList = struct iovec[2];
+
+  /// \brief Constructor
+  /// \param capacity How many bytes the buffer can hold
+  RingBuffer(std::size_t capacity);
+
+  RingBuffer(const RingBuffer &) = delete;
+  RingBuffer &operator=(const RingBuffer &) = delete;
+
+  /// \return How many bytes the buffer can hold
+  std::size_t capacity() const;
+
+  /// \return How many bytes are waiting to be consumed
+  std::size_t size() const;
+
+  /// \return How many bytes can be written before the buffer is full
+  std::size_t freeSpace() const;
+
+  /// \brief Returns the free space, starting from the write position
+  /// \param region_list Where the regions are stored
+  /// \return How many regions have been stored (0, 1 or 2)
+  std::size_t writableRegions(RegionList &region_list);
+
+  /// \brief Marks the given amount of bytes as written
+  /// \param size How many bytes have been written in the writable regions
+  void commit(std::size_t size);
+
+  /// \brief Returns the data waiting to be consumed, in order
+  /// \param region_list Where the regions are stored
+  /// \return How many regions have been stored (0, 1 or 2)
+  std::size_t readableRegions(RegionList &region_list) const;
+
+  /// \brief Releases the given amount of bytes from the read position
+  /// \param size How many bytes have been consumed
+  void consume(std::size_t size);
+
+  /// \return How many bytes have been committed since the buffer was
+  ///         created
+  std::uint64_t committedByteCount() const;
+
+  /// \brief Copies the given data into the buffer
+  /// \param data The data to copy
+  /// \param size The size of the data
+  /// \return How many bytes have been written, which is less than the
+  ///         given size when the buffer becomes full
+  std::size_t write(const char *data, std::size_t size);
+
+private:
+  /// \brief The buffer storage
+  std::vector<char> buffer;
+
+  /// \brief How many bytes have been consumed so far, owned by the reader
+  std::atomic<std::uint64_t> read_position{0U};
+
+  /// \brief How many bytes have been committed so far, owned by the writer
+  std::atomic<std::uint64_t> write_position{0U};
+};
+} // namespace zeek
@@ -0,0 +1,22 @@
+#include "stagesignal.h"
+
+namespace zeek {
+void StageSignal::notify() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    signaled = true;
+  }
+
+  signal_cv.notify_one();
+}
+
+bool StageSignal::wait(const std::chrono::milliseconds &timeout) {
+  std::unique_lock<std::mutex> lock(mutex);
+
+  auto succeeded =
+      signal_cv.wait_for(lock, timeout, [this]() { return signaled; });
+
+  signaled = false;
+  return succeeded;
+}
+} // namespace zeek
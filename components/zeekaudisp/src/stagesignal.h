@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace zeek {
+/// \brief Wakes up a pipeline stage that is waiting for work. A signal sent
+///        while the stage is busy is kept, so that its next wait() returns
+///        immediately instead of missing the new work
+class StageSignal final {
+public:
+  /// \brief Constructor
+  StageSignal() = default;
+
+  StageSignal(const StageSignal &) = delete;
+  StageSignal &operator=(const StageSignal &) = delete;
+
+  /// \brief Wakes up the waiting stage. This method can be called from any
+  ///        thread
+  void notify();
+
+  /// \brief Waits until notify() is called, or the timeout expires, and
+  ///        then clears the signal
+  /// \param timeout How long to wait at most
+  /// \return True if the stage has been signaled
+  bool wait(const std::chrono::milliseconds &timeout);
+
+private:
+  /// \brief Guards the signaled flag
+  std::mutex mutex;
+
+  /// \brief Used to wake up the waiting stage
+  std::condition_variable signal_cv;
+
+  /// \brief Whether notify() has been called since the last wait()
+  bool signaled{false};
+};
+} // namespace zeek
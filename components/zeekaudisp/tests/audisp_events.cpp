@@ -122,5 +122,71 @@ SCENARIO("AudispConsumer event parsers", "[AudispConsumer]") {
       }
     }
   }
+
+  GIVEN("a full execve event and the native parser") {
+    // clang-format off
+    static const std::string kExecveEvent = "type=SYSCALL msg=audit(1572891138.674:28907): arch=c000003e syscall=59 success=yes exit=0 a0=7ffddc903cc0 a1=7f4e2c51a940 a2=55989bc751c0 a3=8 items=2 ppid=11413 pid=11414 auid=4294967295 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=pts1 ses=4294967295 comm=\"cat\" exe=\"/bin/cat\" key=(null)\ntype=EXECVE msg=audit(1572891138.674:28907): argc=2 a0=\"cat\" a1=\"--version\"\ntype=CWD msg=audit(1572891138.674:28907): cwd=\"/var/log/audit\"\ntype=PATH msg=audit(1572891138.674:28907): item=0 name=\"/bin/cat\" inode=5689 dev=00:18 mode=0100755 ouid=0 ogid=0 rdev=00:00 nametype=NORMAL cap_fp=0000000000000000 cap_fi=0000000000000000 cap_fe=0 cap_fver=0\ntype=PATH msg=audit(1572891138.674:28907): item=1 name=\"/lib64/ld-linux-x86-64.so.2\" inode=6763 dev=00:18 mode=0100755 ouid=0 ogid=0 rdev=00:00 nametype=NORMAL cap_fp=0000000000000000 cap_fi=0000000000000000 cap_fe=0 cap_fver=0\ntype=PROCTITLE msg=audit(1572891138.674:28907): proctitle=636174002D2D76657273696F6E\ntype=EOE msg=audit(1572891138.674:28907): \n";
+    // clang-format on
+
+    IAudispConsumer::Ref audisp_consumer;
+
+    {
+      IAudispProducer::Ref audisp_producer;
+      auto status = MockedAudispProducer::create(audisp_producer, kExecveEvent);
+      REQUIRE(status.succeeded());
+
+      status = AudispConsumer::createWithProducer(
+          audisp_consumer, std::move(audisp_producer),
+          IAudispConsumer::Parser::Native);
+
+      audisp_producer = {};
+
+      REQUIRE(status.succeeded());
+    }
+
+    WHEN("processing the event") {
+      // The EOE record completes the event, so there is no need to wait
+      auto status = audisp_consumer->processEvents();
+      REQUIRE(status.succeeded());
+
+      THEN("the event is returned with all its records") {
+        AudispConsumer::AuditEventList event_list;
+        status = audisp_consumer->getEvents(event_list);
+        REQUIRE(status.succeeded());
+
+        REQUIRE(event_list.size() == 1U);
+
+        const auto &event = event_list.at(0);
+        REQUIRE(event.serial == 28907U);
+        REQUIRE(event.execve_data.has_value());
+        REQUIRE(event.path_data.has_value());
+        REQUIRE(event.cwd_data.has_value());
+        REQUIRE(!event.sockaddr_data.has_value());
+
+        const auto &syscall_record = event.syscall_data;
+        REQUIRE(syscall_record.type ==
+                IAudispConsumer::SyscallRecordData::Type::Execve);
+
+        REQUIRE(syscall_record.process_id == 11414);
+        REQUIRE(syscall_record.parent_process_id == 11413);
+        REQUIRE(syscall_record.auid == 4294967295);
+        REQUIRE(syscall_record.exe == "/bin/cat");
+        REQUIRE(syscall_record.succeeded);
+
+        const auto &execve_record = event.execve_data.value();
+        REQUIRE(execve_record.argc == 2);
+        REQUIRE(execve_record.argument_list.size() == 2U);
+        REQUIRE(execve_record.argument_list.at(0) == "cat");
+        REQUIRE(execve_record.argument_list.at(1) == "--version");
+
+        const auto &path_record = event.path_data.value();
+        REQUIRE(path_record.size() == 2U);
+        REQUIRE(path_record.at(0).path == "/bin/cat");
+        REQUIRE(path_record.at(0).mode == 0100755);
+
+        REQUIRE(event.cwd_data.value() == "/var/log/audit");
+      }
+    }
+  }
 }
 } // namespace zeek
@@ -3,6 +3,8 @@
 
 #include <catch2/catch.hpp>
 
+#include <sys/socket.h>
+
 namespace zeek {
 SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
   GIVEN("a valid AUDIT_SYSCALL record for an execve event") {
@@ -77,6 +79,50 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     }
   }
 
+  GIVEN("an AUDIT_SYSCALL record for an exit_group event") {
+    // clang-format off
+    static const MockedAuparseInterface::FieldList kAuditSyscallRecord = {
+      { "type", "1300" },
+      { "arch", "c000003e" },
+      { "syscall", "231" },
+      { "a0", "0" },
+      { "a1", "3c" },
+      { "a2", "0" },
+      { "a3", "7f4e2c51a940" },
+      { "items", "0" },
+      { "ppid", "6882" },
+      { "pid", "7841" },
+      { "auid", "1000" },
+      { "uid", "1000" },
+      { "gid", "1000" },
+      { "euid", "1000" },
+      { "egid", "1000" },
+      { "comm", "\"sh\"" },
+      { "exe", "\"/usr/bin/bash\"" },
+      { "key", "(null)" }
+    };
+    // clang-format on
+
+    MockedAuparseInterface::Ref auparse;
+    auto status = MockedAuparseInterface::create(auparse, kAuditSyscallRecord);
+    REQUIRE(status.succeeded());
+
+    WHEN("parsing the event record") {
+      std::optional<AudispConsumer::SyscallRecordData> optional_data;
+      status = AudispConsumer::parseSyscallRecord(optional_data, auparse);
+
+      THEN("the missing success and exit fields are accepted") {
+        REQUIRE(status.succeeded());
+        REQUIRE(optional_data.has_value());
+
+        const auto &data = optional_data.value();
+        REQUIRE(data.type == AudispConsumer::SyscallRecordData::Type::Exit);
+        REQUIRE(data.process_id == 7841);
+        REQUIRE(data.parent_process_id == 6882);
+      }
+    }
+  }
+
   GIVEN("a list of AUDIT_EXECVE records with split arguments") {
     // clang-format off
     static const MockedAuparseInterface::FieldList kAuditExecveRecord01 = {
@@ -133,7 +179,7 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
       }
 
       REQUIRE(raw_execve_record.argc == 4);
-      REQUIRE(raw_execve_record.argument_list.size() == 5U);
+      REQUIRE(raw_execve_record.argument_list.size() == 4U);
 
       AudispConsumer::ExecveRecordData execve_record;
       auto status = AudispConsumer::processExecveRecords(execve_record,
@@ -149,10 +195,131 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
         REQUIRE(execve_record.argument_list.at(1U) == "arg_1");
         REQUIRE(execve_record.argument_list.at(2U) == "arg_2");
         REQUIRE(execve_record.argument_list.at(3U) == "arg_3");
+        REQUIRE(!execve_record.truncated);
+      }
+    }
+  }
+
+  GIVEN("an AUDIT_EXECVE record with more than ten arguments") {
+    MockedAuparseInterface::FieldList execve_record_fields = {
+        {"type", "1309"}, {"argc", "12"}};
+
+    for (auto i = 0U; i < 12U; ++i) {
+      auto index = std::to_string(i);
+      execve_record_fields.push_back({"a" + index, "\"arg_" + index + "\""});
+    }
+
+    MockedAuparseInterface::Ref auparse;
+    auto status = MockedAuparseInterface::create(auparse, execve_record_fields);
+    REQUIRE(status.succeeded());
+
+    WHEN("parsing and assembling the record") {
+      AudispConsumer::RawExecveRecordData raw_execve_record;
+      status = AudispConsumer::parseRawExecveRecord(raw_execve_record, auparse);
+      REQUIRE(status.succeeded());
+
+      AudispConsumer::ExecveRecordData execve_record;
+      status = AudispConsumer::processExecveRecords(execve_record,
+                                                    raw_execve_record);
+      REQUIRE(status.succeeded());
+
+      THEN("the arguments keep their numeric order") {
+        REQUIRE(execve_record.argument_list.size() == 12U);
+
+        for (auto i = 0U; i < 12U; ++i) {
+          REQUIRE(execve_record.argument_list.at(i) ==
+                  "arg_" + std::to_string(i));
+        }
+      }
+    }
+  }
+
+  GIVEN("an AUDIT_EXECVE record that exceeds the configured limits") {
+    // clang-format off
+    static const MockedAuparseInterface::FieldList kAuditExecveRecord = {
+      { "type", "1309" },
+      { "argc", "4" },
+      { "a0", "\"gcc\"" },
+      { "a1_len", "16" },
+      { "a1[0]", "\"-DVALUE\"" },
+      { "a1[1]", "\"=ABCDEF\"" },
+      { "a2", "\"-c\"" },
+      { "a3", "\"main.c\"" }
+    };
+    // clang-format on
+
+    MockedAuparseInterface::Ref auparse;
+    auto status = MockedAuparseInterface::create(auparse, kAuditExecveRecord);
+    REQUIRE(status.succeeded());
+
+    AudispConsumer::ExecveLimits execve_limits;
+    AudispConsumer::RawExecveRecordData raw_execve_record;
+
+    WHEN("only the argument count is limited") {
+      execve_limits.max_argument_count = 3U;
+      execve_limits.max_command_line_size = 0U;
+
+      status = AudispConsumer::parseRawExecveRecord(raw_execve_record, auparse,
+                                                    execve_limits);
+      REQUIRE(status.succeeded());
+
+      AudispConsumer::ExecveRecordData execve_record;
+      status = AudispConsumer::processExecveRecords(execve_record,
+                                                    raw_execve_record);
+      REQUIRE(status.succeeded());
+
+      THEN("the extra arguments are discarded") {
+        REQUIRE(execve_record.argc == 4);
+        REQUIRE(execve_record.truncated);
+
+        REQUIRE(execve_record.argument_list ==
+                std::vector<std::string>{"gcc", "-DVALUE=ABCDEF", "-c"});
+      }
+    }
+
+    WHEN("only the command line size is limited") {
+      execve_limits.max_argument_count = 0U;
+      execve_limits.max_command_line_size = 10U;
+
+      status = AudispConsumer::parseRawExecveRecord(raw_execve_record, auparse,
+                                                    execve_limits);
+      REQUIRE(status.succeeded());
+
+      AudispConsumer::ExecveRecordData execve_record;
+      status = AudispConsumer::processExecveRecords(execve_record,
+                                                    raw_execve_record);
+      REQUIRE(status.succeeded());
+
+      THEN("the arguments are cut once the limit is reached") {
+        REQUIRE(execve_record.truncated);
+
+        REQUIRE(execve_record.argument_list ==
+                std::vector<std::string>{"gcc", "-DVALUE", "", ""});
       }
     }
   }
 
+  GIVEN("an AUDIT_EXECVE record with out of order arguments") {
+    // clang-format off
+    static const MockedAuparseInterface::FieldList kAuditExecveRecord = {
+      { "type", "1309" },
+      { "argc", "3" },
+      { "a0", "\"ls\"" },
+      { "a2", "\"-l\"" }
+    };
+    // clang-format on
+
+    MockedAuparseInterface::Ref auparse;
+    auto status = MockedAuparseInterface::create(auparse, kAuditExecveRecord);
+    REQUIRE(status.succeeded());
+
+    THEN("parsing fails") {
+      AudispConsumer::RawExecveRecordData raw_execve_record;
+      status = AudispConsumer::parseRawExecveRecord(raw_execve_record, auparse);
+      REQUIRE(!status.succeeded());
+    }
+  }
+
   GIVEN("a valid AUDIT_CWD record") {
     static const std::string kCwdFolderPath{"/path/to/folder"};
 
@@ -298,7 +465,8 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     static const AudispConsumer::SockaddrRecordData kExpectedAuditSockaddrRecord01 = {
       2,
       8080,
-      "127.0.0.1"
+      "127.0.0.1",
+      {}
     };
     // clang-format on
 
@@ -313,7 +481,8 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     static const AudispConsumer::SockaddrRecordData kExpectedAuditSockaddrRecord02 = {
       1,
       0,
-      "/dev/log"
+      "/dev/log",
+      {}
     };
     // clang-format on
 
@@ -328,7 +497,40 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     static const AudispConsumer::SockaddrRecordData kExpectedAuditSockaddrRecord03 = {
       1,
       0,
-      "/var/run/nscd/socket"
+      "/var/run/nscd/socket",
+      {}
+    };
+    // clang-format on
+
+    // clang-format off
+    static const MockedAuparseInterface::FieldList kAuditSockaddrRecord04 = {
+      { "type", "1306" },
+      { "saddr", "0A0000500000000020010DB800000000000000000000000100000000" }
+    };
+    // clang-format on
+
+    // clang-format off
+    static const AudispConsumer::SockaddrRecordData kExpectedAuditSockaddrRecord04 = {
+      10,
+      80,
+      "2001:db8::1",
+      {}
+    };
+    // clang-format on
+
+    // clang-format off
+    static const MockedAuparseInterface::FieldList kAuditSockaddrRecord05 = {
+      { "type", "1306" },
+      { "saddr", "0A0001BB0000000000000000000000000000FFFFC0A80001" }
+    };
+    // clang-format on
+
+    // clang-format off
+    static const AudispConsumer::SockaddrRecordData kExpectedAuditSockaddrRecord05 = {
+      10,
+      443,
+      "::ffff:192.168.0.1",
+      {}
     };
     // clang-format on
 
@@ -336,7 +538,9 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     static const std::vector<MockedAuparseInterface::FieldList> kAuditSockaddrRecordList = {
       kAuditSockaddrRecord01,
       kAuditSockaddrRecord02,
-      kAuditSockaddrRecord03
+      kAuditSockaddrRecord03,
+      kAuditSockaddrRecord04,
+      kAuditSockaddrRecord05
     };
     // clang-format on
 
@@ -344,7 +548,9 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
     static const std::vector<AudispConsumer::SockaddrRecordData> kExpectedAuditSockaddrRecordList = {
       kExpectedAuditSockaddrRecord01,
       kExpectedAuditSockaddrRecord02,
-      kExpectedAuditSockaddrRecord03
+      kExpectedAuditSockaddrRecord03,
+      kExpectedAuditSockaddrRecord04,
+      kExpectedAuditSockaddrRecord05
     };
     // clang-format on
 
@@ -373,6 +579,34 @@ SCENARIO("AudispConsumer record parsers", "[AudispConsumer]") {
           REQUIRE(parsed_data.family == expected_data.family);
           REQUIRE(parsed_data.port == expected_data.port);
           REQUIRE(parsed_data.address == expected_data.address);
+
+          // Only IP addresses have a binary representation
+          REQUIRE(parsed_data.address_bytes.has_value() ==
+                  (parsed_data.family != AF_UNIX));
+        }
+
+        REQUIRE(parsed_record_list.at(0).address_bytes.value().at(0) == 127U);
+        REQUIRE(parsed_record_list.at(3).address_bytes.value().at(3) == 0xB8U);
+      }
+    }
+  }
+
+  GIVEN("an invalid AUDIT_SOCKADDR record") {
+    WHEN("parsing the event record") {
+      THEN("an error is returned") {
+        for (const auto &saddr_value :
+             {"0200", "02001F907F00000", "0200ZZ907F000001", "2A001F907F000001",
+              "0A001F90" "00000000000000000000000000000000"}) {
+
+          MockedAuparseInterface::Ref auparse = {};
+          auto status = MockedAuparseInterface::create(
+              auparse, {{"type", "1306"}, {"saddr", saddr_value}});
+
+          REQUIRE(status.succeeded());
+
+          AudispConsumer::SockaddrRecordData output = {};
+          status = AudispConsumer::parseSockaddrRecord(output, auparse);
+          REQUIRE(!status.succeeded());
         }
       }
     }
@@ -0,0 +1,85 @@
+#include "audispfilereader.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+const std::string kStreamData{"type=EOE msg=audit(1.000:1): \n"};
+
+std::string readAll(RingBuffer &buffer) {
+  RingBuffer::RegionList region_list;
+  auto region_count = buffer.readableRegions(region_list);
+
+  std::string output;
+  for (std::size_t i = 0U; i < region_count; ++i) {
+    output.append(static_cast<const char *>(region_list[i].iov_base),
+                  region_list[i].iov_len);
+  }
+
+  buffer.consume(output.size());
+  return output;
+}
+} // namespace
+
+TEST_CASE("Audisp file reader", "[AudispFileReader]") {
+  char path_template[] = "/tmp/zeek_audisp_file_reader_XXXXXX";
+  auto fd = mkstemp(path_template);
+  REQUIRE(fd != -1);
+  close(fd);
+
+  {
+    std::ofstream stream_file(path_template, std::ios::binary);
+    stream_file << kStreamData;
+  }
+
+  IAudispProducer::Ref audisp_producer;
+  auto status = AudispFileReader::create(audisp_producer, path_template);
+  std::remove(path_template);
+
+  REQUIRE(status.succeeded());
+
+  SECTION("The stream is copied in chunks that fit the buffer") {
+    RingBuffer buffer(16U);
+
+    status = audisp_producer->read(buffer);
+    REQUIRE(status.succeeded());
+    REQUIRE(buffer.size() == 16U);
+
+    auto output = readAll(buffer);
+
+    status = audisp_producer->read(buffer);
+    REQUIRE(status.succeeded());
+
+    output += readAll(buffer);
+    REQUIRE(output == kStreamData);
+  }
+
+  SECTION("Nothing more is returned once the stream has been copied") {
+    RingBuffer buffer(64U);
+
+    status = audisp_producer->read(buffer);
+    REQUIRE(status.succeeded());
+    REQUIRE(readAll(buffer) == kStreamData);
+
+    audisp_producer->interrupt();
+
+    status = audisp_producer->read(buffer);
+    REQUIRE(status.succeeded());
+    REQUIRE(buffer.size() == 0U);
+  }
+}
+
+TEST_CASE("Audisp file reader errors", "[AudispFileReader]") {
+  IAudispProducer::Ref audisp_producer;
+  auto status = AudispFileReader::create(audisp_producer,
+                                         "/tmp/zeek_audisp_missing_stream");
+
+  REQUIRE(!status.succeeded());
+}
+} // namespace zeek
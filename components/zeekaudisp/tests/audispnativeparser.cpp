@@ -0,0 +1,233 @@
+#include "audispnativeparser.h"
+
+#include <libaudit_wrapper.h>
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+struct ParsedRecord final {
+  int type{0};
+  std::vector<std::pair<std::string, std::string>> field_list;
+};
+
+using ParsedEvent = std::vector<ParsedRecord>;
+
+struct CallbackContext final {
+  IAuparseInterface *parser{nullptr};
+  std::vector<ParsedEvent> event_list;
+  std::vector<unsigned long> serial_list;
+};
+
+void parserCallback(auparse_state_t *, auparse_cb_event_t event_type,
+                    void *user_data) {
+
+  REQUIRE(event_type == AUPARSE_CB_EVENT_READY);
+
+  auto &context = *static_cast<CallbackContext *>(user_data);
+  auto &parser = *context.parser;
+
+  ParsedEvent event;
+
+  REQUIRE(parser.firstRecord() == 1);
+
+  do {
+    ParsedRecord record;
+    record.type = parser.getType();
+
+    if (parser.firstField() > 0) {
+      do {
+        record.field_list.push_back(
+            {parser.getFieldName(), parser.getFieldStr()});
+      } while (parser.nextField() > 0);
+    }
+
+    event.push_back(std::move(record));
+  } while (parser.nextRecord() > 0);
+
+  context.event_list.push_back(std::move(event));
+  context.serial_list.push_back(parser.getSerial());
+}
+
+IAuparseInterface::Ref
+createParser(CallbackContext &context,
+             const AudispNativeParser::Configuration &configuration) {
+
+  IAuparseInterface::Ref parser;
+  auto status = AudispNativeParser::create(parser, configuration);
+  REQUIRE(status.succeeded());
+
+  context.parser = parser.get();
+  parser->addCallback(parserCallback, &context, nullptr);
+
+  return parser;
+}
+
+void feedString(IAuparseInterface &parser, const std::string &buffer) {
+  parser.feed(buffer.data(), buffer.size());
+}
+
+const AudispNativeParser::Configuration kNoTimeoutConfiguration = {
+    std::chrono::milliseconds(60000), 1024U};
+
+// clang-format off
+const std::string kBindEvent =
+  "type=SYSCALL msg=audit(1573593461.740:303): arch=c000003e syscall=49 success=yes exit=0 a0=3 items=0 ppid=14019 pid=14223 comm=\"nc\" exe=\"/bin/nc.openbsd\" key=(null)\n"
+  "type=SOCKADDR msg=audit(1573593461.740:303): saddr=0200270F000000000000000000000000\n"
+  "type=PROCTITLE msg=audit(1573593461.740:303): proctitle=6E63002D6C00302E302E302E30002D700039393939\n"
+  "type=EOE msg=audit(1573593461.740:303): \n";
+// clang-format on
+} // namespace
+
+TEST_CASE("Native audisp parser", "[AudispNativeParser]") {
+  CallbackContext context;
+
+  SECTION("Records are split into fields") {
+    auto parser = createParser(context, kNoTimeoutConfiguration);
+    feedString(*parser, kBindEvent);
+
+    REQUIRE(context.event_list.size() == 1U);
+
+    const auto &event = context.event_list.at(0);
+    REQUIRE(event.size() == 3U);
+
+    REQUIRE(event.at(0).type == AUDIT_SYSCALL);
+    REQUIRE(event.at(1).type == AUDIT_SOCKADDR);
+    REQUIRE(event.at(2).type == AUDIT_PROCTITLE);
+
+    const auto &syscall_field_list = event.at(0).field_list;
+    REQUIRE(syscall_field_list.size() == 12U);
+
+    REQUIRE(syscall_field_list.at(0).first == "type");
+    REQUIRE(syscall_field_list.at(0).second == "SYSCALL");
+    REQUIRE(syscall_field_list.at(1).first == "arch");
+    REQUIRE(syscall_field_list.at(1).second == "c000003e");
+    REQUIRE(syscall_field_list.at(9).first == "comm");
+    REQUIRE(syscall_field_list.at(9).second == "\"nc\"");
+    REQUIRE(syscall_field_list.at(11).first == "key");
+    REQUIRE(syscall_field_list.at(11).second == "(null)");
+
+    const auto &sockaddr_field_list = event.at(1).field_list;
+    REQUIRE(sockaddr_field_list.size() == 2U);
+    REQUIRE(sockaddr_field_list.at(1).first == "saddr");
+    REQUIRE(sockaddr_field_list.at(1).second ==
+            "0200270F000000000000000000000000");
+  }
+
+  SECTION("Records can be split across multiple chunks") {
+    auto parser = createParser(context, kNoTimeoutConfiguration);
+
+    for (auto c : kBindEvent) {
+      parser->feed(&c, 1U);
+    }
+
+    REQUIRE(context.event_list.size() == 1U);
+    REQUIRE(context.event_list.at(0).size() == 3U);
+    REQUIRE(context.event_list.at(0).at(1).field_list.at(1).second ==
+            "0200270F000000000000000000000000");
+  }
+
+  SECTION("Interleaved events are reassembled by serial number") {
+    auto parser = createParser(context, kNoTimeoutConfiguration);
+
+    // clang-format off
+    feedString(*parser,
+      "type=SYSCALL msg=audit(1.000:1): syscall=59\n"
+      "type=SYSCALL msg=audit(1.000:2): syscall=42\n"
+      "type=CWD msg=audit(1.000:1): cwd=\"/\"\n"
+      "type=SOCKADDR msg=audit(1.000:2): saddr=00\n"
+      "type=EOE msg=audit(1.000:2): \n"
+      "type=EOE msg=audit(1.000:1): \n");
+    // clang-format on
+
+    REQUIRE(context.event_list.size() == 2U);
+
+    const auto &first_event = context.event_list.at(0);
+    REQUIRE(first_event.size() == 2U);
+    REQUIRE(first_event.at(0).field_list.at(1).second == "42");
+    REQUIRE(first_event.at(1).type == AUDIT_SOCKADDR);
+
+    const auto &second_event = context.event_list.at(1);
+    REQUIRE(second_event.size() == 2U);
+    REQUIRE(second_event.at(0).field_list.at(1).second == "59");
+    REQUIRE(second_event.at(1).type == AUDIT_CWD);
+
+    REQUIRE(context.serial_list == std::vector<unsigned long>{2U, 1U});
+    REQUIRE(parser->getSerial() == 0U);
+  }
+
+  SECTION("Node names, enriched fields and unnamed types are handled") {
+    auto parser = createParser(context, kNoTimeoutConfiguration);
+
+    // clang-format off
+    feedString(*parser,
+      "node=host type=SYSCALL msg=audit(1.000:3): syscall=59 key=(null)\x1d" "ARCH=x86_64 SYSCALL=execve\n"
+      "type=UNKNOWN[1334] msg=audit(1.000:3): value=1\n"
+      "type=EOE msg=audit(1.000:3): \n");
+    // clang-format on
+
+    REQUIRE(context.event_list.size() == 1U);
+
+    const auto &event = context.event_list.at(0);
+    REQUIRE(event.size() == 2U);
+
+    REQUIRE(event.at(0).field_list.size() == 3U);
+    REQUIRE(event.at(0).field_list.at(2).first == "key");
+    REQUIRE(event.at(0).field_list.at(2).second == "(null)");
+
+    REQUIRE(event.at(1).type == 1334);
+  }
+
+  SECTION("Events without an EOE record are delivered after the timeout") {
+    auto parser = createParser(
+        context, AudispNativeParser::Configuration{
+                     std::chrono::milliseconds(0), 1024U});
+
+    feedString(*parser, "type=SYSCALL msg=audit(1.000:4): syscall=59\n");
+
+    REQUIRE(context.event_list.size() == 1U);
+    REQUIRE(context.event_list.at(0).at(0).type == AUDIT_SYSCALL);
+  }
+
+  SECTION("The oldest event is delivered when too many are pending") {
+    auto parser = createParser(
+        context, AudispNativeParser::Configuration{
+                     std::chrono::milliseconds(60000), 1U});
+
+    feedString(*parser, "type=SYSCALL msg=audit(1.000:5): syscall=59\n");
+    REQUIRE(context.event_list.empty());
+
+    feedString(*parser, "type=SYSCALL msg=audit(1.000:6): syscall=42\n");
+    REQUIRE(context.event_list.size() == 1U);
+    REQUIRE(context.event_list.at(0).at(0).field_list.at(1).second == "59");
+
+    parser->flushFeed();
+    REQUIRE(context.event_list.size() == 2U);
+    REQUIRE(context.event_list.at(1).at(0).field_list.at(1).second == "42");
+  }
+
+  SECTION("Bursts over the pending event limit are delivered in order") {
+    auto parser = createParser(
+        context, AudispNativeParser::Configuration{
+                     std::chrono::milliseconds(60000), 4U});
+
+    // The serials are fed out of order, all in a single chunk
+    std::string buffer;
+    for (auto serial : {13, 10, 12, 17, 11, 15, 14, 16}) {
+      buffer += "type=SYSCALL msg=audit(1.000:" + std::to_string(serial) +
+                "): syscall=" + std::to_string(serial) + "\n";
+    }
+
+    feedString(*parser, buffer);
+    REQUIRE(context.event_list.size() == 4U);
+
+    parser->flushFeed();
+    REQUIRE(context.event_list.size() == 8U);
+
+    for (std::size_t i = 0U; i < context.event_list.size(); ++i) {
+      CHECK(context.event_list.at(i).at(0).field_list.at(1).second ==
+            std::to_string(10U + i));
+    }
+  }
+}
+} // namespace zeek
@@ -1,5 +1,8 @@
 #include "audit_utils.h"
 
+#include <algorithm>
+#include <cctype>
+
 #include <catch2/catch.hpp>
 
 namespace zeek {
@@ -141,5 +144,151 @@ SCENARIO("Audit utilities", "[audit_utils]") {
       }
     }
   }
+
+  GIVEN("a list of audit integers") {
+    WHEN("converting them to numbers") {
+      THEN("the values match the ones returned by std::strtoll") {
+        for (const auto &buffer : {"0", "7841", "-2", "4294967295",
+                                   "-9223372036854775807", "12ab"}) {
+
+          std::int64_t output{};
+          REQUIRE(convertAuditInteger(output, buffer));
+          REQUIRE(output == std::strtoll(buffer, nullptr, 10));
+        }
+
+        for (const auto &buffer : {"0", "0100644", "-17", "7778"}) {
+          std::int64_t output{};
+          REQUIRE(convertAuditInteger(output, buffer, 8));
+          REQUIRE(output == std::strtoll(buffer, nullptr, 8));
+        }
+      }
+    }
+
+    WHEN("converting values out of range") {
+      THEN("they are clamped like std::strtoll does") {
+        for (const auto &buffer :
+             {"9223372036854775807", "9223372036854775808",
+              "-9223372036854775808", "-9223372036854775809",
+              "99999999999999999999999", "-99999999999999999999999"}) {
+
+          std::int64_t output{};
+          REQUIRE(convertAuditInteger(output, buffer));
+          REQUIRE(output == std::strtoll(buffer, nullptr, 10));
+        }
+
+        for (const auto &buffer :
+             {"777777777777777777777", "1000000000000000000000",
+              "-1000000000000000000000", "-1000000000000000000001"}) {
+
+          std::int64_t output{};
+          REQUIRE(convertAuditInteger(output, buffer, 8));
+          REQUIRE(output == std::strtoll(buffer, nullptr, 8));
+        }
+      }
+    }
+
+    WHEN("converting invalid values") {
+      THEN("no digit is converted") {
+        for (const auto &buffer : {"", "-", "(null)", "?"}) {
+          std::int64_t output{1};
+          REQUIRE(!convertAuditInteger(output, buffer));
+          REQUIRE(output == 0);
+        }
+
+        std::int64_t output{1};
+        REQUIRE(!convertAuditInteger(output, "9", 8));
+        REQUIRE(output == 0);
+      }
+    }
+  }
+
+  GIVEN("a list of IPv6 addresses") {
+    // clang-format off
+    static const std::vector<std::pair<const char *, const char *>> kAddressList = {
+      { "0000:0000:0000:0000:0000:0000:0000:0000", "::" },
+      { "0000:0000:0000:0000:0000:0000:0000:0001", "::1" },
+      { "2001:0db8:0000:0000:0000:0000:0000:0001", "2001:db8::1" },
+      { "2001:0db8:0000:0001:0000:0000:0000:0001", "2001:db8:0:1::1" },
+      { "2001:0db8:0000:0000:0001:0000:0000:0001", "2001:db8::1:0:0:1" },
+      { "2001:0db8:0000:0001:0001:0001:0001:0001", "2001:db8:0:1:1:1:1:1" },
+      { "fe80:0000:0000:0000:0000:0000:0000:0000", "fe80::" },
+      { "2001:0DB8:AAAA:BBBB:CCCC:DDDD:EEEE:FFFF",
+        "2001:db8:aaaa:bbbb:cccc:dddd:eeee:ffff" },
+      { "0000:0000:0000:0000:0000:ffff:c0a8:0001", "::ffff:192.168.0.1" },
+      { "0000:0000:0000:0000:0000:0000:c0a8:0001", "::c0a8:1" }
+    };
+    // clang-format on
+
+    WHEN("formatting them") {
+      THEN("the canonical representation is returned") {
+        for (const auto &p : kAddressList) {
+          std::string hex_address{p.first};
+          hex_address.erase(
+              std::remove(hex_address.begin(), hex_address.end(), ':'),
+              hex_address.end());
+
+          std::transform(hex_address.begin(), hex_address.end(),
+                         hex_address.begin(), ::toupper);
+
+          std::string address;
+          REQUIRE(convertHexString(address, hex_address));
+          REQUIRE(address.size() == 16U);
+
+          NetworkAddressBuffer buffer;
+          auto formatted_address = formatIPv6Address(
+              buffer, reinterpret_cast<const std::uint8_t *>(address.data()));
+
+          REQUIRE(formatted_address == p.second);
+        }
+      }
+    }
+  }
+
+  GIVEN("a list of IPv4 addresses") {
+    WHEN("formatting them") {
+      THEN("the dotted decimal representation is returned") {
+        NetworkAddressBuffer buffer;
+
+        static const std::uint8_t kAddress01[] = {0, 0, 0, 0};
+        REQUIRE(formatIPv4Address(buffer, kAddress01) == "0.0.0.0");
+
+        static const std::uint8_t kAddress02[] = {255, 10, 100, 9};
+        REQUIRE(formatIPv4Address(buffer, kAddress02) == "255.10.100.9");
+      }
+    }
+  }
+
+  GIVEN("hex encoded sockaddr structures") {
+    WHEN("decoding a valid structure") {
+      sockaddr_storage address;
+      std::size_t address_size{};
+      auto succeeded =
+          decodeSockaddr(address, address_size, "02001F907F000001");
+
+      THEN("the structure is decoded in place") {
+        REQUIRE(succeeded);
+        REQUIRE(address_size == 8U);
+        REQUIRE(address.ss_family == AF_INET);
+
+        auto address_bytes = reinterpret_cast<const std::uint8_t *>(&address);
+        REQUIRE(address_bytes[4] == 0x7FU);
+        REQUIRE(address_bytes[8] == 0U);
+      }
+    }
+
+    WHEN("decoding invalid structures") {
+      THEN("an error is returned") {
+        sockaddr_storage address;
+        std::size_t address_size{};
+
+        REQUIRE(!decodeSockaddr(address, address_size, "020"));
+        REQUIRE(!decodeSockaddr(address, address_size, "02001f90"));
+        REQUIRE(!decodeSockaddr(address, address_size,
+                                std::string(sizeof(address) * 2U + 2U, '0')));
+
+        REQUIRE(address_size == 0U);
+      }
+    }
+  }
 }
 } // namespace zeek
@@ -0,0 +1,275 @@
+#include "audispconsumer.h"
+#include "auditeventfilter.h"
+#include "mockedaudispproducer.h"
+
+#include <catch2/catch.hpp>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+namespace zeek {
+namespace {
+using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+IAudispConsumer::FilterRule parseRule(const std::string &rule_string) {
+  IAudispConsumer::FilterRule rule;
+  auto status = IAudispConsumer::parseFilterRule(rule, rule_string);
+  REQUIRE(status.succeeded());
+
+  return rule;
+}
+
+IAudispConsumer::AuditEvent generateConnectEvent(const std::string &address) {
+  IAudispConsumer::AuditEvent audit_event;
+  audit_event.syscall_data.type = SyscallType::Connect;
+  audit_event.syscall_data.exe = "/usr/bin/curl";
+
+  IAudispConsumer::SockaddrRecordData sockaddr_data;
+  sockaddr_data.family = AF_INET;
+  sockaddr_data.address = address;
+
+  std::array<std::uint8_t, 16> address_bytes{};
+  if (inet_pton(AF_INET6, address.c_str(), address_bytes.data()) == 1) {
+    sockaddr_data.family = AF_INET6;
+  } else {
+    REQUIRE(inet_pton(AF_INET, address.c_str(), address_bytes.data()) == 1);
+  }
+
+  sockaddr_data.address_bytes = address_bytes;
+  audit_event.sockaddr_data = std::move(sockaddr_data);
+
+  return audit_event;
+}
+} // namespace
+
+TEST_CASE("Filter rule parsing", "[AuditEventFilter]") {
+  IAudispConsumer::FilterRule rule;
+
+  auto status = IAudispConsumer::parseFilterRule(
+      rule, "exclude exe=/usr/bin/ls uid=1000 syscall=execve");
+
+  REQUIRE(status.succeeded());
+  REQUIRE(rule.action == IAudispConsumer::FilterRule::Action::Exclude);
+  REQUIRE(rule.exe == "/usr/bin/ls");
+  REQUIRE(rule.uid == 1000);
+  REQUIRE(rule.syscall == SyscallType::Execve);
+  REQUIRE(!rule.auid.has_value());
+  REQUIRE(!rule.path_prefix.has_value());
+  REQUIRE(!rule.address.has_value());
+
+  REQUIRE(describeFilterRule(rule) ==
+          "exclude syscall=execve exe=/usr/bin/ls uid=1000");
+
+  status = IAudispConsumer::parseFilterRule(rule, "include address=::1/128");
+  REQUIRE(status.succeeded());
+  REQUIRE(rule.action == IAudispConsumer::FilterRule::Action::Include);
+  REQUIRE(rule.address == "::1/128");
+
+  // clang-format off
+  const std::vector<std::string> kInvalidRuleList = {
+    "",
+    "exclude",
+    "drop exe=/bin/ls",
+    "exclude exe",
+    "exclude exe=",
+    "exclude name=test",
+    "exclude uid=abc",
+    "exclude syscall=read",
+    "exclude address=10.0.0.0/33",
+    "exclude address=10.0.0.0/",
+    "exclude address=example.com"
+  };
+  // clang-format on
+
+  for (const auto &rule_string : kInvalidRuleList) {
+    status = IAudispConsumer::parseFilterRule(rule, rule_string);
+    REQUIRE(!status.succeeded());
+  }
+}
+
+SCENARIO("Audit event filtering", "[AuditEventFilter]") {
+  GIVEN("rules that only need the SYSCALL record") {
+    AuditEventFilter::Ref event_filter;
+    auto status = AuditEventFilter::create(
+        event_filter, {parseRule("include exe=/usr/bin/sudo"),
+                       parseRule("exclude auid=4294967295")});
+
+    REQUIRE(status.succeeded());
+
+    IAudispConsumer::SyscallRecordData syscall_data;
+    syscall_data.type = SyscallType::Execve;
+    syscall_data.auid = 4294967295;
+
+    WHEN("the first rule matches") {
+      syscall_data.exe = "/usr/bin/sudo";
+
+      THEN("the event is accepted") {
+        REQUIRE(event_filter->matchSyscall(syscall_data) ==
+                AuditEventFilter::Decision::Accept);
+      }
+    }
+
+    WHEN("only the second rule matches") {
+      syscall_data.exe = "/usr/bin/cat";
+
+      THEN("the event is rejected and the rule counter is updated") {
+        REQUIRE(event_filter->matchSyscall(syscall_data) ==
+                AuditEventFilter::Decision::Reject);
+
+        IAudispConsumer::FilterRuleCounterList counter_list;
+        event_filter->getCounters(counter_list);
+
+        REQUIRE(counter_list.size() == 2U);
+        REQUIRE(counter_list.at(0).match_count == 0U);
+        REQUIRE(counter_list.at(1).rule == "exclude auid=4294967295");
+        REQUIRE(counter_list.at(1).match_count == 1U);
+      }
+    }
+
+    WHEN("no rule matches") {
+      syscall_data.auid = 1000;
+
+      THEN("the event is accepted") {
+        REQUIRE(event_filter->matchSyscall(syscall_data) ==
+                AuditEventFilter::Decision::Accept);
+      }
+    }
+  }
+
+  GIVEN("rules on the SOCKADDR and PATH records") {
+    AuditEventFilter::Ref event_filter;
+    auto status = AuditEventFilter::create(
+        event_filter, {parseRule("exclude syscall=connect address=10.0.0.0/8"),
+                       parseRule("exclude path_prefix=/proc/")});
+
+    REQUIRE(status.succeeded());
+
+    WHEN("matching a connection inside the excluded block") {
+      auto audit_event = generateConnectEvent("10.1.2.3");
+
+      THEN("the decision is taken after the event has been parsed") {
+        REQUIRE(event_filter->matchSyscall(audit_event.syscall_data) ==
+                AuditEventFilter::Decision::Undecided);
+
+        REQUIRE(!event_filter->matchEvent(audit_event));
+      }
+    }
+
+    WHEN("matching a connection outside the excluded block") {
+      auto audit_event = generateConnectEvent("192.168.1.1");
+
+      THEN("the event is kept") {
+        REQUIRE(event_filter->matchEvent(audit_event));
+      }
+    }
+
+    WHEN("matching an event with an excluded path") {
+      IAudispConsumer::AuditEvent audit_event;
+      audit_event.syscall_data.type = SyscallType::Open;
+
+      IAudispConsumer::PathRecordData path_data(1U);
+      path_data.at(0).path = "/proc/self/status";
+      audit_event.path_data = std::move(path_data);
+
+      THEN("the event is discarded") {
+        REQUIRE(!event_filter->matchEvent(audit_event));
+      }
+    }
+  }
+
+  GIVEN("a rule on an IPv6 block") {
+    AuditEventFilter::Ref event_filter;
+    auto status = AuditEventFilter::create(
+        event_filter, {parseRule("exclude address=fe80::/10")});
+
+    REQUIRE(status.succeeded());
+
+    THEN("only the addresses inside the block are matched") {
+      REQUIRE(!event_filter->matchEvent(generateConnectEvent("fe80::1")));
+      REQUIRE(!event_filter->matchEvent(generateConnectEvent("febf::1")));
+
+      REQUIRE(event_filter->matchEvent(generateConnectEvent("fec0::1")));
+      REQUIRE(event_filter->matchEvent(generateConnectEvent("10.0.0.1")));
+    }
+  }
+
+  GIVEN("a rule using the expanded IPv6 address format") {
+    AuditEventFilter::Ref event_filter;
+    auto status = AuditEventFilter::create(
+        event_filter,
+        {parseRule("exclude address="
+                   "fe:80:00:00:00:00:00:00:00:00:00:00:00:00:00:00/10")});
+
+    REQUIRE(status.succeeded());
+
+    THEN("the rule is still accepted") {
+      REQUIRE(!event_filter->matchEvent(generateConnectEvent("fe80::1")));
+      REQUIRE(event_filter->matchEvent(generateConnectEvent("fec0::1")));
+    }
+  }
+
+  GIVEN("a connection without a binary address") {
+    AuditEventFilter::Ref event_filter;
+    auto status = AuditEventFilter::create(
+        event_filter, {parseRule("exclude address=0.0.0.0/0")});
+
+    REQUIRE(status.succeeded());
+
+    IAudispConsumer::AuditEvent audit_event;
+    audit_event.syscall_data.type = SyscallType::Connect;
+
+    IAudispConsumer::SockaddrRecordData sockaddr_data;
+    sockaddr_data.family = AF_UNIX;
+    sockaddr_data.address = "/run/systemd/notify";
+    audit_event.sockaddr_data = std::move(sockaddr_data);
+
+    THEN("the address rule does not match") {
+      REQUIRE(event_filter->matchEvent(audit_event));
+    }
+  }
+}
+
+SCENARIO("AudispConsumer event filtering", "[AuditEventFilter]") {
+  GIVEN("an execve event and a rule that excludes it") {
+    // clang-format off
+    static const std::string kExecveEvent = "type=SYSCALL msg=audit(1572891138.674:28907): arch=c000003e syscall=59 success=yes exit=0 a0=7ffddc903cc0 a1=7f4e2c51a940 a2=55989bc751c0 a3=8 items=1 ppid=11413 pid=11414 auid=4294967295 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=pts1 ses=4294967295 comm=\"cat\" exe=\"/bin/cat\" key=(null)\ntype=EXECVE msg=audit(1572891138.674:28907): argc=2 a0=\"cat\" a1=\"--version\"\ntype=CWD msg=audit(1572891138.674:28907): cwd=\"/var/log/audit\"\ntype=PATH msg=audit(1572891138.674:28907): item=0 name=\"/bin/cat\" inode=5689 dev=00:18 mode=0100755 ouid=0 ogid=0 rdev=00:00 nametype=NORMAL cap_fp=0000000000000000 cap_fi=0000000000000000 cap_fe=0 cap_fver=0\ntype=EOE msg=audit(1572891138.674:28907): \n";
+    // clang-format on
+
+    IAudispConsumer::Ref audisp_consumer;
+
+    {
+      IAudispProducer::Ref audisp_producer;
+      auto status = MockedAudispProducer::create(audisp_producer, kExecveEvent);
+      REQUIRE(status.succeeded());
+
+      status = AudispConsumer::createWithProducer(
+          audisp_consumer, std::move(audisp_producer),
+          IAudispConsumer::Parser::Native,
+          IAudispConsumer::OverflowPolicy::Drop,
+          {parseRule("exclude exe=/bin/cat syscall=execve")});
+
+      audisp_producer = {};
+
+      REQUIRE(status.succeeded());
+    }
+
+    WHEN("processing the event") {
+      auto status = audisp_consumer->processEvents();
+      REQUIRE(status.succeeded());
+
+      THEN("the event is discarded and counted") {
+        IAudispConsumer::AuditEventList event_list;
+        status = audisp_consumer->getEvents(event_list);
+        REQUIRE(status.succeeded());
+        REQUIRE(event_list.empty());
+
+        IAudispConsumer::FilterRuleCounterList counter_list;
+        audisp_consumer->getFilterRuleCounters(counter_list);
+
+        REQUIRE(counter_list.size() == 1U);
+        REQUIRE(counter_list.at(0).match_count == 1U);
+      }
+    }
+  }
+}
+} // namespace zeek
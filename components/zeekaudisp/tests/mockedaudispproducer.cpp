@@ -25,12 +25,14 @@ Status MockedAudispProducer::create(IAudispProducer::Ref &obj,
 
 MockedAudispProducer::~MockedAudispProducer() {}
 
-Status MockedAudispProducer::read(std::string &buffer) {
-  buffer = d->event_buffer;
+Status MockedAudispProducer::read(RingBuffer &buffer) {
+  buffer.write(d->event_buffer.data(), d->event_buffer.size());
 
   return Status::success();
 }
 
+void MockedAudispProducer::interrupt() {}
+
 MockedAudispProducer::MockedAudispProducer(const std::string &event_buffer)
     : d(new PrivateData) {
   if (event_buffer.empty()) {
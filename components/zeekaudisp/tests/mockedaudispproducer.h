@@ -14,7 +14,8 @@ public:
                        const std::string &socket_path);
   virtual ~MockedAudispProducer() override;
 
-  virtual Status read(std::string &buffer) override;
+  virtual Status read(RingBuffer &buffer) override;
+  virtual void interrupt() override;
 
 protected:
   MockedAudispProducer(const std::string &socket_path);
@@ -70,6 +70,8 @@ int MockedAuparseInterface::feed(const char *, size_t) { return 0; }
 
 int MockedAuparseInterface::getType() { return 0; }
 
+unsigned long MockedAuparseInterface::getSerial() { return 0U; }
+
 int MockedAuparseInterface::nextRecord() { return 0; }
 
 int MockedAuparseInterface::nextEvent() { return 0; }
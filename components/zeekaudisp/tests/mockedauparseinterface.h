@@ -26,6 +26,7 @@ public:
   virtual int flushFeed() override;
   virtual int feed(const char *, size_t) override;
   virtual int getType() override;
+  virtual unsigned long getSerial() override;
   virtual int nextRecord() override;
   virtual int nextEvent() override;
   virtual void addCallback(auparse_callback_ptr, void *, user_destroy) override;
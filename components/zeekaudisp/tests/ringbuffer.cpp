@@ -0,0 +1,81 @@
+#include "ringbuffer.h"
+
+#include <string>
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+std::string readAll(const RingBuffer &buffer) {
+  RingBuffer::RegionList region_list;
+  auto region_count = buffer.readableRegions(region_list);
+
+  std::string output;
+  for (std::size_t i = 0U; i < region_count; ++i) {
+    output.append(static_cast<const char *>(region_list[i].iov_base),
+                  region_list[i].iov_len);
+  }
+
+  return output;
+}
+} // namespace
+
+TEST_CASE("Ring buffer", "[RingBuffer]") {
+  RingBuffer buffer(8U);
+
+  SECTION("An empty buffer exposes a single writable region") {
+    RingBuffer::RegionList region_list;
+
+    REQUIRE(buffer.readableRegions(region_list) == 0U);
+    REQUIRE(buffer.writableRegions(region_list) == 1U);
+    REQUIRE(region_list[0].iov_len == 8U);
+  }
+
+  SECTION("Writes stop when the buffer is full") {
+    REQUIRE(buffer.write("0123456789", 10U) == 8U);
+    REQUIRE(buffer.size() == 8U);
+    REQUIRE(buffer.freeSpace() == 0U);
+
+    RingBuffer::RegionList region_list;
+    REQUIRE(buffer.writableRegions(region_list) == 0U);
+    REQUIRE(readAll(buffer) == "01234567");
+  }
+
+  SECTION("Data spanning the wrap point is returned in order") {
+    REQUIRE(buffer.write("abcdef", 6U) == 6U);
+    buffer.consume(4U);
+
+    RingBuffer::RegionList region_list;
+    REQUIRE(buffer.writableRegions(region_list) == 2U);
+    REQUIRE(region_list[0].iov_len == 2U);
+    REQUIRE(region_list[1].iov_len == 4U);
+
+    REQUIRE(buffer.write("ghijk", 5U) == 5U);
+    REQUIRE(buffer.size() == 7U);
+
+    REQUIRE(buffer.readableRegions(region_list) == 2U);
+    REQUIRE(region_list[0].iov_len == 4U);
+    REQUIRE(region_list[1].iov_len == 3U);
+    REQUIRE(readAll(buffer) == "efghijk");
+
+    buffer.consume(5U);
+    REQUIRE(readAll(buffer) == "jk");
+  }
+
+  SECTION("Committed writable regions become readable") {
+    buffer.write("xy", 2U);
+    buffer.consume(2U);
+
+    RingBuffer::RegionList region_list;
+    REQUIRE(buffer.writableRegions(region_list) == 2U);
+    REQUIRE(region_list[0].iov_len == 6U);
+    REQUIRE(region_list[1].iov_len == 2U);
+
+    auto data = static_cast<char *>(region_list[0].iov_base);
+    data[0] = 'z';
+    buffer.commit(1U);
+
+    REQUIRE(readAll(buffer) == "z");
+  }
+}
+} // namespace zeek
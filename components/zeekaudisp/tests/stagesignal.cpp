@@ -0,0 +1,100 @@
+#include "audispconsumer.h"
+#include "mockedaudispproducer.h"
+#include "stagesignal.h"
+
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+const std::chrono::milliseconds kLongTimeout{5000};
+
+// clang-format off
+const std::string kExecveEvent = "type=SYSCALL msg=audit(1572891138.674:28907): arch=c000003e syscall=59 success=yes exit=0 a0=7ffddc903cc0 a1=7f4e2c51a940 a2=55989bc751c0 a3=8 items=1 ppid=11413 pid=11414 auid=4294967295 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=pts1 ses=4294967295 comm=\"cat\" exe=\"/bin/cat\" key=(null)\ntype=EXECVE msg=audit(1572891138.674:28907): argc=2 a0=\"cat\" a1=\"--version\"\ntype=CWD msg=audit(1572891138.674:28907): cwd=\"/var/log/audit\"\ntype=PATH msg=audit(1572891138.674:28907): item=0 name=\"/bin/cat\" inode=5689 dev=00:18 mode=0100755 ouid=0 ogid=0 rdev=00:00 nametype=NORMAL cap_fp=0000000000000000 cap_fi=0000000000000000 cap_fe=0 cap_fver=0\ntype=EOE msg=audit(1572891138.674:28907): \n";
+// clang-format on
+} // namespace
+
+TEST_CASE("Stage signal", "[StageSignal]") {
+  StageSignal stage_signal;
+
+  SECTION("The wait times out when nothing happens") {
+    CHECK(!stage_signal.wait(std::chrono::milliseconds(10)));
+  }
+
+  SECTION("A signal sent before the wait is not lost") {
+    stage_signal.notify();
+    stage_signal.notify();
+
+    CHECK(stage_signal.wait(kLongTimeout));
+
+    // Repeated signals are only reported once
+    CHECK(!stage_signal.wait(std::chrono::milliseconds(0)));
+  }
+
+  SECTION("A signal from another thread ends the wait") {
+    std::thread notifier_thread([&stage_signal]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      stage_signal.notify();
+    });
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto signaled = stage_signal.wait(kLongTimeout);
+    auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    notifier_thread.join();
+
+    CHECK(signaled);
+    CHECK(elapsed_time < kLongTimeout);
+  }
+}
+
+TEST_CASE("Pipeline stage wake-ups", "[AudispConsumer]") {
+  IAudispProducer::Ref audisp_producer;
+  auto status = MockedAudispProducer::create(audisp_producer, kExecveEvent);
+  REQUIRE(status.succeeded());
+
+  IAudispConsumer::Ref audisp_consumer;
+  status = AudispConsumer::createWithProducer(
+      audisp_consumer, std::move(audisp_producer),
+      IAudispConsumer::Parser::Native);
+
+  REQUIRE(status.succeeded());
+
+  SECTION("The table stage is woken up by new events") {
+    std::thread pipeline_thread([&audisp_consumer]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+      REQUIRE(audisp_consumer->readData().succeeded());
+      REQUIRE(audisp_consumer->parseData().succeeded());
+    });
+
+    auto start_time = std::chrono::steady_clock::now();
+    audisp_consumer->waitForEvents(kLongTimeout);
+    auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    pipeline_thread.join();
+
+    CHECK(elapsed_time < kLongTimeout);
+
+    IAudispConsumer::AuditEventList event_list;
+    REQUIRE(audisp_consumer->getEvents(event_list).succeeded());
+    CHECK(event_list.size() == 1U);
+  }
+
+  SECTION("Interrupting the consumer wakes up the idle stages") {
+    std::thread interrupt_thread([&audisp_consumer]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      audisp_consumer->interrupt();
+    });
+
+    auto start_time = std::chrono::steady_clock::now();
+    audisp_consumer->waitForEvents(kLongTimeout);
+    auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    interrupt_thread.join();
+
+    CHECK(elapsed_time < kLongTimeout);
+  }
+}
+} // namespace zeek
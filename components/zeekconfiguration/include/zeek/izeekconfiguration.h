@@ -9,6 +9,18 @@ public:
   /// \brief A unique reference to a configuration object
   using Ref = std::unique_ptr<IZeekConfiguration>;
 
+  /// \brief The address of a Zeek server
+  struct ServerAddress final {
+    /// \brief Host name or IP address
+    std::string address;
+
+    /// \brief Port number
+    std::uint16_t port{0U};
+  };
+
+  /// \brief A list of Zeek server addresses
+  using ServerAddressList = std::vector<ServerAddress>;
+
   /// \brief Factory method
   /// \param ref Where the output object is stored
   /// \param virtual_database A reference to a virtual database instance. Used
@@ -30,6 +42,10 @@ public:
   /// \return Returns the configured server port
   virtual std::uint16_t serverPort() const = 0;
 
+  /// \return Returns all the configured servers. The first one is always
+  ///         the server_address/server_port pair
+  virtual const ServerAddressList &serverList() const = 0;
+
   /// \brief Returns a list of Zeek groups to be joined on startup
   /// \return Returns the configured group list
   virtual const std::vector<std::string> &groupList() const = 0;
@@ -53,6 +69,72 @@ public:
   ///         that is waiting to be queried
   virtual std::size_t maxQueuedRowCount() const = 0;
 
+  /// \return Returns how many seconds the agent waits, after reconnecting,
+  ///         for the Zeek server to renew the subscriptions of the previous
+  ///         session. A value of zero disables session resumption
+  virtual std::uint32_t sessionResumptionTimeout() const = 0;
+
+  /// \return Returns the folder where the agent persists its state across
+  ///         restarts. An empty path disables persistence
+  virtual const std::string &stateFolder() const = 0;
+
+  /// \return Returns how many rows the agent can publish every second,
+  ///         across all topics. A value of zero disables the limit
+  virtual std::uint32_t maxRowsPerSecond() const = 0;
+
+  /// \return Returns how many bytes the agent can publish every second,
+  ///         across all topics. A value of zero disables the limit
+  virtual std::uint32_t maxBytesPerSecond() const = 0;
+
+  /// \return Returns how many rows the agent can publish every second
+  ///         to a single response topic. A value of zero disables the
+  ///         limit
+  virtual std::uint32_t maxTopicRowsPerSecond() const = 0;
+
+  /// \return Returns how many bytes the agent can publish every second
+  ///         to a single response topic. A value of zero disables the
+  ///         limit
+  virtual std::uint32_t maxTopicBytesPerSecond() const = 0;
+
+  /// \return Returns the parser used for the audisp event stream; either
+  ///         "auparse" (libauparse) or "native"
+  virtual const std::string &audispParser() const = 0;
+
+  /// \return Returns what the audisp pipeline does with parsed events when
+  ///         the table stage falls behind; either "drop" or "block"
+  virtual const std::string &audispOverflowPolicy() const = 0;
+
+  /// \return Returns the rules used to discard unwanted audisp events, in
+  ///         the "<include|exclude> key=value ..." format
+  virtual const std::vector<std::string> &audispFilterList() const = 0;
+
+  /// \return Returns how many arguments are kept from each execve command
+  ///         line. A value of zero disables the limit
+  virtual std::uint32_t audispMaxExecveArgumentCount() const = 0;
+
+  /// \return Returns how many bytes are kept from each execve command line,
+  ///         across all of its arguments. A value of zero disables the limit
+  virtual std::uint32_t audispMaxExecveCommandLineSize() const = 0;
+
+  /// \return Returns for how many seconds identical audisp events are
+  ///         folded into a single row. A value of zero disables coalescing
+  virtual std::uint32_t audispCoalescingWindow() const = 0;
+
+  /// \return Returns the columns that identify duplicated events, for each
+  ///         audisp table, in the "<table>=<column>,<column>,..." format.
+  ///         Tables that are not listed compare all their columns
+  virtual const std::vector<std::string> &audispCoalescingKeyList() const = 0;
+
+  /// \return Returns how full an audisp table queue can get, as a percentage
+  ///         of max_queued_row_count, before the table starts sampling its
+  ///         rows. A value of zero disables sampling
+  virtual std::uint32_t audispSamplingThreshold() const = 0;
+
+  /// \return Returns for how many seconds an audisp table keeps receiving
+  ///         events after it has last been queried. A value of zero keeps
+  ///         all the tables active
+  virtual std::uint32_t audispTableActivityTimeout() const = 0;
+
   IZeekConfiguration(const IZeekConfiguration &) = delete;
   IZeekConfiguration &operator=(const IZeekConfiguration &) = delete;
 };
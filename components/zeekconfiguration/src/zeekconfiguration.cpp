@@ -2,6 +2,7 @@
 #include "configurationchecker.h"
 #include "zeekconfigurationtableplugin.h"
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <sstream>
@@ -63,6 +64,17 @@ const ConfigurationChecker::Constraints kConfigurationConstraints = {
     }
   },
 
+  {
+    "server_list",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      true,
+      "",
+      false
+    }
+  },
+
   {
     "certificate_authority",
 
@@ -116,9 +128,219 @@ const ConfigurationChecker::Constraints kConfigurationConstraints = {
       "",
       REQUIRE_OSQUERY_EXTENSIONS_SOCKET
     }
+  },
+
+  {
+    "session_resumption_timeout",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "state_folder",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "max_rows_per_second",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "max_bytes_per_second",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "max_topic_rows_per_second",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "max_topic_bytes_per_second",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_parser",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_overflow_policy",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_filter_list",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      true,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_max_execve_argument_count",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_max_execve_command_line_size",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_coalescing_window",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_coalescing_key_list",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::String,
+      true,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_sampling_threshold",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
+  },
+
+  {
+    "audisp_table_activity_timeout",
+
+    {
+      ConfigurationChecker::MemberConstraint::Type::UInt32,
+      false,
+      "",
+      false
+    }
   }
 };
 // clang-format on
+
+Status parseServerAddress(IZeekConfiguration::ServerAddress &server_address,
+                          const std::string &value) {
+  server_address = {};
+
+  // IPv6 addresses must be enclosed in brackets: [address]:port
+  std::string address;
+  std::string port;
+
+  if (!value.empty() && value.front() == '[') {
+    auto closing_bracket = value.find("]:");
+    if (closing_bracket == std::string::npos) {
+      return Status::failure("Invalid server_list entry: " + value);
+    }
+
+    address = value.substr(1U, closing_bracket - 1U);
+    port = value.substr(closing_bracket + 2U);
+
+  } else {
+    auto separator = value.rfind(':');
+    if (separator == std::string::npos ||
+        value.find(':') != separator) {
+      return Status::failure("Invalid server_list entry: " + value);
+    }
+
+    address = value.substr(0U, separator);
+    port = value.substr(separator + 1U);
+  }
+
+  if (address.empty() || port.empty() || port.size() > 5U ||
+      port.find_first_not_of("0123456789") != std::string::npos) {
+    return Status::failure("Invalid server_list entry: " + value);
+  }
+
+  auto port_number = std::stoul(port);
+  if (port_number == 0U || port_number > 65535U) {
+    return Status::failure("Invalid port number in server_list entry: " +
+                           value);
+  }
+
+  server_address.address = std::move(address);
+  server_address.port = static_cast<std::uint16_t>(port_number);
+
+  return Status::success();
+}
 } // namespace
 
 struct ZeekConfiguration::PrivateData final {
@@ -151,6 +373,11 @@ const std::vector<std::string> &ZeekConfiguration::groupList() const {
   return d->context.group_list;
 }
 
+const IZeekConfiguration::ServerAddressList &
+ZeekConfiguration::serverList() const {
+  return d->context.server_list;
+}
+
 const std::string &ZeekConfiguration::getLogFolder() const {
   return d->context.log_folder;
 }
@@ -175,6 +402,67 @@ std::size_t ZeekConfiguration::maxQueuedRowCount() const {
   return d->context.max_queued_row_count;
 }
 
+std::uint32_t ZeekConfiguration::sessionResumptionTimeout() const {
+  return d->context.session_resumption_timeout;
+}
+
+const std::string &ZeekConfiguration::stateFolder() const {
+  return d->context.state_folder;
+}
+
+std::uint32_t ZeekConfiguration::maxRowsPerSecond() const {
+  return d->context.max_rows_per_second;
+}
+
+std::uint32_t ZeekConfiguration::maxBytesPerSecond() const {
+  return d->context.max_bytes_per_second;
+}
+
+std::uint32_t ZeekConfiguration::maxTopicRowsPerSecond() const {
+  return d->context.max_topic_rows_per_second;
+}
+
+std::uint32_t ZeekConfiguration::maxTopicBytesPerSecond() const {
+  return d->context.max_topic_bytes_per_second;
+}
+
+const std::string &ZeekConfiguration::audispParser() const {
+  return d->context.audisp_parser;
+}
+
+const std::string &ZeekConfiguration::audispOverflowPolicy() const {
+  return d->context.audisp_overflow_policy;
+}
+
+const std::vector<std::string> &ZeekConfiguration::audispFilterList() const {
+  return d->context.audisp_filter_list;
+}
+
+std::uint32_t ZeekConfiguration::audispMaxExecveArgumentCount() const {
+  return d->context.audisp_max_execve_argument_count;
+}
+
+std::uint32_t ZeekConfiguration::audispMaxExecveCommandLineSize() const {
+  return d->context.audisp_max_execve_command_line_size;
+}
+
+std::uint32_t ZeekConfiguration::audispCoalescingWindow() const {
+  return d->context.audisp_coalescing_window;
+}
+
+const std::vector<std::string> &
+ZeekConfiguration::audispCoalescingKeyList() const {
+  return d->context.audisp_coalescing_key_list;
+}
+
+std::uint32_t ZeekConfiguration::audispSamplingThreshold() const {
+  return d->context.audisp_sampling_threshold;
+}
+
+std::uint32_t ZeekConfiguration::audispTableActivityTimeout() const {
+  return d->context.audisp_table_activity_timeout;
+}
+
 ZeekConfiguration::ZeekConfiguration(IVirtualDatabase &virtual_database,
                                      const std::string &configuration_file_path)
     : d(new PrivateData(virtual_database)) {
@@ -279,6 +567,32 @@ Status ZeekConfiguration::parseConfigurationData(Context &context,
     context.group_list.push_back(group);
   }
 
+  context.server_list.push_back({context.server_address, context.server_port});
+
+  if (document.HasMember("server_list")) {
+    const auto &server_list = document["server_list"];
+
+    for (auto i = 0U; i < server_list.Size(); ++i) {
+      ServerAddress server_address;
+      status = parseServerAddress(server_address, server_list[i].GetString());
+      if (!status.succeeded()) {
+        return status;
+      }
+
+      auto it = std::find_if(
+          context.server_list.begin(), context.server_list.end(),
+
+          [&server_address](const ServerAddress &other) -> bool {
+            return (server_address.address == other.address &&
+                    server_address.port == other.port);
+          });
+
+      if (it == context.server_list.end()) {
+        context.server_list.push_back(std::move(server_address));
+      }
+    }
+  }
+
   if (document.HasMember("max_queued_row_count")) {
     context.max_queued_row_count =
         static_cast<std::uint32_t>(document["max_queued_row_count"].GetInt());
@@ -287,6 +601,148 @@ Status ZeekConfiguration::parseConfigurationData(Context &context,
     context.max_queued_row_count = 50000U;
   }
 
+  if (document.HasMember("session_resumption_timeout")) {
+    context.session_resumption_timeout = static_cast<std::uint32_t>(
+        document["session_resumption_timeout"].GetInt());
+
+  } else {
+    context.session_resumption_timeout = 30U;
+  }
+
+  if (document.HasMember("state_folder")) {
+    context.state_folder = document["state_folder"].GetString();
+
+  } else {
+    context.state_folder = "";
+  }
+
+  if (document.HasMember("max_rows_per_second")) {
+    context.max_rows_per_second =
+        static_cast<std::uint32_t>(document["max_rows_per_second"].GetInt());
+
+  } else {
+    context.max_rows_per_second = 0U;
+  }
+
+  if (document.HasMember("max_bytes_per_second")) {
+    context.max_bytes_per_second =
+        static_cast<std::uint32_t>(document["max_bytes_per_second"].GetInt());
+
+  } else {
+    context.max_bytes_per_second = 0U;
+  }
+
+  if (document.HasMember("max_topic_rows_per_second")) {
+    context.max_topic_rows_per_second = static_cast<std::uint32_t>(
+        document["max_topic_rows_per_second"].GetInt());
+
+  } else {
+    context.max_topic_rows_per_second = 0U;
+  }
+
+  if (document.HasMember("max_topic_bytes_per_second")) {
+    context.max_topic_bytes_per_second = static_cast<std::uint32_t>(
+        document["max_topic_bytes_per_second"].GetInt());
+
+  } else {
+    context.max_topic_bytes_per_second = 0U;
+  }
+
+  if (document.HasMember("audisp_parser")) {
+    context.audisp_parser = document["audisp_parser"].GetString();
+
+    if (context.audisp_parser != "auparse" &&
+        context.audisp_parser != "native") {
+      return Status::failure("Invalid audisp_parser value: " +
+                             context.audisp_parser);
+    }
+
+  } else {
+    context.audisp_parser = "auparse";
+  }
+
+  if (document.HasMember("audisp_overflow_policy")) {
+    context.audisp_overflow_policy =
+        document["audisp_overflow_policy"].GetString();
+
+    if (context.audisp_overflow_policy != "drop" &&
+        context.audisp_overflow_policy != "block") {
+      return Status::failure("Invalid audisp_overflow_policy value: " +
+                             context.audisp_overflow_policy);
+    }
+
+  } else {
+    context.audisp_overflow_policy = "drop";
+  }
+
+  context.audisp_filter_list = {};
+
+  if (document.HasMember("audisp_filter_list")) {
+    const auto &audisp_filter_list = document["audisp_filter_list"];
+
+    for (auto i = 0U; i < audisp_filter_list.Size(); ++i) {
+      context.audisp_filter_list.push_back(
+          audisp_filter_list[i].GetString());
+    }
+  }
+
+  if (document.HasMember("audisp_max_execve_argument_count")) {
+    context.audisp_max_execve_argument_count = static_cast<std::uint32_t>(
+        document["audisp_max_execve_argument_count"].GetInt());
+
+  } else {
+    context.audisp_max_execve_argument_count = 4096U;
+  }
+
+  if (document.HasMember("audisp_max_execve_command_line_size")) {
+    context.audisp_max_execve_command_line_size = static_cast<std::uint32_t>(
+        document["audisp_max_execve_command_line_size"].GetInt());
+
+  } else {
+    context.audisp_max_execve_command_line_size = 131072U;
+  }
+
+  if (document.HasMember("audisp_coalescing_window")) {
+    context.audisp_coalescing_window = static_cast<std::uint32_t>(
+        document["audisp_coalescing_window"].GetInt());
+
+  } else {
+    context.audisp_coalescing_window = 0U;
+  }
+
+  context.audisp_coalescing_key_list = {};
+
+  if (document.HasMember("audisp_coalescing_key_list")) {
+    const auto &audisp_coalescing_key_list =
+        document["audisp_coalescing_key_list"];
+
+    for (auto i = 0U; i < audisp_coalescing_key_list.Size(); ++i) {
+      context.audisp_coalescing_key_list.push_back(
+          audisp_coalescing_key_list[i].GetString());
+    }
+  }
+
+  if (document.HasMember("audisp_sampling_threshold")) {
+    context.audisp_sampling_threshold = static_cast<std::uint32_t>(
+        document["audisp_sampling_threshold"].GetInt());
+
+    if (context.audisp_sampling_threshold > 100U) {
+      return Status::failure("Invalid audisp_sampling_threshold value: " +
+                             std::to_string(context.audisp_sampling_threshold));
+    }
+
+  } else {
+    context.audisp_sampling_threshold = 0U;
+  }
+
+  if (document.HasMember("audisp_table_activity_timeout")) {
+    context.audisp_table_activity_timeout = static_cast<std::uint32_t>(
+        document["audisp_table_activity_timeout"].GetInt());
+
+  } else {
+    context.audisp_table_activity_timeout = 0U;
+  }
+
   if (document.HasMember("authentication")) {
     const auto &auth_object = document["authentication"];
     std::vector<std::string> auth_file_list;
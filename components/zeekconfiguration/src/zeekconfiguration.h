@@ -19,6 +19,10 @@ public:
   /// \return Returns the configured group list
   virtual const std::vector<std::string> &groupList() const override;
 
+  /// \return Returns all the configured servers. The first one is always
+  ///         the server_address/server_port pair
+  virtual const ServerAddressList &serverList() const override;
+
   /// \return Returns the configured log folder
   virtual const std::string &getLogFolder() const override;
 
@@ -38,6 +42,73 @@ public:
   ///         that is waiting to be queried
   virtual std::size_t maxQueuedRowCount() const override;
 
+  /// \return Returns how many seconds the agent waits, after reconnecting,
+  ///         for the Zeek server to renew the subscriptions of the previous
+  ///         session. A value of zero disables session resumption
+  virtual std::uint32_t sessionResumptionTimeout() const override;
+
+  /// \return Returns the folder where the agent persists its state across
+  ///         restarts. An empty path disables persistence
+  virtual const std::string &stateFolder() const override;
+
+  /// \return Returns how many rows the agent can publish every second,
+  ///         across all topics. A value of zero disables the limit
+  virtual std::uint32_t maxRowsPerSecond() const override;
+
+  /// \return Returns how many bytes the agent can publish every second,
+  ///         across all topics. A value of zero disables the limit
+  virtual std::uint32_t maxBytesPerSecond() const override;
+
+  /// \return Returns how many rows the agent can publish every second
+  ///         to a single response topic. A value of zero disables the
+  ///         limit
+  virtual std::uint32_t maxTopicRowsPerSecond() const override;
+
+  /// \return Returns how many bytes the agent can publish every second
+  ///         to a single response topic. A value of zero disables the
+  ///         limit
+  virtual std::uint32_t maxTopicBytesPerSecond() const override;
+
+  /// \return Returns the parser used for the audisp event stream; either
+  ///         "auparse" (libauparse) or "native"
+  virtual const std::string &audispParser() const override;
+
+  /// \return Returns what the audisp pipeline does with parsed events when
+  ///         the table stage falls behind; either "drop" or "block"
+  virtual const std::string &audispOverflowPolicy() const override;
+
+  /// \return Returns the rules used to discard unwanted audisp events, in
+  ///         the "<include|exclude> key=value ..." format
+  virtual const std::vector<std::string> &audispFilterList() const override;
+
+  /// \return Returns how many arguments are kept from each execve command
+  ///         line. A value of zero disables the limit
+  virtual std::uint32_t audispMaxExecveArgumentCount() const override;
+
+  /// \return Returns how many bytes are kept from each execve command line,
+  ///         across all of its arguments. A value of zero disables the limit
+  virtual std::uint32_t audispMaxExecveCommandLineSize() const override;
+
+  /// \return Returns for how many seconds identical audisp events are
+  ///         folded into a single row. A value of zero disables coalescing
+  virtual std::uint32_t audispCoalescingWindow() const override;
+
+  /// \return Returns the columns that identify duplicated events, for each
+  ///         audisp table, in the "<table>=<column>,<column>,..." format.
+  ///         Tables that are not listed compare all their columns
+  virtual const std::vector<std::string> &
+  audispCoalescingKeyList() const override;
+
+  /// \return Returns how full an audisp table queue can get, as a percentage
+  ///         of max_queued_row_count, before the table starts sampling its
+  ///         rows. A value of zero disables sampling
+  virtual std::uint32_t audispSamplingThreshold() const override;
+
+  /// \return Returns for how many seconds an audisp table keeps receiving
+  ///         events after it has last been queried. A value of zero keeps
+  ///         all the tables active
+  virtual std::uint32_t audispTableActivityTimeout() const override;
+
 protected:
   /// \brief Constructor
   /// \param virtual_database A reference to a virtual database instance. Used
@@ -79,6 +150,9 @@ public:
     /// \brief List of Zeek groups to join on startup
     std::vector<std::string> group_list;
 
+    /// \brief All the Zeek servers, including the main one
+    ServerAddressList server_list;
+
     /// \brief Path to the configured certificate authority
     std::string certificate_authority;
 
@@ -94,6 +168,62 @@ public:
     /// \brief Maximum amount of rows that can be queued in a table that is
     /// waiting to be queried
     std::size_t max_queued_row_count;
+
+    /// \brief How long to wait for the subscriptions of the previous session
+    /// to be renewed after a reconnection (0 disables resumption)
+    std::uint32_t session_resumption_timeout;
+
+    /// \brief Path to the folder where the agent state is persisted
+    std::string state_folder;
+
+    /// \brief Maximum amount of rows published every second (0 disables
+    /// the limit)
+    std::uint32_t max_rows_per_second;
+
+    /// \brief Maximum amount of bytes published every second (0 disables
+    /// the limit)
+    std::uint32_t max_bytes_per_second;
+
+    /// \brief Maximum amount of rows published every second to a single
+    /// topic (0 disables the limit)
+    std::uint32_t max_topic_rows_per_second;
+
+    /// \brief Maximum amount of bytes published every second to a single
+    /// topic (0 disables the limit)
+    std::uint32_t max_topic_bytes_per_second;
+
+    /// \brief The parser used for the audisp event stream
+    std::string audisp_parser;
+
+    /// \brief What the audisp pipeline does with parsed events when the
+    /// table stage falls behind
+    std::string audisp_overflow_policy;
+
+    /// \brief The rules used to discard unwanted audisp events
+    std::vector<std::string> audisp_filter_list;
+
+    /// \brief Maximum amount of arguments kept from each execve command line
+    /// (0 disables the limit)
+    std::uint32_t audisp_max_execve_argument_count;
+
+    /// \brief Maximum size of each execve command line, in bytes (0 disables
+    /// the limit)
+    std::uint32_t audisp_max_execve_command_line_size;
+
+    /// \brief How long identical audisp events are coalesced, in seconds
+    /// (0 disables coalescing)
+    std::uint32_t audisp_coalescing_window;
+
+    /// \brief The columns used to coalesce the events of each audisp table
+    std::vector<std::string> audisp_coalescing_key_list;
+
+    /// \brief Queue usage percentage that enables sampling in the audisp tables
+    /// (0 disables sampling)
+    std::uint32_t audisp_sampling_threshold;
+
+    /// \brief Seconds an audisp table keeps receiving events after its last
+    /// query (0 keeps all the tables active)
+    std::uint32_t audisp_table_activity_timeout;
   };
 
   /// \brief Parses the given configuration data in JSON format
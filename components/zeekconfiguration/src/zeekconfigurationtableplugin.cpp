@@ -41,6 +41,23 @@ void generateRow(IVirtualTable::RowList &row_list, const std::string &key_name,
 
   row_list.push_back(std::move(row));
 }
+
+void generateRow(IVirtualTable::RowList &row_list, const std::string &key_name,
+                 const IZeekConfiguration::ServerAddressList &value) {
+
+  std::vector<std::string> converted_value;
+  for (const auto &server_address : value) {
+    auto address = server_address.address;
+    if (address.find(':') != std::string::npos) {
+      address = "[" + address + "]";
+    }
+
+    converted_value.push_back(address + ":" +
+                              std::to_string(server_address.port));
+  }
+
+  generateRow(row_list, key_name, converted_value);
+}
 } // namespace
 
 struct ZeekConfigurationTablePlugin::PrivateData final {
@@ -94,6 +111,7 @@ Status ZeekConfigurationTablePlugin::generateRowList(RowList &row_list) {
   generateRow(row_list, "server_address", d->configuration.serverAddress());
   generateRow(row_list, "server_port", d->configuration.serverPort());
   generateRow(row_list, "group_list", d->configuration.groupList());
+  generateRow(row_list, "server_list", d->configuration.serverList());
   generateRow(row_list, "log_folder", d->configuration.getLogFolder());
 
   generateRow(row_list, "certificate_authority",
@@ -110,6 +128,49 @@ Status ZeekConfigurationTablePlugin::generateRowList(RowList &row_list) {
   generateRow(row_list, "max_queued_row_count",
               d->configuration.maxQueuedRowCount());
 
+  generateRow(row_list, "session_resumption_timeout",
+              d->configuration.sessionResumptionTimeout());
+
+  generateRow(row_list, "state_folder", d->configuration.stateFolder());
+
+  generateRow(row_list, "max_rows_per_second",
+              d->configuration.maxRowsPerSecond());
+
+  generateRow(row_list, "max_bytes_per_second",
+              d->configuration.maxBytesPerSecond());
+
+  generateRow(row_list, "max_topic_rows_per_second",
+              d->configuration.maxTopicRowsPerSecond());
+
+  generateRow(row_list, "max_topic_bytes_per_second",
+              d->configuration.maxTopicBytesPerSecond());
+
+  generateRow(row_list, "audisp_parser", d->configuration.audispParser());
+
+  generateRow(row_list, "audisp_overflow_policy",
+              d->configuration.audispOverflowPolicy());
+
+  generateRow(row_list, "audisp_filter_list",
+              d->configuration.audispFilterList());
+
+  generateRow(row_list, "audisp_max_execve_argument_count",
+              d->configuration.audispMaxExecveArgumentCount());
+
+  generateRow(row_list, "audisp_max_execve_command_line_size",
+              d->configuration.audispMaxExecveCommandLineSize());
+
+  generateRow(row_list, "audisp_coalescing_window",
+              d->configuration.audispCoalescingWindow());
+
+  generateRow(row_list, "audisp_coalescing_key_list",
+              d->configuration.audispCoalescingKeyList());
+
+  generateRow(row_list, "audisp_sampling_threshold",
+              d->configuration.audispSamplingThreshold());
+
+  generateRow(row_list, "audisp_table_activity_timeout",
+              d->configuration.audispTableActivityTimeout());
+
   return Status::success();
 }
 
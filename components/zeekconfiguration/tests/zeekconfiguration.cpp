@@ -22,6 +22,12 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
       "test/group/1"
     ],
 
+    "server_list": [
+      "127.0.0.1:9999",
+      "10.0.0.2:47760",
+      "[::1]:9999"
+    ],
+
     "authentication": {
       "certificate_authority": "nul",
       "client_certificate": "nul",
@@ -29,7 +35,22 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
     },
 
     "osquery_extensions_socket": "C:\\osquery_extensions_socket",
-    "max_queued_row_count": 1337
+    "max_queued_row_count": 1337,
+    "session_resumption_timeout": 15,
+    "state_folder": "/var/lib/zeek-agent",
+    "max_rows_per_second": 5000,
+    "max_bytes_per_second": 4194304,
+    "max_topic_rows_per_second": 1000,
+    "max_topic_bytes_per_second": 1048576,
+    "audisp_parser": "native",
+    "audisp_overflow_policy": "block",
+    "audisp_filter_list": [ "exclude exe=/usr/bin/ls" ],
+    "audisp_max_execve_argument_count": 1024,
+    "audisp_max_execve_command_line_size": 65536,
+    "audisp_coalescing_window": 5,
+    "audisp_coalescing_key_list": [ "file_events=pid,exe,syscall,path" ],
+    "audisp_sampling_threshold": 50,
+    "audisp_table_activity_timeout": 600
   }
   )"";
 
@@ -50,6 +71,12 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
       "test/group/1"
     ],
 
+    "server_list": [
+      "127.0.0.1:9999",
+      "10.0.0.2:47760",
+      "[::1]:9999"
+    ],
+
     "authentication": {
       "certificate_authority": "/dev/null",
       "client_certificate": "/dev/null",
@@ -57,7 +84,22 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
     },
 
     "osquery_extensions_socket": "/test/path",
-    "max_queued_row_count": 1337
+    "max_queued_row_count": 1337,
+    "session_resumption_timeout": 15,
+    "state_folder": "/var/lib/zeek-agent",
+    "max_rows_per_second": 5000,
+    "max_bytes_per_second": 4194304,
+    "max_topic_rows_per_second": 1000,
+    "max_topic_bytes_per_second": 1048576,
+    "audisp_parser": "native",
+    "audisp_overflow_policy": "block",
+    "audisp_filter_list": [ "exclude exe=/usr/bin/ls" ],
+    "audisp_max_execve_argument_count": 1024,
+    "audisp_max_execve_command_line_size": 65536,
+    "audisp_coalescing_window": 5,
+    "audisp_coalescing_key_list": [ "file_events=pid,exe,syscall,path" ],
+    "audisp_sampling_threshold": 50,
+    "audisp_table_activity_timeout": 600
   }
   )"";
 #endif
@@ -78,6 +120,14 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
   REQUIRE(context.group_list.at(0U) == "test/group/0");
   REQUIRE(context.group_list.at(1U) == "test/group/1");
 
+  REQUIRE(context.server_list.size() == 3U);
+  REQUIRE(context.server_list.at(0U).address == "127.0.0.1");
+  REQUIRE(context.server_list.at(0U).port == 9999U);
+  REQUIRE(context.server_list.at(1U).address == "10.0.0.2");
+  REQUIRE(context.server_list.at(1U).port == 47760U);
+  REQUIRE(context.server_list.at(2U).address == "::1");
+  REQUIRE(context.server_list.at(2U).port == 9999U);
+
   REQUIRE(context.certificate_authority == kExpectedCertFile);
   REQUIRE(context.client_certificate == kExpectedCertFile);
   REQUIRE(context.client_key == kExpectedCertFile);
@@ -85,5 +135,64 @@ TEST_CASE("Reading configuration files", "[ZeekConfiguration]") {
           kExceptedOsqueryExtensionsSocket);
 
   REQUIRE(context.max_queued_row_count == 1337U);
+  REQUIRE(context.session_resumption_timeout == 15U);
+  REQUIRE(context.state_folder == "/var/lib/zeek-agent");
+  REQUIRE(context.max_rows_per_second == 5000U);
+  REQUIRE(context.max_bytes_per_second == 4194304U);
+  REQUIRE(context.max_topic_rows_per_second == 1000U);
+  REQUIRE(context.max_topic_bytes_per_second == 1048576U);
+  REQUIRE(context.audisp_parser == "native");
+  REQUIRE(context.audisp_overflow_policy == "block");
+  REQUIRE(context.audisp_filter_list ==
+          std::vector<std::string>{"exclude exe=/usr/bin/ls"});
+  REQUIRE(context.audisp_max_execve_argument_count == 1024U);
+  REQUIRE(context.audisp_max_execve_command_line_size == 65536U);
+  REQUIRE(context.audisp_coalescing_window == 5U);
+  REQUIRE(context.audisp_coalescing_key_list ==
+          std::vector<std::string>{"file_events=pid,exe,syscall,path"});
+  REQUIRE(context.audisp_sampling_threshold == 50U);
+  REQUIRE(context.audisp_table_activity_timeout == 600U);
+}
+
+TEST_CASE("Invalid server list entries", "[ZeekConfiguration]") {
+  const std::vector<std::string> kInvalidEntryList = {
+      "127.0.0.1", "127.0.0.1:", ":9999", "127.0.0.1:0", "127.0.0.1:65536",
+      "127.0.0.1:port", "::1:9999", "[::1]9999", "[]:9999"};
+
+  for (const auto &entry : kInvalidEntryList) {
+    const std::string kTestConfiguration = R""(
+    {
+      "server_address": "127.0.0.1",
+      "server_port": 9999,
+      "log_folder": "/var/log/zeek",
+      "group_list": [],
+      "server_list": [ ")"" + entry + R""(" ]
+    }
+    )"";
+
+    ZeekConfiguration::Context context;
+    auto status =
+        ZeekConfiguration::parseConfigurationData(context, kTestConfiguration);
+
+    CHECK(!status.succeeded());
+  }
+}
+
+TEST_CASE("Invalid audisp sampling threshold", "[ZeekConfiguration]") {
+  const std::string kTestConfiguration = R""(
+  {
+    "server_address": "127.0.0.1",
+    "server_port": 9999,
+    "log_folder": "/var/log/zeek",
+    "group_list": [],
+    "audisp_sampling_threshold": 101
+  }
+  )"";
+
+  ZeekConfiguration::Context context;
+  auto status =
+      ZeekConfiguration::parseConfigurationData(context, kTestConfiguration);
+
+  CHECK(!status.succeeded());
 }
 } // namespace zeek
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string_view>
 #include <vector>
 
 #include <zeek/ivirtualtable.h>
@@ -26,6 +28,72 @@ public:
   /// \brief A list of generated rows, made of many OutputRow objects
   using QueryOutput = std::vector<OutputRow>;
 
+  /// \brief A read-only view over the current row of a running query. It
+  ///        is only valid inside IQueryOutputSink::processRow
+  class IRowView {
+  public:
+    /// \brief Column value types
+    enum class ColumnType { Null, Integer, String, Double };
+
+    /// \brief Constructor
+    IRowView() = default;
+
+    /// \brief Destructor
+    virtual ~IRowView() = default;
+
+    /// \return The number of columns in the row
+    virtual std::size_t columnCount() const = 0;
+
+    /// \param index The column index
+    /// \return The name of the specified column
+    virtual const std::string &columnName(std::size_t index) const = 0;
+
+    /// \param index The column index
+    /// \return The type of the value stored in the specified column
+    virtual ColumnType columnType(std::size_t index) const = 0;
+
+    /// \param index The index of an Integer column
+    /// \return The column value
+    virtual std::int64_t integerValue(std::size_t index) const = 0;
+
+    /// \param index The index of a Double column
+    /// \return The column value
+    virtual double doubleValue(std::size_t index) const = 0;
+
+    /// \param index The index of a String column
+    /// \return The column value, pointing inside the database buffers
+    virtual std::string_view stringValue(std::size_t index) const = 0;
+
+    IRowView(const IRowView &other) = delete;
+    IRowView &operator=(const IRowView &other) = delete;
+  };
+
+  /// \brief Receives the query output one row at a time, while the
+  ///        statement is being stepped
+  class IQueryOutputSink {
+  public:
+    /// \brief A reference to a query output sink
+    using Ref = std::unique_ptr<IQueryOutputSink>;
+
+    /// \brief Constructor
+    IQueryOutputSink() = default;
+
+    /// \brief Destructor
+    virtual ~IQueryOutputSink() = default;
+
+    /// \brief Processes the next row; returning an error aborts the query
+    /// \param row The current row
+    /// \return A Status object
+    virtual Status processRow(const IRowView &row) = 0;
+
+    /// \brief Called once after the last row has been processed
+    /// \return A Status object
+    virtual Status finish() = 0;
+
+    IQueryOutputSink(const IQueryOutputSink &other) = delete;
+    IQueryOutputSink &operator=(const IQueryOutputSink &other) = delete;
+  };
+
   /// \brief A reference to a virtual database object
   using Ref = std::unique_ptr<IVirtualDatabase>;
 
@@ -59,6 +127,14 @@ public:
   /// \return A Status object
   virtual Status query(QueryOutput &output, const std::string &query) const = 0;
 
+  /// \brief Queries the virtual database, passing each row to the given
+  ///        sink as soon as it is produced
+  /// \param sink The object receiving the query output
+  /// \param query The SQL statement to execute
+  /// \return A Status object
+  virtual Status query(IQueryOutputSink &sink,
+                       const std::string &query) const = 0;
+
   IVirtualDatabase(const IVirtualDatabase &other) = delete;
   IVirtualDatabase &operator=(const IVirtualDatabase &other) = delete;
 };
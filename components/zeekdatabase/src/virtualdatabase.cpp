@@ -3,15 +3,166 @@
 #include "virtualtablemodule.h"
 #include "zeektablelisttableplugin.h"
 
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 
 #include <sqlite3.h>
 
 namespace zeek {
+namespace {
+/// \brief Exposes the current row of a SQLite statement without copying
+class SqliteRowView final : public IVirtualDatabase::IRowView {
+public:
+  /// \brief Constructor
+  /// \param sql_stmt A prepared SQLite statement
+  SqliteRowView(sqlite3_stmt *sql_stmt) : statement(sql_stmt) {
+    auto column_count = sqlite3_column_count(statement);
+
+    column_name_list.reserve(static_cast<std::size_t>(column_count));
+    column_type_list.resize(static_cast<std::size_t>(column_count));
+
+    for (int column_index = 0; column_index < column_count; ++column_index) {
+      column_name_list.push_back(sqlite3_column_name(statement, column_index));
+    }
+  }
+
+  /// \brief Destructor
+  virtual ~SqliteRowView() override = default;
+
+  /// \brief Reads the column types of the row the statement is pointing to
+  /// \return A Status object
+  Status update() {
+    for (std::size_t i = 0U; i < column_type_list.size(); ++i) {
+      auto sqlite_type = sqlite3_column_type(statement, static_cast<int>(i));
+
+      switch (sqlite_type) {
+      case SQLITE_NULL:
+        column_type_list[i] = ColumnType::Null;
+        break;
+
+      case SQLITE_INTEGER:
+        column_type_list[i] = ColumnType::Integer;
+        break;
+
+      case SQLITE_FLOAT:
+        column_type_list[i] = ColumnType::Double;
+        break;
+
+      case SQLITE_TEXT:
+        column_type_list[i] = ColumnType::String;
+        break;
+
+      default:
+        return Status::failure("Invalid column type found");
+      }
+    }
+
+    return Status::success();
+  }
+
+  virtual std::size_t columnCount() const override {
+    return column_name_list.size();
+  }
+
+  virtual const std::string &columnName(std::size_t index) const override {
+    return column_name_list.at(index);
+  }
+
+  virtual ColumnType columnType(std::size_t index) const override {
+    return column_type_list.at(index);
+  }
+
+  virtual std::int64_t integerValue(std::size_t index) const override {
+    return static_cast<std::int64_t>(
+        sqlite3_column_int64(statement, static_cast<int>(index)));
+  }
+
+  virtual double doubleValue(std::size_t index) const override {
+    return sqlite3_column_double(statement, static_cast<int>(index));
+  }
+
+  virtual std::string_view stringValue(std::size_t index) const override {
+    // sqlite3_column_bytes must be called after sqlite3_column_text, so
+    // that the size matches the UTF-8 representation
+    auto string_data = reinterpret_cast<const char *>(
+        sqlite3_column_text(statement, static_cast<int>(index)));
+
+    auto string_size = sqlite3_column_bytes(statement, static_cast<int>(index));
+
+    if (string_data == nullptr) {
+      return {};
+    }
+
+    return std::string_view(string_data,
+                            static_cast<std::size_t>(string_size));
+  }
+
+private:
+  sqlite3_stmt *statement{nullptr};
+  std::vector<std::string> column_name_list;
+  std::vector<ColumnType> column_type_list;
+};
+
+/// \brief Materializes the whole query output, used by the QueryOutput
+///        overload of VirtualDatabase::query
+class QueryOutputBuilder final : public IVirtualDatabase::IQueryOutputSink {
+public:
+  /// \brief Constructor
+  /// \param query_output Where the rows are stored
+  QueryOutputBuilder(IVirtualDatabase::QueryOutput &query_output)
+      : output(query_output) {}
+
+  /// \brief Destructor
+  virtual ~QueryOutputBuilder() override = default;
+
+  virtual Status processRow(const IVirtualDatabase::IRowView &row) override {
+    IVirtualDatabase::OutputRow current_row;
+    current_row.reserve(row.columnCount());
+
+    for (std::size_t i = 0U; i < row.columnCount(); ++i) {
+      IVirtualDatabase::ColumnValue column;
+      column.name = row.columnName(i);
+
+      switch (row.columnType(i)) {
+      case IVirtualDatabase::IRowView::ColumnType::Null:
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::Integer:
+        column.data = row.integerValue(i);
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::Double:
+        column.data = row.doubleValue(i);
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::String:
+        column.data = std::string(row.stringValue(i));
+        break;
+      }
+
+      current_row.push_back(std::move(column));
+    }
+
+    output.push_back(std::move(current_row));
+    return Status::success();
+  }
+
+  virtual Status finish() override { return Status::success(); }
+
+private:
+  IVirtualDatabase::QueryOutput &output;
+};
+} // namespace
+
 struct VirtualDatabase::PrivateData final {
   sqlite3 *sqlite_database{nullptr};
 
+  // Queries can be issued by more than one thread, and SQLite connections
+  // must not be used concurrently. The mutex is recursive because the
+  // registration methods call each other
+  std::recursive_mutex database_mutex;
+
   std::unordered_map<std::string, VirtualTableModule::Ref>
       registered_module_list;
 
@@ -26,6 +177,8 @@ VirtualDatabase::~VirtualDatabase() {
 }
 
 std::vector<std::string> VirtualDatabase::virtualTableList() const {
+  std::lock_guard<std::recursive_mutex> lock(d->database_mutex);
+
   std::vector<std::string> virtual_table_list;
 
   for (const auto &p : d->registered_module_list) {
@@ -37,6 +190,8 @@ std::vector<std::string> VirtualDatabase::virtualTableList() const {
 }
 
 Status VirtualDatabase::registerTable(IVirtualTable::Ref table) {
+  std::lock_guard<std::recursive_mutex> lock(d->database_mutex);
+
   if (table->name().empty()) {
     return Status::failure("Empty table name");
   }
@@ -83,6 +238,8 @@ Status VirtualDatabase::registerTable(IVirtualTable::Ref table) {
 }
 
 Status VirtualDatabase::unregisterTable(const std::string &name) {
+  std::lock_guard<std::recursive_mutex> lock(d->database_mutex);
+
   auto table_it = d->registered_module_list.find(name);
   if (table_it == d->registered_module_list.end()) {
     return Status::failure("The specified table does not exists");
@@ -127,59 +284,53 @@ Status VirtualDatabase::query(QueryOutput &output,
 
   output = {};
 
-  SqliteStatement sql_stmt;
-  auto status = prepareSqliteStatement(sql_stmt, d->sqlite_database, query);
-  if (!status.succeeded()) {
-    return status;
-  }
+  QueryOutput temp_output;
+  QueryOutputBuilder query_output_builder(temp_output);
 
+  auto status = this->query(query_output_builder, query);
   if (!status.succeeded()) {
     return status;
   }
 
-  QueryOutput temp_output;
-  auto column_count = sqlite3_column_count(sql_stmt.get());
-
-  while (sqlite3_step(sql_stmt.get()) == SQLITE_ROW) {
-    OutputRow current_row = {};
-
-    for (int column_index = 0; column_index < column_count; ++column_index) {
-      ColumnValue column = {};
-
-      auto sqlite_type = sqlite3_column_type(sql_stmt.get(), column_index);
-
-      switch (sqlite_type) {
-      case SQLITE_NULL:
-        break;
+  output = std::move(temp_output);
+  return Status::success();
+}
 
-      case SQLITE_INTEGER:
-        column.data = static_cast<std::int64_t>(
-            sqlite3_column_int(sql_stmt.get(), column_index));
+Status VirtualDatabase::query(IQueryOutputSink &sink,
+                              const std::string &query) const {
 
-        break;
+  std::lock_guard<std::recursive_mutex> lock(d->database_mutex);
 
-      case SQLITE_TEXT: {
-        auto string_data = reinterpret_cast<const char *>(
-            sqlite3_column_text(sql_stmt.get(), column_index));
+  SqliteStatement sql_stmt;
+  auto status = prepareSqliteStatement(sql_stmt, d->sqlite_database, query);
+  if (!status.succeeded()) {
+    return status;
+  }
 
-        column.data = std::string(string_data);
-        break;
-      }
+  SqliteRowView row_view(sql_stmt.get());
 
-      default:
-        return Status::failure("Invalid column type found");
-      }
+  for (;;) {
+    auto err = sqlite3_step(sql_stmt.get());
+    if (err == SQLITE_DONE) {
+      break;
 
-      column.name = sqlite3_column_name(sql_stmt.get(), column_index);
+    } else if (err != SQLITE_ROW) {
+      return Status::failure("Failed to execute the query: " +
+                             std::string(sqlite3_errmsg(d->sqlite_database)));
+    }
 
-      current_row.push_back(std::move(column));
+    status = row_view.update();
+    if (!status.succeeded()) {
+      return status;
     }
 
-    temp_output.push_back(std::move(current_row));
+    status = sink.processRow(row_view);
+    if (!status.succeeded()) {
+      return status;
+    }
   }
 
-  output = std::move(temp_output);
-  return Status::success();
+  return sink.finish();
 }
 
 VirtualDatabase::VirtualDatabase() : d(new PrivateData) {
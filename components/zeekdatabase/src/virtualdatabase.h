@@ -32,6 +32,14 @@ public:
   virtual Status query(QueryOutput &output,
                        const std::string &query) const override;
 
+  /// \brief Queries the virtual database, passing each row to the given
+  ///        sink as soon as it is produced
+  /// \param sink The object receiving the query output
+  /// \param query The SQL statement to execute
+  /// \return A Status object
+  virtual Status query(IQueryOutputSink &sink,
+                       const std::string &query) const override;
+
 protected:
   /// \brief Constructor
   VirtualDatabase();
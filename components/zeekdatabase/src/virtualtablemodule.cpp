@@ -277,7 +277,8 @@ int VirtualTableModule::onTableColumn(sqlite3_vtab_cursor *cursor,
     const auto &current_column_data =
         std::get<std::int64_t>(current_column_value_data);
 
-    sqlite3_result_int(context, static_cast<int>(current_column_data));
+    sqlite3_result_int64(context,
+                         static_cast<sqlite3_int64>(current_column_data));
 
   } else if (std::holds_alternative<std::string>(current_column_value_data)) {
     const auto &current_column_data =
@@ -342,6 +343,10 @@ VirtualTableModule::generateSQLTableDefinition(std::string &sql_statement,
       column_type_as_string = "TEXT";
       break;
 
+    case IVirtualTable::ColumnType::Double:
+      column_type_as_string = "DOUBLE";
+      break;
+
     default:
       break;
     }
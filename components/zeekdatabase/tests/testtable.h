@@ -7,6 +7,8 @@ class TestTable final : public IVirtualTable {
 public:
   enum class SchemaType { Valid, Invalid };
 
+  static const std::int64_t kLargeIntegerBase{0x100000000LL};
+
   TestTable(SchemaType schema_type_, std::size_t row_count_ = 1U)
       : schema_type(schema_type_), row_count(row_count_) {}
 
@@ -21,6 +23,8 @@ public:
     // clang-format off
     static const Schema kValidTableSchema = {
       { "integer", IVirtualTable::ColumnType::Integer },
+      { "large_integer", IVirtualTable::ColumnType::Integer },
+      { "floating_point", IVirtualTable::ColumnType::Double },
       { "string", IVirtualTable::ColumnType::String }
     };
     // clang-format on
@@ -42,6 +46,8 @@ public:
     for (auto i = 0U; i < row_count; ++i) {
       Row row = {};
       row.insert({"integer", static_cast<std::int64_t>(i)});
+      row.insert({"large_integer", kLargeIntegerBase + i});
+      row.insert({"floating_point", static_cast<double>(i) + 0.5});
       row.insert({"string", std::to_string(i)});
       row_list.push_back(row);
     }
@@ -4,6 +4,50 @@
 #include <catch2/catch.hpp>
 
 namespace zeek {
+namespace {
+class TestQueryOutputSink final : public IVirtualDatabase::IQueryOutputSink {
+public:
+  virtual ~TestQueryOutputSink() override = default;
+
+  virtual Status processRow(const IVirtualDatabase::IRowView &row) override {
+    if (finished) {
+      return Status::failure("Row received after the end of the output");
+    }
+
+    REQUIRE(row.columnCount() == 3U);
+    REQUIRE(row.columnName(0U) == "large_integer");
+    REQUIRE(row.columnName(1U) == "floating_point");
+    REQUIRE(row.columnName(2U) == "string");
+
+    REQUIRE(row.columnType(0U) ==
+            IVirtualDatabase::IRowView::ColumnType::Integer);
+
+    REQUIRE(row.columnType(1U) ==
+            IVirtualDatabase::IRowView::ColumnType::Double);
+
+    REQUIRE(row.columnType(2U) ==
+            IVirtualDatabase::IRowView::ColumnType::String);
+
+    auto row_index = static_cast<std::int64_t>(row_count);
+
+    CHECK(row.integerValue(0U) == TestTable::kLargeIntegerBase + row_index);
+    CHECK(row.doubleValue(1U) == static_cast<double>(row_index) + 0.5);
+    CHECK(row.stringValue(2U) == std::to_string(row_index));
+
+    ++row_count;
+    return Status::success();
+  }
+
+  virtual Status finish() override {
+    finished = true;
+    return Status::success();
+  }
+
+  std::size_t row_count{0U};
+  bool finished{false};
+};
+} // namespace
+
 SCENARIO("Basic VirtualDatabase operations", "[VirtualDatabase]") {
   GIVEN("a virtual database") {
     IVirtualDatabase::Ref virtual_database;
@@ -119,6 +163,27 @@ SCENARIO("Basic VirtualDatabase operations", "[VirtualDatabase]") {
       }
     }
 
+    WHEN("streaming the output of a query to a sink") {
+      static const std::size_t kRowCount{100U};
+
+      IVirtualTable::Ref test_table(
+          new TestTable(TestTable::SchemaType::Valid, kRowCount));
+
+      status = virtual_database->registerTable(test_table);
+      REQUIRE(status.succeeded());
+
+      TestQueryOutputSink query_output_sink;
+      status = virtual_database->query(
+          query_output_sink,
+          "SELECT large_integer, floating_point, string FROM TestTable;");
+
+      THEN("each row is visited with 64-bit integers and doubles intact") {
+        REQUIRE(status.succeeded());
+        CHECK(query_output_sink.row_count == kRowCount);
+        CHECK(query_output_sink.finished);
+      }
+    }
+
     WHEN("querying an empty table") {
       static const std::size_t kRowCount{0U};
 
@@ -17,7 +17,8 @@ SCENARIO("Basic VirtualTableModule operations", "[VirtualTableModule]") {
 
       THEN("a valid SQL statement is generated") {
         static const std::string kExpectedSQLStatement{
-            "CREATE TABLE TestTable (\n  integer BIGINT,\n  string TEXT\n)\n"};
+            "CREATE TABLE TestTable (\n  floating_point DOUBLE,\n  integer "
+            "BIGINT,\n  large_integer BIGINT,\n  string TEXT\n)\n"};
 
         REQUIRE(sql_statement == kExpectedSQLStatement);
       }
@@ -1,12 +1,12 @@
 #include "zeekloggertableplugin.h"
 
 #include <chrono>
-#include <mutex>
+
+#include <zeek/mpscbatchqueue.h>
 
 namespace zeek {
 struct ZeekLoggerTablePlugin::PrivateData final {
-  RowList row_list;
-  std::mutex row_list_mutex;
+  MPSCBatchQueue<Row> row_queue;
 };
 
 Status ZeekLoggerTablePlugin::create(Ref &obj) {
@@ -47,11 +47,7 @@ const ZeekLoggerTablePlugin::Schema &ZeekLoggerTablePlugin::schema() const {
 }
 
 Status ZeekLoggerTablePlugin::generateRowList(RowList &row_list) {
-  std::lock_guard<std::mutex> lock(d->row_list_mutex);
-
-  row_list = std::move(d->row_list);
-  d->row_list = {};
-
+  d->row_queue.takeAll(row_list);
   return Status::success();
 }
 
@@ -64,12 +60,7 @@ Status ZeekLoggerTablePlugin::appendMessage(IZeekLogger::Severity severity,
     return status;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(d->row_list_mutex);
-
-    d->row_list.push_back(std::move(row));
-  }
-
+  d->row_queue.push(std::move(row));
   return Status::success();
 }
 
@@ -27,6 +27,10 @@ public:
   /// \param terminate When set to true, the service should terminate
   /// \return A Status object
   virtual Status exec(std::atomic_bool &terminate) = 0;
+
+  /// \brief Wakes up the service if it is blocked waiting for new events.
+  ///        Called after the terminate flag has been set
+  virtual void interrupt() {}
 };
 
 /// \brief An interface for service factories
@@ -76,6 +76,11 @@ Status ZeekServiceManager::startServices() {
 void ZeekServiceManager::stopServices() {
   d->terminate = true;
 
+  for (auto &p : d->service_list) {
+    auto &service_instance = p.second;
+    service_instance.service->interrupt();
+  }
+
   for (auto &p : d->service_list) {
     const auto &service_name = p.first;
     auto &service_instance = p.second;
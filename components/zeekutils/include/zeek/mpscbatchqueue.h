@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace zeek {
+/// \brief An unbounded, lock-free queue where any number of producer
+///        threads append batches of items, and a single consumer thread
+///        takes everything that has been queued at once
+template <typename T> class MPSCBatchQueue final {
+public:
+  /// \brief A list of items, appended or taken with a single operation
+  using Batch = std::vector<T>;
+
+  /// \brief Constructor
+  MPSCBatchQueue() = default;
+
+  /// \brief Destructor
+  ~MPSCBatchQueue() { deleteNodeList(head.exchange(nullptr)); }
+
+  /// \brief Appends a single item. This method can be called from any
+  ///        thread
+  /// \param value The item to append
+  void push(T value) {
+    Batch batch;
+    batch.push_back(std::move(value));
+
+    pushBatch(std::move(batch));
+  }
+
+  /// \brief Appends a list of items, keeping their order. This method can
+  ///        be called from any thread
+  /// \param batch The items to append
+  void pushBatch(Batch batch) {
+    if (batch.empty()) {
+      return;
+    }
+
+    // Counted before being published, so that the consumer never takes
+    // more items than have been counted
+    item_count.fetch_add(batch.size(), std::memory_order_relaxed);
+
+    auto node = new Node{std::move(batch), nullptr};
+    node->next = head.load(std::memory_order_relaxed);
+
+    while (!head.compare_exchange_weak(node->next, node,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  /// \brief Takes all the queued items, in the order they were appended.
+  ///        Only one thread at a time should call this method
+  /// \param item_list Where the items are stored
+  void takeAll(Batch &item_list) {
+    item_list = {};
+
+    // Nodes are pushed to the front, so the detached list is newest first
+    Node *node_list{nullptr};
+    for (auto node = head.exchange(nullptr, std::memory_order_acquire);
+         node != nullptr;) {
+
+      auto next_node = node->next;
+      node->next = node_list;
+      node_list = node;
+      node = next_node;
+    }
+
+    std::size_t taken_item_count{0U};
+
+    for (auto node = node_list; node != nullptr; node = node->next) {
+      taken_item_count += node->batch.size();
+
+      if (item_list.empty()) {
+        item_list = std::move(node->batch);
+
+      } else {
+        item_list.insert(item_list.end(),
+                         std::make_move_iterator(node->batch.begin()),
+                         std::make_move_iterator(node->batch.end()));
+      }
+    }
+
+    deleteNodeList(node_list);
+    item_count.fetch_sub(taken_item_count, std::memory_order_relaxed);
+  }
+
+  /// \return How many items are queued; an estimate while producers are
+  ///         appending
+  std::size_t size() const {
+    return item_count.load(std::memory_order_relaxed);
+  }
+
+  MPSCBatchQueue(const MPSCBatchQueue &) = delete;
+  MPSCBatchQueue &operator=(const MPSCBatchQueue &) = delete;
+
+private:
+  /// \brief A single queued batch
+  struct Node final {
+    /// \brief The batch items
+    Batch batch;
+
+    /// \brief The next node in the list
+    Node *next{nullptr};
+  };
+
+  /// \brief Deletes all the nodes in the given list
+  /// \param node_list The first node of the list
+  static void deleteNodeList(Node *node_list) {
+    while (node_list != nullptr) {
+      auto next_node = node_list->next;
+      delete node_list;
+
+      node_list = next_node;
+    }
+  }
+
+  /// \brief The most recently appended node
+  std::atomic<Node *> head{nullptr};
+
+  /// \brief How many items are queued
+  std::atomic<std::size_t> item_count{0U};
+};
+} // namespace zeek
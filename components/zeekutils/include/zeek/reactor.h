@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief A file descriptor that can be signaled to wake up a Reactor
+class EventNotifier final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A reference to an event notifier object
+  using Ref = std::unique_ptr<EventNotifier>;
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \return A Status object
+  static Status create(Ref &obj);
+
+  /// \brief Destructor
+  ~EventNotifier();
+
+  /// \return The file descriptor that becomes readable when signaled
+  int fd() const;
+
+  /// \brief Signals the notifier, waking up the reactors watching it.
+  ///        This method can be called from any thread
+  void notify();
+
+  /// \brief Clears the pending notifications
+  void reset();
+
+  EventNotifier(const EventNotifier &) = delete;
+  EventNotifier &operator=(const EventNotifier &) = delete;
+
+protected:
+  /// \brief Constructor
+  EventNotifier();
+};
+
+/// \brief A readiness notification loop built on top of epoll
+class Reactor final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A reference to a reactor object
+  using Ref = std::unique_ptr<Reactor>;
+
+  /// \brief A list of file descriptors
+  using DescriptorList = std::vector<int>;
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \return A Status object
+  static Status create(Ref &obj);
+
+  /// \brief Destructor
+  ~Reactor();
+
+  /// \brief Starts watching the given file descriptor for incoming data
+  /// \param fd The file descriptor to watch
+  /// \return A Status object
+  Status addDescriptor(int fd);
+
+  /// \brief Stops watching the given file descriptor
+  /// \param fd A file descriptor previously passed to addDescriptor
+  /// \return A Status object
+  Status removeDescriptor(int fd);
+
+  /// \brief Waits until one or more descriptors become readable
+  /// \param ready_list Where the readable descriptors are stored; empty
+  ///                   if the timeout has expired
+  /// \param timeout How long to wait for new events
+  /// \return A Status object
+  Status wait(DescriptorList &ready_list,
+              const std::chrono::milliseconds &timeout);
+
+  Reactor(const Reactor &) = delete;
+  Reactor &operator=(const Reactor &) = delete;
+
+protected:
+  /// \brief Constructor
+  Reactor();
+};
+} // namespace zeek
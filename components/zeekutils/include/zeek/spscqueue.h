@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief A bounded, lock-free queue with exactly one producer thread and
+///        one consumer thread
+template <typename T> class SPSCQueue final {
+public:
+  /// \brief Constructor
+  /// \param capacity How many items the queue can hold
+  SPSCQueue(std::size_t capacity) {
+    if (capacity == 0U) {
+      throw Status::failure("Invalid queue capacity");
+    }
+
+    // One slot is always kept empty to tell a full queue from an empty one
+    slot_list.resize(capacity + 1U);
+  }
+
+  /// \brief Appends an item; must only be called by the producer
+  /// \param value The item to append, moved only when there is room
+  /// \return False if the queue is full
+  bool tryPush(T &value) {
+    auto current_tail = tail.load(std::memory_order_relaxed);
+    auto next_tail = nextIndex(current_tail);
+
+    if (next_tail == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    slot_list[current_tail] = std::move(value);
+    tail.store(next_tail, std::memory_order_release);
+
+    return true;
+  }
+
+  /// \brief Removes the oldest item; must only be called by the consumer
+  /// \param value Where the item is stored
+  /// \return False if the queue is empty
+  bool tryPop(T &value) {
+    auto current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = std::move(slot_list[current_head]);
+    slot_list[current_head] = {};
+
+    head.store(nextIndex(current_head), std::memory_order_release);
+    return true;
+  }
+
+  /// \return How many items are queued. When called from a thread other
+  ///         than the producer and the consumer, this is an estimate
+  std::size_t size() const {
+    auto current_head = head.load(std::memory_order_acquire);
+    auto current_tail = tail.load(std::memory_order_acquire);
+
+    if (current_tail >= current_head) {
+      return current_tail - current_head;
+    }
+
+    return slot_list.size() - current_head + current_tail;
+  }
+
+  /// \return How many items the queue can hold
+  std::size_t capacity() const { return slot_list.size() - 1U; }
+
+  SPSCQueue(const SPSCQueue &) = delete;
+  SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+private:
+  /// \brief Returns the slot that follows the given one
+  /// \param index A slot index
+  /// \return The next slot index
+  std::size_t nextIndex(std::size_t index) const {
+    ++index;
+    return index == slot_list.size() ? 0U : index;
+  }
+
+  /// \brief The item storage
+  std::vector<T> slot_list;
+
+  /// \brief The next slot to be read, owned by the consumer. Kept on its
+  ///        own cache line so that the two threads do not invalidate each
+  ///        other's writes
+  alignas(64) std::atomic<std::size_t> head{0U};
+
+  /// \brief The next slot to be written, owned by the producer
+  alignas(64) std::atomic<std::size_t> tail{0U};
+};
+} // namespace zeek
@@ -0,0 +1,146 @@
+#include <zeek/reactor.h>
+
+#include <cerrno>
+#include <cstdint>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace zeek {
+namespace {
+const std::size_t kMaxEventCount{64U};
+} // namespace
+
+struct EventNotifier::PrivateData final {
+  int fd{-1};
+};
+
+Status EventNotifier::create(Ref &obj) {
+  obj.reset();
+
+  try {
+    auto ptr = new EventNotifier();
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+EventNotifier::~EventNotifier() { close(d->fd); }
+
+int EventNotifier::fd() const { return d->fd; }
+
+void EventNotifier::notify() {
+  std::uint64_t value{1U};
+
+  // The only possible failure is a counter overflow, in which case the
+  // descriptor is already readable
+  auto err = write(d->fd, &value, sizeof(value));
+  static_cast<void>(err);
+}
+
+void EventNotifier::reset() {
+  std::uint64_t value{0U};
+
+  auto err = read(d->fd, &value, sizeof(value));
+  static_cast<void>(err);
+}
+
+EventNotifier::EventNotifier() : d(new PrivateData) {
+  d->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (d->fd == -1) {
+    throw Status::failure("Failed to create the eventfd descriptor: errno " +
+                          std::to_string(errno));
+  }
+}
+
+struct Reactor::PrivateData final {
+  int epoll_fd{-1};
+  std::vector<struct epoll_event> event_list;
+};
+
+Status Reactor::create(Ref &obj) {
+  obj.reset();
+
+  try {
+    auto ptr = new Reactor();
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+Reactor::~Reactor() { close(d->epoll_fd); }
+
+Status Reactor::addDescriptor(int fd) {
+  struct epoll_event event {};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+
+  if (epoll_ctl(d->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    return Status::failure("epoll_ctl() has failed to add descriptor " +
+                           std::to_string(fd) + ": errno " +
+                           std::to_string(errno));
+  }
+
+  return Status::success();
+}
+
+Status Reactor::removeDescriptor(int fd) {
+  if (epoll_ctl(d->epoll_fd, EPOLL_CTL_DEL, fd, nullptr) != 0) {
+    return Status::failure("epoll_ctl() has failed to remove descriptor " +
+                           std::to_string(fd) + ": errno " +
+                           std::to_string(errno));
+  }
+
+  return Status::success();
+}
+
+Status Reactor::wait(DescriptorList &ready_list,
+                     const std::chrono::milliseconds &timeout) {
+  ready_list.clear();
+
+  auto event_count =
+      epoll_wait(d->epoll_fd, d->event_list.data(),
+                 static_cast<int>(d->event_list.size()),
+                 static_cast<int>(timeout.count()));
+
+  if (event_count == -1) {
+    if (errno == EINTR) {
+      return Status::success();
+    }
+
+    return Status::failure("epoll_wait() has failed: errno " +
+                           std::to_string(errno));
+  }
+
+  for (int i = 0; i < event_count; ++i) {
+    ready_list.push_back(d->event_list[static_cast<std::size_t>(i)].data.fd);
+  }
+
+  return Status::success();
+}
+
+Reactor::Reactor() : d(new PrivateData) {
+  d->event_list.resize(kMaxEventCount);
+
+  d->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (d->epoll_fd == -1) {
+    throw Status::failure("Failed to create the epoll descriptor: errno " +
+                          std::to_string(errno));
+  }
+}
+} // namespace zeek
@@ -0,0 +1,74 @@
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+#include <zeek/mpscbatchqueue.h>
+
+namespace zeek {
+TEST_CASE("MPSC batch queue", "[MPSCBatchQueue]") {
+  MPSCBatchQueue<int> queue;
+
+  SECTION("Items are taken in the order they were appended") {
+    queue.push(1);
+    queue.pushBatch({2, 3, 4});
+    queue.pushBatch({});
+    queue.push(5);
+
+    REQUIRE(queue.size() == 5U);
+
+    MPSCBatchQueue<int>::Batch item_list;
+    queue.takeAll(item_list);
+
+    REQUIRE(item_list == MPSCBatchQueue<int>::Batch{1, 2, 3, 4, 5});
+    REQUIRE(queue.size() == 0U);
+
+    queue.takeAll(item_list);
+    REQUIRE(item_list.empty());
+  }
+
+  SECTION("Concurrent producers do not lose items") {
+    const int kProducerCount{4};
+    const int kItemsPerProducer{10000};
+
+    std::vector<std::thread> producer_list;
+    for (int producer = 0; producer < kProducerCount; ++producer) {
+      producer_list.emplace_back([&queue, producer]() {
+        for (int i = 0; i < kItemsPerProducer; ++i) {
+          queue.push(producer * kItemsPerProducer + i);
+        }
+      });
+    }
+
+    MPSCBatchQueue<int>::Batch item_list;
+    std::vector<int> last_item_list(kProducerCount, -1);
+    std::size_t taken_item_count{0U};
+
+    auto validateItems = [&]() {
+      for (auto item : item_list) {
+        auto producer = item / kItemsPerProducer;
+
+        // Items from the same producer must keep their order
+        REQUIRE(item > last_item_list.at(producer));
+        last_item_list.at(producer) = item;
+      }
+
+      taken_item_count += item_list.size();
+    };
+
+    while (taken_item_count < kProducerCount * kItemsPerProducer) {
+      queue.takeAll(item_list);
+      validateItems();
+
+      std::this_thread::yield();
+    }
+
+    for (auto &producer : producer_list) {
+      producer.join();
+    }
+
+    queue.takeAll(item_list);
+    REQUIRE(item_list.empty());
+    REQUIRE(queue.size() == 0U);
+  }
+}
+} // namespace zeek
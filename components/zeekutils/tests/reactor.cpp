@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+#include <unistd.h>
+
+#include <zeek/reactor.h>
+
+namespace zeek {
+namespace {
+const std::chrono::milliseconds kLongTimeout{5000};
+
+bool isReady(const Reactor::DescriptorList &ready_list, int fd) {
+  return std::find(ready_list.begin(), ready_list.end(), fd) !=
+         ready_list.end();
+}
+} // namespace
+
+TEST_CASE("Waking up the reactor", "[Reactor]") {
+  Reactor::Ref reactor;
+  auto status = Reactor::create(reactor);
+  REQUIRE(status.succeeded());
+
+  EventNotifier::Ref event_notifier;
+  status = EventNotifier::create(event_notifier);
+  REQUIRE(status.succeeded());
+
+  status = reactor->addDescriptor(event_notifier->fd());
+  REQUIRE(status.succeeded());
+
+  Reactor::DescriptorList ready_list;
+
+  SECTION("The wait times out when nothing happens") {
+    status = reactor->wait(ready_list, std::chrono::milliseconds(10));
+
+    REQUIRE(status.succeeded());
+    CHECK(ready_list.empty());
+  }
+
+  SECTION("A notification from another thread ends the wait") {
+    std::thread notifier_thread([&event_notifier]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      event_notifier->notify();
+    });
+
+    auto start_time = std::chrono::steady_clock::now();
+    status = reactor->wait(ready_list, kLongTimeout);
+    auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    notifier_thread.join();
+
+    REQUIRE(status.succeeded());
+    REQUIRE(ready_list.size() == 1U);
+    CHECK(ready_list.at(0) == event_notifier->fd());
+    CHECK(elapsed_time < kLongTimeout);
+
+    // The notification stays pending until it is cleared
+    status = reactor->wait(ready_list, std::chrono::milliseconds(0));
+    REQUIRE(status.succeeded());
+    CHECK(ready_list.size() == 1U);
+
+    event_notifier->reset();
+
+    status = reactor->wait(ready_list, std::chrono::milliseconds(0));
+    REQUIRE(status.succeeded());
+    CHECK(ready_list.empty());
+  }
+
+  SECTION("Repeated notifications are reported once") {
+    event_notifier->notify();
+    event_notifier->notify();
+
+    status = reactor->wait(ready_list, kLongTimeout);
+
+    REQUIRE(status.succeeded());
+    CHECK(ready_list.size() == 1U);
+  }
+}
+
+TEST_CASE("Readiness dispatch", "[Reactor]") {
+  Reactor::Ref reactor;
+  auto status = Reactor::create(reactor);
+  REQUIRE(status.succeeded());
+
+  EventNotifier::Ref event_notifier;
+  status = EventNotifier::create(event_notifier);
+  REQUIRE(status.succeeded());
+
+  int pipe_fd_list[2]{};
+  REQUIRE(pipe(pipe_fd_list) == 0);
+
+  auto pipe_read_fd = pipe_fd_list[0];
+  auto pipe_write_fd = pipe_fd_list[1];
+
+  REQUIRE(reactor->addDescriptor(event_notifier->fd()).succeeded());
+  REQUIRE(reactor->addDescriptor(pipe_read_fd).succeeded());
+
+  // The same descriptor can not be watched twice
+  CHECK(!reactor->addDescriptor(pipe_read_fd).succeeded());
+
+  Reactor::DescriptorList ready_list;
+
+  SECTION("Only the readable descriptors are reported") {
+    REQUIRE(write(pipe_write_fd, "x", 1U) == 1);
+
+    status = reactor->wait(ready_list, kLongTimeout);
+    REQUIRE(status.succeeded());
+
+    CHECK(ready_list.size() == 1U);
+    CHECK(isReady(ready_list, pipe_read_fd));
+    CHECK(!isReady(ready_list, event_notifier->fd()));
+
+    event_notifier->notify();
+
+    status = reactor->wait(ready_list, kLongTimeout);
+    REQUIRE(status.succeeded());
+
+    CHECK(ready_list.size() == 2U);
+    CHECK(isReady(ready_list, pipe_read_fd));
+    CHECK(isReady(ready_list, event_notifier->fd()));
+
+    // Draining the data makes the descriptor idle again
+    char buffer{};
+    REQUIRE(read(pipe_read_fd, &buffer, 1U) == 1);
+
+    status = reactor->wait(ready_list, kLongTimeout);
+    REQUIRE(status.succeeded());
+
+    CHECK(ready_list.size() == 1U);
+    CHECK(isReady(ready_list, event_notifier->fd()));
+  }
+
+  SECTION("Removed descriptors are no longer reported") {
+    REQUIRE(reactor->removeDescriptor(pipe_read_fd).succeeded());
+    CHECK(!reactor->removeDescriptor(pipe_read_fd).succeeded());
+
+    REQUIRE(write(pipe_write_fd, "x", 1U) == 1);
+
+    status = reactor->wait(ready_list, std::chrono::milliseconds(10));
+    REQUIRE(status.succeeded());
+    CHECK(ready_list.empty());
+  }
+
+  close(pipe_read_fd);
+  close(pipe_write_fd);
+}
+} // namespace zeek
@@ -0,0 +1,137 @@
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <catch2/catch.hpp>
+
+#include <zeek/spscqueue.h>
+
+namespace zeek {
+TEST_CASE("SPSC queue", "[SPSCQueue]") {
+  SPSCQueue<int> queue(4U);
+  REQUIRE(queue.capacity() == 4U);
+
+  SECTION("An empty queue has nothing to pop") {
+    int value{-1};
+    CHECK(!queue.tryPop(value));
+    CHECK(value == -1);
+    CHECK(queue.size() == 0U);
+  }
+
+  SECTION("A full queue rejects new items") {
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(queue.tryPush(i));
+      REQUIRE(queue.size() == static_cast<std::size_t>(i + 1));
+    }
+
+    int value{4};
+    CHECK(!queue.tryPush(value));
+    CHECK(queue.size() == 4U);
+
+    // Popping a single item makes room for a new one
+    REQUIRE(queue.tryPop(value));
+    CHECK(value == 0);
+
+    value = 4;
+    CHECK(queue.tryPush(value));
+    CHECK(queue.size() == 4U);
+
+    for (int i = 1; i < 5; ++i) {
+      REQUIRE(queue.tryPop(value));
+      CHECK(value == i);
+    }
+
+    CHECK(!queue.tryPop(value));
+    CHECK(queue.size() == 0U);
+  }
+
+  SECTION("Items keep their order when the indexes wrap around") {
+    int next_pushed_value{0};
+    int next_popped_value{0};
+
+    // Both indexes go around the slot list several times, with a varying
+    // amount of queued items
+    for (std::size_t round = 0U; round < 16U; ++round) {
+      auto push_count = 1U + (round % 4U);
+
+      for (std::size_t i = 0U; i < push_count; ++i) {
+        auto value = next_pushed_value++;
+        REQUIRE(queue.tryPush(value));
+      }
+
+      REQUIRE(queue.size() == push_count);
+
+      int value{};
+      while (queue.tryPop(value)) {
+        REQUIRE(value == next_popped_value);
+        ++next_popped_value;
+      }
+
+      REQUIRE(queue.size() == 0U);
+    }
+
+    CHECK(next_popped_value == next_pushed_value);
+  }
+}
+
+TEST_CASE("SPSC queue item ownership", "[SPSCQueue]") {
+  SPSCQueue<std::unique_ptr<std::string>> queue(1U);
+
+  auto first_item = std::make_unique<std::string>("first");
+  REQUIRE(queue.tryPush(first_item));
+  CHECK(first_item == nullptr);
+
+  // Items are only moved when there is room for them
+  auto second_item = std::make_unique<std::string>("second");
+  REQUIRE(!queue.tryPush(second_item));
+  REQUIRE(second_item != nullptr);
+  CHECK(*second_item == "second");
+
+  std::unique_ptr<std::string> value;
+  REQUIRE(queue.tryPop(value));
+  REQUIRE(value != nullptr);
+  CHECK(*value == "first");
+}
+
+TEST_CASE("SPSC queue with concurrent producer and consumer",
+          "[SPSCQueue]") {
+  const int kItemCount{200000};
+
+  SPSCQueue<int> queue(64U);
+
+  std::thread producer_thread([&queue]() {
+    for (int i = 0; i < kItemCount;) {
+      auto value = i;
+      if (queue.tryPush(value)) {
+        ++i;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  int expected_value{0};
+  bool ordered{true};
+
+  while (expected_value < kItemCount) {
+    int value{};
+    if (!queue.tryPop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    // A Catch2 assertion for each item would slow the consumer down too
+    // much. The queue is always drained, so that the producer can finish
+    if (value != expected_value) {
+      ordered = false;
+    }
+
+    ++expected_value;
+  }
+
+  producer_thread.join();
+
+  CHECK(ordered);
+  CHECK(queue.size() == 0U);
+}
+} // namespace zeek
@@ -0,0 +1,32 @@
+#include "backoff.h"
+
+#include <algorithm>
+
+namespace zeek {
+namespace {
+// Prevents the shift from overflowing; the cap is always reached first
+const std::uint32_t kMaxExponent{20U};
+} // namespace
+
+ExponentialBackoff::ExponentialBackoff(
+    const std::chrono::milliseconds &base_delay_,
+    const std::chrono::milliseconds &max_delay_, std::uint32_t seed)
+    : base_delay(base_delay_), max_delay(std::max(base_delay_, max_delay_)),
+      generator(seed) {}
+
+std::chrono::milliseconds ExponentialBackoff::nextDelay() {
+  auto exponent = std::min(attempt_count, kMaxExponent);
+  ++attempt_count;
+
+  auto step = std::min(base_delay.count() << exponent, max_delay.count());
+
+  std::uniform_int_distribution<std::chrono::milliseconds::rep> distribution(
+      step / 2, step);
+
+  return std::chrono::milliseconds(distribution(generator));
+}
+
+void ExponentialBackoff::reset() { attempt_count = 0U; }
+
+std::uint32_t ExponentialBackoff::attemptCount() const { return attempt_count; }
+} // namespace zeek
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace zeek {
+/// \brief Computes capped, exponentially growing retry delays with jitter
+class ExponentialBackoff final {
+public:
+  /// \brief Constructor
+  /// \param base_delay The delay used for the first retry
+  /// \param max_delay The upper bound for the delay
+  /// \param seed The seed for the jitter generator
+  ExponentialBackoff(const std::chrono::milliseconds &base_delay,
+                     const std::chrono::milliseconds &max_delay,
+                     std::uint32_t seed = std::random_device()());
+
+  /// \brief Returns the delay to wait before the next attempt. The delay is
+  ///        uniformly distributed between half and the full value of the
+  ///        current exponential step, so that agents restarting together do
+  ///        not retry at the same time
+  /// \return The retry delay
+  std::chrono::milliseconds nextDelay();
+
+  /// \brief Resets the backoff state after a successful attempt
+  void reset();
+
+  /// \return How many delays have been returned since the last reset
+  std::uint32_t attemptCount() const;
+
+private:
+  /// \brief The delay used for the first retry
+  std::chrono::milliseconds base_delay;
+
+  /// \brief The upper bound for the delay
+  std::chrono::milliseconds max_delay;
+
+  /// \brief How many delays have been returned since the last reset
+  std::uint32_t attempt_count{0U};
+
+  /// \brief The jitter generator
+  std::minstd_rand generator;
+};
+} // namespace zeek
@@ -0,0 +1,463 @@
+#include "differentialstore.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace zeek {
+namespace {
+// "ZADS" (Zeek Agent Differential State)
+const std::uint32_t kFileMagic{0x5344415AU};
+const std::uint32_t kFormatVersion{2U};
+
+enum class ColumnTag : std::uint8_t { Null, Integer, String, Double };
+
+template <typename IntegerType>
+void writeInteger(std::string &buffer, IntegerType value) {
+  static_assert(std::is_integral<IntegerType>::value,
+                "Only integer types can be serialized");
+
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void writeString(std::string &buffer, const std::string &value) {
+  writeInteger(buffer, static_cast<std::uint32_t>(value.size()));
+  buffer.append(value);
+}
+
+template <typename IntegerType>
+bool readInteger(IntegerType &value, const std::string &buffer,
+                 std::size_t &offset) {
+  static_assert(std::is_integral<IntegerType>::value,
+                "Only integer types can be deserialized");
+
+  if (buffer.size() - offset < sizeof(value)) {
+    return false;
+  }
+
+  std::memcpy(&value, buffer.data() + offset, sizeof(value));
+  offset += sizeof(value);
+
+  return true;
+}
+
+bool readString(std::string &value, const std::string &buffer,
+                std::size_t &offset) {
+  std::uint32_t size{0U};
+  if (!readInteger(size, buffer, offset)) {
+    return false;
+  }
+
+  if (buffer.size() - offset < size) {
+    return false;
+  }
+
+  value.assign(buffer, offset, size);
+  offset += size;
+
+  return true;
+}
+
+Status serializeTask(std::string &buffer, const QueryScheduler::Task &task) {
+  if (task.type != QueryScheduler::Task::Type::AddScheduledQuery ||
+      !task.interval.has_value() || !task.update_type.has_value()) {
+    return Status::failure("Only scheduled queries can be persisted");
+  }
+
+  writeString(buffer, task.query);
+  writeString(buffer, task.response_event);
+  writeString(buffer, task.response_topic);
+  writeString(buffer, task.cookie);
+  writeInteger(buffer, task.interval.value());
+  writeInteger(buffer, static_cast<std::uint8_t>(task.update_type.value()));
+
+  writeInteger(buffer, static_cast<std::uint32_t>(task.key_column_list.size()));
+  for (const auto &key_column_name : task.key_column_list) {
+    writeString(buffer, key_column_name);
+  }
+
+  return Status::success();
+}
+
+Status deserializeTask(QueryScheduler::Task &task, const std::string &buffer,
+                       std::size_t &offset) {
+  task = {};
+  task.type = QueryScheduler::Task::Type::AddScheduledQuery;
+
+  std::uint64_t interval{0U};
+  std::uint8_t update_type{0U};
+
+  if (!readString(task.query, buffer, offset) ||
+      !readString(task.response_event, buffer, offset) ||
+      !readString(task.response_topic, buffer, offset) ||
+      !readString(task.cookie, buffer, offset) ||
+      !readInteger(interval, buffer, offset) ||
+      !readInteger(update_type, buffer, offset)) {
+    return Status::failure("Truncated task definition");
+  }
+
+  if (update_type >
+      static_cast<std::uint8_t>(QueryScheduler::Task::UpdateType::Both)) {
+    return Status::failure("Invalid task update type");
+  }
+
+  std::uint32_t key_column_count{0U};
+  if (!readInteger(key_column_count, buffer, offset)) {
+    return Status::failure("Truncated task definition");
+  }
+
+  for (std::uint32_t i = 0U; i < key_column_count; ++i) {
+    std::string key_column_name;
+    if (!readString(key_column_name, buffer, offset)) {
+      return Status::failure("Truncated task definition");
+    }
+
+    task.key_column_list.push_back(std::move(key_column_name));
+  }
+
+  task.interval = interval;
+  task.update_type = static_cast<QueryScheduler::Task::UpdateType>(update_type);
+
+  return Status::success();
+}
+
+Status serializeRow(std::string &buffer,
+                    const IVirtualDatabase::OutputRow &row) {
+  writeInteger(buffer, static_cast<std::uint32_t>(row.size()));
+
+  for (const auto &column : row) {
+    writeString(buffer, column.name);
+
+    if (!column.data.has_value()) {
+      writeInteger(buffer, static_cast<std::uint8_t>(ColumnTag::Null));
+      continue;
+    }
+
+    const auto &column_variant = column.data.value();
+
+    if (std::holds_alternative<std::int64_t>(column_variant)) {
+      writeInteger(buffer, static_cast<std::uint8_t>(ColumnTag::Integer));
+      writeInteger(buffer, std::get<std::int64_t>(column_variant));
+
+    } else if (std::holds_alternative<std::string>(column_variant)) {
+      writeInteger(buffer, static_cast<std::uint8_t>(ColumnTag::String));
+      writeString(buffer, std::get<std::string>(column_variant));
+
+    } else if (std::holds_alternative<double>(column_variant)) {
+      auto double_value = std::get<double>(column_variant);
+
+      std::uint64_t raw_value{0U};
+      std::memcpy(&raw_value, &double_value, sizeof(raw_value));
+
+      writeInteger(buffer, static_cast<std::uint8_t>(ColumnTag::Double));
+      writeInteger(buffer, raw_value);
+
+    } else {
+      return Status::failure("Invalid column type");
+    }
+  }
+
+  return Status::success();
+}
+
+Status deserializeRow(IVirtualDatabase::OutputRow &row,
+                      const std::string &buffer, std::size_t &offset) {
+  row = {};
+
+  std::uint32_t column_count{0U};
+  if (!readInteger(column_count, buffer, offset)) {
+    return Status::failure("Truncated row");
+  }
+
+  for (std::uint32_t i = 0U; i < column_count; ++i) {
+    IVirtualDatabase::ColumnValue column;
+
+    std::uint8_t tag{0U};
+    if (!readString(column.name, buffer, offset) ||
+        !readInteger(tag, buffer, offset)) {
+      return Status::failure("Truncated column");
+    }
+
+    bool succeeded{true};
+
+    switch (static_cast<ColumnTag>(tag)) {
+    case ColumnTag::Null:
+      break;
+
+    case ColumnTag::Integer: {
+      std::int64_t integer_value{0};
+      succeeded = readInteger(integer_value, buffer, offset);
+      column.data = integer_value;
+      break;
+    }
+
+    case ColumnTag::String: {
+      std::string string_value;
+      succeeded = readString(string_value, buffer, offset);
+      column.data = std::move(string_value);
+      break;
+    }
+
+    case ColumnTag::Double: {
+      std::uint64_t raw_value{0U};
+      succeeded = readInteger(raw_value, buffer, offset);
+
+      double double_value{0.0};
+      std::memcpy(&double_value, &raw_value, sizeof(double_value));
+
+      column.data = double_value;
+      break;
+    }
+
+    default:
+      return Status::failure("Invalid column type");
+    }
+
+    if (!succeeded) {
+      return Status::failure("Truncated column value");
+    }
+
+    row.push_back(std::move(column));
+  }
+
+  return Status::success();
+}
+
+Status writeFile(const std::string &path, const std::string &buffer) {
+  auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd == -1) {
+    return Status::failure("Failed to open the following file: " + path);
+  }
+
+  auto data = buffer.data();
+  auto remaining_bytes = buffer.size();
+  auto succeeded{true};
+
+  while (remaining_bytes != 0U) {
+    auto written_bytes = write(fd, data, remaining_bytes);
+    if (written_bytes == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      succeeded = false;
+      break;
+    }
+
+    data += written_bytes;
+    remaining_bytes -= static_cast<std::size_t>(written_bytes);
+  }
+
+  if (succeeded && fsync(fd) != 0) {
+    succeeded = false;
+  }
+
+  if (close(fd) != 0) {
+    succeeded = false;
+  }
+
+  if (!succeeded) {
+    return Status::failure("Failed to write the following file: " + path);
+  }
+
+  return Status::success();
+}
+
+Status syncFolder(const std::string &path) {
+  auto fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    return Status::failure("Failed to open the following folder: " + path);
+  }
+
+  auto succeeded = fsync(fd) == 0;
+  close(fd);
+
+  if (!succeeded) {
+    return Status::failure("Failed to sync the following folder: " + path);
+  }
+
+  return Status::success();
+}
+} // namespace
+
+Status DifferentialStore::save(const std::string &path,
+                               const EntryList &entry_list) {
+  std::string buffer;
+  auto status = serialize(buffer, entry_list);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  // Write and sync a temporary file first, then atomically rename it and
+  // sync the parent folder, so that a crash can never leave a partially
+  // written state behind
+  auto temporary_path = path + ".tmp";
+
+  status = writeFile(temporary_path, buffer);
+  if (!status.succeeded()) {
+    std::error_code error;
+    std::filesystem::remove(temporary_path, error);
+
+    return status;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+
+  if (error) {
+    std::filesystem::remove(temporary_path, error);
+    return Status::failure("Failed to replace the following file: " + path);
+  }
+
+  auto parent_path = std::filesystem::path(path).parent_path();
+  if (parent_path.empty()) {
+    parent_path = ".";
+  }
+
+  return syncFolder(parent_path.string());
+}
+
+Status DifferentialStore::load(EntryList &entry_list, const std::string &path) {
+  entry_list = {};
+
+  std::error_code error;
+  if (!std::filesystem::exists(path, error)) {
+    return Status::success();
+  }
+
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return Status::failure("Failed to open the following file: " + path);
+  }
+
+  std::stringstream buffer;
+  buffer << stream.rdbuf();
+
+  if (stream.fail()) {
+    return Status::failure("Failed to read the following file: " + path);
+  }
+
+  return deserialize(entry_list, buffer.str());
+}
+
+Status DifferentialStore::serialize(std::string &buffer,
+                                    const EntryList &entry_list) {
+  buffer = {};
+
+  writeInteger(buffer, kFileMagic);
+  writeInteger(buffer, kFormatVersion);
+  writeInteger(buffer, static_cast<std::uint32_t>(entry_list.size()));
+
+  for (const auto &entry : entry_list) {
+    auto status = serializeTask(buffer, entry.task);
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    static const ZeekConnection::DifferentialData kEmptyDifferentialData;
+
+    const auto &differential_data = entry.differential_data != nullptr
+                                        ? *entry.differential_data
+                                        : kEmptyDifferentialData;
+
+    std::vector<std::uint64_t> row_hash_list;
+    row_hash_list.reserve(differential_data.size());
+
+    for (const auto &differential_data_p : differential_data) {
+      row_hash_list.push_back(differential_data_p.first);
+    }
+
+    std::sort(row_hash_list.begin(), row_hash_list.end());
+
+    writeInteger(buffer, static_cast<std::uint32_t>(row_hash_list.size()));
+
+    for (auto row_hash : row_hash_list) {
+      writeInteger(buffer, row_hash);
+
+      status = serializeRow(buffer, differential_data.at(row_hash));
+      if (!status.succeeded()) {
+        return status;
+      }
+    }
+  }
+
+  return Status::success();
+}
+
+Status DifferentialStore::deserialize(EntryList &entry_list,
+                                      const std::string &buffer) {
+  entry_list = {};
+
+  std::size_t offset{0U};
+
+  std::uint32_t magic{0U};
+  std::uint32_t version{0U};
+  std::uint32_t entry_count{0U};
+
+  if (!readInteger(magic, buffer, offset) || magic != kFileMagic) {
+    return Status::failure("Invalid differential state file");
+  }
+
+  if (!readInteger(version, buffer, offset) || version != kFormatVersion) {
+    return Status::failure("Unsupported differential state version");
+  }
+
+  if (!readInteger(entry_count, buffer, offset)) {
+    return Status::failure("Truncated differential state file");
+  }
+
+  EntryList output;
+
+  for (std::uint32_t i = 0U; i < entry_count; ++i) {
+    Entry entry;
+
+    auto status = deserializeTask(entry.task, buffer, offset);
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    std::uint32_t row_count{0U};
+    if (!readInteger(row_count, buffer, offset)) {
+      return Status::failure("Truncated differential state file");
+    }
+
+    ZeekConnection::DifferentialData differential_data;
+
+    for (std::uint32_t j = 0U; j < row_count; ++j) {
+      std::uint64_t row_hash{0U};
+      if (!readInteger(row_hash, buffer, offset)) {
+        return Status::failure("Truncated differential state file");
+      }
+
+      IVirtualDatabase::OutputRow row;
+      status = deserializeRow(row, buffer, offset);
+      if (!status.succeeded()) {
+        return status;
+      }
+
+      differential_data.insert({row_hash, std::move(row)});
+    }
+
+    entry.differential_data =
+        std::make_shared<const ZeekConnection::DifferentialData>(
+            std::move(differential_data));
+
+    output.push_back(std::move(entry));
+  }
+
+  if (offset != buffer.size()) {
+    return Status::failure("Unexpected trailing data in the differential "
+                           "state file");
+  }
+
+  entry_list = std::move(output);
+  return Status::success();
+}
+} // namespace zeek
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "zeekconnection.h"
+
+#include <string>
+#include <vector>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief Persists the differential state of the scheduled queries, so
+///        that it survives agent restarts
+class DifferentialStore final {
+public:
+  /// \brief The persisted state of a single scheduled query
+  struct Entry final {
+    /// \brief The task that has been scheduled by the Zeek server
+    QueryScheduler::Task task;
+
+    /// \brief The rows that have last been sent to the Zeek server; may be
+    ///        null if there are none
+    ZeekConnection::DifferentialDataRef differential_data;
+  };
+
+  /// \brief A list of persisted scheduled queries
+  using EntryList = std::vector<Entry>;
+
+  /// \brief Atomically replaces the given file with the specified entries
+  /// \param path The destination file
+  /// \param entry_list The entries to save
+  /// \return A Status object
+  static Status save(const std::string &path, const EntryList &entry_list);
+
+  /// \brief Loads the entries stored in the given file
+  /// \param entry_list Where the loaded entries are stored
+  /// \param path The source file
+  /// \return A Status object
+  static Status load(EntryList &entry_list, const std::string &path);
+
+  /// \brief Serializes the given entries. Rows are sorted by hash so that
+  ///        the output is stable
+  /// \param buffer Where the serialized data is stored
+  /// \param entry_list The entries to serialize
+  /// \return A Status object
+  static Status serialize(std::string &buffer, const EntryList &entry_list);
+
+  /// \brief Deserializes the given buffer
+  /// \param entry_list Where the deserialized entries are stored
+  /// \param buffer The serialized data
+  /// \return A Status object
+  static Status deserialize(EntryList &entry_list, const std::string &buffer);
+};
+} // namespace zeek
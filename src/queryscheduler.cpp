@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <thread>
 
@@ -11,7 +12,9 @@ namespace {
 Status querySchedulerThread(QueryScheduler &query_scheduler,
                             std::atomic_bool &terminate) {
   while (!terminate) {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    // Scheduled queries have a one second resolution, but new one-shot
+    // tasks should be executed as soon as they are received
+    query_scheduler.waitForTaskQueue(std::chrono::seconds(1));
 
     auto status = query_scheduler.processEvents();
     if (!status.succeeded()) {
@@ -23,6 +26,16 @@ Status querySchedulerThread(QueryScheduler &query_scheduler,
 
   return Status::success();
 }
+
+Status interactiveExecutorThread(QueryScheduler &query_scheduler,
+                                 std::atomic_bool &terminate) {
+  while (!terminate) {
+    query_scheduler.waitForInteractiveTaskQueue(std::chrono::seconds(1));
+    query_scheduler.processInteractiveTasks();
+  }
+
+  return Status::success();
+}
 } // namespace
 
 struct QueryScheduler::PrivateData final {
@@ -32,16 +45,25 @@ struct QueryScheduler::PrivateData final {
   IVirtualDatabase &virtual_database;
 
   std::unique_ptr<std::thread> thread;
+  std::unique_ptr<std::thread> interactive_thread;
   std::atomic_bool terminate{false};
 
   TaskQueue task_queue;
   std::mutex task_queue_mutex;
+  std::condition_variable task_queue_cv;
+
+  TaskQueue interactive_task_queue;
+  std::mutex interactive_task_queue_mutex;
+  std::condition_variable interactive_task_queue_cv;
 
   std::map<std::string, Task> scheduled_task_list;
   std::vector<std::pair<std::uint64_t, std::string>> schedule;
 
   std::mutex task_output_list_mutex;
+  std::condition_variable task_output_list_cv;
   std::vector<TaskOutput> task_output_list;
+
+  SnapshotSinkFactory snapshot_sink_factory;
 };
 
 Status QueryScheduler::create(Ref &obj, IVirtualDatabase &virtual_database) {
@@ -63,16 +85,60 @@ Status QueryScheduler::create(Ref &obj, IVirtualDatabase &virtual_database) {
 
 QueryScheduler::~QueryScheduler() { stop(); }
 
+void QueryScheduler::setSnapshotSinkFactory(
+    SnapshotSinkFactory snapshot_sink_factory) {
+  d->snapshot_sink_factory = std::move(snapshot_sink_factory);
+}
+
 void QueryScheduler::processTaskQueue(TaskQueue task_queue) {
-  std::lock_guard<std::mutex> lock(d->task_queue_mutex);
-
-  // clang-format off
-  d->task_queue.insert(
-    d->task_queue.end(),
-    std::make_move_iterator(task_queue.begin()),
-    std::make_move_iterator(task_queue.end())
-  );
-  // clang-format on
+  if (task_queue.empty()) {
+    return;
+  }
+
+  // One-shot queries are handled by the interactive executor, so that they
+  // never have to wait for the scheduled queries that are due
+  TaskQueue scheduled_task_queue;
+  TaskQueue interactive_task_queue;
+
+  for (auto &task : task_queue) {
+    if (task.type == Task::Type::ExecuteQuery) {
+      interactive_task_queue.push_back(std::move(task));
+    } else {
+      scheduled_task_queue.push_back(std::move(task));
+    }
+  }
+
+  if (!interactive_task_queue.empty()) {
+    {
+      std::lock_guard<std::mutex> lock(d->interactive_task_queue_mutex);
+
+      // clang-format off
+      d->interactive_task_queue.insert(
+        d->interactive_task_queue.end(),
+        std::make_move_iterator(interactive_task_queue.begin()),
+        std::make_move_iterator(interactive_task_queue.end())
+      );
+      // clang-format on
+    }
+
+    d->interactive_task_queue_cv.notify_one();
+  }
+
+  if (!scheduled_task_queue.empty()) {
+    {
+      std::lock_guard<std::mutex> lock(d->task_queue_mutex);
+
+      // clang-format off
+      d->task_queue.insert(
+        d->task_queue.end(),
+        std::make_move_iterator(scheduled_task_queue.begin()),
+        std::make_move_iterator(scheduled_task_queue.end())
+      );
+      // clang-format on
+    }
+
+    d->task_queue_cv.notify_one();
+  }
 }
 
 Status QueryScheduler::processEvents() {
@@ -93,19 +159,7 @@ Status QueryScheduler::processEvents() {
   for (auto &task : task_queue) {
     auto task_key = task.query + task.response_topic + task.cookie;
 
-    if (task.type == Task::Type::ExecuteQuery) {
-      getLogger().logMessage(IZeekLogger::Severity::Information,
-                             "Executing one-shot query: " + task.query);
-
-      auto status = executeTask(task);
-      if (!status.succeeded()) {
-        getLogger().logMessage(
-            IZeekLogger::Severity::Error,
-            "The query scheduler could not execute a one-shot task: " +
-                status.message());
-      }
-
-    } else if (task.type == Task::Type::AddScheduledQuery) {
+    if (task.type == Task::Type::AddScheduledQuery) {
       auto task_it = d->scheduled_task_list.find(task_key);
       if (task_it != d->scheduled_task_list.end()) {
         getLogger().logMessage(IZeekLogger::Severity::Error,
@@ -187,6 +241,34 @@ Status QueryScheduler::processEvents() {
   return Status::success();
 }
 
+void QueryScheduler::processInteractiveTasks() {
+  TaskQueue task_queue;
+
+  {
+    std::lock_guard<std::mutex> lock(d->interactive_task_queue_mutex);
+
+    task_queue = std::move(d->interactive_task_queue);
+    d->interactive_task_queue = {};
+  }
+
+  for (const auto &task : task_queue) {
+    if (d->terminate) {
+      break;
+    }
+
+    getLogger().logMessage(IZeekLogger::Severity::Information,
+                           "Executing one-shot query: " + task.query);
+
+    auto status = executeTask(task);
+    if (!status.succeeded()) {
+      getLogger().logMessage(
+          IZeekLogger::Severity::Error,
+          "The query scheduler could not execute a one-shot task: " +
+              status.message());
+    }
+  }
+}
+
 QueryScheduler::TaskOutputList QueryScheduler::getTaskOutputList() {
   TaskOutputList task_output_list;
 
@@ -200,11 +282,53 @@ QueryScheduler::TaskOutputList QueryScheduler::getTaskOutputList() {
   return task_output_list;
 }
 
+QueryScheduler::TaskOutputList QueryScheduler::waitForTaskOutputList(
+    const std::chrono::milliseconds &timeout) {
+
+  TaskOutputList task_output_list;
+
+  {
+    std::unique_lock<std::mutex> lock(d->task_output_list_mutex);
+
+    d->task_output_list_cv.wait_for(lock, timeout, [this]() -> bool {
+      return !d->task_output_list.empty() || d->terminate;
+    });
+
+    task_output_list = std::move(d->task_output_list);
+    d->task_output_list = {};
+  }
+
+  return task_output_list;
+}
+
+void QueryScheduler::waitForTaskQueue(
+    const std::chrono::milliseconds &timeout) {
+
+  std::unique_lock<std::mutex> lock(d->task_queue_mutex);
+
+  d->task_queue_cv.wait_for(lock, timeout, [this]() -> bool {
+    return !d->task_queue.empty() || d->terminate;
+  });
+}
+
+void QueryScheduler::waitForInteractiveTaskQueue(
+    const std::chrono::milliseconds &timeout) {
+
+  std::unique_lock<std::mutex> lock(d->interactive_task_queue_mutex);
+
+  d->interactive_task_queue_cv.wait_for(lock, timeout, [this]() -> bool {
+    return !d->interactive_task_queue.empty() || d->terminate;
+  });
+}
+
 Status QueryScheduler::start() {
   try {
     d->thread = std::make_unique<std::thread>(
         querySchedulerThread, std::ref(*this), std::ref(d->terminate));
 
+    d->interactive_thread = std::make_unique<std::thread>(
+        interactiveExecutorThread, std::ref(*this), std::ref(d->terminate));
+
     return Status::success();
 
   } catch (const std::bad_alloc &) {
@@ -217,20 +341,61 @@ void QueryScheduler::stop() {
     return;
   }
 
-  d->terminate = true;
+  {
+    // Take all the locks so that no waiter can miss the notification
+    std::lock_guard<std::mutex> task_queue_lock(d->task_queue_mutex);
+    std::lock_guard<std::mutex> interactive_task_queue_lock(
+        d->interactive_task_queue_mutex);
+
+    std::lock_guard<std::mutex> task_output_list_lock(
+        d->task_output_list_mutex);
+
+    d->terminate = true;
+  }
+
+  d->task_queue_cv.notify_all();
+  d->interactive_task_queue_cv.notify_all();
+  d->task_output_list_cv.notify_all();
 
   d->thread->join();
   d->thread.reset();
+
+  if (d->interactive_thread) {
+    d->interactive_thread->join();
+    d->interactive_thread.reset();
+  }
 }
 
 QueryScheduler::QueryScheduler(IVirtualDatabase &virtual_database)
     : d(new PrivateData(virtual_database)) {}
 
 Status QueryScheduler::executeTask(const Task &task) {
+  // Snapshots do not need any post-processing, so they can be sent out
+  // while SQLite is stepping the statement
+  if (!task.update_type.has_value() && d->snapshot_sink_factory) {
+    IVirtualDatabase::IQueryOutputSink::Ref sink;
+    auto status = d->snapshot_sink_factory(sink, task);
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    if (!sink) {
+      return Status::success();
+    }
+
+    status = d->virtual_database.query(*sink.get(), task.query);
+    if (!status.succeeded()) {
+      return Status::failure(status.message() + ". Query: " + task.query);
+    }
+
+    return Status::success();
+  }
+
   TaskOutput task_output;
   task_output.response_topic = task.response_topic;
   task_output.response_event = task.response_event;
   task_output.update_type = task.update_type;
+  task_output.key_column_list = task.key_column_list;
   task_output.cookie = task.cookie;
 
   auto status = d->virtual_database.query(task_output.query_output, task.query);
@@ -243,6 +408,7 @@ Status QueryScheduler::executeTask(const Task &task) {
     d->task_output_list.push_back(std::move(task_output));
   }
 
+  d->task_output_list_cv.notify_one();
   return Status::success();
 }
 } // namespace zeek
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 
 #include <zeek/ivirtualdatabase.h>
@@ -53,6 +55,10 @@ public:
 
     /// \brief Requested update type (differential)
     std::optional<UpdateType> update_type;
+
+    /// \brief The columns identifying a row across differential runs. When
+    ///        empty, rows are identified by all of their columns
+    std::vector<std::string> key_column_list;
   };
 
   /// \brief A list of tasks to process
@@ -72,6 +78,9 @@ public:
     /// \brief The update types this task is interested in
     std::optional<Task::UpdateType> update_type;
 
+    /// \brief The key columns used for differentials
+    std::vector<std::string> key_column_list;
+
     /// \brief The query output for this task
     IVirtualDatabase::QueryOutput query_output;
   };
@@ -79,6 +88,17 @@ public:
   /// \brief A list of task outputs
   using TaskOutputList = std::vector<TaskOutput>;
 
+  /// \brief Creates the sink receiving the rows of a snapshot task. An
+  ///        empty sink skips the task
+  using SnapshotSinkFactory = std::function<Status(
+      IVirtualDatabase::IQueryOutputSink::Ref &sink, const Task &task)>;
+
+  /// \brief Streams the output of snapshot tasks to the sinks created by
+  ///        the given factory, instead of queuing it as TaskOutput.
+  ///        Must be called before start()
+  /// \param snapshot_sink_factory The sink factory
+  void setSnapshotSinkFactory(SnapshotSinkFactory snapshot_sink_factory);
+
   /// \brief Processes the given task queue, updating the internal state
   /// \param task_queue The task queue to process
   void processTaskQueue(TaskQueue task_queue);
@@ -87,9 +107,29 @@ public:
   /// \return A Status object
   Status processEvents();
 
+  /// \brief Executes the queued one-shot tasks
+  void processInteractiveTasks();
+
   /// \return The output for the running tasks
   TaskOutputList getTaskOutputList();
 
+  /// \brief Waits for new task output, timing out after the given amount of
+  ///        time or as soon as the scheduler is stopped
+  /// \param timeout How long to wait for new output
+  /// \return The output for the running tasks; empty if nothing was produced
+  TaskOutputList
+  waitForTaskOutputList(const std::chrono::milliseconds &timeout);
+
+  /// \brief Waits until new tasks are queued, timing out after the given
+  ///        amount of time or as soon as the scheduler is stopped
+  /// \param timeout How long to wait for new tasks
+  void waitForTaskQueue(const std::chrono::milliseconds &timeout);
+
+  /// \brief Waits until new one-shot tasks are queued, timing out after the
+  ///        given amount of time or as soon as the scheduler is stopped
+  /// \param timeout How long to wait for new tasks
+  void waitForInteractiveTaskQueue(const std::chrono::milliseconds &timeout);
+
   /// \brief Starts the internal query scheduler services
   /// \return A Status object
   Status start();
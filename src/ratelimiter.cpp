@@ -0,0 +1,120 @@
+#include "ratelimiter.h"
+
+#include <algorithm>
+
+namespace zeek {
+TokenBucket::TokenBucket(std::uint64_t rate_) : rate(rate_) {}
+
+bool TokenBucket::available(std::uint64_t requested_token_count,
+                            const std::chrono::steady_clock::time_point &now) {
+  if (rate == 0U) {
+    return true;
+  }
+
+  // The capacity matches one second worth of tokens
+  auto capacity = static_cast<double>(rate);
+
+  if (!initialized) {
+    token_count = capacity;
+    last_refill = now;
+    initialized = true;
+
+  } else if (now > last_refill) {
+    auto elapsed_time =
+        std::chrono::duration<double>(now - last_refill).count();
+
+    token_count = std::min(
+        capacity, token_count + elapsed_time * static_cast<double>(rate));
+
+    last_refill = now;
+  }
+
+  return token_count >=
+         std::min(static_cast<double>(requested_token_count), capacity);
+}
+
+void TokenBucket::consume(std::uint64_t requested_token_count) {
+  if (rate == 0U) {
+    return;
+  }
+
+  token_count -= static_cast<double>(requested_token_count);
+}
+
+RateLimiter::RateLimiter(const Configuration &configuration)
+    : config(configuration),
+      global_buckets{TokenBucket(configuration.max_rows_per_second),
+                     TokenBucket(configuration.max_bytes_per_second)} {}
+
+bool RateLimiter::acquire(const std::string &topic, const std::string &query_id,
+                          std::uint64_t byte_count,
+                          const std::chrono::steady_clock::time_point &now) {
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if (consumeTokens(topic, byte_count, now)) {
+    return true;
+  }
+
+  auto &drop_counters = drop_counter_map[query_id];
+  if (drop_counters.response_topic.empty()) {
+    drop_counters.response_topic = topic;
+  }
+
+  ++drop_counters.row_count;
+  drop_counters.byte_count += byte_count;
+
+  return false;
+}
+
+bool RateLimiter::tryAcquire(const std::string &topic,
+                             std::uint64_t byte_count,
+                             const std::chrono::steady_clock::time_point &now) {
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return consumeTokens(topic, byte_count, now);
+}
+
+RateLimiter::DropCounterMap RateLimiter::takeDropCounters() {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto output = std::move(drop_counter_map);
+  drop_counter_map = {};
+
+  return output;
+}
+
+bool RateLimiter::consumeTokens(
+    const std::string &topic, std::uint64_t byte_count,
+    const std::chrono::steady_clock::time_point &now) {
+
+  auto topic_bucket_it = topic_bucket_map.find(topic);
+  if (topic_bucket_it == topic_bucket_map.end()) {
+    BucketPair topic_buckets{TokenBucket(config.max_topic_rows_per_second),
+                             TokenBucket(config.max_topic_bytes_per_second)};
+
+    topic_bucket_it =
+        topic_bucket_map.insert({topic, std::move(topic_buckets)}).first;
+  }
+
+  auto &topic_buckets = topic_bucket_it->second;
+
+  // Check every bucket before consuming, so that a rejected row does not
+  // use up the tokens of the other limits
+  auto accepted = global_buckets.rows.available(1U, now) &&
+                  global_buckets.bytes.available(byte_count, now) &&
+                  topic_buckets.rows.available(1U, now) &&
+                  topic_buckets.bytes.available(byte_count, now);
+
+  if (!accepted) {
+    return false;
+  }
+
+  global_buckets.rows.consume(1U);
+  global_buckets.bytes.consume(byte_count);
+  topic_buckets.rows.consume(1U);
+  topic_buckets.bytes.consume(byte_count);
+
+  return true;
+}
+} // namespace zeek
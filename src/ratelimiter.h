@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace zeek {
+/// \brief A token bucket, refilled at a constant rate
+class TokenBucket final {
+public:
+  /// \brief Constructor
+  /// \param rate How many tokens are added every second; zero disables
+  ///             the limit
+  TokenBucket(std::uint64_t rate = 0U);
+
+  /// \brief Refills the bucket and checks whether the given amount of tokens
+  ///        can be consumed. A request larger than the bucket capacity is
+  ///        accepted when the bucket is full, so that it can not block
+  ///        forever
+  /// \param token_count How many tokens are needed
+  /// \param now The current time
+  /// \return True if the tokens are available
+  bool available(std::uint64_t token_count,
+                 const std::chrono::steady_clock::time_point &now);
+
+  /// \brief Consumes the given amount of tokens; the bucket can go into debt,
+  ///        which is paid back by the next refills
+  /// \param token_count How many tokens to consume
+  void consume(std::uint64_t token_count);
+
+private:
+  /// \brief How many tokens are added every second
+  std::uint64_t rate{0U};
+
+  /// \brief The tokens currently in the bucket
+  double token_count{0.0};
+
+  /// \brief When the bucket has last been refilled
+  std::chrono::steady_clock::time_point last_refill;
+
+  /// \brief Whether the bucket has been filled at least once
+  bool initialized{false};
+};
+
+/// \brief Limits how fast the query output is published, both globally and
+///        for each response topic
+class RateLimiter final {
+public:
+  /// \brief Rate limits; zero disables the corresponding limit
+  struct Configuration final {
+    /// \brief Maximum amount of rows published every second
+    std::uint64_t max_rows_per_second{0U};
+
+    /// \brief Maximum amount of bytes published every second
+    std::uint64_t max_bytes_per_second{0U};
+
+    /// \brief Maximum amount of rows published every second, per topic
+    std::uint64_t max_topic_rows_per_second{0U};
+
+    /// \brief Maximum amount of bytes published every second, per topic
+    std::uint64_t max_topic_bytes_per_second{0U};
+  };
+
+  /// \brief Output that has been dropped because of the rate limits
+  struct DropCounters final {
+    /// \brief The response topic of the query
+    std::string response_topic;
+
+    /// \brief How many rows have been dropped
+    std::uint64_t row_count{0U};
+
+    /// \brief How many bytes have been dropped
+    std::uint64_t byte_count{0U};
+  };
+
+  /// \brief Drop counters, indexed by query ID
+  using DropCounterMap = std::unordered_map<std::string, DropCounters>;
+
+  /// \brief Constructor
+  /// \param configuration The rate limits
+  RateLimiter(const Configuration &configuration);
+
+  /// \brief Requests permission to publish a single row. Rows that are
+  ///        rejected are added to the drop counters. Thread safe
+  /// \param topic The response topic
+  /// \param query_id The query that produced the row; the drop counters
+  ///                 are tracked per query, so that they can be reported
+  ///                 to the server that owns it
+  /// \param byte_count The (estimated) row size
+  /// \param now The current time
+  /// \return True if the row can be published
+  bool acquire(const std::string &topic, const std::string &query_id,
+               std::uint64_t byte_count,
+               const std::chrono::steady_clock::time_point &now =
+                   std::chrono::steady_clock::now());
+
+  /// \brief Requests permission to publish a single row that will be sent
+  ///        again later if it is rejected, such as a differential row that
+  ///        is kept out of the saved state. Rejected rows are not lost, so
+  ///        they are not added to the drop counters. Thread safe
+  /// \param topic The response topic
+  /// \param byte_count The (estimated) row size
+  /// \param now The current time
+  /// \return True if the row can be published now
+  bool tryAcquire(const std::string &topic, std::uint64_t byte_count,
+                  const std::chrono::steady_clock::time_point &now =
+                      std::chrono::steady_clock::now());
+
+  /// \return The drop counters accumulated since the last call
+  DropCounterMap takeDropCounters();
+
+  RateLimiter(const RateLimiter &) = delete;
+  RateLimiter &operator=(const RateLimiter &) = delete;
+
+private:
+  /// \brief The row and byte buckets for a single scope
+  struct BucketPair final {
+    /// \brief Row bucket
+    TokenBucket rows;
+
+    /// \brief Byte bucket
+    TokenBucket bytes;
+  };
+
+  /// \brief Consumes the tokens for a single row if every limit allows it.
+  ///        The mutex must be held by the caller
+  /// \param topic The response topic
+  /// \param byte_count The (estimated) row size
+  /// \param now The current time
+  /// \return True if the tokens have been consumed
+  bool consumeTokens(const std::string &topic, std::uint64_t byte_count,
+                     const std::chrono::steady_clock::time_point &now);
+
+  /// \brief The rate limits
+  Configuration config;
+
+  /// \brief Guards the buckets and the drop counters
+  std::mutex mutex;
+
+  /// \brief The global buckets
+  BucketPair global_buckets;
+
+  /// \brief The per-topic buckets
+  std::unordered_map<std::string, BucketPair> topic_bucket_map;
+
+  /// \brief The drop counters
+  DropCounterMap drop_counter_map;
+};
+} // namespace zeek
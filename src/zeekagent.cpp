@@ -21,10 +21,41 @@
 #include <zeek/system_identifiers.h>
 
 namespace zeek {
+namespace {
+const std::chrono::milliseconds kPublisherWaitTimeout{1000};
+const std::chrono::seconds kStateCheckpointInterval{60};
+
+void publisherThread(ZeekConnection &zeek_connection,
+                     QueryScheduler &query_scheduler,
+                     std::atomic_bool &terminate) {
+
+  while (!terminate) {
+    auto task_output_list =
+        query_scheduler.waitForTaskOutputList(kPublisherWaitTimeout);
+
+    if (task_output_list.empty()) {
+      continue;
+    }
+
+    auto status =
+        zeek_connection.processTaskOutputList(std::move(task_output_list));
+
+    if (!status.succeeded()) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Failed to process the task output list: " +
+                                 status.message());
+    }
+  }
+}
+} // namespace
+
 struct ZeekAgent::PrivateData final {
   IVirtualDatabase::Ref virtual_database;
   std::string host_identifier;
   std::vector<IVirtualTable::Ref> internal_table_list;
+
+  std::unique_ptr<std::thread> publisher_thread;
+  std::atomic_bool terminate_publisher{false};
 };
 
 Status ZeekAgent::create(Ref &obj) {
@@ -93,66 +124,78 @@ Status ZeekAgent::exec(std::atomic_bool &terminate) {
   }
 #endif
 
-  while (!terminate) {
-    service_manager->checkServices();
-
-    if (zeek_connection && query_scheduler) {
-      status = zeek_connection->processEvents();
-
-      if (!status.succeeded()) {
-        getLogger().logMessage(IZeekLogger::Severity::Error,
-                               "The connection has been lost: " +
-                                   status.message());
-
-        zeek_connection.reset();
+  // Connecting is non-blocking; the connection keeps retrying in the
+  // background while the services and the local queries keep running
+  status = initializeConnection(zeek_connection);
+  if (!status.succeeded()) {
+    getLogger().logMessage(IZeekLogger::Severity::Error,
+                           "Failed to initialize the connection: " +
+                               status.message());
 
-        query_scheduler->stop();
-        query_scheduler.reset();
+    return status;
+  }
 
-        continue;
-      }
+  // The scheduled queries survive reconnections; the connection object
+  // reconciles them with the subscriptions renewed by the Zeek server
+  status = initializeQueryScheduler(query_scheduler, *zeek_connection.get());
+  if (!status.succeeded()) {
+    status = Status::failure("Failed to initialize the query scheduler");
 
-    } else {
-      status = initializeConnection(zeek_connection);
+    getLogger().logMessage(IZeekLogger::Severity::Error, status.message());
+    return status;
+  }
 
-      if (!status.succeeded()) {
-        getLogger().logMessage(
-            IZeekLogger::Severity::Error,
-            "Reconnecting has failed. Retrying again later...");
+  status = startPublisher(*zeek_connection.get(), *query_scheduler.get());
+  if (!status.succeeded()) {
+    getLogger().logMessage(IZeekLogger::Severity::Error, status.message());
+    return status;
+  }
 
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-        continue;
-      }
+  auto next_state_checkpoint =
+      std::chrono::steady_clock::now() + kStateCheckpointInterval;
 
-      status = initializeQueryScheduler(query_scheduler);
-      if (!status.succeeded()) {
-        status = Status::failure("Failed to initialize the query scheduler");
+  while (!terminate) {
+    service_manager->checkServices();
 
-        getLogger().logMessage(IZeekLogger::Severity::Error, status.message());
-        return status;
-      }
+    status = zeek_connection->processEvents();
+    if (!status.succeeded()) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Failed to process the connection events: " +
+                                 status.message());
     }
 
-    auto task_queue = zeek_connection->getTaskQueue();
-    query_scheduler->processTaskQueue(std::move(task_queue));
-
-    auto task_output_list = query_scheduler->getTaskOutputList();
-    if (!task_output_list.empty()) {
-      status =
-          zeek_connection->processTaskOutputList(std::move(task_output_list));
+    auto current_time = std::chrono::steady_clock::now();
+    if (current_time >= next_state_checkpoint) {
+      next_state_checkpoint = current_time + kStateCheckpointInterval;
 
+      status = zeek_connection->saveDifferentialState();
       if (!status.succeeded()) {
         getLogger().logMessage(IZeekLogger::Severity::Error,
-                               "Failed to process the task output list: " +
+                               "Failed to save the differential state: " +
                                    status.message());
       }
     }
+
+    // The task output is published by the publisher thread as soon as it
+    // becomes available
+    auto task_queue = zeek_connection->getTaskQueue();
+    query_scheduler->processTaskQueue(std::move(task_queue));
   }
 
   getLogger().logMessage(IZeekLogger::Severity::Information,
                          "Stopping all services");
 
+  stopQueryProcessing(query_scheduler);
+
   if (zeek_connection) {
+    // The publisher has been stopped, so the state can no longer change
+    status = zeek_connection->saveDifferentialState();
+    if (!status.succeeded()) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Failed to save the differential state: " +
+                                 status.message());
+    }
+
     zeek_connection.reset();
   }
 
@@ -161,11 +204,6 @@ Status ZeekAgent::exec(std::atomic_bool &terminate) {
   osquery_interface.reset();
 #endif
 
-  if (query_scheduler) {
-    query_scheduler->stop();
-    query_scheduler.reset();
-  }
-
   service_manager->stopServices();
   service_manager.reset();
 
@@ -201,7 +239,8 @@ Status ZeekAgent::initializeConnection(ZeekConnection::Ref &zeek_connection) {
 }
 
 Status
-ZeekAgent::initializeQueryScheduler(QueryScheduler::Ref &query_scheduler) {
+ZeekAgent::initializeQueryScheduler(QueryScheduler::Ref &query_scheduler,
+                                    ZeekConnection &zeek_connection) {
   if (query_scheduler) {
     query_scheduler->stop();
     query_scheduler.reset();
@@ -214,6 +253,13 @@ ZeekAgent::initializeQueryScheduler(QueryScheduler::Ref &query_scheduler) {
     return status;
   }
 
+  // Snapshot rows are published directly from the scheduler thread
+  query_scheduler->setSnapshotSinkFactory(
+      [&zeek_connection](IVirtualDatabase::IQueryOutputSink::Ref &sink,
+                         const QueryScheduler::Task &task) -> Status {
+        return zeek_connection.createSnapshotSink(sink, task);
+      });
+
   status = query_scheduler->start();
   if (!status.succeeded()) {
     return status;
@@ -222,6 +268,43 @@ ZeekAgent::initializeQueryScheduler(QueryScheduler::Ref &query_scheduler) {
   return Status::success();
 }
 
+Status ZeekAgent::startPublisher(ZeekConnection &zeek_connection,
+                                 QueryScheduler &query_scheduler) {
+  if (d->publisher_thread) {
+    return Status::failure("The publisher thread is already running");
+  }
+
+  try {
+    d->terminate_publisher = false;
+
+    d->publisher_thread = std::make_unique<std::thread>(
+        publisherThread, std::ref(zeek_connection), std::ref(query_scheduler),
+        std::ref(d->terminate_publisher));
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+  }
+}
+
+void ZeekAgent::stopQueryProcessing(QueryScheduler::Ref &query_scheduler) {
+  d->terminate_publisher = true;
+
+  // Stopping the scheduler also wakes up the publisher thread if it is
+  // waiting for new task output
+  if (query_scheduler) {
+    query_scheduler->stop();
+  }
+
+  if (d->publisher_thread) {
+    d->publisher_thread->join();
+    d->publisher_thread.reset();
+  }
+
+  query_scheduler.reset();
+}
+
 Status
 ZeekAgent::initializeServiceManager(IZeekServiceManager::Ref &service_manager) {
   auto &virtual_database = *d->virtual_database.get();
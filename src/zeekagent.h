@@ -49,8 +49,21 @@ private:
 
   /// \brief Initializes the query scheduler
   /// \param query_scheduler Where the scheduler object is stored
+  /// \param zeek_connection The connection used to publish the snapshots
   /// \return A Status object
-  Status initializeQueryScheduler(QueryScheduler::Ref &query_scheduler);
+  Status initializeQueryScheduler(QueryScheduler::Ref &query_scheduler,
+                                  ZeekConnection &zeek_connection);
+
+  /// \brief Starts the thread that publishes the task output to Zeek
+  /// \param zeek_connection The connection used to publish the results
+  /// \param query_scheduler The scheduler producing the task output
+  /// \return A Status object
+  Status startPublisher(ZeekConnection &zeek_connection,
+                        QueryScheduler &query_scheduler);
+
+  /// \brief Stops the publisher thread and the query scheduler
+  /// \param query_scheduler The scheduler object, reset on return
+  void stopQueryProcessing(QueryScheduler::Ref &query_scheduler);
 
   /// \brief Initializes the service manager
   /// \param service_manager Where the service manager object is stored
@@ -1,10 +1,20 @@
 #include "zeekconnection.h"
+#include "backoff.h"
 #include "configuration.h"
+#include "differentialstore.h"
 #include "logger.h"
+#include "ratelimiter.h"
 #include "uniquexxh64state.h"
 #include "utils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <broker/endpoint.hh>
 #include <broker/zeek.hh>
@@ -12,6 +22,10 @@
 #include <zeek/network.h>
 #include <zeek/system_identifiers.h>
 
+#if defined(ZEEK_AGENT_PLATFORM_LINUX)
+#include <zeek/reactor.h>
+#endif
+
 namespace zeek {
 namespace {
 #if defined(ZEEK_AGENT_ENABLE_OSQUERY_SUPPORT)
@@ -31,6 +45,27 @@ const std::string kBrokerTopic_ANNOUNCE{"/zeek/zeek-agent/host_announce"};
 const std::string kBrokerTopic_PRE_INDIVIDUALS{"/zeek/zeek-agent/host/"};
 const std::string kBrokerTopic_PRE_GROUPS{"/zeek/zeek-agent/group/"};
 const std::string kBrokerEvent_HOST_NEW{"ZeekAgent::host_new"};
+const std::string kBrokerEvent_OUTPUT_DROPPED{"ZeekAgent::host_output_dropped"};
+
+const std::chrono::milliseconds kActivityTimeout{1000};
+
+const std::chrono::seconds kConnectionTimeout{10};
+const std::chrono::milliseconds kReconnectionBaseDelay{1000};
+const std::chrono::milliseconds kReconnectionMaxDelay{60000};
+
+const std::string kDifferentialStateFileName{"differential_state.bin"};
+
+const std::chrono::seconds kDropReportInterval{10};
+
+// Every server may send the same one-shot query; the copies that arrive
+// within this window are ignored
+const std::chrono::seconds kOneShotQueryDeduplicationWindow{30};
+
+const std::size_t kBulkOutputSliceSize{256U};
+
+// How long the output of a single query can be held back by the
+// interactive output, across all of its slices
+const std::chrono::milliseconds kMaxBulkOutputDelay{1000};
 
 template <typename FieldType, int field_index>
 FieldType getZeekEventField(const broker::zeek::Event &event) {
@@ -53,24 +88,419 @@ auto getZeekEventCookie = getZeekEventField<std::string, 2>;
 auto getZeekEventResponseTopic = getZeekEventField<std::string, 3>;
 auto getZeekEventUpdateType = getZeekEventField<std::string, 4>;
 auto getZeekEventInterval = getZeekEventField<std::uint64_t, 5>;
+
+const std::size_t kZeekEventKeyColumnListIndex{6U};
+
+std::vector<std::string>
+getZeekEventKeyColumnList(const broker::zeek::Event &event) {
+  // The key columns are optional, so that subscriptions sent by older
+  // scripts keep working with whole-row differentials
+  const auto &argument_list = event.args();
+  if (kZeekEventKeyColumnListIndex >= argument_list.size()) {
+    return {};
+  }
+
+  const auto &argument = argument_list[kZeekEventKeyColumnListIndex];
+  if (!broker::is<broker::vector>(argument)) {
+    throw Status::failure("Field is of wrong type");
+  }
+
+  std::vector<std::string> key_column_list;
+
+  for (const auto &key_column : broker::get<broker::vector>(argument)) {
+    if (!broker::is<std::string>(key_column)) {
+      throw Status::failure("Key column names must be strings");
+    }
+
+    const auto &key_column_name = broker::get<std::string>(key_column);
+
+    if (std::find(key_column_list.begin(), key_column_list.end(),
+                  key_column_name) != key_column_list.end()) {
+      throw Status::failure("Duplicated key column: " + key_column_name);
+    }
+
+    key_column_list.push_back(key_column_name);
+  }
+
+  return key_column_list;
+}
+
+bool isSameSubscription(const QueryScheduler::Task &task1,
+                        const QueryScheduler::Task &task2) {
+  return task1.query == task2.query && task1.interval == task2.interval &&
+         task1.update_type == task2.update_type &&
+         task1.key_column_list == task2.key_column_list;
+}
+
+/// \brief Scores a peer for the given shard (rendezvous hashing); the
+///        shard is owned by the connected peer with the highest score, so
+///        only the shards of a lost peer move when it goes away
+std::uint64_t computeShardScore(const std::string &shard_key,
+                                const std::string &peer_name) {
+  auto buffer = shard_key + "@" + peer_name;
+  return XXH64(buffer.data(), buffer.size(), 0U);
+}
+
+QueryScheduler::Task createRemovalTask(const QueryScheduler::Task &task) {
+  auto removal_task = task;
+  removal_task.type = QueryScheduler::Task::Type::RemoveScheduledQuery;
+
+  return removal_task;
+}
+
+RateLimiter::Configuration getRateLimiterConfiguration() {
+  RateLimiter::Configuration configuration;
+  configuration.max_rows_per_second = getConfig().maxRowsPerSecond();
+  configuration.max_bytes_per_second = getConfig().maxBytesPerSecond();
+
+  configuration.max_topic_rows_per_second =
+      getConfig().maxTopicRowsPerSecond();
+
+  configuration.max_topic_bytes_per_second =
+      getConfig().maxTopicBytesPerSecond();
+
+  return configuration;
+}
+
+/// \brief Estimates how many bytes the given row takes once published
+std::uint64_t estimateRowSize(const IVirtualDatabase::OutputRow &row) {
+  std::uint64_t row_size{0U};
+
+  for (const auto &column : row) {
+    if (!column.data.has_value()) {
+      row_size += 1U;
+      continue;
+    }
+
+    const auto &column_variant = column.data.value();
+
+    if (std::holds_alternative<std::string>(column_variant)) {
+      row_size += std::get<std::string>(column_variant).size();
+    } else {
+      row_size += sizeof(std::uint64_t);
+    }
+  }
+
+  return row_size;
+}
+
+/// \brief Estimates how many bytes the given row takes once published
+std::uint64_t estimateRowSize(const IVirtualDatabase::IRowView &row) {
+  std::uint64_t row_size{0U};
+
+  for (std::size_t i = 0U; i < row.columnCount(); ++i) {
+    switch (row.columnType(i)) {
+    case IVirtualDatabase::IRowView::ColumnType::Null:
+      row_size += 1U;
+      break;
+
+    case IVirtualDatabase::IRowView::ColumnType::String:
+      row_size += row.stringValue(i).size();
+      break;
+
+    case IVirtualDatabase::IRowView::ColumnType::Integer:
+    case IVirtualDatabase::IRowView::ColumnType::Double:
+      row_size += sizeof(std::uint64_t);
+      break;
+    }
+  }
+
+  return row_size;
+}
+
+bool isKeyColumn(const std::vector<std::string> &key_column_list,
+                 const std::string &column_name) {
+  return std::find(key_column_list.begin(), key_column_list.end(),
+                   column_name) != key_column_list.end();
+}
+
+/// \brief How a keyed row has changed between two runs
+enum class RowChange {
+  /// \brief The row is the same
+  None,
+
+  /// \brief The row can be sent as an UPDATE event
+  Updated,
+
+  /// \brief The row must be sent as a REMOVE and an ADD event
+  Replaced
+};
+
+/// \brief Builds the row sent with an UPDATE event: key columns and
+///        changed columns are kept, while the unchanged ones are set to NULL
+/// \return Whether the row has changed, and how it must be sent
+RowChange createUpdatedRow(IVirtualDatabase::OutputRow &updated_row,
+                           const IVirtualDatabase::OutputRow &old_row,
+                           const IVirtualDatabase::OutputRow &new_row,
+                           const std::vector<std::string> &key_column_list) {
+
+  updated_row = new_row;
+
+  // The rows come from the same query, so the columns can only differ if
+  // the table schema itself has changed
+  if (old_row.size() != new_row.size()) {
+    return RowChange::Replaced;
+  }
+
+  auto row_change = RowChange::None;
+
+  for (std::size_t i = 0U; i < new_row.size(); ++i) {
+    const auto &old_column = old_row.at(i);
+    const auto &new_column = new_row.at(i);
+
+    if (old_column.name != new_column.name) {
+      return RowChange::Replaced;
+    }
+
+    if (isKeyColumn(key_column_list, new_column.name)) {
+      continue;
+    }
+
+    if (old_column.data == new_column.data) {
+      updated_row.at(i).data = std::nullopt;
+      continue;
+    }
+
+    // NULL marks the unchanged columns, so a column that has become NULL
+    // can not be represented by an UPDATE event
+    if (!new_column.data.has_value()) {
+      return RowChange::Replaced;
+    }
+
+    row_change = RowChange::Updated;
+  }
+
+  return row_change;
+}
+
+/// \brief Lets the interactive output overtake the bulk output that is
+///        published by the publisher thread
+class PublisherPriority final {
+public:
+  /// \brief Marks the start of an interactive output stream
+  void beginInteractiveOutput() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++interactive_output_count;
+  }
+
+  /// \brief Marks the end of an interactive output stream
+  void endInteractiveOutput() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      --interactive_output_count;
+    }
+
+    interactive_output_cv.notify_all();
+  }
+
+  /// \brief Waits until no interactive output is being published, or until
+  ///        the given deadline expires. Returns immediately once the
+  ///        deadline has passed
+  /// \param deadline When to stop waiting
+  void waitForInteractiveOutput(
+      const std::chrono::steady_clock::time_point &deadline) {
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    interactive_output_cv.wait_until(lock, deadline, [this]() -> bool {
+      return interactive_output_count == 0U;
+    });
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable interactive_output_cv;
+  std::size_t interactive_output_count{0U};
+};
+
+broker::data createMessageHeader(const std::string &host_identifier,
+                                 const std::string &trigger,
+                                 const std::string &cookie) {
+  // clang-format off
+  return broker::data(
+    broker::vector(
+      {
+        broker::data(host_identifier),
+        broker::data(broker::data(broker::enum_value{trigger})),
+        broker::data(cookie)
+      }
+    )
+  );
+  // clang-format on
+}
+
+/// \brief Publishes the rows of a snapshot query while SQLite is still
+///        stepping the statement, without materializing the query output
+class SnapshotPublisher final : public IVirtualDatabase::IQueryOutputSink {
+public:
+  /// \brief Constructor
+  /// \param endpoint The endpoint used to publish the events
+  /// \param host_identifier The identifier of this host
+  /// \param priority Used to hold back the bulk output while the rows of
+  ///                 this snapshot are being published
+  /// \param limiter The rate limiter applied to the published rows
+  /// \param task The snapshot task
+  /// \param task_query_id The query ID of the snapshot task
+  SnapshotPublisher(broker::endpoint &endpoint,
+                    const std::string &host_identifier,
+                    PublisherPriority &priority, RateLimiter &limiter,
+                    const QueryScheduler::Task &task,
+                    const std::string &task_query_id)
+      : broker_endpoint(endpoint), publisher_priority(priority),
+        rate_limiter(limiter), query_id(task_query_id),
+        response_topic(task.response_topic),
+        response_event(task.response_event),
+        message_header(createMessageHeader(host_identifier,
+                                           "ZeekAgent::SNAPSHOT",
+                                           task.cookie)) {}
+
+  /// \brief Destructor
+  virtual ~SnapshotPublisher() override {
+    if (output_started) {
+      publisher_priority.endInteractiveOutput();
+    }
+  }
+
+  virtual Status processRow(const IVirtualDatabase::IRowView &row) override {
+    // The bulk output only yields once rows are actually flowing, and not
+    // while this query is still waiting for the database
+    if (!output_started) {
+      publisher_priority.beginInteractiveOutput();
+      output_started = true;
+    }
+
+    // Rows over the rate limits are dropped, and reported by the connection
+    if (!rate_limiter.acquire(response_topic, query_id,
+                              estimateRowSize(row))) {
+      return Status::success();
+    }
+
+    // Each published event takes ownership of its message vector, so it is
+    // allocated once per row with its final size
+    broker::vector message_data;
+    message_data.reserve(row.columnCount() + 1U);
+    message_data.push_back(message_header);
+
+    for (std::size_t i = 0U; i < row.columnCount(); ++i) {
+      switch (row.columnType(i)) {
+      case IVirtualDatabase::IRowView::ColumnType::Integer:
+        message_data.emplace_back(row.integerValue(i));
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::Double:
+        message_data.emplace_back(row.doubleValue(i));
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::String:
+        // The only copy: SQLite reuses the column buffer on the next step
+        message_data.emplace_back(std::string(row.stringValue(i)));
+        break;
+
+      case IVirtualDatabase::IRowView::ColumnType::Null:
+        if (!null_column_reported) {
+          getLogger().logMessage(IZeekLogger::Severity::Warning,
+                                 "Returning a NULL column. This may not be "
+                                 "correctly supported by Zeek");
+
+          null_column_reported = true;
+        }
+
+        message_data.emplace_back();
+        break;
+      }
+    }
+
+    // clang-format off
+    broker_endpoint.publish(
+      response_topic,
+      broker::zeek::Event(response_event, std::move(message_data))
+    );
+    // clang-format on
+
+    return Status::success();
+  }
+
+  virtual Status finish() override { return Status::success(); }
+
+private:
+  broker::endpoint &broker_endpoint;
+  PublisherPriority &publisher_priority;
+  RateLimiter &rate_limiter;
+  std::string query_id;
+  std::string response_topic;
+  std::string response_event;
+  broker::data message_header;
+  bool output_started{false};
+  bool null_column_reported{false};
+};
 } // namespace
 
-struct ZeekConnection::PrivateData final {
-  PrivateData(broker::configuration config)
-      : broker_endpoint(new broker::endpoint(std::move(config))),
-        status_subscriber(broker_endpoint->make_status_subscriber(true)) {}
+struct ZeekConnection::Peer final {
+  Peer(broker::configuration config,
+       const IZeekConfiguration::ServerAddress &server_address)
+      : address(server_address.address), port(server_address.port),
+        broker_endpoint(new broker::endpoint(std::move(config))),
+        status_subscriber(broker_endpoint->make_status_subscriber(true)),
+        subscriber(broker_endpoint->make_subscriber({})) {
 
-  std::string peer_name;
-  std::string host_identifier;
+    name = address.find(':') == std::string::npos ? address
+                                                   : "[" + address + "]";
+
+    name += ":" + std::to_string(port);
+  }
+
+  std::string address;
+  std::uint16_t port{0U};
+  std::string name;
+
+  // Each server gets its own endpoint, so that output can be published to
+  // a single server instead of being forwarded to all of them
   std::unique_ptr<broker::endpoint> broker_endpoint;
 
   broker::status_subscriber status_subscriber;
 
-  std::unordered_map<std::string, broker::subscriber> subscriber_map;
+  // A single subscriber for all the control topics; topics are added and
+  // removed as groups are joined and left
+  broker::subscriber subscriber;
+
+  std::atomic<State> state{State::Disconnected};
+  std::chrono::steady_clock::time_point next_connection_attempt;
+  std::chrono::steady_clock::time_point connection_attempt_deadline;
+
+  ExponentialBackoff reconnection_backoff{kReconnectionBaseDelay,
+                                          kReconnectionMaxDelay};
+};
+
+struct ZeekConnection::PrivateData final {
+  std::string peer_name;
+  std::string host_identifier;
+
+  // Never changes after construction, so the publisher thread can read it
+  // without locking
+  std::vector<std::unique_ptr<Peer>> peer_list;
+
   std::vector<std::string> joined_group_list;
+  std::vector<std::string> subscribed_topic_list;
+
+  std::atomic<State> state{State::Disconnected};
+
+#if defined(ZEEK_AGENT_PLATFORM_LINUX)
+  Reactor::Ref reactor;
+#endif
 
   QueryScheduler::TaskQueue task_queue;
-  DifferentialContext differential_context;
+
+  // Guards the session context, which is also accessed by the publisher
+  // thread
+  std::mutex session_mutex;
+
+  SessionContext session_context;
+  std::chrono::steady_clock::time_point resumption_deadline;
+
+  PublisherPriority publisher_priority;
+
+  RateLimiter rate_limiter{getRateLimiterConfiguration()};
+  std::chrono::steady_clock::time_point next_drop_report;
 };
 
 Status ZeekConnection::create(Ref &obj, const std::string &host_identifier) {
@@ -90,7 +520,13 @@ Status ZeekConnection::create(Ref &obj, const std::string &host_identifier) {
   }
 }
 
-ZeekConnection::~ZeekConnection() { d->broker_endpoint->shutdown(); }
+ZeekConnection::~ZeekConnection() {
+  for (auto &peer : d->peer_list) {
+    peer->broker_endpoint->shutdown();
+  }
+}
+
+ZeekConnection::State ZeekConnection::state() const { return d->state; }
 
 Status ZeekConnection::joinGroup(const std::string &name) {
   auto group_it =
@@ -131,20 +567,24 @@ Status ZeekConnection::leaveGroup(const std::string &name) {
 }
 
 Status ZeekConnection::processEvents() {
-  StatusEventList status_event_list;
-  auto status = getStatusEvents(status_event_list);
-  if (!status.succeeded()) {
-    return status;
-  }
+  for (auto &peer : d->peer_list) {
+    StatusEventList status_event_list;
+    StatusErrorList status_error_list;
+    auto status =
+        getStatusEvents(*peer.get(), status_event_list, status_error_list);
 
-  if (!status_event_list.empty()) {
-    // Whatever happened, we are either disconnected or have just
-    // reconnected (in which case we have to reset the connection state)
-    return Status::failure("Connection hase been lost or reset");
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    updateConnectionState(*peer.get(), status_event_list, status_error_list);
   }
 
+  updateSessionState();
+  reportDroppedOutput();
+
   bool ready{false};
-  status = waitForActivity(ready);
+  auto status = waitForActivity(ready);
   if (!status.succeeded()) {
     return status;
   }
@@ -153,74 +593,226 @@ Status ZeekConnection::processEvents() {
     return Status::success();
   }
 
-  for (auto &subscriber_p : d->subscriber_map) {
-    auto &subscriber = subscriber_p.second;
+  // The same requests may come from more than one server; processTask()
+  // ignores the subscriptions that are already active
+  for (auto &peer : d->peer_list) {
+    for (const auto &message : peer->subscriber.poll()) {
+      processZeekEvent(broker::zeek::Event(caf::get<1>(message)));
+    }
+  }
 
-    for (const auto &message : subscriber.poll()) {
-      broker::zeek::Event event(caf::get<1>(message));
+  return Status::success();
+}
 
-      if (event.name() == kHostJoinEvent || event.name() == kHostLeaveEvent) {
-        const auto &argument_list = event.args();
+void ZeekConnection::processZeekEvent(const broker::zeek::Event &event) {
+  Status status;
 
-        if (argument_list.size() != 1U) {
-          getLogger().logMessage(IZeekLogger::Severity::Error,
-                                 "Invalid host_join/host_leave event received "
-                                 "(wrong argument count)");
+  if (event.name() == kHostJoinEvent || event.name() == kHostLeaveEvent) {
+    const auto &argument_list = event.args();
 
-          continue;
-        }
+    if (argument_list.size() != 1U) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Invalid host_join/host_leave event received "
+                             "(wrong argument count)");
 
-        auto group_name_ptr = broker::get_if<std::string>(argument_list[0]);
-        if (group_name_ptr == nullptr) {
-          getLogger().logMessage(IZeekLogger::Severity::Error,
-                                 "Invalid host_join/host_leave event received "
-                                 "(missing or invalid group name)");
+      return;
+    }
 
-          continue;
-        }
+    auto group_name_ptr = broker::get_if<std::string>(argument_list[0]);
+    if (group_name_ptr == nullptr) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Invalid host_join/host_leave event received "
+                             "(missing or invalid group name)");
 
-        const auto &group_name = *group_name_ptr;
+      return;
+    }
 
-        if (event.name() == kHostJoinEvent) {
-          status = joinGroup(group_name);
-        } else {
-          status = leaveGroup(group_name);
-        }
+    const auto &group_name = *group_name_ptr;
 
-        if (!status.succeeded()) {
-          getLogger().logMessage(
-              IZeekLogger::Severity::Error,
-              "Failed to handle host_join/host_leave event: " +
-                  status.message());
-        }
+    // Each server may send the same request, so repeated ones are ignored
+    auto joined = std::find(d->joined_group_list.begin(),
+                            d->joined_group_list.end(),
+                            group_name) != d->joined_group_list.end();
 
-      } else {
-        QueryScheduler::Task pending_task;
+    if (joined == (event.name() == kHostJoinEvent)) {
+      return;
+    }
 
-        status = taskFromZeekEvent(pending_task, event);
-        if (!status.succeeded()) {
-          getLogger().logMessage(IZeekLogger::Severity::Error,
+    if (event.name() == kHostJoinEvent) {
+      status = joinGroup(group_name);
+    } else {
+      status = leaveGroup(group_name);
+    }
+
+    if (!status.succeeded()) {
+      getLogger().logMessage(IZeekLogger::Severity::Error,
+                             "Failed to handle host_join/host_leave event: " +
                                  status.message());
+    }
 
-        } else {
-          if (pending_task.type ==
-              QueryScheduler::Task::Type::RemoveScheduledQuery) {
-            auto query_id = computeQueryID(pending_task.response_topic,
-                                           pending_task.response_event,
-                                           pending_task.cookie);
+  } else {
+    QueryScheduler::Task pending_task;
 
-            d->differential_context.erase(query_id);
-          }
+    status = taskFromZeekEvent(pending_task, event);
+    if (!status.succeeded()) {
+      getLogger().logMessage(IZeekLogger::Severity::Error, status.message());
+
+    } else {
+      processTask(std::move(pending_task));
+    }
+  }
+}
+
+void ZeekConnection::processTask(QueryScheduler::Task task) {
+  std::lock_guard<std::mutex> lock(d->session_mutex);
+
+  if (task.type == QueryScheduler::Task::Type::ExecuteQuery) {
+    if (acceptOneShotTask(d->session_context, task)) {
+      d->task_queue.push_back(std::move(task));
+
+    } else {
+      getLogger().logMessage(IZeekLogger::Severity::Debug,
+                             "Ignoring a repeated one-shot query: " +
+                                 task.query);
+    }
+
+    return;
+  }
+
+  auto query = task.query;
+  if (reconcileScheduledTask(d->session_context, d->task_queue,
+                             std::move(task))) {
+
+    getLogger().logMessage(IZeekLogger::Severity::Debug,
+                           "Resuming scheduled query: " + query);
+  }
+}
+
+Status ZeekConnection::saveDifferentialState() {
+  const auto &state_folder = getConfig().stateFolder();
+  if (state_folder.empty()) {
+    return Status::success();
+  }
+
+  // Only the tasks and the differential data pointers are copied while the
+  // session is locked; the rows are serialized afterwards
+  DifferentialStore::EntryList entry_list;
+
+  {
+    std::lock_guard<std::mutex> lock(d->session_mutex);
+
+    const auto &session_context = d->session_context;
+
+    for (const auto *subscription_map :
+         {&session_context.active_subscription_map,
+          &session_context.resuming_subscription_map}) {
 
-          d->task_queue.push_back(std::move(pending_task));
+      for (const auto &subscription_p : *subscription_map) {
+        const auto &query_id = subscription_p.first;
+        const auto &task = subscription_p.second;
+
+        DifferentialStore::Entry entry;
+        entry.task = task;
+
+        const auto &differential_context =
+            session_context.differential_context;
+
+        auto context_it = differential_context.find(query_id);
+        if (context_it != differential_context.end()) {
+          entry.differential_data = context_it->second;
         }
+
+        entry_list.push_back(std::move(entry));
       }
     }
   }
 
+  std::error_code error;
+  std::filesystem::create_directories(state_folder, error);
+  if (error) {
+    return Status::failure("Failed to create the state folder: " +
+                           state_folder);
+  }
+
+  auto state_file_path =
+      (std::filesystem::path(state_folder) / kDifferentialStateFileName)
+          .string();
+
+  return DifferentialStore::save(state_file_path, entry_list);
+}
+
+Status ZeekConnection::loadDifferentialState() {
+  const auto &state_folder = getConfig().stateFolder();
+  if (state_folder.empty()) {
+    return Status::success();
+  }
+
+  auto state_file_path =
+      (std::filesystem::path(state_folder) / kDifferentialStateFileName)
+          .string();
+
+  DifferentialStore::EntryList entry_list;
+  auto status = DifferentialStore::load(entry_list, state_file_path);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  std::lock_guard<std::mutex> lock(d->session_mutex);
+
+  for (auto &entry : entry_list) {
+    auto query_id = computeQueryID(entry.task.response_topic,
+                                   entry.task.response_event,
+                                   entry.task.cookie);
+
+    auto &session_context = d->session_context;
+
+    if (entry.differential_data != nullptr &&
+        !entry.differential_data->empty()) {
+      session_context.differential_context.insert(
+          {query_id, std::move(entry.differential_data)});
+    }
+
+    session_context.resuming_subscription_map.insert({query_id, entry.task});
+    d->task_queue.push_back(std::move(entry.task));
+  }
+
+  if (!entry_list.empty()) {
+    getLogger().logMessage(IZeekLogger::Severity::Information,
+                           "Restored " + std::to_string(entry_list.size()) +
+                               " scheduled queries from " + state_file_path);
+  }
+
   return Status::success();
 }
 
+Status ZeekConnection::createSnapshotSink(
+    IVirtualDatabase::IQueryOutputSink::Ref &sink,
+    const QueryScheduler::Task &task) {
+
+  sink.reset();
+
+  // Snapshots produced while disconnected would be discarded anyway, so
+  // the query is not even executed
+  auto query_id =
+      computeQueryID(task.response_topic, task.response_event, task.cookie);
+
+  auto peer = selectPeer(query_id);
+  if (peer == nullptr) {
+    return Status::success();
+  }
+
+  try {
+    sink = std::make_unique<SnapshotPublisher>(
+        *peer->broker_endpoint.get(), d->host_identifier,
+        d->publisher_priority, d->rate_limiter, task, query_id);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+  }
+}
+
 QueryScheduler::TaskQueue ZeekConnection::getTaskQueue() {
   auto output = std::move(d->task_queue);
   d->task_queue = {};
@@ -229,34 +821,48 @@ QueryScheduler::TaskQueue ZeekConnection::getTaskQueue() {
 }
 
 void ZeekConnection::publishTaskOutput(
-    const std::string &trigger, const std::string &response_topic,
+    Peer &peer, const std::string &trigger, const std::string &response_topic,
     const std::string &response_event, const std::string &cookie,
-    const IVirtualDatabase::QueryOutput &query_output) {
+    IVirtualDatabase::QueryOutput query_output,
+    const std::chrono::steady_clock::time_point &bulk_output_deadline) {
 
-  // clang-format off
-  broker::vector message_header(
-    {
-      broker::data(d->host_identifier),
-      broker::data(broker::data(broker::enum_value{trigger})),
-      broker::data(cookie)
+  auto message_header =
+      createMessageHeader(d->host_identifier, trigger, cookie);
+
+  // Update events use NULL to mark the columns that have not changed
+  bool null_column_reported = (trigger == "ZeekAgent::UPDATE");
+
+  for (std::size_t row_index = 0U; row_index < query_output.size();
+       ++row_index) {
+
+    // Bulk output is published in slices, and the one-shot queries that
+    // are streaming their snapshots are allowed to go first. No lock is
+    // held here, and the total delay is bounded for each query
+    if (row_index % kBulkOutputSliceSize == 0U) {
+      d->publisher_priority.waitForInteractiveOutput(bulk_output_deadline);
     }
-  );
-  // clang-format on
 
-  for (const auto &row : query_output) {
-    broker::vector message_data = {broker::data(message_header)};
+    auto &row = query_output.at(row_index);
+
+    // The rows are owned by this method, so their values are moved into the
+    // message instead of being copied. The message vector itself is handed
+    // over to the published event, so it is allocated once per row with its
+    // final size
+    broker::vector message_data;
+    message_data.reserve(row.size() + 1U);
+    message_data.push_back(message_header);
 
     bool skip_row = false;
 
-    for (const auto &column : row) {
+    for (auto &column : row) {
       broker::data column_value = {};
 
       if (column.data.has_value()) {
-        const auto &column_variant = column.data.value();
+        auto &column_variant = column.data.value();
 
         if (std::holds_alternative<std::string>(column_variant)) {
-          const auto &string_value = std::get<std::string>(column_variant);
-          column_value = broker::data(string_value);
+          auto &string_value = std::get<std::string>(column_variant);
+          column_value = broker::data(std::move(string_value));
 
         } else if (std::holds_alternative<std::int64_t>(column_variant)) {
           auto integer_value = std::get<std::int64_t>(column_variant);
@@ -273,187 +879,554 @@ void ZeekConnection::publishTaskOutput(
           break;
         }
 
-      } else {
-        getLogger().logMessage(IZeekLogger::Severity::Warning,
-                               "Returning a NULL column. This may not be "
-                               "correctly supported by Zeek");
+      } else {
+        if (!null_column_reported) {
+          getLogger().logMessage(IZeekLogger::Severity::Warning,
+                                 "Returning a NULL column. This may not be "
+                                 "correctly supported by Zeek");
+
+          null_column_reported = true;
+        }
+
+        column_value = broker::data();
+      }
+
+      message_data.push_back(std::move(column_value));
+    }
+
+    if (!skip_row) {
+      // clang-format off
+      peer.broker_endpoint->publish(
+        response_topic,
+        broker::zeek::Event(response_event, std::move(message_data))
+      );
+      // clang-format on
+    }
+  }
+}
+
+Status
+ZeekConnection::processTaskOutput(QueryScheduler::TaskOutput task_output) {
+
+  auto query_id = computeQueryID(task_output.response_topic,
+                                 task_output.response_event,
+                                 task_output.cookie);
+
+  Peer *peer{nullptr};
+
+  auto bulk_output_deadline =
+      std::chrono::steady_clock::now() + kMaxBulkOutputDelay;
+
+  if (task_output.update_type.has_value()) {
+    DifferentialOutput differential_output;
+
+    {
+      // The peer is selected while holding the lock, so that a failover
+      // either happens before the differentials are computed, or resets
+      // them after this output has been published
+      std::lock_guard<std::mutex> lock(d->session_mutex);
+
+      // Output produced while disconnected is discarded without touching
+      // the differential state, so that the first run after the
+      // subscription has been renewed only sends what has actually changed
+      peer = selectPeer(query_id);
+      if (peer == nullptr) {
+        return Status::success();
+      }
+
+      // The rate limits are applied before the differential state is
+      // updated, so that the rejected rows are reported again by the next
+      // run instead of being lost. They are deferred rather than dropped,
+      // so they are not added to the drop counters
+      const auto &response_topic = task_output.response_topic;
+
+      auto status = computeSubscriptionDifferentials(
+          d->session_context, differential_output, task_output,
+          [this, &response_topic](const IVirtualDatabase::OutputRow &row) {
+            return d->rate_limiter.tryAcquire(response_topic,
+                                              estimateRowSize(row));
+          });
+
+      if (!status.succeeded()) {
+        return status;
+      }
+    }
+
+    publishTaskOutput(*peer, "ZeekAgent::ADD", task_output.response_topic,
+                      task_output.response_event, task_output.cookie,
+                      std::move(differential_output.added_row_list),
+                      bulk_output_deadline);
+
+    publishTaskOutput(*peer, "ZeekAgent::REMOVE", task_output.response_topic,
+                      task_output.response_event, task_output.cookie,
+                      std::move(differential_output.removed_row_list),
+                      bulk_output_deadline);
+
+    publishTaskOutput(*peer, "ZeekAgent::UPDATE", task_output.response_topic,
+                      task_output.response_event, task_output.cookie,
+                      std::move(differential_output.updated_row_list),
+                      bulk_output_deadline);
+
+  } else {
+    peer = selectPeer(query_id);
+    if (peer == nullptr) {
+      return Status::success();
+    }
+
+    // Rows over the rate limits are dropped, and reported by processEvents()
+    auto &query_output = task_output.query_output;
+
+    query_output.erase(
+        std::remove_if(query_output.begin(), query_output.end(),
+                       [this, &task_output, &query_id](
+                           const IVirtualDatabase::OutputRow &row) -> bool {
+                         return !d->rate_limiter.acquire(
+                             task_output.response_topic, query_id,
+                             estimateRowSize(row));
+                       }),
+        query_output.end());
+
+    publishTaskOutput(*peer, "ZeekAgent::SNAPSHOT", task_output.response_topic,
+                      task_output.response_event, task_output.cookie,
+                      std::move(task_output.query_output),
+                      bulk_output_deadline);
+  }
+
+  return Status::success();
+}
+
+Status ZeekConnection::processTaskOutputList(
+    QueryScheduler::TaskOutputList task_output_list) {
+
+  for (auto &task_output : task_output_list) {
+    auto status = processTaskOutput(std::move(task_output));
+    if (!status.succeeded()) {
+      return status;
+    }
+  }
+
+  return Status::success();
+}
+
+Status ZeekConnection::waitForActivity(bool &ready) {
+  ready = false;
+
+#if defined(ZEEK_AGENT_PLATFORM_LINUX)
+  // The subscriber and the status subscriber of each server are registered
+  // with the reactor, so connection changes are also reported as soon as
+  // they happen
+  Reactor::DescriptorList ready_list;
+  auto status = d->reactor->wait(ready_list, kActivityTimeout);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  ready = !ready_list.empty();
+  return Status::success();
+
+#else
+  fd_set fd_list;
+  FD_ZERO(&fd_list);
+
+  int highest_socket_fd = -1;
+
+  for (const auto &peer : d->peer_list) {
+    auto socket = peer->subscriber.fd();
+    FD_SET(socket, &fd_list);
+
+    highest_socket_fd = std::max(highest_socket_fd, socket);
+  }
+
+  struct timeval timeout {};
+  timeout.tv_sec = static_cast<long>(kActivityTimeout.count() / 1000);
+
+  auto select_err =
+      select(highest_socket_fd + 1, &fd_list, nullptr, nullptr, &timeout);
+  if (select_err == 0) {
+    return Status::success();
+
+  } else if (select_err == -1) {
+#ifdef WIN32
+    auto error_code = WSAGetLastError();
+    auto eintr_value = WSAEINTR;
+#else
+    auto error_code = errno;
+    auto eintr_value = EINTR;
+#endif
+
+    if (error_code == eintr_value) {
+      return Status::success();
+    }
+
+    return Status::failure("poll() has failed with error " +
+                           std::to_string(error_code));
+  }
+
+  ready = true;
+  return Status::success();
+#endif
+}
+
+ZeekConnection::ZeekConnection(const std::string &host_identifier)
+    : d(new PrivateData) {
+
+  d->peer_name = getSystemHostname();
+  d->host_identifier = host_identifier;
+
+  for (const auto &server_address : getConfig().serverList()) {
+    d->peer_list.push_back(
+        std::make_unique<Peer>(getBrokerConfiguration(), server_address));
+  }
+
+#if defined(ZEEK_AGENT_PLATFORM_LINUX)
+  {
+    auto status = Reactor::create(d->reactor);
+    if (!status.succeeded()) {
+      throw status;
+    }
+
+    for (const auto &peer : d->peer_list) {
+      status = d->reactor->addDescriptor(peer->status_subscriber.fd());
+      if (!status.succeeded()) {
+        throw status;
+      }
+
+      status = d->reactor->addDescriptor(peer->subscriber.fd());
+      if (!status.succeeded()) {
+        throw status;
+      }
+    }
+  }
+#endif
+
+  // Subscriptions are local to the endpoint and survive reconnections; the
+  // connection itself is established by processEvents()
+  auto status = createSubscription(kBrokerTopic_ALL);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status =
+      createSubscription(kBrokerTopic_PRE_INDIVIDUALS + d->host_identifier);
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  for (const auto &group_name : getConfig().groupList()) {
+    status = joinGroup(group_name);
+    if (!status.succeeded()) {
+      throw status;
+    }
+  }
+
+  // A missing or damaged state only means that the differentials are
+  // computed again from scratch
+  status = loadDifferentialState();
+  if (!status.succeeded()) {
+    getLogger().logMessage(IZeekLogger::Severity::Warning,
+                           "Failed to restore the differential state: " +
+                               status.message());
+  }
+}
+
+broker::configuration ZeekConnection::getBrokerConfiguration() {
+  auto ca_file_path = getConfig().certificateAuthority();
+  auto cert_file_path = getConfig().clientCertificate();
+  auto key_file_path = getConfig().clientKey();
+
+  broker::configuration config;
+
+  if (!ca_file_path.empty() && !cert_file_path.empty() &&
+      !key_file_path.empty()) {
+    config.set("openssl.cafile", ca_file_path);
+    config.set("openssl.certificate", cert_file_path);
+    config.set("openssl.key", key_file_path);
+  }
+
+  return config;
+}
+
+Status ZeekConnection::createSubscription(const std::string &topic) {
+  auto topic_it = std::find(d->subscribed_topic_list.begin(),
+                            d->subscribed_topic_list.end(), topic);
+
+  if (topic_it != d->subscribed_topic_list.end()) {
+    return Status::failure(
+        "A subscription already exists for the following topic: " + topic);
+  }
+
+  for (auto &peer : d->peer_list) {
+    peer->subscriber.add_topic(topic);
+  }
+
+  d->subscribed_topic_list.push_back(topic);
+
+  getLogger().logMessage(IZeekLogger::Severity::Information,
+                         "Subscribed to: " + topic);
+
+  return Status::success();
+}
+
+Status ZeekConnection::destroySubscription(const std::string &topic) {
+  auto topic_it = std::find(d->subscribed_topic_list.begin(),
+                            d->subscribed_topic_list.end(), topic);
+
+  if (topic_it == d->subscribed_topic_list.end()) {
+    return Status::failure("The following topic has not been subscribed to: " +
+                           topic);
+  }
+
+  for (auto &peer : d->peer_list) {
+    peer->subscriber.remove_topic(topic);
+  }
+
+  d->subscribed_topic_list.erase(topic_it);
+  return Status::success();
+}
+
+Status ZeekConnection::getStatusEvents(Peer &peer,
+                                       StatusEventList &status_event_list,
+                                       StatusErrorList &status_error_list) {
+  status_event_list = {};
+  status_error_list = {};
+
+  auto status_message_list = peer.status_subscriber.poll();
+  if (status_message_list.empty()) {
+    return Status::success();
+  }
+
+  for (const auto &status_message : status_message_list) {
+    if (const auto &status = caf::get_if<broker::status>(&status_message)) {
+      status_event_list.push_back(status->code());
+    }
+
+    if (const auto &error = caf::get_if<broker::error>(&status_message)) {
+      std::string message = caf::to_string(error->context()).c_str();
+      status_error_list.push_back(std::move(message));
+    }
+  }
+
+  return Status::success();
+}
+
+void ZeekConnection::updateConnectionState(
+    Peer &peer, const StatusEventList &status_event_list,
+    const StatusErrorList &status_error_list) {
+
+  for (const auto &error_message : status_error_list) {
+    getLogger().logMessage(IZeekLogger::Severity::Warning,
+                           "Broker has returned an error (" + peer.name +
+                               "): " + error_message);
+  }
+
+  for (const auto &status_code : status_event_list) {
+    switch (status_code) {
+    case broker::sc::peer_added:
+      if (peer.state != State::Connected) {
+        peer.state = State::Connected;
+        peer.reconnection_backoff.reset();
+
+        getLogger().logMessage(IZeekLogger::Severity::Information,
+                               "Successfully connected to " + peer.name);
+
+        // Take over the queries that this server owns from the other
+        // servers; with no other server connected there is nothing to
+        // take over, and the suspended session is resumed instead
+        if (d->state == State::Connected) {
+          resetPeerShards(peer);
+        }
+
+        announceHost(peer);
+      }
+
+      break;
+
+    case broker::sc::peer_lost:
+    case broker::sc::peer_removed:
+      if (peer.state == State::Connected) {
+        scheduleConnectionAttempt(peer, "The connection has been lost");
+
+        // Hand the queries owned by this server over to the ones that are
+        // still connected. The session is suspended by updateSessionState()
+        // when no server is left
+        auto other_peer_connected =
+            std::any_of(d->peer_list.begin(), d->peer_list.end(),
+                        [](const std::unique_ptr<Peer> &other_peer) {
+                          return other_peer->state == State::Connected;
+                        });
+
+        if (other_peer_connected) {
+          resetPeerShards(peer);
+        }
 
-        column_value = broker::data();
+      } else if (peer.state == State::Connecting) {
+        scheduleConnectionAttempt(peer, "The connection attempt has failed");
       }
 
-      message_data.push_back(std::move(column_value));
-    }
+      break;
 
-    if (!skip_row) {
-      // clang-format off
-      d->broker_endpoint->publish(
-        response_topic,
-        broker::zeek::Event(response_event, message_data)
-      );
-      // clang-format on
+    case broker::sc::unspecified:
+    default:
+      break;
     }
   }
-}
 
-Status ZeekConnection::processTaskOutput(
-    const QueryScheduler::TaskOutput &task_output) {
-
-  if (task_output.update_type.has_value()) {
-    DifferentialOutput differential_output;
-    auto status = computeDifferentials(d->differential_context,
-                                       differential_output, task_output);
-    if (!status.succeeded()) {
-      return status;
-    }
+  if (peer.state == State::Connecting && !status_error_list.empty()) {
+    scheduleConnectionAttempt(peer, "The connection attempt has failed");
+  }
 
-    publishTaskOutput("ZeekAgent::ADD", task_output.response_topic,
-                      task_output.response_event, task_output.cookie,
-                      differential_output.added_row_list);
+  auto current_time = std::chrono::steady_clock::now();
 
-    publishTaskOutput("ZeekAgent::REMOVE", task_output.response_topic,
-                      task_output.response_event, task_output.cookie,
-                      differential_output.removed_row_list);
+  if (peer.state == State::Connecting &&
+      current_time >= peer.connection_attempt_deadline) {
 
-  } else {
-    publishTaskOutput("ZeekAgent::SNAPSHOT", task_output.response_topic,
-                      task_output.response_event, task_output.cookie,
-                      task_output.query_output);
+    peer.broker_endpoint->unpeer_nosync(peer.address, peer.port);
+    scheduleConnectionAttempt(peer, "The connection attempt has timed out");
   }
 
-  return Status::success();
-}
-
-Status ZeekConnection::processTaskOutputList(
-    QueryScheduler::TaskOutputList task_output_list) {
-
-  for (const auto &task_output : task_output_list) {
-    auto status = processTaskOutput(task_output);
-    if (!status.succeeded()) {
-      return status;
-    }
+  if (peer.state == State::Disconnected &&
+      current_time >= peer.next_connection_attempt) {
+    startConnectionAttempt(peer);
   }
+}
 
-  return Status::success();
+void ZeekConnection::startConnectionAttempt(Peer &peer) {
+  getLogger().logMessage(
+      IZeekLogger::Severity::Information,
+      "Connecting to " + peer.name + " (attempt " +
+          std::to_string(peer.reconnection_backoff.attemptCount() + 1U) +
+          ")");
+
+  // Retries are driven by the backoff policy, so broker must not retry on
+  // its own
+  peer.broker_endpoint->peer_nosync(peer.address, peer.port,
+                                    broker::timeout::seconds(0));
+
+  peer.state = State::Connecting;
+  peer.connection_attempt_deadline =
+      std::chrono::steady_clock::now() + kConnectionTimeout;
 }
 
-Status ZeekConnection::waitForActivity(bool &ready) {
-  ready = false;
+void ZeekConnection::scheduleConnectionAttempt(Peer &peer,
+                                               const std::string &reason) {
+  auto delay = peer.reconnection_backoff.nextDelay();
 
-  fd_set fd_list;
-  FD_ZERO(&fd_list);
+  peer.state = State::Disconnected;
+  peer.next_connection_attempt = std::chrono::steady_clock::now() + delay;
 
-  int highest_socket_fd = -1;
+  getLogger().logMessage(IZeekLogger::Severity::Error,
+                         reason + " (" + peer.name + "). Retrying in " +
+                             std::to_string(delay.count()) + " ms");
+}
 
-  for (const auto &subscriber_p : d->subscriber_map) {
-    const auto &subscriber = subscriber_p.second;
+void ZeekConnection::updateSessionState() {
+  auto new_state = State::Disconnected;
 
-    auto socket = subscriber.fd();
-    FD_SET(socket, &fd_list);
+  for (const auto &peer : d->peer_list) {
+    if (peer->state == State::Connected) {
+      new_state = State::Connected;
+      break;
 
-    highest_socket_fd = std::max(highest_socket_fd, socket);
+    } else if (peer->state == State::Connecting) {
+      new_state = State::Connecting;
+    }
   }
 
-  struct timeval timeout {};
-  timeout.tv_sec = 1;
-
-  auto select_err =
-      select(highest_socket_fd + 1, &fd_list, nullptr, nullptr, &timeout);
-  if (select_err == 0) {
-    return Status::success();
+  auto previous_state = d->state.exchange(new_state);
 
-  } else if (select_err == -1) {
-#ifdef WIN32
-    auto error_code = WSAGetLastError();
-    auto eintr_value = WSAEINTR;
-#else
-    auto error_code = errno;
-    auto eintr_value = EINTR;
-#endif
+  if (previous_state == State::Connected && new_state != State::Connected) {
+    suspendSession();
 
-    if (error_code == eintr_value) {
-      return Status::success();
-    }
+  } else if (previous_state != State::Connected &&
+             new_state == State::Connected) {
 
-    return Status::failure("poll() has failed with error " +
-                           std::to_string(error_code));
+    d->resumption_deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::seconds(getConfig().sessionResumptionTimeout());
   }
 
-  ready = true;
-  return Status::success();
+  if (new_state == State::Connected &&
+      std::chrono::steady_clock::now() >= d->resumption_deadline) {
+    expireSuspendedSession();
+  }
 }
 
-ZeekConnection::ZeekConnection(const std::string &host_identifier)
-    : d(new PrivateData(getBrokerConfiguration())) {
+ZeekConnection::Peer *
+ZeekConnection::selectPeer(const std::string &shard_key,
+                           const Peer *candidate) const {
 
-  d->peer_name = getSystemHostname();
-  d->host_identifier = host_identifier;
+  Peer *selected_peer{nullptr};
+  std::uint64_t highest_score{0U};
 
-  const auto &server_address = getConfig().serverAddress();
-  auto server_port = getConfig().serverPort();
+  for (const auto &peer : d->peer_list) {
+    if (peer.get() != candidate && peer->state != State::Connected) {
+      continue;
+    }
 
-  d->broker_endpoint->peer_nosync(server_address, server_port,
-                                  broker::timeout::seconds(3));
+    auto score = computeShardScore(shard_key, peer->name);
+    if (selected_peer == nullptr || score > highest_score) {
+      selected_peer = peer.get();
+      highest_score = score;
+    }
+  }
 
-  bool connected{false};
+  return selected_peer;
+}
 
-  for (std::size_t retry = 0U; retry < 5U; ++retry) {
-    std::this_thread::sleep_for(std::chrono::seconds(1U));
+void ZeekConnection::resetPeerShards(const Peer &peer) {
+  std::lock_guard<std::mutex> lock(d->session_mutex);
 
-    StatusEventList status_event_list;
-    auto status = getStatusEvents(status_event_list);
-    if (!status.succeeded()) {
-      throw status;
-    }
+  std::size_t reset_count{0U};
 
-    for (const auto &status_code : status_event_list) {
-      switch (status_code) {
-      case broker::sc::peer_added:
-        connected = true;
-        break;
+  auto &session_context = d->session_context;
 
-      case broker::sc::peer_lost:
-      case broker::sc::peer_removed:
-        connected = false;
-        break;
+  for (const auto *subscription_map :
+       {&session_context.active_subscription_map,
+        &session_context.resuming_subscription_map}) {
 
-      case broker::sc::unspecified:
-      default:
-        break;
+    for (const auto &subscription_p : *subscription_map) {
+      const auto &query_id = subscription_p.first;
+      if (selectPeer(query_id, &peer) != &peer) {
+        continue;
       }
-    }
 
-    if (connected) {
-      break;
+      if (session_context.differential_context.erase(query_id) != 0U) {
+        ++reset_count;
+      }
     }
   }
 
-  if (!connected) {
-    throw Status::failure("The connection to the Zeek server timed out");
+  if (reset_count != 0U) {
+    getLogger().logMessage(IZeekLogger::Severity::Information,
+                           std::to_string(reset_count) +
+                               " scheduled queries have moved to a different "
+                               "server and will send their full results");
   }
+}
 
-  getLogger().logMessage(IZeekLogger::Severity::Information,
-                         "Successfully connected to " + server_address + ":" +
-                             std::to_string(server_port));
-
-  auto status = createSubscription(kBrokerTopic_ALL);
-  if (!status.succeeded()) {
-    throw status;
-  }
+void ZeekConnection::suspendSession() {
+  // Keep the scheduled tasks and their differential state around; they are
+  // resumed when the Zeek server renews the same subscriptions
+  std::lock_guard<std::mutex> lock(d->session_mutex);
+  suspendSubscriptions(d->session_context);
+}
 
-  status =
-      createSubscription(kBrokerTopic_PRE_INDIVIDUALS + d->host_identifier);
+void ZeekConnection::expireSuspendedSession() {
+  std::lock_guard<std::mutex> lock(d->session_mutex);
 
-  if (!status.succeeded()) {
-    throw status;
-  }
+  auto expired_count =
+      expireSuspendedSubscriptions(d->session_context, d->task_queue);
 
-  for (const auto &group_name : getConfig().groupList()) {
-    status = joinGroup(group_name);
-    if (!status.succeeded()) {
-      throw status;
-    }
+  if (expired_count != 0U) {
+    getLogger().logMessage(
+        IZeekLogger::Severity::Information,
+        std::to_string(expired_count) +
+            " scheduled queries have not been renewed and will be removed");
   }
+}
 
+void ZeekConnection::announceHost(Peer &peer) {
   broker::vector joined_group_list;
 
   for (const auto &group : d->joined_group_list) {
@@ -471,7 +1444,7 @@ ZeekConnection::ZeekConnection(const std::string &host_identifier)
     kBrokerEvent_HOST_NEW,
 
     {
-      broker::data(caf::to_string(d->broker_endpoint->node_id())),
+      broker::data(caf::to_string(peer.broker_endpoint->node_id())),
       broker::data(d->peer_name),
       broker::data(d->host_identifier),
       joined_group_list,
@@ -482,75 +1455,71 @@ ZeekConnection::ZeekConnection(const std::string &host_identifier)
   );
   // clang-format on
 
-  d->broker_endpoint->publish(kBrokerTopic_ANNOUNCE, message);
+  peer.broker_endpoint->publish(kBrokerTopic_ANNOUNCE, message);
 }
 
-broker::configuration ZeekConnection::getBrokerConfiguration() {
-  auto ca_file_path = getConfig().certificateAuthority();
-  auto cert_file_path = getConfig().clientCertificate();
-  auto key_file_path = getConfig().clientKey();
-
-  broker::configuration config;
-
-  if (!ca_file_path.empty() && !cert_file_path.empty() &&
-      !key_file_path.empty()) {
-    config.set("openssl.cafile", ca_file_path);
-    config.set("openssl.certificate", cert_file_path);
-    config.set("openssl.key", key_file_path);
+void ZeekConnection::reportDroppedOutput() {
+  // The counters keep accumulating while disconnected
+  if (d->state != State::Connected) {
+    return;
   }
 
-  return config;
-}
-
-Status ZeekConnection::createSubscription(const std::string &topic) {
-  if (d->subscriber_map.count(topic) != 0U) {
-    return Status::failure(
-        "A subscription already exists for the following topic: " + topic);
+  auto current_time = std::chrono::steady_clock::now();
+  if (current_time < d->next_drop_report) {
+    return;
   }
 
-  auto subscriber = d->broker_endpoint->make_subscriber({topic});
-  d->subscriber_map.insert({topic, std::move(subscriber)});
-
-  getLogger().logMessage(IZeekLogger::Severity::Information,
-                         "Subscribed to: " + topic);
-
-  return Status::success();
-}
+  d->next_drop_report = current_time + kDropReportInterval;
 
-Status ZeekConnection::destroySubscription(const std::string &topic) {
-  auto subscriber_it = d->subscriber_map.find(topic);
-  if (subscriber_it == d->subscriber_map.end()) {
-    return Status::failure("The following topic has not been subscribed to: " +
-                           topic);
-  }
+  // The counters are tracked per query, and each query is reported to the
+  // server that owns it; queries sharing a topic and a server are merged
+  // into a single report. Reports with no server connected are dropped
+  using ReportKey = std::pair<Peer *, std::string>;
+  std::map<ReportKey, RateLimiter::DropCounters> report_map;
 
-  auto &subscriber = subscriber_it->second;
-  subscriber.remove_topic(topic);
+  for (auto &drop_counters_p : d->rate_limiter.takeDropCounters()) {
+    const auto &query_id = drop_counters_p.first;
+    auto &drop_counters = drop_counters_p.second;
 
-  d->subscriber_map.erase(subscriber_it);
-  return Status::success();
-}
+    auto peer = selectPeer(query_id);
+    if (peer == nullptr) {
+      continue;
+    }
 
-Status ZeekConnection::getStatusEvents(StatusEventList &status_event_list) {
-  status_event_list = {};
+    auto &report =
+        report_map[ReportKey{peer, std::move(drop_counters.response_topic)}];
 
-  auto status_message_list = d->status_subscriber.poll();
-  if (status_message_list.empty()) {
-    return Status::success();
+    report.row_count += drop_counters.row_count;
+    report.byte_count += drop_counters.byte_count;
   }
 
-  for (const auto &status_message : status_message_list) {
-    if (const auto &status = caf::get_if<broker::status>(&status_message)) {
-      status_event_list.push_back(status->code());
-    }
+  for (const auto &report_p : report_map) {
+    auto peer = report_p.first.first;
+    const auto &response_topic = report_p.first.second;
+    const auto &drop_counters = report_p.second;
+
+    getLogger().logMessage(IZeekLogger::Severity::Warning,
+                           "The rate limits have dropped " +
+                               std::to_string(drop_counters.row_count) +
+                               " rows (" +
+                               std::to_string(drop_counters.byte_count) +
+                               " bytes) on the following topic: " +
+                               response_topic);
+
+    // clang-format off
+    broker::zeek::Event message(
+      kBrokerEvent_OUTPUT_DROPPED,
+
+      {
+        broker::data(d->host_identifier),
+        broker::data(static_cast<broker::count>(drop_counters.row_count)),
+        broker::data(static_cast<broker::count>(drop_counters.byte_count))
+      }
+    );
+    // clang-format on
 
-    if (const auto &error = caf::get_if<broker::error>(&status_message)) {
-      std::string message = caf::to_string(error->context()).c_str();
-      return Status::failure(message);
-    }
+    peer->broker_endpoint->publish(response_topic, message);
   }
-
-  return Status::success();
 }
 
 Status
@@ -575,8 +1544,8 @@ ZeekConnection::computeQueryOutputHash(std::uint64_t &hash,
     if (!column_value.data.has_value()) {
       static const std::string kNullColumnValue{"<NULL>"};
 
-      error = XXH64_update(xxh64_state.get(), column_value.name.c_str(),
-                           column_value.name.size());
+      error = XXH64_update(xxh64_state.get(), kNullColumnValue.c_str(),
+                           kNullColumnValue.size());
 
     } else {
       const auto &var = column_value.data.value();
@@ -593,6 +1562,12 @@ ZeekConnection::computeQueryOutputHash(std::uint64_t &hash,
         error = XXH64_update(xxh64_state.get(), &integer_value,
                              sizeof(integer_value));
 
+      } else if (std::holds_alternative<double>(var)) {
+        auto double_value = std::get<double>(var);
+
+        error = XXH64_update(xxh64_state.get(), &double_value,
+                             sizeof(double_value));
+
       } else {
         return Status::failure("Invalid column type");
       }
@@ -607,6 +1582,35 @@ ZeekConnection::computeQueryOutputHash(std::uint64_t &hash,
   return Status::success();
 }
 
+Status ZeekConnection::computeRowKeyHash(
+    std::uint64_t &hash, const IVirtualDatabase::OutputRow &row,
+    const std::vector<std::string> &key_column_list) {
+
+  hash = 0U;
+
+  IVirtualDatabase::OutputRow key_row;
+  key_row.reserve(key_column_list.size());
+
+  for (const auto &key_column_name : key_column_list) {
+    auto column_it =
+        std::find_if(row.begin(), row.end(),
+                     [&key_column_name](
+                         const IVirtualDatabase::ColumnValue &column) -> bool {
+                       return column.name == key_column_name;
+                     });
+
+    if (column_it == row.end()) {
+      return Status::failure("The following key column was not found in "
+                             "the query output: " +
+                             key_column_name);
+    }
+
+    key_row.push_back(*column_it);
+  }
+
+  return computeQueryOutputHash(hash, key_row);
+}
+
 std::string ZeekConnection::computeQueryID(const std::string &response_topic,
                                            const std::string &response_event,
                                            const std::string &cookie) {
@@ -615,20 +1619,40 @@ std::string ZeekConnection::computeQueryID(const std::string &response_topic,
 
 Status ZeekConnection::computeDifferentials(
     DifferentialContext &context, DifferentialOutput &output,
-    const QueryScheduler::TaskOutput &task_output) {
+    const QueryScheduler::TaskOutput &task_output,
+    const RowFilter &row_filter) {
 
   output = {};
 
-  // Generate new differential data for this query output
+  auto acceptRow = [&row_filter](const IVirtualDatabase::OutputRow &row) {
+    return !row_filter || row_filter(row);
+  };
+
+  // Generate new differential data for this query output. Keyed rows are
+  // indexed by their key columns only, so that changes can be detected
+  const auto &key_column_list = task_output.key_column_list;
+
   DifferentialData differential_data;
+  std::vector<std::uint64_t> row_hash_list;
+  row_hash_list.reserve(task_output.query_output.size());
+
   for (const auto &row : task_output.query_output) {
     std::uint64_t row_hash = 0U;
-    auto status = computeQueryOutputHash(row_hash, row);
+
+    auto status = key_column_list.empty()
+                      ? computeQueryOutputHash(row_hash, row)
+                      : computeRowKeyHash(row_hash, row, key_column_list);
+
     if (!status.succeeded()) {
       return status;
     }
 
-    differential_data.insert({row_hash, row});
+    auto inserted = differential_data.insert({row_hash, row}).second;
+    if (!inserted && !key_column_list.empty()) {
+      return Status::failure("Multiple rows share the same key columns");
+    }
+
+    row_hash_list.push_back(row_hash);
   }
 
   // Look for the old differential data
@@ -638,13 +1662,34 @@ Status ZeekConnection::computeDifferentials(
 
   auto old_differential_data_it = context.find(query_id);
   if (old_differential_data_it == context.end()) {
-    context.insert({query_id, std::move(differential_data)});
-    output.added_row_list = task_output.query_output;
+    // Rows that are not accepted are left out of the differential data,
+    // so that the next run reports them as added
+    std::unordered_set<std::uint64_t> accepted_row_hash_set;
+
+    for (std::size_t i = 0U; i < task_output.query_output.size(); ++i) {
+      const auto &row = task_output.query_output.at(i);
+
+      if (acceptRow(row)) {
+        output.added_row_list.push_back(row);
+        accepted_row_hash_set.insert(row_hash_list.at(i));
+      }
+    }
+
+    for (auto it = differential_data.begin(); it != differential_data.end();) {
+      if (accepted_row_hash_set.count(it->first) == 0U) {
+        it = differential_data.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    context.insert({query_id, std::make_shared<const DifferentialData>(
+                                  std::move(differential_data))});
 
     return Status::success();
   }
 
-  auto &old_differential_data = old_differential_data_it->second;
+  const auto &old_differential_data = *old_differential_data_it->second;
 
   // Determine what kind of updates we are required to process
   bool process_rows_added{false};
@@ -668,15 +1713,64 @@ Status ZeekConnection::computeDifferentials(
     }
   }
 
-  // Put new rows in the added row list
+  // The changes that are not accepted are reverted in the new differential
+  // data once the output has been computed: new rows are left out, and old
+  // rows are put back
+  std::vector<std::uint64_t> rejected_row_hash_list;
+  DifferentialData restored_differential_data;
+
+  // Put new rows in the added row list, and keyed rows whose values have
+  // changed in the updated row list
   if (process_rows_added) {
     for (const auto &new_diff_p : differential_data) {
       const auto &new_row_hash = new_diff_p.first;
       const auto &new_row_output = new_diff_p.second;
 
-      if (old_differential_data.find(new_row_hash) ==
-          old_differential_data.end()) {
-        output.added_row_list.push_back(new_row_output);
+      auto old_row_it = old_differential_data.find(new_row_hash);
+      if (old_row_it == old_differential_data.end()) {
+        if (acceptRow(new_row_output)) {
+          output.added_row_list.push_back(new_row_output);
+        } else {
+          rejected_row_hash_list.push_back(new_row_hash);
+        }
+
+        continue;
+      }
+
+      if (key_column_list.empty()) {
+        continue;
+      }
+
+      const auto &old_row_output = old_row_it->second;
+
+      IVirtualDatabase::OutputRow updated_row;
+      auto row_change = createUpdatedRow(updated_row, old_row_output,
+                                         new_row_output, key_column_list);
+
+      if (row_change == RowChange::Updated) {
+        if (acceptRow(updated_row)) {
+          output.updated_row_list.push_back(std::move(updated_row));
+        } else {
+          restored_differential_data.insert({new_row_hash, old_row_output});
+        }
+
+      } else if (row_change == RowChange::Replaced) {
+        if (process_rows_removed) {
+          if (!acceptRow(old_row_output)) {
+            restored_differential_data.insert({new_row_hash, old_row_output});
+            continue;
+          }
+
+          output.removed_row_list.push_back(old_row_output);
+        }
+
+        // Once the old row has been removed, the new one is just a row
+        // that has not been added yet
+        if (acceptRow(new_row_output)) {
+          output.added_row_list.push_back(new_row_output);
+        } else {
+          rejected_row_hash_list.push_back(new_row_hash);
+        }
       }
     }
   }
@@ -687,18 +1781,160 @@ Status ZeekConnection::computeDifferentials(
       const auto &old_row_hash = old_diff_p.first;
       const auto &old_row_output = old_diff_p.second;
 
-      if (differential_data.find(old_row_hash) == differential_data.end()) {
+      if (differential_data.find(old_row_hash) != differential_data.end()) {
+        continue;
+      }
+
+      if (acceptRow(old_row_output)) {
         output.removed_row_list.push_back(old_row_output);
+      } else {
+        restored_differential_data.insert({old_row_hash, old_row_output});
       }
     }
   }
 
-  // Update the differential data inside the context structure
-  std::swap(old_differential_data, differential_data);
+  for (const auto &rejected_row_hash : rejected_row_hash_list) {
+    differential_data.erase(rejected_row_hash);
+  }
+
+  for (auto &restored_diff_p : restored_differential_data) {
+    differential_data[restored_diff_p.first] =
+        std::move(restored_diff_p.second);
+  }
+
+  // Replace the differential data inside the context structure. The old
+  // data may still be referenced by a state snapshot that is being saved
+  old_differential_data_it->second =
+      std::make_shared<const DifferentialData>(std::move(differential_data));
 
   return Status::success();
 }
 
+bool ZeekConnection::reconcileScheduledTask(
+    SessionContext &context, QueryScheduler::TaskQueue &task_queue,
+    QueryScheduler::Task task) {
+
+  auto query_id =
+      computeQueryID(task.response_topic, task.response_event, task.cookie);
+
+  if (task.type == QueryScheduler::Task::Type::RemoveScheduledQuery) {
+    context.active_subscription_map.erase(query_id);
+    context.resuming_subscription_map.erase(query_id);
+    context.differential_context.erase(query_id);
+
+    task_queue.push_back(std::move(task));
+    return false;
+  }
+
+  // Every server may send the same subscription; only the first one is
+  // scheduled, and a changed one replaces the active task
+  auto active_subscription_it = context.active_subscription_map.find(query_id);
+  if (active_subscription_it != context.active_subscription_map.end()) {
+    if (isSameSubscription(active_subscription_it->second, task)) {
+      return false;
+    }
+
+    context.differential_context.erase(query_id);
+    task_queue.push_back(createRemovalTask(active_subscription_it->second));
+  }
+
+  auto resuming_subscription_it =
+      context.resuming_subscription_map.find(query_id);
+
+  if (resuming_subscription_it != context.resuming_subscription_map.end()) {
+    auto previous_task = std::move(resuming_subscription_it->second);
+    context.resuming_subscription_map.erase(resuming_subscription_it);
+
+    if (isSameSubscription(previous_task, task)) {
+      // The query is still scheduled and its differential state still
+      // matches what the Zeek server has received
+      context.active_subscription_map.insert(
+          {query_id, std::move(previous_task)});
+
+      return true;
+    }
+
+    // The subscription has changed, start again from a clean state
+    context.differential_context.erase(query_id);
+    task_queue.push_back(createRemovalTask(previous_task));
+  }
+
+  context.active_subscription_map[query_id] = task;
+  task_queue.push_back(std::move(task));
+
+  return false;
+}
+
+bool ZeekConnection::acceptOneShotTask(
+    SessionContext &context, const QueryScheduler::Task &task,
+    const std::chrono::steady_clock::time_point &now) {
+
+  auto &recent_one_shot_query_map = context.recent_one_shot_query_map;
+
+  for (auto it = recent_one_shot_query_map.begin();
+       it != recent_one_shot_query_map.end();) {
+
+    if (now >= it->second) {
+      it = recent_one_shot_query_map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  auto query_id =
+      computeQueryID(task.response_topic, task.response_event, task.cookie);
+
+  return recent_one_shot_query_map
+      .insert({std::move(query_id), now + kOneShotQueryDeduplicationWindow})
+      .second;
+}
+
+void ZeekConnection::suspendSubscriptions(SessionContext &context) {
+  for (auto &subscription_p : context.active_subscription_map) {
+    context.resuming_subscription_map.insert(std::move(subscription_p));
+  }
+
+  context.active_subscription_map.clear();
+}
+
+std::size_t ZeekConnection::expireSuspendedSubscriptions(
+    SessionContext &context, QueryScheduler::TaskQueue &task_queue) {
+
+  auto expired_count = context.resuming_subscription_map.size();
+
+  for (const auto &subscription_p : context.resuming_subscription_map) {
+    const auto &query_id = subscription_p.first;
+    const auto &task = subscription_p.second;
+
+    context.differential_context.erase(query_id);
+    task_queue.push_back(createRemovalTask(task));
+  }
+
+  context.resuming_subscription_map.clear();
+  return expired_count;
+}
+
+Status ZeekConnection::computeSubscriptionDifferentials(
+    SessionContext &context, DifferentialOutput &output,
+    const QueryScheduler::TaskOutput &task_output,
+    const RowFilter &row_filter) {
+
+  output = {};
+
+  // Skip subscriptions that have been removed, or that have not been
+  // renewed yet
+  auto query_id =
+      computeQueryID(task_output.response_topic, task_output.response_event,
+                     task_output.cookie);
+
+  if (context.active_subscription_map.count(query_id) == 0U) {
+    return Status::success();
+  }
+
+  return computeDifferentials(context.differential_context, output,
+                              task_output, row_filter);
+}
+
 Status
 ZeekConnection::scheduledTaskFromZeekEvent(QueryScheduler::Task &task,
                                            const broker::zeek::Event &event) {
@@ -722,6 +1958,7 @@ ZeekConnection::scheduledTaskFromZeekEvent(QueryScheduler::Task &task,
     task.cookie = getZeekEventCookie(event);
     task.response_topic = getZeekEventResponseTopic(event);
     task.interval = getZeekEventInterval(event);
+    task.key_column_list = getZeekEventKeyColumnList(event);
 
     auto update_type = getZeekEventUpdateType(event);
     if (update_type == "ADDED") {
@@ -781,10 +2018,13 @@ Status ZeekConnection::taskFromZeekEvent(QueryScheduler::Task &task,
   const auto &event_name = event.name();
 
   if (event_name == kHostSubscribeEvent ||
-      event_name == kHostUnsubscribeEvent || event_name == kHostExecuteEvent) {
+      event_name == kHostUnsubscribeEvent) {
 
     return scheduledTaskFromZeekEvent(task, event);
 
+  } else if (event_name == kHostExecuteEvent) {
+    return oneShotTaskFromZeekEvent(task, event);
+
   } else {
     task = {};
     return Status::failure("Invalid event name: " + event_name);
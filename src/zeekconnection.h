@@ -2,6 +2,8 @@
 
 #include "queryscheduler.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <optional>
 
@@ -39,6 +41,13 @@ public:
   /// \brief Destructor
   ~ZeekConnection();
 
+  /// \brief Connection states
+  enum class State { Disconnected, Connecting, Connected };
+
+  /// \return The current connection state; the agent is connected as long
+  ///         as at least one of the configured Zeek servers is reachable
+  State state() const;
+
   /// \brief Joins a new Zeek group
   /// \param name The group name
   /// \return A Status object
@@ -49,7 +58,9 @@ public:
   /// \return A Status object
   Status leaveGroup(const std::string &name);
 
-  /// \brief Updates the connection state
+  /// \brief Updates the connection state, starting a new connection
+  ///        attempt when needed, and processes the incoming Zeek events.
+  ///        This method never blocks for more than one second
   /// \return A Status object
   Status processEvents();
 
@@ -57,15 +68,35 @@ public:
   QueryScheduler::TaskQueue getTaskQueue();
 
   /// \brief Processes the given list of task outputs, dispatching the
-  ///        results to the Zeek instance
+  ///        results to the Zeek instance. This method can be called from
+  ///        a different thread than the one running processEvents()
   /// \param task_output_list A list of task outputs
   /// \return A Status object
   Status processTaskOutputList(QueryScheduler::TaskOutputList task_output_list);
 
+  /// \brief Creates a sink that publishes the rows of a snapshot task as
+  ///        soon as they are produced. This method can be called from a
+  ///        different thread than the one running processEvents()
+  /// \param sink Where the sink is stored; left empty if the output would
+  ///             be discarded because the connection is down
+  /// \param task The snapshot task
+  /// \return A Status object
+  Status createSnapshotSink(IVirtualDatabase::IQueryOutputSink::Ref &sink,
+                            const QueryScheduler::Task &task);
+
+  /// \brief Saves the scheduled queries and their differential state to
+  ///        the configured state folder. Does nothing if persistence has
+  ///        not been enabled
+  /// \return A Status object
+  Status saveDifferentialState();
+
   ZeekConnection(const ZeekConnection &) = delete;
   ZeekConnection &operator=(const ZeekConnection &) = delete;
 
 private:
+  /// \brief The connection to a single Zeek server
+  struct Peer;
+
   /// \brief Constructor
   /// \param host_identifier The UUID of the system, or the hostname
   ///                        if it was not possible to acquire it
@@ -74,12 +105,12 @@ private:
   /// \return The broker configuration
   broker::configuration getBrokerConfiguration();
 
-  /// \brief Subscribes to a new broker topic
+  /// \brief Subscribes to a new broker topic on all the Zeek servers
   /// \param topic The topic name
   /// \return A Status object
   Status createSubscription(const std::string &topic);
 
-  /// \brief Unsubscribes from a broker topic
+  /// \brief Unsubscribes from a broker topic on all the Zeek servers
   /// \param topic The topic name
   /// \return A Status object
   Status destroySubscription(const std::string &topic);
@@ -87,10 +118,83 @@ private:
   /// \brief A list of broker status events
   using StatusEventList = std::vector<broker::sc>;
 
-  /// \brief Updates the connection status
+  /// \brief A list of broker error messages
+  using StatusErrorList = std::vector<std::string>;
+
+  /// \brief Updates the connection status of the given peer
+  /// \param peer The Zeek server
   /// \param status_event_list Where the new status list is stored
+  /// \param status_error_list Where the received errors are stored
   /// \return A Status object
-  Status getStatusEvents(StatusEventList &status_event_list);
+  Status getStatusEvents(Peer &peer, StatusEventList &status_event_list,
+                         StatusErrorList &status_error_list);
+
+  /// \brief Advances the connection state machine of the given peer
+  /// \param peer The Zeek server
+  /// \param status_event_list The status events received from broker
+  /// \param status_error_list The errors received from broker
+  void updateConnectionState(Peer &peer,
+                             const StatusEventList &status_event_list,
+                             const StatusErrorList &status_error_list);
+
+  /// \brief Starts a new, non-blocking, connection attempt
+  /// \param peer The Zeek server
+  void startConnectionAttempt(Peer &peer);
+
+  /// \brief Schedules the next connection attempt according to the backoff
+  ///        policy
+  /// \param peer The Zeek server
+  /// \param reason Why the connection has been lost or could not be
+  ///               established
+  void scheduleConnectionAttempt(Peer &peer, const std::string &reason);
+
+  /// \brief Updates the overall connection state from the state of the
+  ///        peers, suspending and expiring the session as needed
+  void updateSessionState();
+
+  /// \brief Selects the connected peer that owns the given shard
+  /// \param shard_key The query ID or topic used to shard the output
+  /// \param candidate A peer that is considered connected even if it is
+  ///                  not; used to find the shards owned by a lost peer
+  /// \return The selected peer, or nullptr if no peer is connected
+  Peer *selectPeer(const std::string &shard_key,
+                   const Peer *candidate = nullptr) const;
+
+  /// \brief Resets the differential state of the queries owned by the
+  ///        given peer, so that their new owner receives the full results
+  /// \param peer The peer that has just connected or has been lost
+  void resetPeerShards(const Peer &peer);
+
+  /// \brief Suspends the scheduled tasks of the current Zeek session, so
+  ///        that they can be resumed after reconnecting
+  void suspendSession();
+
+  /// \brief Removes the suspended tasks that have not been renewed by the
+  ///        Zeek server in time
+  void expireSuspendedSession();
+
+  /// \brief Loads the state saved by saveDifferentialState(). The loaded
+  ///        queries are scheduled again and handled like a suspended
+  ///        session until the Zeek server renews them
+  /// \return A Status object
+  Status loadDifferentialState();
+
+  /// \brief Handles a single event received from a Zeek server
+  /// \param event The Zeek request
+  void processZeekEvent(const broker::zeek::Event &event);
+
+  /// \brief Queues the given task, reconciling subscriptions with the
+  ///        ones of a suspended session
+  /// \param task The task received from the Zeek server
+  void processTask(QueryScheduler::Task task);
+
+  /// \brief Announces this host to the given Zeek server
+  /// \param peer The Zeek server
+  void announceHost(Peer &peer);
+
+  /// \brief Periodically reports the output that has been dropped by the
+  ///        rate limits to the affected response topics
+  void reportDroppedOutput();
 
   /// \brief Waits for new events, timing out after 1 second
   /// \param ready This boolean is set to true if there is incoming data
@@ -102,20 +206,25 @@ private:
   ///        the Zeek instance
   /// \param task_output The task output that needs to be processed
   /// \return A Status object
-  Status processTaskOutput(const QueryScheduler::TaskOutput &task_output);
+  Status processTaskOutput(QueryScheduler::TaskOutput task_output);
 
-  /// \brief Publishes the given task output message to Zeek
+  /// \brief Publishes the given task output message to Zeek. The rate
+  ///        limits must have already been applied to the rows
+  /// \param peer The Zeek server that owns this task
   /// \param trigger The reason this task was run (differential change or
   ///                snapshot)
   /// \param response_topic The output topic
   /// \param response_event The event name
   /// \param cookie The id that identifies this task
-  /// \param query_output The query results associated with this task
-  void publishTaskOutput(const std::string &trigger,
-                         const std::string &response_topic,
-                         const std::string &response_event,
-                         const std::string &cookie,
-                         const IVirtualDatabase::QueryOutput &query_output);
+  /// \param query_output The query results associated with this task; the
+  ///                     column values are moved into the published events
+  /// \param bulk_output_deadline Until when the output can be held back
+  ///                             while interactive output is published
+  void publishTaskOutput(
+      Peer &peer, const std::string &trigger,
+      const std::string &response_topic, const std::string &response_event,
+      const std::string &cookie, IVirtualDatabase::QueryOutput query_output,
+      const std::chrono::steady_clock::time_point &bulk_output_deadline);
 
 public:
   /// \brief The differential context for a single table, used to calculate
@@ -123,9 +232,40 @@ public:
   using DifferentialData =
       std::unordered_map<std::uint64_t, IVirtualDatabase::OutputRow>;
 
+  /// \brief Shared, immutable differential data. Each run replaces it
+  ///        instead of modifying it, so that a snapshot of the whole context
+  ///        only needs to copy the pointers
+  using DifferentialDataRef = std::shared_ptr<const DifferentialData>;
+
   /// \brief The global differentinal context for all tables, used to calculate
   ///        differential output
-  using DifferentialContext = std::unordered_map<std::string, DifferentialData>;
+  using DifferentialContext =
+      std::unordered_map<std::string, DifferentialDataRef>;
+
+  /// \brief Scheduled tasks, indexed by query ID
+  using SubscriptionMap = std::unordered_map<std::string, QueryScheduler::Task>;
+
+  /// \brief When each recent one-shot query stops being deduplicated,
+  ///        indexed by query ID
+  using OneShotQueryMap =
+      std::unordered_map<std::string, std::chrono::steady_clock::time_point>;
+
+  /// \brief The scheduled queries of the Zeek session, and the differential
+  ///        state of the results that have been sent for them
+  struct SessionContext final {
+    /// \brief The differential state, indexed by query ID
+    DifferentialContext differential_context;
+
+    /// \brief The subscriptions that are producing output
+    SubscriptionMap active_subscription_map;
+
+    /// \brief The subscriptions of a suspended session, waiting to be
+    ///        renewed by a Zeek server
+    SubscriptionMap resuming_subscription_map;
+
+    /// \brief The one-shot queries that have been accepted recently
+    OneShotQueryMap recent_one_shot_query_map;
+  };
 
   /// \brief Differential output
   struct DifferentialOutput final {
@@ -134,8 +274,17 @@ public:
 
     /// \brief List of removed rows
     IVirtualDatabase::QueryOutput removed_row_list;
+
+    /// \brief List of keyed rows whose values have changed. Only the key
+    ///        columns and the changed columns are set. Rows where a column
+    ///        has become NULL are reported as removed and added instead
+    IVirtualDatabase::QueryOutput updated_row_list;
   };
 
+  /// \brief Decides whether a differential row can be published; used to
+  ///        apply the rate limits before the differential state is updated
+  using RowFilter = std::function<bool(const IVirtualDatabase::OutputRow &)>;
+
   /// \brief Computes a hash that represents the given query output row. Used
   ///        for differentials
   /// \param hash The calculated hash
@@ -144,6 +293,16 @@ public:
   static Status computeQueryOutputHash(std::uint64_t &hash,
                                        const IVirtualDatabase::OutputRow &row);
 
+  /// \brief Computes a hash of the key columns of the given row. Used for
+  ///        keyed differentials
+  /// \param hash The calculated hash
+  /// \param row The row to hash
+  /// \param key_column_list The names of the key columns
+  /// \return A Status object
+  static Status
+  computeRowKeyHash(std::uint64_t &hash, const IVirtualDatabase::OutputRow &row,
+                    const std::vector<std::string> &key_column_list);
+
   /// \brief Computes a unique query ID for the specified task attributes
   /// \param response_topic The response topic of the task
   /// \param response_event The event name of the task
@@ -158,10 +317,67 @@ public:
   /// \param context The differential context, updated on return
   /// \param output The differential output
   /// \param task_output The full task output
+  /// \param row_filter Optional; the rows it rejects are left out of the
+  ///                   output, and the differential context is updated as
+  ///                   if they had not changed, so that the next run
+  ///                   reports them again
   /// \return A Status object
   static Status
   computeDifferentials(DifferentialContext &context, DifferentialOutput &output,
-                       const QueryScheduler::TaskOutput &task_output);
+                       const QueryScheduler::TaskOutput &task_output,
+                       const RowFilter &row_filter = {});
+
+  /// \brief Reconciles a scheduled task received from a Zeek server with
+  ///        the active subscriptions and with the ones of a suspended
+  ///        session. Repeated subscriptions are ignored, renewed ones are
+  ///        resumed with their differential state, and changed ones start
+  ///        again from a clean state
+  /// \param context The session context, updated on return
+  /// \param task_queue Where the tasks for the query scheduler are appended
+  /// \param task An AddScheduledQuery or RemoveScheduledQuery task
+  /// \return True if a suspended subscription has been resumed
+  static bool reconcileScheduledTask(SessionContext &context,
+                                     QueryScheduler::TaskQueue &task_queue,
+                                     QueryScheduler::Task task);
+
+  /// \brief Deduplicates the one-shot queries sent by more than one Zeek
+  ///        server: a query with the same ID is only accepted once within
+  ///        the deduplication window
+  /// \param context The session context, updated on return
+  /// \param task An ExecuteQuery task
+  /// \param now The current time
+  /// \return True if the query should be executed
+  static bool acceptOneShotTask(SessionContext &context,
+                                const QueryScheduler::Task &task,
+                                const std::chrono::steady_clock::time_point
+                                    &now = std::chrono::steady_clock::now());
+
+  /// \brief Suspends the active subscriptions, keeping their differential
+  ///        state so that they can be resumed after reconnecting
+  /// \param context The session context, updated on return
+  static void suspendSubscriptions(SessionContext &context);
+
+  /// \brief Removes the suspended subscriptions that have not been renewed
+  /// \param context The session context, updated on return
+  /// \param task_queue Where the removal tasks are appended
+  /// \return How many subscriptions have been removed
+  static std::size_t
+  expireSuspendedSubscriptions(SessionContext &context,
+                               QueryScheduler::TaskQueue &task_queue);
+
+  /// \brief Computes the differentials for the output of a subscription.
+  ///        The output of subscriptions that are not active, because they
+  ///        have been removed or have not been renewed yet, is discarded
+  ///        without touching the differential state
+  /// \param context The session context, updated on return
+  /// \param output The differential output; empty if discarded
+  /// \param task_output The full task output
+  /// \param row_filter Optional; see computeDifferentials()
+  /// \return A Status object
+  static Status computeSubscriptionDifferentials(
+      SessionContext &context, DifferentialOutput &output,
+      const QueryScheduler::TaskOutput &task_output,
+      const RowFilter &row_filter = {});
 
   /// \brief Creates a new scheduled task from the given broker event
   /// \param task Where the new task is stored
@@ -0,0 +1,118 @@
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace zeek {
+namespace {
+std::atomic<std::uint64_t> allocation_count{0U};
+std::atomic<std::uint64_t> allocated_byte_count{0U};
+
+thread_local bool tracking_paused{false};
+
+void trackAllocation(std::size_t size) {
+  if (tracking_paused) {
+    return;
+  }
+
+  allocation_count.fetch_add(1U, std::memory_order_relaxed);
+  allocated_byte_count.fetch_add(size, std::memory_order_relaxed);
+}
+
+void *allocate(std::size_t size) {
+  trackAllocation(size);
+
+  auto ptr = std::malloc(size != 0U ? size : 1U);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment) {
+  trackAllocation(size);
+
+  // aligned_alloc() requires the size to be a multiple of the alignment
+  auto alignment_value = static_cast<std::size_t>(alignment);
+  auto aligned_size =
+      ((size + alignment_value - 1U) / alignment_value) * alignment_value;
+
+  auto ptr = std::aligned_alloc(alignment_value,
+                                aligned_size != 0U ? aligned_size
+                                                   : alignment_value);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return ptr;
+}
+} // namespace
+
+AllocationCounters getAllocationCounters() {
+  AllocationCounters counters;
+  counters.allocation_count = allocation_count.load(std::memory_order_relaxed);
+  counters.allocated_byte_count =
+      allocated_byte_count.load(std::memory_order_relaxed);
+
+  return counters;
+}
+
+ScopedAllocationTrackingPause::ScopedAllocationTrackingPause()
+    : previous_tracking_paused(tracking_paused) {
+  tracking_paused = true;
+}
+
+ScopedAllocationTrackingPause::~ScopedAllocationTrackingPause() {
+  tracking_paused = previous_tracking_paused;
+}
+} // namespace zeek
+
+void *operator new(std::size_t size) { return zeek::allocate(size); }
+void *operator new[](std::size_t size) { return zeek::allocate(size); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return zeek::allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return zeek::allocateAligned(size, alignment);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return zeek::allocate(size);
+
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return zeek::allocate(size);
+
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
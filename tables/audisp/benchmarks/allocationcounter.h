@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace zeek {
+/// \brief Process-wide allocation counters, collected by the replacement
+///        global operator new
+struct AllocationCounters final {
+  /// \brief How many allocations have been made
+  std::uint64_t allocation_count{0U};
+
+  /// \brief How many bytes have been requested
+  std::uint64_t allocated_byte_count{0U};
+};
+
+/// \brief Returns the allocations made so far, excluding the ones made while
+///        tracking was paused
+/// \return The allocation counters
+AllocationCounters getAllocationCounters();
+
+/// \brief Pauses the allocation tracking on the current thread, so that the
+///        benchmark bookkeeping is not counted as pipeline allocations
+class ScopedAllocationTrackingPause final {
+public:
+  /// \brief Constructor
+  ScopedAllocationTrackingPause();
+
+  /// \brief Destructor
+  ~ScopedAllocationTrackingPause();
+
+  ScopedAllocationTrackingPause(const ScopedAllocationTrackingPause &) =
+      delete;
+
+  ScopedAllocationTrackingPause &
+  operator=(const ScopedAllocationTrackingPause &) = delete;
+
+private:
+  /// \brief The tracking state at construction time
+  bool previous_tracking_paused{false};
+};
+} // namespace zeek
@@ -0,0 +1,250 @@
+#include "benchmarkutils.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+#include <libaudit_wrapper.h>
+#include <sys/resource.h>
+
+namespace zeek {
+namespace {
+/// \brief All the records of a single event share this timestamp
+const std::string kEventTimestamp{"1572891138.674"};
+
+/// \brief The executable reported by all the generated events
+const std::string kExecutablePath{"/usr/bin/zeek-agent-benchmark"};
+
+/// \brief x86_64 syscall numbers
+const int kExecveSyscallNumber{59};
+const int kConnectSyscallNumber{42};
+const int kOpenSyscallNumber{2};
+
+void appendRecordHeader(std::stringstream &stream, const char *record_type,
+                        std::size_t serial) {
+  stream << "type=" << record_type << " msg=audit(" << kEventTimestamp << ":"
+         << serial << "): ";
+}
+
+void appendSyscallRecord(std::stringstream &stream, std::size_t serial,
+                         int syscall_number, std::size_t item_count) {
+
+  auto process_id = 1000U + (serial % 30000U);
+
+  appendRecordHeader(stream, "SYSCALL", serial);
+  stream << "arch=c000003e syscall=" << syscall_number
+         << " success=yes exit=3 a0=3 a1=7ffddc903cc0 a2=10 a3=8 items="
+         << item_count << " ppid=" << process_id - 1U << " pid=" << process_id
+         << " auid=1000 uid=1000 gid=1000 euid=1000 suid=1000 fsuid=1000"
+         << " egid=1000 sgid=1000 fsgid=1000 tty=pts1 ses=1"
+         << " comm=\"benchmark\" exe=\"" << kExecutablePath
+         << "\" key=(null)\n";
+}
+
+void appendPathRecord(std::stringstream &stream, std::size_t serial,
+                      std::size_t item, const std::string &path) {
+
+  appendRecordHeader(stream, "PATH", serial);
+  stream << "item=" << item << " name=\"" << path << "\" inode="
+         << 5000U + serial << " dev=00:18 mode=0100755 ouid=0 ogid=0"
+         << " rdev=00:00 nametype=NORMAL cap_fp=0000000000000000"
+         << " cap_fi=0000000000000000 cap_fe=0 cap_fver=0\n";
+}
+
+void appendEndOfEventRecord(std::stringstream &stream, std::size_t serial) {
+  appendRecordHeader(stream, "EOE", serial);
+  stream << "\n";
+}
+
+void appendExecveEvent(std::stringstream &stream, std::size_t serial,
+                       const std::string &argument,
+                       std::size_t argument_count) {
+
+  appendSyscallRecord(stream, serial, kExecveSyscallNumber, 1U);
+
+  appendRecordHeader(stream, "EXECVE", serial);
+  stream << "argc=" << argument_count;
+  for (std::size_t i = 0U; i < argument_count; ++i) {
+    stream << " a" << i << "=\"" << argument << "\"";
+  }
+  stream << "\n";
+
+  appendRecordHeader(stream, "CWD", serial);
+  stream << "cwd=\"/var/tmp\"\n";
+
+  appendPathRecord(stream, serial, 0U, kExecutablePath);
+  appendEndOfEventRecord(stream, serial);
+}
+
+void appendConnectEvent(std::stringstream &stream, std::size_t serial) {
+  appendSyscallRecord(stream, serial, kConnectSyscallNumber, 0U);
+
+  // AF_INET, port 80, 192.168.x.y
+  appendRecordHeader(stream, "SOCKADDR", serial);
+
+  auto host = static_cast<unsigned int>(serial % 65536U);
+
+  stream << "saddr=02000050C0A8" << std::hex << std::uppercase
+         << std::setw(4) << std::setfill('0') << host << std::dec
+         << std::setfill(' ') << "0000000000000000\n";
+
+  appendEndOfEventRecord(stream, serial);
+}
+
+void appendOpenEvent(std::stringstream &stream, std::size_t serial) {
+  appendSyscallRecord(stream, serial, kOpenSyscallNumber, 1U);
+
+  appendRecordHeader(stream, "CWD", serial);
+  stream << "cwd=\"/var/tmp\"\n";
+
+  appendPathRecord(stream, serial, 0U,
+                   "/var/tmp/benchmark_" + std::to_string(serial % 1024U));
+
+  appendEndOfEventRecord(stream, serial);
+}
+} // namespace
+
+Status generateSyntheticAuditStream(std::string &stream,
+                                    const SyntheticStreamSettings &settings) {
+  stream = {};
+
+  auto total_weight = settings.execve_weight + settings.connect_weight +
+                      settings.open_weight;
+
+  if (total_weight == 0U) {
+    return Status::failure("At least one event type must have a weight");
+  }
+
+  if (settings.execve_weight != 0U) {
+    if (settings.argument_count == 0U) {
+      return Status::failure("Execve events need at least one argument");
+    }
+
+    // Each argument takes its value plus ' aN=""'
+    auto execve_record_size =
+        settings.argument_count * (settings.argument_size + 12U);
+
+    if (execve_record_size + 128U > MAX_AUDIT_MESSAGE_LENGTH) {
+      return Status::failure("The execve arguments do not fit in a single "
+                             "EXECVE record");
+    }
+  }
+
+  // Arguments are plain lowercase letters, so they are never hex encoded
+  std::string argument(settings.argument_size, 'a');
+  for (std::size_t i = 0U; i < argument.size(); ++i) {
+    argument[i] = static_cast<char>('a' + (i % 26U));
+  }
+
+  std::stringstream output;
+
+  for (std::size_t i = 0U; i < settings.event_count; ++i) {
+    auto serial = i + 1U;
+    auto position = i % total_weight;
+
+    if (position < settings.execve_weight) {
+      appendExecveEvent(output, serial, argument, settings.argument_count);
+
+    } else if (position < settings.execve_weight + settings.connect_weight) {
+      appendConnectEvent(output, serial);
+
+    } else {
+      appendOpenEvent(output, serial);
+    }
+  }
+
+  stream = output.str();
+  return Status::success();
+}
+
+Status repeatAuditStream(std::string &output, const std::string &stream,
+                         std::size_t repeat_count) {
+  output = {};
+
+  static const std::string kMessageHeader{"msg=audit("};
+
+  // Record where each serial number is, and find the highest one
+  std::vector<std::pair<std::size_t, std::size_t>> serial_location_list;
+  std::uint64_t max_serial{0U};
+
+  for (auto header_position = stream.find(kMessageHeader);
+       header_position != std::string::npos;
+       header_position = stream.find(kMessageHeader, header_position + 1U)) {
+
+    auto serial_start = stream.find(':', header_position);
+    auto serial_end = stream.find(')', header_position);
+    if (serial_start == std::string::npos ||
+        serial_end == std::string::npos || serial_start > serial_end) {
+      return Status::failure("Invalid audit message header");
+    }
+
+    ++serial_start;
+
+    auto serial_string = stream.substr(serial_start, serial_end - serial_start);
+
+    char *end_ptr{nullptr};
+    auto serial = std::strtoull(serial_string.c_str(), &end_ptr, 10);
+    if (serial_string.empty() || *end_ptr != 0) {
+      return Status::failure("Invalid audit event serial number: " +
+                             serial_string);
+    }
+
+    max_serial = std::max(max_serial, static_cast<std::uint64_t>(serial));
+    serial_location_list.push_back({serial_start, serial_end});
+  }
+
+  output.reserve(stream.size() * repeat_count);
+
+  for (std::size_t i = 0U; i < repeat_count; ++i) {
+    auto serial_offset = max_serial * i;
+    std::size_t copied_byte_count{0U};
+
+    for (const auto &serial_location : serial_location_list) {
+      output.append(stream, copied_byte_count,
+                    serial_location.first - copied_byte_count);
+
+      auto serial = std::strtoull(stream.c_str() + serial_location.first,
+                                  nullptr, 10);
+
+      output.append(std::to_string(serial + serial_offset));
+      copied_byte_count = serial_location.second;
+    }
+
+    output.append(stream, copied_byte_count, std::string::npos);
+  }
+
+  return Status::success();
+}
+
+void computeLatencyPercentiles(LatencyPercentiles &percentiles,
+                               LatencySampleList &sample_list) {
+  percentiles = {};
+  if (sample_list.empty()) {
+    return;
+  }
+
+  std::sort(sample_list.begin(), sample_list.end());
+
+  auto getPercentile = [&](std::size_t percentile) {
+    auto index = (sample_list.size() - 1U) * percentile / 100U;
+    return sample_list.at(index);
+  };
+
+  percentiles.sample_count = sample_list.size();
+  percentiles.p50 = getPercentile(50U);
+  percentiles.p90 = getPercentile(90U);
+  percentiles.p99 = getPercentile(99U);
+  percentiles.max = sample_list.back();
+}
+
+std::uint64_t getPeakResidentSetSize() {
+  struct rusage resource_usage {};
+  if (getrusage(RUSAGE_SELF, &resource_usage) != 0) {
+    return 0U;
+  }
+
+  // Linux reports the value in kilobytes
+  return static_cast<std::uint64_t>(resource_usage.ru_maxrss) * 1024U;
+}
+} // namespace zeek
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief How the synthetic audisp stream is generated
+struct SyntheticStreamSettings final {
+  /// \brief How many events are generated
+  std::size_t event_count{100000U};
+
+  /// \brief The relative amount of execve events
+  std::size_t execve_weight{1U};
+
+  /// \brief The relative amount of connect events
+  std::size_t connect_weight{1U};
+
+  /// \brief The relative amount of open events
+  std::size_t open_weight{1U};
+
+  /// \brief How many arguments each execve event has
+  std::size_t argument_count{4U};
+
+  /// \brief The size of each execve argument, in bytes
+  std::size_t argument_size{16U};
+};
+
+/// \brief Generates an audisp stream with the given event mix. The event
+///        types are interleaved according to their weights, so that every
+///        part of the stream has the same mix
+/// \param stream Where the generated stream is stored
+/// \param settings How the stream is generated
+/// \return A Status object
+Status generateSyntheticAuditStream(std::string &stream,
+                                    const SyntheticStreamSettings &settings);
+
+/// \brief Concatenates multiple copies of an audisp stream. The event serial
+///        numbers of each copy are moved past the ones of the previous copy,
+///        so that the parser does not merge the records of different copies
+/// \param output Where the repeated stream is stored
+/// \param stream The stream to repeat
+/// \param repeat_count How many copies are made
+/// \return A Status object
+Status repeatAuditStream(std::string &output, const std::string &stream,
+                         std::size_t repeat_count);
+
+/// \brief Latency percentiles of a single pipeline stage
+struct LatencyPercentiles final {
+  /// \brief How many samples have been collected
+  std::size_t sample_count{0U};
+
+  /// \brief Median
+  std::chrono::nanoseconds p50{0};
+
+  /// \brief 90th percentile
+  std::chrono::nanoseconds p90{0};
+
+  /// \brief 99th percentile
+  std::chrono::nanoseconds p99{0};
+
+  /// \brief Slowest sample
+  std::chrono::nanoseconds max{0};
+};
+
+/// \brief A list of latency samples
+using LatencySampleList = std::vector<std::chrono::nanoseconds>;
+
+/// \brief Computes the percentiles of the given samples
+/// \param percentiles Where the percentiles are stored
+/// \param sample_list The samples; they are sorted in place
+void computeLatencyPercentiles(LatencyPercentiles &percentiles,
+                               LatencySampleList &sample_list);
+
+/// \return The peak resident set size of the process, in bytes
+std::uint64_t getPeakResidentSetSize();
+} // namespace zeek
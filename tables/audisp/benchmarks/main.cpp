@@ -0,0 +1,788 @@
+#include "allocationcounter.h"
+#include "auditeventdispatcher.h"
+#include "benchmarkutils.h"
+#include "fileeventstableplugin.h"
+#include "processeventstableplugin.h"
+#include "processtree.h"
+#include "socketeventstableplugin.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+#include <zeek/iaudispconsumer.h>
+#include <zeek/izeekconfiguration.h>
+#include <zeek/izeeklogger.h>
+
+namespace zeek {
+namespace {
+/// \brief How long the table stage waits for new events before checking
+///        the query interval and whether the run is over
+const std::chrono::milliseconds kTableStageWaitTime{1};
+
+/// \brief How long the benchmark waits for more events once the whole
+///        stream has been read and the queues are empty. It is longer than
+///        the timeout used by the native parser for events without an EOE
+///        record
+const std::chrono::seconds kSettleTime{3};
+
+/// \brief The table plugins drop rows past this limit; the benchmark
+///        queries them often enough to never reach it
+const std::size_t kMaxQueuedRowCount{1000000U};
+
+/// \brief Same process limit used by the audisp service
+const std::size_t kMaxTrackedProcessCount{32768U};
+
+/// \brief The benchmark settings
+struct BenchmarkSettings final {
+  /// \brief A captured audisp stream; when empty, a synthetic stream is
+  ///        generated
+  std::string input_path;
+
+  /// \brief How many copies of the stream are replayed
+  std::size_t repeat_count{1U};
+
+  /// \brief The synthetic stream settings
+  SyntheticStreamSettings synthetic_stream;
+
+  /// \brief The parser used for the audisp text stream
+  IAudispConsumer::Parser parser{IAudispConsumer::Parser::Native};
+
+  /// \brief What to do when the table stage falls behind
+  IAudispConsumer::OverflowPolicy overflow_policy{
+      IAudispConsumer::OverflowPolicy::Block};
+
+  /// \brief How often the tables are queried
+  std::chrono::milliseconds query_interval{1000};
+};
+
+/// \brief The measurements of a single run
+struct BenchmarkResults final {
+  std::uint64_t stream_byte_count{0U};
+  std::uint64_t parsed_event_count{0U};
+  std::uint64_t delivered_event_count{0U};
+  std::uint64_t dropped_event_count{0U};
+  std::uint64_t generated_row_count{0U};
+  std::size_t warning_count{0U};
+  bool completed{false};
+
+  std::chrono::nanoseconds elapsed_time{0};
+
+  LatencyPercentiles reader_latency;
+  LatencyPercentiles parser_latency;
+  LatencyPercentiles table_latency;
+
+  AllocationCounters allocations;
+  std::uint64_t peak_rss{0U};
+};
+
+/// \brief Counts the warnings emitted by the table plugins, printing the
+///        first few of them
+class BenchmarkLogger final : public IZeekLogger {
+public:
+  virtual void logMessage(Severity severity,
+                          const std::string &message) override {
+
+    if (severity != Severity::Warning && severity != Severity::Error) {
+      return;
+    }
+
+    if (warning_count.fetch_add(1U) < 10U) {
+      std::cerr << "Table warning: " << message << "\n";
+    }
+  }
+
+  std::atomic<std::size_t> warning_count{0U};
+};
+
+void printUsage(const char *program_name) {
+  std::cerr
+      << "Usage: " << program_name << " [options]\n\n"
+      << "Replays a captured audisp stream, or a synthetic one, through the\n"
+      << "audisp pipeline and the audisp table plugins at full speed\n\n"
+      << "  --input=<path>           Captured audisp stream to replay\n"
+      << "  --repeat=<count>         How many times the stream is replayed\n"
+      << "  --events=<count>         Synthetic event count\n"
+      << "  --mix=<e>:<c>:<o>        Synthetic execve:connect:open weights\n"
+      << "  --argc=<count>           Arguments of each synthetic execve\n"
+      << "  --arg-size=<bytes>       Size of each synthetic argument\n"
+      << "  --parser=<native|auparse>\n"
+      << "  --overflow-policy=<block|drop>\n"
+      << "  --query-interval=<ms>    How often the tables are queried\n";
+}
+
+bool parseUnsignedInteger(std::size_t &value, const std::string &buffer) {
+  if (buffer.empty()) {
+    return false;
+  }
+
+  char *end_ptr{nullptr};
+  auto converted_value = std::strtoull(buffer.c_str(), &end_ptr, 10);
+  if (*end_ptr != 0) {
+    return false;
+  }
+
+  value = static_cast<std::size_t>(converted_value);
+  return true;
+}
+
+Status parseEventMix(SyntheticStreamSettings &settings,
+                     const std::string &buffer) {
+
+  std::vector<std::size_t> weight_list;
+
+  std::size_t start{0U};
+  for (;;) {
+    auto separator = buffer.find(':', start);
+
+    auto weight_string = buffer.substr(start, separator - start);
+
+    std::size_t weight{0U};
+    if (!parseUnsignedInteger(weight, weight_string)) {
+      return Status::failure("Invalid event mix: " + buffer);
+    }
+
+    weight_list.push_back(weight);
+
+    if (separator == std::string::npos) {
+      break;
+    }
+
+    start = separator + 1U;
+  }
+
+  if (weight_list.size() != 3U) {
+    return Status::failure("Invalid event mix: " + buffer);
+  }
+
+  settings.execve_weight = weight_list.at(0U);
+  settings.connect_weight = weight_list.at(1U);
+  settings.open_weight = weight_list.at(2U);
+
+  return Status::success();
+}
+
+Status parseCommandLine(BenchmarkSettings &settings, int argc, char *argv[]) {
+  settings = {};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+
+    auto separator = argument.find('=');
+    if (argument.compare(0U, 2U, "--") != 0 ||
+        separator == std::string::npos) {
+      return Status::failure("Invalid option: " + argument);
+    }
+
+    auto name = argument.substr(2U, separator - 2U);
+    auto value = argument.substr(separator + 1U);
+
+    std::size_t integer_value{0U};
+    bool valid_value{true};
+
+    if (name == "input") {
+      settings.input_path = value;
+
+    } else if (name == "repeat") {
+      valid_value = parseUnsignedInteger(settings.repeat_count, value) &&
+                    settings.repeat_count != 0U;
+
+    } else if (name == "events") {
+      valid_value =
+          parseUnsignedInteger(settings.synthetic_stream.event_count, value);
+
+    } else if (name == "mix") {
+      auto status = parseEventMix(settings.synthetic_stream, value);
+      if (!status.succeeded()) {
+        return status;
+      }
+
+    } else if (name == "argc") {
+      valid_value =
+          parseUnsignedInteger(settings.synthetic_stream.argument_count, value);
+
+    } else if (name == "arg-size") {
+      valid_value =
+          parseUnsignedInteger(settings.synthetic_stream.argument_size, value);
+
+    } else if (name == "parser") {
+      if (value == "native") {
+        settings.parser = IAudispConsumer::Parser::Native;
+      } else if (value == "auparse") {
+        settings.parser = IAudispConsumer::Parser::Auparse;
+      } else {
+        valid_value = false;
+      }
+
+    } else if (name == "overflow-policy") {
+      if (value == "block") {
+        settings.overflow_policy = IAudispConsumer::OverflowPolicy::Block;
+      } else if (value == "drop") {
+        settings.overflow_policy = IAudispConsumer::OverflowPolicy::Drop;
+      } else {
+        valid_value = false;
+      }
+
+    } else if (name == "query-interval") {
+      valid_value = parseUnsignedInteger(integer_value, value);
+      settings.query_interval = std::chrono::milliseconds(integer_value);
+
+    } else {
+      return Status::failure("Unknown option: " + argument);
+    }
+
+    if (!valid_value) {
+      return Status::failure("Invalid value for the " + name +
+                             " option: " + value);
+    }
+  }
+
+  return Status::success();
+}
+
+/// \brief Writes the given data to a new temporary file
+/// \param path Where the path of the created file is stored
+/// \param data The file contents
+/// \return A Status object
+Status writeTemporaryFile(std::string &path, const std::string &data) {
+  path = {};
+
+  char path_template[] = "/tmp/zeek_audisp_benchmark_XXXXXX";
+  auto fd = mkstemp(path_template);
+  if (fd == -1) {
+    return Status::failure("Failed to create a temporary file");
+  }
+
+  close(fd);
+
+  std::ofstream output_file(path_template, std::ios::binary);
+  output_file << data;
+  output_file.close();
+
+  if (!output_file) {
+    std::remove(path_template);
+    return Status::failure("Failed to write the temporary file");
+  }
+
+  path = path_template;
+  return Status::success();
+}
+
+/// \brief Creates the configuration object used by the table plugins
+/// \param configuration Where the created object is stored
+/// \param virtual_database The database where the configuration is exported
+/// \return A Status object
+Status createConfiguration(IZeekConfiguration::Ref &configuration,
+                           IVirtualDatabase &virtual_database) {
+
+  std::stringstream config_data;
+  config_data << "{\n"
+              << "  \"server_address\": \"127.0.0.1\",\n"
+              << "  \"server_port\": 9999,\n"
+              << "  \"log_folder\": \"/tmp\",\n"
+              << "  \"group_list\": [],\n"
+              << "  \"osquery_extensions_socket\": \"\",\n"
+              << "  \"max_queued_row_count\": " << kMaxQueuedRowCount << "\n"
+              << "}\n";
+
+  std::string config_path;
+  auto status = writeTemporaryFile(config_path, config_data.str());
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  status = IZeekConfiguration::create(configuration, virtual_database,
+                                      config_path);
+
+  std::remove(config_path.c_str());
+  return status;
+}
+
+/// \brief Returns the metrics of the given stage
+/// \param metrics The metrics of all the stages
+/// \param name The stage name
+/// \return The stage metrics, or empty ones if the stage is not found
+IAudispConsumer::PipelineStageMetrics
+getStageMetrics(const IAudispConsumer::PipelineMetrics &metrics,
+                const std::string &name) {
+
+  for (const auto &stage_metrics : metrics) {
+    if (stage_metrics.name == name) {
+      return stage_metrics;
+    }
+  }
+
+  return {};
+}
+
+/// \brief Runs a pipeline stage on the current thread, recording the
+///        duration of each call that made progress
+/// \param stop Set to true when the benchmark ends
+/// \param stage The stage function
+/// \param progress_counter Returns a value that grows when the stage works
+/// \param sample_list Where the latency samples are stored
+void runMeasuredStage(std::atomic_bool &stop,
+                      const std::function<Status()> &stage,
+                      const std::function<std::uint64_t()> &progress_counter,
+                      LatencySampleList &sample_list) {
+
+  std::uint64_t previous_progress{0U};
+
+  while (!stop) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto status = stage();
+    auto end_time = std::chrono::steady_clock::now();
+
+    if (!status.succeeded()) {
+      std::cerr << "Pipeline stage failure: " << status.message() << "\n";
+      stop = true;
+      break;
+    }
+
+    ScopedAllocationTrackingPause allocation_tracking_pause;
+
+    auto current_progress = progress_counter();
+    if (current_progress != previous_progress) {
+      sample_list.push_back(end_time - start_time);
+      previous_progress = current_progress;
+    }
+  }
+}
+
+Status runBenchmark(BenchmarkResults &results,
+                    const BenchmarkSettings &settings,
+                    const std::string &stream_path,
+                    std::uint64_t stream_byte_count) {
+
+  results = {};
+  results.stream_byte_count = stream_byte_count;
+
+  IVirtualDatabase::Ref virtual_database;
+  auto status = IVirtualDatabase::create(virtual_database);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  IZeekConfiguration::Ref configuration;
+  status = createConfiguration(configuration, *virtual_database);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  BenchmarkLogger logger;
+
+  ProcessTree::Ref process_tree;
+  status = ProcessTree::create(process_tree, kMaxTrackedProcessCount);
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  IVirtualTable::Ref process_events_table;
+  status = ProcessEventsTablePlugin::create(process_events_table,
+                                            *configuration, logger);
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  IVirtualTable::Ref socket_events_table;
+  status = SocketEventsTablePlugin::create(socket_events_table,
+                                           *configuration, logger);
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  IVirtualTable::Ref file_events_table;
+  status = FileEventsTablePlugin::create(file_events_table, *configuration,
+                                         logger);
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  // Same routing as in the audisp service
+  AuditEventDispatcher event_dispatcher(logger, std::chrono::hours(24));
+
+  auto &process_events_table_impl =
+      *static_cast<ProcessEventsTablePlugin *>(process_events_table.get());
+
+  status = event_dispatcher.registerTable(
+      process_events_table_impl.name(),
+      ProcessEventsTablePlugin::syscallTypeList(),
+      [&process_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return process_events_table_impl.processEvents(event_list);
+      },
+      []() { return std::chrono::steady_clock::now(); });
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  auto &socket_events_table_impl =
+      *static_cast<SocketEventsTablePlugin *>(socket_events_table.get());
+
+  status = event_dispatcher.registerTable(
+      socket_events_table_impl.name(),
+      SocketEventsTablePlugin::syscallTypeList(),
+      [&socket_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return socket_events_table_impl.processEvents(event_list);
+      },
+      []() { return std::chrono::steady_clock::now(); });
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  auto &file_events_table_impl =
+      *static_cast<FileEventsTablePlugin *>(file_events_table.get());
+
+  status = event_dispatcher.registerTable(
+      file_events_table_impl.name(), FileEventsTablePlugin::syscallTypeList(),
+      [&file_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return file_events_table_impl.processEvents(event_list);
+      },
+      []() { return std::chrono::steady_clock::now(); });
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  IAudispConsumer::Ref audisp_consumer;
+  status = IAudispConsumer::createFromFile(audisp_consumer, stream_path,
+                                           settings.parser,
+                                           settings.overflow_policy);
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  auto queryTables = [&]() -> Status {
+    for (auto table : {process_events_table.get(), socket_events_table.get(),
+                       file_events_table.get()}) {
+
+      IVirtualTable::RowList row_list;
+      auto status = table->generateRowList(row_list);
+      if (!status.succeeded()) {
+        return status;
+      }
+
+      results.generated_row_count += row_list.size();
+    }
+
+    return Status::success();
+  };
+
+  auto getMetrics = [&]() {
+    IAudispConsumer::PipelineMetrics metrics;
+    audisp_consumer->getPipelineMetrics(metrics);
+
+    return metrics;
+  };
+
+  // Everything allocated so far is setup; only the pipeline is measured
+  auto initial_allocations = getAllocationCounters();
+  auto start_time = std::chrono::steady_clock::now();
+
+  std::atomic_bool stop{false};
+
+  LatencySampleList reader_sample_list;
+  std::thread reader_thread([&]() {
+    runMeasuredStage(
+        stop, [&]() { return audisp_consumer->readData(); },
+        [&]() {
+          return getStageMetrics(getMetrics(), "reader").processed_count;
+        },
+        reader_sample_list);
+  });
+
+  // The progress of the parser is the amount of data it has consumed
+  LatencySampleList parser_sample_list;
+  std::thread parser_thread([&]() {
+    runMeasuredStage(
+        stop, [&]() { return audisp_consumer->parseData(); },
+        [&]() {
+          auto metrics = getMetrics();
+          return getStageMetrics(metrics, "reader").processed_count -
+                 getStageMetrics(metrics, "parser").queue_depth;
+        },
+        parser_sample_list);
+  });
+
+  LatencySampleList table_sample_list;
+  auto last_query_time = start_time;
+  auto last_progress_time = start_time;
+
+  while (!stop) {
+    auto batch_start_time = std::chrono::steady_clock::now();
+
+    IAudispConsumer::AuditEventList event_list;
+    audisp_consumer->getEvents(event_list);
+
+    if (!event_list.empty()) {
+      process_tree->processEvents(event_list);
+      event_dispatcher.dispatch(event_list);
+
+      auto batch_end_time = std::chrono::steady_clock::now();
+      last_progress_time = batch_end_time;
+
+      ScopedAllocationTrackingPause allocation_tracking_pause;
+      table_sample_list.push_back(batch_end_time - batch_start_time);
+    }
+
+    auto current_time = std::chrono::steady_clock::now();
+    if (current_time - last_query_time >= settings.query_interval) {
+      status = queryTables();
+      if (!status.succeeded()) {
+        stop = true;
+        break;
+      }
+
+      last_query_time = current_time;
+    }
+
+    if (!event_list.empty()) {
+      continue;
+    }
+
+    // The run ends once the whole stream has been read, both queues are
+    // empty and no event has been delivered for a while
+    bool pipeline_drained{false};
+
+    {
+      ScopedAllocationTrackingPause allocation_tracking_pause;
+
+      auto metrics = getMetrics();
+      pipeline_drained =
+          getStageMetrics(metrics, "reader").processed_count ==
+              results.stream_byte_count &&
+          getStageMetrics(metrics, "parser").queue_depth == 0U &&
+          getStageMetrics(metrics, "tables").queue_depth == 0U;
+    }
+
+    if (pipeline_drained && current_time - last_progress_time >= kSettleTime) {
+      results.completed = true;
+      break;
+    }
+
+    audisp_consumer->waitForEvents(kTableStageWaitTime);
+  }
+
+  stop = true;
+  audisp_consumer->interrupt();
+
+  reader_thread.join();
+  parser_thread.join();
+
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  status = queryTables();
+  if (!status.succeeded()) {
+    return status;
+  }
+
+  auto final_allocations = getAllocationCounters();
+
+  auto metrics = getMetrics();
+  auto table_metrics = getStageMetrics(metrics, "tables");
+
+  results.parsed_event_count =
+      getStageMetrics(metrics, "parser").processed_count;
+
+  results.delivered_event_count = table_metrics.processed_count;
+  results.dropped_event_count = table_metrics.dropped_count;
+  results.warning_count = logger.warning_count;
+
+  // The settle time is not part of the measurement
+  results.elapsed_time = last_progress_time - start_time;
+
+  computeLatencyPercentiles(results.reader_latency, reader_sample_list);
+  computeLatencyPercentiles(results.parser_latency, parser_sample_list);
+  computeLatencyPercentiles(results.table_latency, table_sample_list);
+
+  results.allocations.allocation_count =
+      final_allocations.allocation_count -
+      initial_allocations.allocation_count;
+
+  results.allocations.allocated_byte_count =
+      final_allocations.allocated_byte_count -
+      initial_allocations.allocated_byte_count;
+
+  results.peak_rss = getPeakResidentSetSize();
+  return Status::success();
+}
+
+void printLatency(const std::string &stage_name,
+                  const LatencyPercentiles &percentiles) {
+
+  auto toMicroseconds = [](const std::chrono::nanoseconds &value) {
+    return static_cast<double>(value.count()) / 1000.0;
+  };
+
+  std::cout << "  " << std::left << std::setw(8) << stage_name << std::right
+            << " p50 " << toMicroseconds(percentiles.p50) << " p90 "
+            << toMicroseconds(percentiles.p90) << " p99 "
+            << toMicroseconds(percentiles.p99) << " max "
+            << toMicroseconds(percentiles.max) << " ("
+            << percentiles.sample_count << " samples)\n";
+}
+
+void printResults(const BenchmarkSettings &settings,
+                  const BenchmarkResults &results) {
+
+  auto elapsed_seconds =
+      std::chrono::duration<double>(results.elapsed_time).count();
+
+  auto events_per_second =
+      elapsed_seconds > 0.0
+          ? static_cast<double>(results.delivered_event_count) /
+                elapsed_seconds
+          : 0.0;
+
+  auto megabytes_per_second =
+      elapsed_seconds > 0.0 ? static_cast<double>(results.stream_byte_count) /
+                                  (1024.0 * 1024.0) / elapsed_seconds
+                            : 0.0;
+
+  auto perEvent = [&](std::uint64_t value) {
+    return results.delivered_event_count != 0U
+               ? static_cast<double>(value) /
+                     static_cast<double>(results.delivered_event_count)
+               : 0.0;
+  };
+
+  const auto &synthetic_stream = settings.synthetic_stream;
+
+  std::cout << std::fixed << std::setprecision(2);
+
+  if (settings.input_path.empty()) {
+    std::cout << "input: synthetic, " << synthetic_stream.event_count
+              << " events, mix " << synthetic_stream.execve_weight << ":"
+              << synthetic_stream.connect_weight << ":"
+              << synthetic_stream.open_weight << ", "
+              << synthetic_stream.argument_count << " arguments of "
+              << synthetic_stream.argument_size << " bytes\n";
+
+  } else {
+    std::cout << "input: " << settings.input_path << "\n";
+  }
+
+  std::cout
+      << "repeat: " << settings.repeat_count << "\n"
+      << "parser: "
+      << (settings.parser == IAudispConsumer::Parser::Native ? "native"
+                                                             : "auparse")
+      << "\n"
+      << "overflow policy: "
+      << (settings.overflow_policy == IAudispConsumer::OverflowPolicy::Block
+              ? "block"
+              : "drop")
+      << "\n"
+      << "completed: " << (results.completed ? "yes" : "no") << "\n"
+      << "stream bytes: " << results.stream_byte_count << "\n"
+      << "events: " << results.parsed_event_count << " parsed, "
+      << results.delivered_event_count << " delivered, "
+      << results.dropped_event_count << " dropped\n"
+      << "rows: " << results.generated_row_count << "\n"
+      << "table warnings: " << results.warning_count << "\n"
+      << "elapsed: " << elapsed_seconds << " s\n"
+      << "throughput: " << events_per_second << " events/s, "
+      << megabytes_per_second << " MiB/s\n"
+      << "stage latency (us):\n";
+
+  printLatency("reader", results.reader_latency);
+  printLatency("parser", results.parser_latency);
+  printLatency("tables", results.table_latency);
+
+  std::cout << "allocations: " << results.allocations.allocation_count
+            << " (" << perEvent(results.allocations.allocation_count)
+            << " per event), " << results.allocations.allocated_byte_count
+            << " bytes ("
+            << perEvent(results.allocations.allocated_byte_count)
+            << " per event)\n"
+            << "peak rss: " << results.peak_rss / 1024U << " KiB\n";
+}
+} // namespace
+} // namespace zeek
+
+int main(int argc, char *argv[]) {
+  zeek::BenchmarkSettings settings;
+  auto status = zeek::parseCommandLine(settings, argc, argv);
+  if (!status.succeeded()) {
+    std::cerr << status.message() << "\n\n";
+    zeek::printUsage(argv[0]);
+    return 1;
+  }
+
+  std::string stream_data;
+
+  if (settings.input_path.empty()) {
+    status = zeek::generateSyntheticAuditStream(stream_data,
+                                                settings.synthetic_stream);
+
+  } else {
+    std::ifstream input_file(settings.input_path, std::ios::binary);
+    if (input_file) {
+      stream_data.assign(std::istreambuf_iterator<char>(input_file),
+                         std::istreambuf_iterator<char>());
+    }
+
+    if (!input_file) {
+      status = zeek::Status::failure("Failed to read the input file: " +
+                                     settings.input_path);
+    }
+  }
+
+  if (status.succeeded() && settings.repeat_count > 1U) {
+    std::string repeated_stream_data;
+    status = zeek::repeatAuditStream(repeated_stream_data, stream_data,
+                                     settings.repeat_count);
+
+    stream_data = std::move(repeated_stream_data);
+  }
+
+  // The stream is always replayed from a temporary file, so that the
+  // consumer is created the same way for every input
+  std::string stream_path;
+  if (status.succeeded()) {
+    status = zeek::writeTemporaryFile(stream_path, stream_data);
+  }
+
+  if (!status.succeeded()) {
+    std::cerr << "Failed to prepare the audisp stream: " << status.message()
+              << "\n";
+
+    return 1;
+  }
+
+  auto stream_byte_count = static_cast<std::uint64_t>(stream_data.size());
+  stream_data = {};
+
+  zeek::BenchmarkResults results;
+  status = zeek::runBenchmark(results, settings, stream_path,
+                              stream_byte_count);
+
+  std::remove(stream_path.c_str());
+
+  if (!status.succeeded()) {
+    std::cerr << "The benchmark has failed: " << status.message() << "\n";
+    return 1;
+  }
+
+  zeek::printResults(settings, results);
+  return results.completed ? 0 : 1;
+}
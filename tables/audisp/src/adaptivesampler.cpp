@@ -0,0 +1,182 @@
+#include "adaptivesampler.h"
+
+#include <algorithm>
+
+namespace zeek {
+namespace {
+/// \brief FNV-1a parameters
+const std::uint64_t kFnvOffsetBasis{0xCBF29CE484222325ULL};
+const std::uint64_t kFnvPrime{0x100000001B3ULL};
+
+/// \brief Adds the given bytes to an FNV-1a hash
+/// \param hash The hash to update
+/// \param buffer The bytes to add
+/// \param size How many bytes to add
+void updateHash(std::uint64_t &hash, const void *buffer, std::size_t size) {
+  auto byte_buffer = static_cast<const std::uint8_t *>(buffer);
+
+  for (std::size_t i = 0U; i < size; ++i) {
+    hash ^= byte_buffer[i];
+    hash *= kFnvPrime;
+  }
+}
+
+/// \brief Spreads the bits of a hash, so that the low bits can be used to
+///        select the rows (splitmix64 finalizer)
+/// \param hash The hash to mix
+/// \return The mixed hash
+std::uint64_t mixHash(std::uint64_t hash) {
+  hash ^= hash >> 30U;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 27U;
+  hash *= 0x94D049BB133111EBULL;
+  hash ^= hash >> 31U;
+
+  return hash;
+}
+
+/// \brief Hashes a table name, so that it can be combined with many event
+///        serial numbers
+/// \param table_name The table name
+/// \return The partial hash
+std::uint64_t hashTableName(const std::string &table_name) {
+  auto hash = kFnvOffsetBasis;
+  updateHash(hash, table_name.data(), table_name.size());
+
+  return hash;
+}
+
+/// \brief Completes a table name hash with an event serial number
+/// \param table_hash The value returned by hashTableName
+/// \param serial The event serial number
+/// \return The event hash
+std::uint64_t finalizeEventHash(std::uint64_t table_hash,
+                                std::uint64_t serial) {
+  updateHash(table_hash, &serial, sizeof(serial));
+  return mixHash(table_hash);
+}
+} // namespace
+
+const std::int64_t AdaptiveSampler::kMaxSampleWeight;
+
+struct AdaptiveSampler::PrivateData final {
+  std::uint64_t table_hash{0U};
+  std::size_t max_queued_row_count{0U};
+
+  // Queue usage, in rows, that starts and stops sampling
+  std::size_t start_row_count{0U};
+  std::size_t stop_row_count{0U};
+
+  std::int64_t sample_weight{1};
+};
+
+Status AdaptiveSampler::create(Ref &obj, const std::string &table_name,
+                               std::size_t max_queued_row_count,
+                               std::uint32_t threshold_percentage) {
+  try {
+    obj.reset(new AdaptiveSampler(table_name, max_queued_row_count,
+                                  threshold_percentage));
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AdaptiveSampler::~AdaptiveSampler() {}
+
+std::size_t AdaptiveSampler::processRows(IVirtualTable::RowList &row_list,
+                                         const SerialList &serial_list,
+                                         std::size_t queued_row_count) {
+  if (queued_row_count >= d->start_row_count) {
+    // Each step past the threshold halves the sample rate, reaching the
+    // lowest one when the queue is full
+    auto max_level = static_cast<std::size_t>(0U);
+    for (auto weight = kMaxSampleWeight; weight > 1; weight /= 2) {
+      ++max_level;
+    }
+
+    auto usage = std::min(queued_row_count, d->max_queued_row_count) -
+                 d->start_row_count;
+
+    auto range = d->max_queued_row_count - d->start_row_count;
+
+    auto level = range != 0U ? 1U + (usage * (max_level - 1U)) / range
+                             : max_level;
+
+    d->sample_weight = static_cast<std::int64_t>(1) << level;
+
+  } else if (queued_row_count < d->stop_row_count) {
+    d->sample_weight = 1;
+
+  } else if (d->sample_weight > 1) {
+    // Keep sampling until the queue has drained below the lower threshold
+    d->sample_weight = 2;
+  }
+
+  if (d->sample_weight == 1) {
+    return 0U;
+  }
+
+  auto mask = static_cast<std::uint64_t>(d->sample_weight - 1);
+  auto initial_row_count = row_list.size();
+
+  std::size_t kept_row_count{0U};
+  for (std::size_t i = 0U; i < initial_row_count; ++i) {
+    // Rows without a serial number are always kept
+    if (i < serial_list.size()) {
+      auto event_hash = finalizeEventHash(d->table_hash, serial_list[i]);
+      if ((event_hash & mask) != 0U) {
+        continue;
+      }
+    }
+
+    if (kept_row_count != i) {
+      row_list[kept_row_count] = std::move(row_list[i]);
+    }
+
+    row_list[kept_row_count]["sample_weight"] = d->sample_weight;
+    ++kept_row_count;
+  }
+
+  row_list.resize(kept_row_count);
+  return initial_row_count - kept_row_count;
+}
+
+std::int64_t AdaptiveSampler::sampleWeight() const { return d->sample_weight; }
+
+void AdaptiveSampler::initializeRow(IVirtualTable::Row &row) {
+  row["sample_weight"] = static_cast<std::int64_t>(1);
+}
+
+std::uint64_t AdaptiveSampler::hashEvent(const std::string &table_name,
+                                         std::uint64_t serial) {
+  return finalizeEventHash(hashTableName(table_name), serial);
+}
+
+AdaptiveSampler::AdaptiveSampler(const std::string &table_name,
+                                 std::size_t max_queued_row_count,
+                                 std::uint32_t threshold_percentage)
+    : d(new PrivateData) {
+
+  if (max_queued_row_count == 0U) {
+    throw Status::failure("The queue capacity must be greater than 0");
+  }
+
+  if (threshold_percentage == 0U || threshold_percentage > 100U) {
+    throw Status::failure("The sampling threshold must be between 1 and 100");
+  }
+
+  d->table_hash = hashTableName(table_name);
+  d->max_queued_row_count = max_queued_row_count;
+
+  d->start_row_count = std::max(
+      static_cast<std::size_t>(1U),
+      (max_queued_row_count * threshold_percentage) / 100U);
+
+  d->stop_row_count = d->start_row_count / 2U;
+}
+} // namespace zeek
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief Keeps a table queue within its budget by sampling the rows once
+///        the queue fills past a threshold, instead of dropping whichever
+///        rows arrive last. Rows are selected by hashing the serial number
+///        of the audit event they come from together with the table name,
+///        so identical events are sampled independently and the same event
+///        is always either kept or discarded at a given rate. Rates are
+///        powers of two, and each kept row carries the number of rows it
+///        stands for in the sample_weight column
+class AdaptiveSampler final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to an AdaptiveSampler object
+  using Ref = std::unique_ptr<AdaptiveSampler>;
+
+  /// \brief The serial numbers of the audit events behind a list of rows
+  using SerialList = std::vector<std::uint64_t>;
+
+  /// \brief The largest sample weight; once the queue is full, 1 row out
+  ///        of this many is kept
+  static const std::int64_t kMaxSampleWeight{1024};
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param table_name The name of the sampled table
+  /// \param max_queued_row_count The queue capacity
+  /// \param threshold_percentage How full the queue can get, as a
+  ///        percentage of its capacity, before sampling starts; full capture
+  ///        resumes when the queue drops below half of the threshold
+  /// \return A Status object
+  static Status create(Ref &obj, const std::string &table_name,
+                       std::size_t max_queued_row_count,
+                       std::uint32_t threshold_percentage);
+
+  /// \brief Destructor
+  ~AdaptiveSampler();
+
+  /// \brief Updates the sample weight from the queue usage, then discards
+  ///        the rows that are not selected
+  /// \param row_list The rows to sample, already initialized with
+  ///        initializeRow; the selected rows get the new sample weight
+  /// \param serial_list The event serial number of each row, in the same
+  ///        order as row_list; rows past the end of the list are kept
+  /// \param queued_row_count How many rows are currently queued
+  /// \return How many rows have been discarded
+  std::size_t processRows(IVirtualTable::RowList &row_list,
+                          const SerialList &serial_list,
+                          std::size_t queued_row_count);
+
+  /// \return The current sample weight; 1 means that all rows are kept
+  std::int64_t sampleWeight() const;
+
+  /// \brief Sets the sample_weight column to 1
+  /// \param row The row to update
+  static void initializeRow(IVirtualTable::Row &row);
+
+  /// \brief Hashes an event serial number together with a table name
+  /// \param table_name The table name
+  /// \param serial The event serial number
+  /// \return The event hash
+  static std::uint64_t hashEvent(const std::string &table_name,
+                                 std::uint64_t serial);
+
+  AdaptiveSampler(const AdaptiveSampler &) = delete;
+  AdaptiveSampler &operator=(const AdaptiveSampler &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param table_name The name of the sampled table
+  /// \param max_queued_row_count The queue capacity
+  /// \param threshold_percentage When sampling starts
+  AdaptiveSampler(const std::string &table_name,
+                  std::size_t max_queued_row_count,
+                  std::uint32_t threshold_percentage);
+};
+} // namespace zeek
@@ -0,0 +1,75 @@
+#include "audispfilterrulestableplugin.h"
+
+namespace zeek {
+struct AudispFilterRulesTablePlugin::PrivateData final {
+  PrivateData(const IAudispConsumer &audisp_consumer_)
+      : audisp_consumer(audisp_consumer_) {}
+
+  const IAudispConsumer &audisp_consumer;
+};
+
+Status
+AudispFilterRulesTablePlugin::create(Ref &obj,
+                                     const IAudispConsumer &audisp_consumer) {
+  try {
+    auto ptr = new AudispFilterRulesTablePlugin(audisp_consumer);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AudispFilterRulesTablePlugin::~AudispFilterRulesTablePlugin() {}
+
+const std::string &AudispFilterRulesTablePlugin::name() const {
+  static const std::string kTableName{"audisp_filter_rules"};
+
+  return kTableName;
+}
+
+const AudispFilterRulesTablePlugin::Schema &
+AudispFilterRulesTablePlugin::schema() const {
+  static const Schema kTableSchema = {
+      {"position", IVirtualTable::ColumnType::Integer},
+      {"rule", IVirtualTable::ColumnType::String},
+      {"matched", IVirtualTable::ColumnType::Integer}};
+
+  return kTableSchema;
+}
+
+Status AudispFilterRulesTablePlugin::generateRowList(RowList &row_list) {
+  IAudispConsumer::FilterRuleCounterList counter_list;
+  d->audisp_consumer.getFilterRuleCounters(counter_list);
+
+  generateRowList(row_list, counter_list);
+  return Status::success();
+}
+
+void AudispFilterRulesTablePlugin::generateRowList(
+    RowList &row_list,
+    const IAudispConsumer::FilterRuleCounterList &counter_list) {
+
+  row_list = {};
+
+  for (std::size_t i = 0U; i < counter_list.size(); ++i) {
+    const auto &counter = counter_list.at(i);
+
+    Row row;
+    row["position"] = static_cast<std::int64_t>(i);
+    row["rule"] = counter.rule;
+    row["matched"] = static_cast<std::int64_t>(counter.match_count);
+
+    row_list.push_back(std::move(row));
+  }
+}
+
+AudispFilterRulesTablePlugin::AudispFilterRulesTablePlugin(
+    const IAudispConsumer &audisp_consumer)
+    : d(new PrivateData(audisp_consumer)) {}
+} // namespace zeek
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <zeek/iaudispconsumer.h>
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief Provides the audisp_filter_rules table, with how many events each
+///        of the configured filter rules has matched
+class AudispFilterRulesTablePlugin final : public IVirtualTable {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param audisp_consumer The consumer applying the filter rules
+  /// \return A Status object
+  static Status create(Ref &obj, const IAudispConsumer &audisp_consumer);
+
+  /// \brief Destructor
+  virtual ~AudispFilterRulesTablePlugin() override;
+
+  /// \return The table name
+  virtual const std::string &name() const override;
+
+  /// \return The table schema
+  virtual const Schema &schema() const override;
+
+  /// \brief Generates one row for each filter rule
+  /// \param row_list Where the generated rows are stored
+  /// \return A Status object
+  virtual Status generateRowList(RowList &row_list) override;
+
+  /// \brief Generates the rows from the given rule counters
+  /// \param row_list Where the generated rows are stored
+  /// \param counter_list The filter rule counters, in rule order
+  static void
+  generateRowList(RowList &row_list,
+                  const IAudispConsumer::FilterRuleCounterList &counter_list);
+
+protected:
+  /// \brief Constructor
+  /// \param audisp_consumer The consumer applying the filter rules
+  AudispFilterRulesTablePlugin(const IAudispConsumer &audisp_consumer);
+};
+} // namespace zeek
@@ -0,0 +1,133 @@
+#include "audisppipelinetableplugin.h"
+
+#include <map>
+#include <mutex>
+
+namespace zeek {
+struct AudispPipelineTablePlugin::PrivateData final {
+  PrivateData(const IAudispConsumer &audisp_consumer_,
+              const AuditEventDispatcher &event_dispatcher_)
+      : audisp_consumer(audisp_consumer_),
+        event_dispatcher(event_dispatcher_) {}
+
+  const IAudispConsumer &audisp_consumer;
+  const AuditEventDispatcher &event_dispatcher;
+
+  std::mutex previous_sample_mutex;
+  std::chrono::steady_clock::time_point previous_sample_time;
+  std::map<std::string, std::uint64_t> previous_processed_count_map;
+};
+
+Status AudispPipelineTablePlugin::create(
+    Ref &obj, const IAudispConsumer &audisp_consumer,
+    const AuditEventDispatcher &event_dispatcher) {
+
+  try {
+    auto ptr = new AudispPipelineTablePlugin(audisp_consumer, event_dispatcher);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AudispPipelineTablePlugin::~AudispPipelineTablePlugin() {}
+
+const std::string &AudispPipelineTablePlugin::name() const {
+  static const std::string kTableName{"audisp_pipeline"};
+
+  return kTableName;
+}
+
+const AudispPipelineTablePlugin::Schema &
+AudispPipelineTablePlugin::schema() const {
+  static const Schema kTableSchema = {
+      {"stage", IVirtualTable::ColumnType::String},
+      {"queue_depth", IVirtualTable::ColumnType::Integer},
+      {"queue_capacity", IVirtualTable::ColumnType::Integer},
+      {"processed", IVirtualTable::ColumnType::Integer},
+      {"dropped", IVirtualTable::ColumnType::Integer},
+      {"throughput", IVirtualTable::ColumnType::Double}};
+
+  return kTableSchema;
+}
+
+Status AudispPipelineTablePlugin::generateRowList(RowList &row_list) {
+  row_list = {};
+
+  IAudispConsumer::PipelineMetrics metrics;
+  d->audisp_consumer.getPipelineMetrics(metrics);
+
+  IAudispConsumer::PipelineStageMetrics dispatcher_metrics;
+  d->event_dispatcher.getMetrics(dispatcher_metrics);
+  metrics.push_back(std::move(dispatcher_metrics));
+
+  std::lock_guard<std::mutex> lock(d->previous_sample_mutex);
+
+  auto current_time = std::chrono::steady_clock::now();
+  auto elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      current_time - d->previous_sample_time);
+
+  for (const auto &stage_metrics : metrics) {
+    auto &previous_processed_count =
+        d->previous_processed_count_map[stage_metrics.name];
+
+    Row row;
+    auto status = generateRow(row, stage_metrics, previous_processed_count,
+                              elapsed_time);
+
+    if (!status.succeeded()) {
+      return status;
+    }
+
+    previous_processed_count = stage_metrics.processed_count;
+    row_list.push_back(std::move(row));
+  }
+
+  d->previous_sample_time = current_time;
+  return Status::success();
+}
+
+Status AudispPipelineTablePlugin::generateRow(
+    Row &row, const IAudispConsumer::PipelineStageMetrics &metrics,
+    std::uint64_t previous_processed_count,
+    const std::chrono::milliseconds &elapsed_time) {
+
+  row = {};
+
+  if (metrics.processed_count < previous_processed_count) {
+    return Status::failure("The processed count of the " + metrics.name +
+                           " stage has decreased");
+  }
+
+  // The throughput is averaged over the time since the previous query
+  double throughput{0.0};
+  if (elapsed_time.count() > 0) {
+    throughput = static_cast<double>(metrics.processed_count -
+                                     previous_processed_count) *
+                 1000.0 / static_cast<double>(elapsed_time.count());
+  }
+
+  row["stage"] = metrics.name;
+  row["queue_depth"] = static_cast<std::int64_t>(metrics.queue_depth);
+  row["queue_capacity"] = static_cast<std::int64_t>(metrics.queue_capacity);
+  row["processed"] = static_cast<std::int64_t>(metrics.processed_count);
+  row["dropped"] = static_cast<std::int64_t>(metrics.dropped_count);
+  row["throughput"] = throughput;
+
+  return Status::success();
+}
+
+AudispPipelineTablePlugin::AudispPipelineTablePlugin(
+    const IAudispConsumer &audisp_consumer,
+    const AuditEventDispatcher &event_dispatcher)
+    : d(new PrivateData(audisp_consumer, event_dispatcher)) {
+
+  d->previous_sample_time = std::chrono::steady_clock::now();
+}
+} // namespace zeek
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "auditeventdispatcher.h"
+
+#include <chrono>
+
+#include <zeek/iaudispconsumer.h>
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief Provides the audisp_pipeline table, with the depth and throughput
+///        of each stage of the Audisp event pipeline
+class AudispPipelineTablePlugin final : public IVirtualTable {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param audisp_consumer The consumer whose pipeline is presented
+  /// \param event_dispatcher The dispatcher that delivers the events to the
+  ///                         tables, presented as the last stage
+  /// \return A Status object
+  static Status create(Ref &obj, const IAudispConsumer &audisp_consumer,
+                       const AuditEventDispatcher &event_dispatcher);
+
+  /// \brief Destructor
+  virtual ~AudispPipelineTablePlugin() override;
+
+  /// \return The table name
+  virtual const std::string &name() const override;
+
+  /// \return The table schema
+  virtual const Schema &schema() const override;
+
+  /// \brief Generates one row for each pipeline stage
+  /// \param row_list Where the generated rows are stored
+  /// \return A Status object
+  virtual Status generateRowList(RowList &row_list) override;
+
+  /// \brief Generates a single row from the given stage metrics
+  /// \param row Where the generated row is stored
+  /// \param metrics The current stage metrics
+  /// \param previous_processed_count The processed count at the previous
+  ///                                 query, used for the throughput
+  /// \param elapsed_time The time since the previous query
+  /// \return A Status object
+  static Status
+  generateRow(Row &row, const IAudispConsumer::PipelineStageMetrics &metrics,
+              std::uint64_t previous_processed_count,
+              const std::chrono::milliseconds &elapsed_time);
+
+protected:
+  /// \brief Constructor
+  /// \param audisp_consumer The consumer whose pipeline is presented
+  /// \param event_dispatcher The dispatcher that delivers the events to the
+  ///                         tables
+  AudispPipelineTablePlugin(const IAudispConsumer &audisp_consumer,
+                            const AuditEventDispatcher &event_dispatcher);
+};
+} // namespace zeek
@@ -1,10 +1,17 @@
 #include "audispservice.h"
+#include "auditeventdispatcher.h"
+#include "audispfilterrulestableplugin.h"
+#include "audisppipelinetableplugin.h"
 #include "fileeventstableplugin.h"
 #include "processeventstableplugin.h"
+#include "processtree.h"
+#include "processtreetableplugin.h"
 #include "socketeventstableplugin.h"
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <thread>
 
 #include <zeek/audispservicefactory.h>
 #include <zeek/iaudispconsumer.h>
@@ -13,6 +20,34 @@ namespace zeek {
 namespace {
 const std::string kAudispSocketPath{"/var/run/audispd_events"};
 const std::string kServiceName{"audisp"};
+
+/// \brief How long the table stage waits for new events before checking
+///        whether the service should terminate
+const std::chrono::milliseconds kMaxEventWaitTime{1000};
+
+/// \brief How many processes the process tree keeps track of
+const std::size_t kMaxTrackedProcessCount{32768U};
+
+/// \brief Runs a single pipeline stage until the service terminates or
+///        another stage fails
+/// \param terminate Set to true when the service should terminate
+/// \param stop_pipeline Set to true when any of the stages fails
+/// \param stage The function implementing the stage
+/// \return A Status object
+Status runPipelineStage(std::atomic_bool &terminate,
+                        std::atomic_bool &stop_pipeline,
+                        const std::function<Status()> &stage) {
+
+  while (!terminate && !stop_pipeline) {
+    auto status = stage();
+    if (!status.succeeded()) {
+      stop_pipeline = true;
+      return status;
+    }
+  }
+
+  return Status::success();
+}
 } // namespace
 
 struct AudispService::PrivateData final {
@@ -26,10 +61,16 @@ struct AudispService::PrivateData final {
   IZeekLogger &logger;
 
   zeek::IAudispConsumer::Ref audisp_consumer;
+  ProcessTree::Ref process_tree;
 
   IVirtualTable::Ref process_events_table;
   IVirtualTable::Ref socket_events_table;
   IVirtualTable::Ref file_events_table;
+  IVirtualTable::Ref audisp_pipeline_table;
+  IVirtualTable::Ref audisp_filter_rules_table;
+  IVirtualTable::Ref process_tree_table;
+
+  std::unique_ptr<AuditEventDispatcher> event_dispatcher;
 };
 
 AudispService::~AudispService() {
@@ -43,81 +84,130 @@ AudispService::~AudispService() {
 
   status = d->virtual_database.unregisterTable(d->file_events_table->name());
   assert(status.succeeded() && "Failed to unregister the file_events table");
-}
 
-const std::string &AudispService::name() const { return kServiceName; }
+  status =
+      d->virtual_database.unregisterTable(d->audisp_pipeline_table->name());
 
-Status AudispService::exec(std::atomic_bool &terminate) {
-  auto &process_events_table_impl =
-      *static_cast<ProcessEventsTablePlugin *>(d->process_events_table.get());
+  assert(status.succeeded() &&
+         "Failed to unregister the audisp_pipeline table");
 
-  auto &socket_events_table_impl =
-      *static_cast<SocketEventsTablePlugin *>(d->socket_events_table.get());
+  status =
+      d->virtual_database.unregisterTable(d->audisp_filter_rules_table->name());
 
-  auto &file_events_table_impl =
-      *static_cast<FileEventsTablePlugin *>(d->file_events_table.get());
+  assert(status.succeeded() &&
+         "Failed to unregister the audisp_filter_rules table");
 
-  while (!terminate) {
-    auto status = d->audisp_consumer->processEvents();
-    if (!status.succeeded()) {
-      return status;
-    }
+  status = d->virtual_database.unregisterTable(d->process_tree_table->name());
+  assert(status.succeeded() && "Failed to unregister the process_tree table");
+}
+
+const std::string &AudispService::name() const { return kServiceName; }
 
+Status AudispService::exec(std::atomic_bool &terminate) {
+  // The reader and the parser stages run on their own threads, connected
+  // by lock-free queues; this thread is the table stage. Socket reads are
+  // never held back by row generation
+  std::atomic_bool stop_pipeline{false};
+
+  Status reader_status;
+  std::thread reader_thread([&]() {
+    reader_status = runPipelineStage(terminate, stop_pipeline, [&]() {
+      return d->audisp_consumer->readData();
+    });
+  });
+
+  Status parser_status;
+  std::thread parser_thread([&]() {
+    parser_status = runPipelineStage(terminate, stop_pipeline, [&]() {
+      return d->audisp_consumer->parseData();
+    });
+  });
+
+  while (!terminate && !stop_pipeline) {
     IAudispConsumer::AuditEventList event_list;
     d->audisp_consumer->getEvents(event_list);
 
     if (event_list.empty()) {
+      d->audisp_consumer->waitForEvents(kMaxEventWaitTime);
       continue;
     }
 
-    status = process_events_table_impl.processEvents(event_list);
-    if (!status.succeeded()) {
-      d->logger.logMessage(
-          IZeekLogger::Severity::Error,
-          "The process_events table failed to process some events: " +
-              status.message());
-    }
+    // The process tree sees every event, even when the process_events
+    // table is not being queried. It also records in each event the
+    // parent process image used for the parent_* columns
+    d->process_tree->processEvents(event_list);
+    d->event_dispatcher->dispatch(event_list);
+  }
 
-    status = socket_events_table_impl.processEvents(event_list);
-    if (!status.succeeded()) {
-      d->logger.logMessage(
-          IZeekLogger::Severity::Error,
-          "The socket_events table failed to process some events: " +
-              status.message());
-    }
+  stop_pipeline = true;
+  d->audisp_consumer->interrupt();
 
-    status = file_events_table_impl.processEvents(event_list);
-    if (!status.succeeded()) {
-      d->logger.logMessage(
-          IZeekLogger::Severity::Error,
-          "The file_events table failed to process some events: " +
-              status.message());
-    }
+  reader_thread.join();
+  parser_thread.join();
+
+  if (!reader_status.succeeded()) {
+    return reader_status;
   }
 
-  return Status::success();
+  return parser_status.succeeded() ? Status::success() : parser_status;
 }
 
+void AudispService::interrupt() { d->audisp_consumer->interrupt(); }
+
 AudispService::AudispService(IVirtualDatabase &virtual_database,
                              IZeekConfiguration &configuration,
                              IZeekLogger &logger)
     : d(new PrivateData(virtual_database, configuration, logger)) {
 
-  auto status =
-      zeek::IAudispConsumer::create(d->audisp_consumer, kAudispSocketPath);
+  auto parser = configuration.audispParser() == "native"
+                    ? IAudispConsumer::Parser::Native
+                    : IAudispConsumer::Parser::Auparse;
+
+  auto overflow_policy = configuration.audispOverflowPolicy() == "block"
+                             ? IAudispConsumer::OverflowPolicy::Block
+                             : IAudispConsumer::OverflowPolicy::Drop;
+
+  IAudispConsumer::FilterRuleList filter_rule_list;
+  for (const auto &rule_string : configuration.audispFilterList()) {
+    IAudispConsumer::FilterRule filter_rule;
+    auto status = IAudispConsumer::parseFilterRule(filter_rule, rule_string);
+    if (!status.succeeded()) {
+      throw status;
+    }
+
+    filter_rule_list.push_back(std::move(filter_rule));
+  }
+
+  IAudispConsumer::ExecveLimits execve_limits;
+  execve_limits.max_argument_count =
+      configuration.audispMaxExecveArgumentCount();
+
+  execve_limits.max_command_line_size =
+      configuration.audispMaxExecveCommandLineSize();
+
+  auto status = zeek::IAudispConsumer::create(
+      d->audisp_consumer, kAudispSocketPath, parser, overflow_policy,
+      filter_rule_list, execve_limits);
 
   if (!status.succeeded()) {
     throw status;
   }
 
+  status = ProcessTree::create(d->process_tree, kMaxTrackedProcessCount);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
   status = ProcessEventsTablePlugin::create(d->process_events_table,
                                             configuration, logger);
+
   if (!status.succeeded()) {
     throw status;
   }
 
   status = SocketEventsTablePlugin::create(d->socket_events_table,
                                            configuration, logger);
+
   if (!status.succeeded()) {
     throw status;
   }
@@ -128,6 +218,86 @@ AudispService::AudispService(IVirtualDatabase &virtual_database,
     throw status;
   }
 
+  // Tables that have not been queried for longer than the activity timeout
+  // stop receiving events, until they are queried again. The discarded
+  // events are counted by the dispatcher stage of the audisp_pipeline table
+  d->event_dispatcher = std::make_unique<AuditEventDispatcher>(
+      logger,
+      std::chrono::seconds(configuration.audispTableActivityTimeout()));
+
+  auto &process_events_table_impl =
+      *static_cast<ProcessEventsTablePlugin *>(d->process_events_table.get());
+
+  status = d->event_dispatcher->registerTable(
+      process_events_table_impl.name(),
+      ProcessEventsTablePlugin::syscallTypeList(),
+      [&process_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return process_events_table_impl.processEvents(event_list);
+      },
+      [&process_events_table_impl]() {
+        return process_events_table_impl.lastQueryTime();
+      });
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  auto &socket_events_table_impl =
+      *static_cast<SocketEventsTablePlugin *>(d->socket_events_table.get());
+
+  status = d->event_dispatcher->registerTable(
+      socket_events_table_impl.name(),
+      SocketEventsTablePlugin::syscallTypeList(),
+      [&socket_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return socket_events_table_impl.processEvents(event_list);
+      },
+      [&socket_events_table_impl]() {
+        return socket_events_table_impl.lastQueryTime();
+      });
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  auto &file_events_table_impl =
+      *static_cast<FileEventsTablePlugin *>(d->file_events_table.get());
+
+  status = d->event_dispatcher->registerTable(
+      file_events_table_impl.name(), FileEventsTablePlugin::syscallTypeList(),
+      [&file_events_table_impl](
+          const IAudispConsumer::AuditEventList &event_list) {
+        return file_events_table_impl.processEvents(event_list);
+      },
+      [&file_events_table_impl]() {
+        return file_events_table_impl.lastQueryTime();
+      });
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = AudispPipelineTablePlugin::create(
+      d->audisp_pipeline_table, *d->audisp_consumer, *d->event_dispatcher);
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = AudispFilterRulesTablePlugin::create(d->audisp_filter_rules_table,
+                                                *d->audisp_consumer);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status =
+      ProcessTreeTablePlugin::create(d->process_tree_table, *d->process_tree);
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
   status = d->virtual_database.registerTable(d->process_events_table);
   if (!status.succeeded()) {
     throw status;
@@ -142,6 +312,21 @@ AudispService::AudispService(IVirtualDatabase &virtual_database,
   if (!status.succeeded()) {
     throw status;
   }
+
+  status = d->virtual_database.registerTable(d->audisp_pipeline_table);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = d->virtual_database.registerTable(d->audisp_filter_rules_table);
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = d->virtual_database.registerTable(d->process_tree_table);
+  if (!status.succeeded()) {
+    throw status;
+  }
 }
 
 struct AudispServiceFactory::PrivateData final {
@@ -23,6 +23,9 @@ public:
   /// \return A Status object
   virtual Status exec(std::atomic_bool &terminate) override;
 
+  /// \brief Wakes up the service if it is waiting for Audisp data
+  virtual void interrupt() override;
+
   AudispService(const AudispService &) = delete;
   AudispService &operator=(const AudispService &) = delete;
 
@@ -0,0 +1,125 @@
+#include "auditeventdispatcher.h"
+
+#include <limits>
+
+namespace zeek {
+namespace {
+/// \brief Marks the syscall types that are not owned by any table
+const std::size_t kNoRoute{std::numeric_limits<std::size_t>::max()};
+
+/// \brief Returns the route table slot for the given syscall type
+/// \param syscall_type The syscall type
+/// \return The slot index
+std::size_t
+getRouteIndex(IAudispConsumer::SyscallRecordData::Type syscall_type) {
+  return static_cast<std::size_t>(syscall_type);
+}
+} // namespace
+
+AuditEventDispatcher::AuditEventDispatcher(
+    IZeekLogger &logger_, const std::chrono::seconds &activity_timeout_)
+    : logger(logger_), activity_timeout(activity_timeout_) {}
+
+Status AuditEventDispatcher::registerTable(
+    const std::string &name, const SyscallTypeList &syscall_type_list,
+    EventHandler event_handler, LastQueryTimeGetter last_query_time_getter) {
+
+  auto table_index = table_list.size();
+
+  for (auto syscall_type : syscall_type_list) {
+    auto route_index = getRouteIndex(syscall_type);
+    if (route_index >= route_table.size()) {
+      route_table.resize(route_index + 1U, kNoRoute);
+    }
+
+    if (route_table[route_index] != kNoRoute) {
+      return Status::failure("The " + name +
+                             " table handles a syscall type that is already "
+                             "owned by the " +
+                             table_list.at(route_table[route_index]).name +
+                             " table");
+    }
+  }
+
+  for (auto syscall_type : syscall_type_list) {
+    route_table[getRouteIndex(syscall_type)] = table_index;
+  }
+
+  Table table;
+  table.name = name;
+  table.event_handler = std::move(event_handler);
+  table.last_query_time_getter = std::move(last_query_time_getter);
+
+  table_list.push_back(std::move(table));
+  return Status::success();
+}
+
+void AuditEventDispatcher::dispatch(
+    IAudispConsumer::AuditEventList &event_list) {
+
+  auto current_time = std::chrono::steady_clock::now();
+
+  std::vector<bool> active_table_list(table_list.size(), true);
+  if (activity_timeout.count() != 0) {
+    for (std::size_t i = 0U; i < table_list.size(); ++i) {
+      active_table_list[i] =
+          current_time - table_list[i].last_query_time_getter() <=
+          activity_timeout;
+    }
+  }
+
+  std::uint64_t dispatched_event_count{0U};
+  std::uint64_t discarded_event_count{0U};
+
+  // A single pass over the events, regardless of how many tables there are
+  for (auto &audit_event : event_list) {
+    auto route_index = getRouteIndex(audit_event.syscall_data.type);
+    if (route_index >= route_table.size()) {
+      continue;
+    }
+
+    auto table_index = route_table[route_index];
+    if (table_index == kNoRoute) {
+      continue;
+    }
+
+    if (!active_table_list[table_index]) {
+      ++discarded_event_count;
+      continue;
+    }
+
+    table_list[table_index].event_list.push_back(std::move(audit_event));
+    ++dispatched_event_count;
+  }
+
+  event_list = {};
+
+  processed_count += dispatched_event_count;
+  dropped_count += discarded_event_count;
+
+  for (auto &table : table_list) {
+    if (table.event_list.empty()) {
+      continue;
+    }
+
+    auto status = table.event_handler(table.event_list);
+    if (!status.succeeded()) {
+      logger.logMessage(IZeekLogger::Severity::Error,
+                        "The " + table.name +
+                            " table failed to process some events: " +
+                            status.message());
+    }
+
+    table.event_list.clear();
+  }
+}
+
+void AuditEventDispatcher::getMetrics(
+    IAudispConsumer::PipelineStageMetrics &metrics) const {
+
+  metrics = {};
+  metrics.name = "dispatcher";
+  metrics.processed_count = processed_count;
+  metrics.dropped_count = dropped_count;
+}
+} // namespace zeek
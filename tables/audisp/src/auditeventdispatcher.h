@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <zeek/iaudispconsumer.h>
+#include <zeek/izeeklogger.h>
+
+namespace zeek {
+/// \brief Partitions the Audit events by syscall type, and delivers each
+///        table only the events it owns
+class AuditEventDispatcher final {
+public:
+  /// \brief The syscall types owned by a table
+  using SyscallTypeList = std::vector<IAudispConsumer::SyscallRecordData::Type>;
+
+  /// \brief Processes the events owned by a table
+  using EventHandler =
+      std::function<Status(const IAudispConsumer::AuditEventList &)>;
+
+  /// \brief Returns when a table has been queried for the last time
+  using LastQueryTimeGetter =
+      std::function<std::chrono::steady_clock::time_point()>;
+
+  /// \brief Constructor
+  /// \param logger An initialized logger object
+  /// \param activity_timeout Tables that have not been queried for longer
+  ///                         than this do not receive any event; zero
+  ///                         keeps all the tables active
+  AuditEventDispatcher(IZeekLogger &logger,
+                       const std::chrono::seconds &activity_timeout);
+
+  /// \brief Registers a new table
+  /// \param name The table name, used for logging
+  /// \param syscall_type_list The syscall types owned by the table
+  /// \param event_handler Receives the events owned by the table
+  /// \param last_query_time_getter Used to skip the idle tables
+  /// \return A Status object
+  Status registerTable(const std::string &name,
+                       const SyscallTypeList &syscall_type_list,
+                       EventHandler event_handler,
+                       LastQueryTimeGetter last_query_time_getter);
+
+  /// \brief Delivers the given events to the tables that own them. The
+  ///        events are moved out of the list
+  /// \param event_list The events to dispatch
+  void dispatch(IAudispConsumer::AuditEventList &event_list);
+
+  /// \brief Returns the metrics of the dispatcher, presented as an
+  ///        additional pipeline stage. Thread safe
+  /// \param metrics Where the metrics are stored; the dropped count is
+  ///                the amount of events discarded because their table
+  ///                was not active
+  void getMetrics(IAudispConsumer::PipelineStageMetrics &metrics) const;
+
+  AuditEventDispatcher(const AuditEventDispatcher &) = delete;
+  AuditEventDispatcher &operator=(const AuditEventDispatcher &) = delete;
+
+private:
+  /// \brief A registered table
+  struct Table final {
+    /// \brief The table name
+    std::string name;
+
+    /// \brief Receives the events owned by the table
+    EventHandler event_handler;
+
+    /// \brief Used to skip the idle tables
+    LastQueryTimeGetter last_query_time_getter;
+
+    /// \brief The events collected during the current dispatch
+    IAudispConsumer::AuditEventList event_list;
+  };
+
+  /// \brief A logger object
+  IZeekLogger &logger;
+
+  /// \brief Tables that have not been queried for longer than this do not
+  ///        receive any event; zero keeps all the tables active
+  std::chrono::seconds activity_timeout;
+
+  /// \brief How many events have been delivered to the tables
+  std::atomic<std::uint64_t> processed_count{0U};
+
+  /// \brief How many events have been discarded because their table was
+  ///        not active
+  std::atomic<std::uint64_t> dropped_count{0U};
+
+  /// \brief The registered tables
+  std::vector<Table> table_list;
+
+  /// \brief Maps each syscall type to the index of the table that owns it
+  std::vector<std::size_t> route_table;
+};
+} // namespace zeek
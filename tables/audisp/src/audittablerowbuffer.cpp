@@ -0,0 +1,192 @@
+#include "audittablerowbuffer.h"
+
+#include <iterator>
+
+#include <zeek/mpscbatchqueue.h>
+
+namespace zeek {
+struct AuditTableRowBuffer::PrivateData final {
+  PrivateData(IZeekLogger &logger_) : logger(logger_) {}
+
+  /// \brief Samples the given rows, logging when sampling starts or stops
+  /// \param row_list The rows to sample
+  /// \param serial_list The event serial number of each row
+  void sampleRows(IVirtualTable::RowList &row_list,
+                  const AdaptiveSampler::SerialList &serial_list);
+
+  /// \brief Drops the rows that do not fit within max_queued_row_count
+  /// \param row_list The rows to trim
+  /// \param queued_row_count How many rows are already queued
+  void dropExcessRows(IVirtualTable::RowList &row_list,
+                      std::size_t queued_row_count);
+
+  IZeekLogger &logger;
+  std::string table_name;
+  std::size_t max_queued_row_count{0U};
+
+  MPSCBatchQueue<IVirtualTable::Row> row_queue;
+  RowCoalescer::Ref row_coalescer;
+  AdaptiveSampler::Ref adaptive_sampler;
+};
+
+void AuditTableRowBuffer::PrivateData::dropExcessRows(
+    IVirtualTable::RowList &row_list, std::size_t queued_row_count) {
+
+  auto available_row_count = queued_row_count < max_queued_row_count
+                                 ? max_queued_row_count - queued_row_count
+                                 : 0U;
+
+  if (row_list.size() <= available_row_count) {
+    return;
+  }
+
+  auto rows_to_remove = row_list.size() - available_row_count;
+
+  logger.logMessage(IZeekLogger::Severity::Warning,
+                    table_name + ": Dropping " +
+                        std::to_string(rows_to_remove) +
+                        " rows (max row count is set to " +
+                        std::to_string(max_queued_row_count) + ")");
+
+  row_list.resize(available_row_count);
+}
+
+void AuditTableRowBuffer::PrivateData::sampleRows(
+    IVirtualTable::RowList &row_list,
+    const AdaptiveSampler::SerialList &serial_list) {
+
+  auto previous_sample_weight = adaptive_sampler->sampleWeight();
+  adaptive_sampler->processRows(row_list, serial_list, row_queue.size());
+
+  auto sample_weight = adaptive_sampler->sampleWeight();
+  if (previous_sample_weight == 1 && sample_weight != 1) {
+    logger.logMessage(IZeekLogger::Severity::Warning,
+                      table_name + ": Queue usage is high, keeping 1 row "
+                                   "out of " +
+                          std::to_string(sample_weight));
+
+  } else if (previous_sample_weight != 1 && sample_weight == 1) {
+    logger.logMessage(IZeekLogger::Severity::Information,
+                      table_name + ": Queue usage is back to normal, "
+                                   "capturing all rows");
+  }
+}
+
+Status AuditTableRowBuffer::getConfiguration(
+    Configuration &buffer_configuration,
+    const IZeekConfiguration &configuration, const std::string &table_name,
+    const IVirtualTable::Schema &schema) {
+
+  buffer_configuration = {};
+  buffer_configuration.max_queued_row_count =
+      configuration.maxQueuedRowCount();
+
+  buffer_configuration.sampling_threshold =
+      configuration.audispSamplingThreshold();
+
+  auto coalescing_window = configuration.audispCoalescingWindow();
+  if (coalescing_window == 0U) {
+    return Status::success();
+  }
+
+  buffer_configuration.coalescing_window =
+      std::chrono::seconds(coalescing_window);
+
+  return RowCoalescer::getKeyColumnList(
+      buffer_configuration.coalescing_key_column_list,
+      configuration.audispCoalescingKeyList(), table_name, schema);
+}
+
+Status AuditTableRowBuffer::create(Ref &obj, IZeekLogger &logger,
+                                   const std::string &table_name,
+                                   const Configuration &configuration) {
+  try {
+    obj.reset(new AuditTableRowBuffer(logger, table_name, configuration));
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+AuditTableRowBuffer::~AuditTableRowBuffer() {}
+
+void AuditTableRowBuffer::initializeRow(IVirtualTable::Row &row) {
+  RowCoalescer::initializeRow(row);
+  AdaptiveSampler::initializeRow(row);
+}
+
+void AuditTableRowBuffer::pushRows(
+    IVirtualTable::RowList row_list,
+    const AdaptiveSampler::SerialList &serial_list) {
+
+  if (d->adaptive_sampler) {
+    d->sampleRows(row_list, serial_list);
+  }
+
+  if (d->row_coalescer) {
+    IVirtualTable::RowList released_row_list;
+    d->row_coalescer->processRows(released_row_list, std::move(row_list),
+                                  RowCoalescer::currentTime());
+
+    row_list = std::move(released_row_list);
+  }
+
+  // The queue can only be trimmed by its consumer, so the rows that do
+  // not fit are dropped before being queued
+  d->dropExcessRows(row_list, d->row_queue.size());
+
+  d->row_queue.pushBatch(std::move(row_list));
+}
+
+void AuditTableRowBuffer::takeRows(IVirtualTable::RowList &row_list) {
+  d->row_queue.takeAll(row_list);
+
+  // Coalesced rows are released when their window closes, even if no new
+  // event has been received since then
+  if (d->row_coalescer) {
+    IVirtualTable::RowList expired_row_list;
+    d->row_coalescer->takeExpiredRows(expired_row_list,
+                                      RowCoalescer::currentTime());
+
+    d->dropExcessRows(expired_row_list, row_list.size());
+
+    row_list.insert(row_list.end(),
+                    std::make_move_iterator(expired_row_list.begin()),
+                    std::make_move_iterator(expired_row_list.end()));
+  }
+}
+
+AuditTableRowBuffer::AuditTableRowBuffer(IZeekLogger &logger,
+                                         const std::string &table_name,
+                                         const Configuration &configuration)
+    : d(new PrivateData(logger)) {
+
+  d->table_name = table_name;
+  d->max_queued_row_count = configuration.max_queued_row_count;
+
+  if (configuration.coalescing_window.count() != 0) {
+    auto status = RowCoalescer::create(
+        d->row_coalescer, configuration.coalescing_window,
+        configuration.coalescing_key_column_list, d->max_queued_row_count);
+
+    if (!status.succeeded()) {
+      throw status;
+    }
+  }
+
+  if (configuration.sampling_threshold != 0U) {
+    auto status =
+        AdaptiveSampler::create(d->adaptive_sampler, table_name,
+                                d->max_queued_row_count,
+                                configuration.sampling_threshold);
+
+    if (!status.succeeded()) {
+      throw status;
+    }
+  }
+}
+} // namespace zeek
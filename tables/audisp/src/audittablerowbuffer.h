@@ -0,0 +1,98 @@
+#pragma once
+
+#include "adaptivesampler.h"
+#include "rowcoalescer.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <zeek/ivirtualtable.h>
+#include <zeek/izeekconfiguration.h>
+#include <zeek/izeeklogger.h>
+
+namespace zeek {
+/// \brief Holds the rows generated by an audisp table until it is queried.
+///        New rows are sampled and coalesced when enabled, and the rows that
+///        do not fit within max_queued_row_count are dropped with a warning
+class AuditTableRowBuffer final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to an AuditTableRowBuffer object
+  using Ref = std::unique_ptr<AuditTableRowBuffer>;
+
+  /// \brief Buffer settings
+  struct Configuration final {
+    /// \brief How many rows can be queued at most
+    std::size_t max_queued_row_count{0U};
+
+    /// \brief How long identical rows are folded together; zero disables
+    ///        coalescing
+    std::chrono::seconds coalescing_window{0};
+
+    /// \brief The columns compared to find identical rows
+    RowCoalescer::KeyColumnList coalescing_key_column_list;
+
+    /// \brief Queue usage percentage that starts sampling; zero disables
+    ///        sampling
+    std::uint32_t sampling_threshold{0U};
+  };
+
+  /// \brief Reads the buffer settings of the given table
+  /// \param buffer_configuration Where the settings are stored
+  /// \param configuration An initialized configuration object
+  /// \param table_name The table name
+  /// \param schema The table schema, used to validate the coalescing keys
+  /// \return A Status object
+  static Status getConfiguration(Configuration &buffer_configuration,
+                                 const IZeekConfiguration &configuration,
+                                 const std::string &table_name,
+                                 const IVirtualTable::Schema &schema);
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param logger An initialized logger object
+  /// \param table_name The table name, used in the log messages
+  /// \param configuration The buffer settings
+  /// \return A Status object
+  static Status create(Ref &obj, IZeekLogger &logger,
+                       const std::string &table_name,
+                       const Configuration &configuration);
+
+  /// \brief Destructor
+  ~AuditTableRowBuffer();
+
+  /// \brief Sets the columns maintained by the buffer to their initial
+  ///        values. Call this on every new row before pushing it
+  /// \param row The row to update
+  static void initializeRow(IVirtualTable::Row &row);
+
+  /// \brief Samples, coalesces and queues the given rows. Rows that do not
+  ///        fit in the queue are dropped. Only one thread at a time should
+  ///        call this method
+  /// \param row_list The new rows, initialized with initializeRow()
+  /// \param serial_list The serial number of the audit event behind each
+  ///        row, used to select the rows when sampling
+  void pushRows(IVirtualTable::RowList row_list,
+                const AdaptiveSampler::SerialList &serial_list);
+
+  /// \brief Takes the queued rows, followed by the coalesced rows whose
+  ///        window has closed. The latter are subject to the same limit
+  ///        as the queued rows
+  /// \param row_list Where the rows are stored
+  void takeRows(IVirtualTable::RowList &row_list);
+
+  AuditTableRowBuffer(const AuditTableRowBuffer &) = delete;
+  AuditTableRowBuffer &operator=(const AuditTableRowBuffer &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param logger An initialized logger object
+  /// \param table_name The table name, used in the log messages
+  /// \param configuration The buffer settings
+  AuditTableRowBuffer(IZeekLogger &logger, const std::string &table_name,
+                      const Configuration &configuration);
+};
+} // namespace zeek
@@ -1,20 +1,25 @@
 #include "fileeventstableplugin.h"
+#include "audittablerowbuffer.h"
 
+#include <atomic>
 #include <chrono>
-#include <filesystem>
-#include <mutex>
 
 namespace zeek {
+namespace {
+/// \brief How many working directories and paths are cached
+const std::size_t kMaxCachedPathCount{8192U};
+} // namespace
+
 struct FileEventsTablePlugin::PrivateData final {
-  PrivateData(IZeekConfiguration &configuration_, IZeekLogger &logger_)
-      : configuration(configuration_), logger(logger_) {}
+  PrivateData(IZeekLogger &logger_) : logger(logger_) {}
 
-  IZeekConfiguration &configuration;
   IZeekLogger &logger;
 
-  RowList row_list;
-  std::mutex row_list_mutex;
-  std::size_t max_queued_row_count{0U};
+  // Only used by the table stage
+  PathNormalizer::Ref path_normalizer;
+
+  AuditTableRowBuffer::Ref row_buffer;
+  std::atomic<std::chrono::steady_clock::time_point> last_query_time;
 };
 
 Status FileEventsTablePlugin::create(Ref &obj,
@@ -55,96 +60,105 @@ const FileEventsTablePlugin::Schema &FileEventsTablePlugin::schema() const {
       {"exe", IVirtualTable::ColumnType::String},
       {"path", IVirtualTable::ColumnType::String},
       {"inode", IVirtualTable::ColumnType::Integer},
-      {"time", IVirtualTable::ColumnType::Integer}};
+      {"time", IVirtualTable::ColumnType::Integer},
+
+      // How many identical events have been folded into the row
+      {"count", IVirtualTable::ColumnType::Integer},
+      {"first_time", IVirtualTable::ColumnType::Integer},
+      {"last_time", IVirtualTable::ColumnType::Integer},
+
+      // How many events the row stands for when the table is sampling
+      {"sample_weight", IVirtualTable::ColumnType::Integer},
+
+      // Taken from the process tree
+      {"parent_exe", IVirtualTable::ColumnType::String},
+      {"parent_cmdline", IVirtualTable::ColumnType::String}};
 
   return kTableSchema;
 }
 
 Status FileEventsTablePlugin::generateRowList(RowList &row_list) {
-  std::lock_guard<std::mutex> lock(d->row_list_mutex);
-
-  row_list = std::move(d->row_list);
-  d->row_list = {};
+  d->last_query_time = std::chrono::steady_clock::now();
 
+  d->row_buffer->takeRows(row_list);
   return Status::success();
 }
 
 Status FileEventsTablePlugin::processEvents(
     const IAudispConsumer::AuditEventList &event_list) {
   RowList generated_row_list;
+  AdaptiveSampler::SerialList serial_list;
+  auto status = Status::success();
 
   for (const auto &audit_event : event_list) {
     Row row;
 
-    auto status = generateRow(row, audit_event);
+    status = generateRow(row, audit_event, *d->path_normalizer);
     if (!status.succeeded()) {
-      return status;
+      break;
     }
 
     if (!row.empty()) {
-      {
-        std::lock_guard<std::mutex> lock(d->row_list_mutex);
-        d->row_list.push_back(row);
-      }
-    }
-  }
+      ProcessTree::addParentColumns(row, audit_event);
 
-  if (d->row_list.size() > d->max_queued_row_count) {
+      AuditTableRowBuffer::initializeRow(row);
 
-    std::lock_guard<std::mutex> lock(d->row_list_mutex);
+      generated_row_list.push_back(std::move(row));
+      serial_list.push_back(audit_event.serial);
+    }
+  }
 
-    if (d->row_list.size() > d->max_queued_row_count) {
-      auto rows_to_remove = d->row_list.size() - d->max_queued_row_count;
+  d->row_buffer->pushRows(std::move(generated_row_list), serial_list);
+  return status;
+}
 
-      d->logger.logMessage(IZeekLogger::Severity::Warning,
-                           "file_events: Dropping " +
-                               std::to_string(rows_to_remove) +
-                               " rows (max row count is set to " +
-                               std::to_string(d->max_queued_row_count) + ")");
+std::chrono::steady_clock::time_point
+FileEventsTablePlugin::lastQueryTime() const {
+  return d->last_query_time;
+}
 
-      d->row_list.erase(d->row_list.begin(),
-                        std::next(d->row_list.begin(), rows_to_remove));
-    }
-  }
+const AuditEventDispatcher::SyscallTypeList &
+FileEventsTablePlugin::syscallTypeList() {
+  static const AuditEventDispatcher::SyscallTypeList kSyscallTypeList = {
+      IAudispConsumer::SyscallRecordData::Type::Open,
+      IAudispConsumer::SyscallRecordData::Type::OpenAt,
+      IAudispConsumer::SyscallRecordData::Type::Create};
 
-  return Status::success();
+  return kSyscallTypeList;
 }
 
 FileEventsTablePlugin::FileEventsTablePlugin(IZeekConfiguration &configuration,
                                              IZeekLogger &logger)
-    : d(new PrivateData(configuration, logger)) {
+    : d(new PrivateData(logger)) {
 
-  d->max_queued_row_count = d->configuration.maxQueuedRowCount();
-}
+  auto status = PathNormalizer::create(d->path_normalizer, kMaxCachedPathCount);
+  if (!status.succeeded()) {
+    throw status;
+  }
 
-std::string FileEventsTablePlugin::CombinePaths(const std::string &cwd,
-                                                const std::string &path) {
-  std::string full_path;
+  AuditTableRowBuffer::Configuration buffer_configuration;
+  status = AuditTableRowBuffer::getConfiguration(
+      buffer_configuration, configuration, name(), schema());
 
-  // Quotes are only present when path contain space
-  if (path[0] == '"') {
-    full_path = path.substr(1, path.size() - 2);
-  } else {
-    full_path = path;
+  if (!status.succeeded()) {
+    throw status;
   }
 
-  // Use cwd when path is not absolute
-  if (full_path[0] != '/') {
-    std::string normalized_cwd;
+  status = AuditTableRowBuffer::create(d->row_buffer, logger, name(),
+                                       buffer_configuration);
 
-    if (cwd[0] == '"') {
-      normalized_cwd = cwd.substr(1, cwd.size() - 2);
-    } else {
-      normalized_cwd = cwd;
-    }
-
-    full_path = std::filesystem::path(normalized_cwd) / full_path;
+  if (!status.succeeded()) {
+    throw status;
   }
-  return full_path;
+
+  // New tables are considered active, so that the first query after the
+  // agent has started returns the events collected so far
+  d->last_query_time = std::chrono::steady_clock::now();
 }
 
 Status FileEventsTablePlugin::generateRow(
-    Row &row, const IAudispConsumer::AuditEvent &audit_event) {
+    Row &row, const IAudispConsumer::AuditEvent &audit_event,
+    PathNormalizer &path_normalizer) {
   row = {};
 
   std::string syscall_name;
@@ -165,8 +179,8 @@ Status FileEventsTablePlugin::generateRow(
     else
       syscall_name = "openat";
 
-    std::string working_dir_path;
-    std::string file_path;
+    std::string_view working_dir_path;
+    std::string_view file_path;
     const auto &path_record = audit_event.path_data.value();
     const auto &cwd_record = audit_event.cwd_data.value();
 
@@ -189,7 +203,7 @@ Status FileEventsTablePlugin::generateRow(
       return Status::failure(
           "Wrong number of path records for open/openat syscall event");
     }
-    full_path = CombinePaths(working_dir_path, file_path);
+    full_path = path_normalizer.resolve(working_dir_path, file_path);
     break;
   }
   case IAudispConsumer::SyscallRecordData::Type::Create: {
@@ -202,9 +216,8 @@ Status FileEventsTablePlugin::generateRow(
       return Status::failure(
           "Wrong number of path records for create syscall event");
     }
-    std::string working_dir_path = path_record.at(0).path;
-    std::string file_path = path_record.at(1).path;
-    full_path = CombinePaths(working_dir_path, file_path);
+    full_path = path_normalizer.resolve(path_record.at(0).path,
+                                        path_record.at(1).path);
     inode = path_record.at(1).inode;
     break;
   }
@@ -215,6 +228,7 @@ Status FileEventsTablePlugin::generateRow(
   case IAudispConsumer::SyscallRecordData::Type::Clone:
   case IAudispConsumer::SyscallRecordData::Type::Bind:
   case IAudispConsumer::SyscallRecordData::Type::Connect:
+  case IAudispConsumer::SyscallRecordData::Type::Exit:
     return Status::success();
   }
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "auditeventdispatcher.h"
+#include "pathnormalizer.h"
+#include "processtree.h"
+
 #include <memory>
 #include <string>
 #include <zeek/iaudispconsumer.h>
@@ -43,23 +47,25 @@ public:
   /// \return A Status object
   Status processEvents(const IAudispConsumer::AuditEventList &event_list);
 
+  /// \return When the table has been queried for the last time
+  std::chrono::steady_clock::time_point lastQueryTime() const;
+
+  /// \return The syscall types whose events are presented by this table
+  static const AuditEventDispatcher::SyscallTypeList &syscallTypeList();
+
   /// \brief Generates a single row from the given Audit event
   /// \param row Where the generated row is stored
   /// \param audit_event a single Audit event
+  /// \param path_normalizer Used to build the path column
   /// \return A Status object
   static Status generateRow(Row &row,
-                            const IAudispConsumer::AuditEvent &audit_event);
+                            const IAudispConsumer::AuditEvent &audit_event,
+                            PathNormalizer &path_normalizer);
 
 protected:
   /// \brief Constructor
   /// \param configuration An initialized configuration object
   /// \param logger An initialized logger object
   FileEventsTablePlugin(IZeekConfiguration &configuration, IZeekLogger &logger);
-
-  /// \brief Combines working directory with file path
-  /// \param cwd current directory path
-  /// \param path file path
-  static std::string CombinePaths(const std::string &cwd,
-                                  const std::string &path);
 };
 } // namespace zeek
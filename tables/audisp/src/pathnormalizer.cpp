@@ -0,0 +1,160 @@
+#include "pathnormalizer.h"
+
+#include <unordered_map>
+
+namespace zeek {
+struct PathNormalizer::PrivateData final {
+  std::size_t max_cache_size{0U};
+
+  // Working directory, as received -> normalized working directory
+  std::unordered_map<std::string, std::string> directory_cache;
+
+  // Path (followed by the working directory when relative) -> normalized
+  // path. The values are the interned paths returned by resolve()
+  std::unordered_map<std::string, std::string> path_cache;
+
+  // Reused for the cache lookups, so that a cache hit does not allocate
+  std::string key_buffer;
+};
+
+Status PathNormalizer::create(Ref &obj, std::size_t max_cache_size) {
+  try {
+    obj.reset(new PathNormalizer(max_cache_size));
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+PathNormalizer::~PathNormalizer() {}
+
+const std::string &PathNormalizer::resolve(std::string_view cwd,
+                                           std::string_view path) {
+  path = stripQuotes(path);
+  bool is_relative_path = path.empty() || path.front() != '/';
+
+  auto &key = d->key_buffer;
+  key.assign(path.data(), path.size());
+
+  if (is_relative_path) {
+    key.push_back('\0');
+    key.append(cwd.data(), cwd.size());
+  }
+
+  auto path_it = d->path_cache.find(key);
+  if (path_it != d->path_cache.end()) {
+    return path_it->second;
+  }
+
+  std::string normalized_path;
+
+  if (is_relative_path) {
+    key.assign(cwd.data(), cwd.size());
+
+    auto directory_it = d->directory_cache.find(key);
+    if (directory_it == d->directory_cache.end()) {
+      if (d->directory_cache.size() >= d->max_cache_size) {
+        d->directory_cache.clear();
+      }
+
+      std::string normalized_directory;
+      appendPath(normalized_directory, stripQuotes(cwd));
+
+      directory_it =
+          d->directory_cache.emplace(key, std::move(normalized_directory))
+              .first;
+    }
+
+    normalized_path = directory_it->second;
+
+    // Restore the path cache key
+    key.assign(path.data(), path.size());
+    key.push_back('\0');
+    key.append(cwd.data(), cwd.size());
+  }
+
+  appendPath(normalized_path, path);
+
+  if (d->path_cache.size() >= d->max_cache_size) {
+    d->path_cache.clear();
+  }
+
+  return d->path_cache.emplace(key, std::move(normalized_path)).first->second;
+}
+
+void PathNormalizer::appendPath(std::string &output, std::string_view path) {
+  if (output.empty() && !path.empty() && path.front() == '/') {
+    output.push_back('/');
+  }
+
+  std::size_t component_start{0U};
+
+  while (component_start < path.size()) {
+    auto component_end = path.find('/', component_start);
+    if (component_end == std::string_view::npos) {
+      component_end = path.size();
+    }
+
+    auto component =
+        path.substr(component_start, component_end - component_start);
+
+    component_start = component_end + 1U;
+
+    if (component.empty() || component == ".") {
+      continue;
+    }
+
+    if (component == "..") {
+      // The parent of the root folder is the root folder itself
+      if (output == "/") {
+        continue;
+      }
+
+      auto separator_index = output.rfind('/');
+      auto last_component = separator_index == std::string::npos
+                                ? std::string_view(output)
+                                : std::string_view(output).substr(
+                                      separator_index + 1U);
+
+      // Relative paths can't be resolved past their first component
+      if (!output.empty() && last_component != "..") {
+        if (separator_index == std::string::npos) {
+          output.clear();
+        } else {
+          output.resize(separator_index == 0U ? 1U : separator_index);
+        }
+
+        continue;
+      }
+    }
+
+    if (!output.empty() && output.back() != '/') {
+      output.push_back('/');
+    }
+
+    output.append(component.data(), component.size());
+  }
+}
+
+std::string_view PathNormalizer::stripQuotes(std::string_view value) {
+  if (value.size() >= 2U && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1U, value.size() - 2U);
+  }
+
+  return value;
+}
+
+PathNormalizer::PathNormalizer(std::size_t max_cache_size)
+    : d(new PrivateData) {
+
+  if (max_cache_size == 0U) {
+    throw Status::failure("The cache size must be greater than 0");
+  }
+
+  d->max_cache_size = max_cache_size;
+}
+} // namespace zeek
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <zeek/status.h>
+
+namespace zeek {
+/// \brief Builds the normalized paths presented by the file_events table.
+///        The "." and ".." components are resolved lexically, without
+///        accessing the filesystem. Since most events share a small set of
+///        working directories and files, both the normalized working
+///        directories and the resulting paths are cached
+class PathNormalizer final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to a PathNormalizer object
+  using Ref = std::unique_ptr<PathNormalizer>;
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param max_cache_size How many entries each cache can hold before it
+  ///        is emptied
+  /// \return A Status object
+  static Status create(Ref &obj, std::size_t max_cache_size);
+
+  /// \brief Destructor
+  ~PathNormalizer();
+
+  /// \brief Returns the normalized path of a file
+  /// \param cwd The directory used when the path is relative
+  /// \param path The file path, optionally enclosed in quotes
+  /// \return The normalized path; the reference is valid until the next
+  ///         call
+  const std::string &resolve(std::string_view cwd, std::string_view path);
+
+  /// \brief Appends the given path to a normalized path, resolving the "."
+  ///        and ".." components and removing duplicated separators
+  /// \param output A normalized path, or an empty string
+  /// \param path The path to append
+  static void appendPath(std::string &output, std::string_view path);
+
+  /// \brief Removes the quotes that Audit adds around some values
+  /// \param value The value to unquote
+  /// \return The value without the enclosing quotes
+  static std::string_view stripQuotes(std::string_view value);
+
+  PathNormalizer(const PathNormalizer &) = delete;
+  PathNormalizer &operator=(const PathNormalizer &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param max_cache_size How many entries each cache can hold
+  PathNormalizer(std::size_t max_cache_size);
+};
+} // namespace zeek
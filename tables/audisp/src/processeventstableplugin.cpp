@@ -1,19 +1,17 @@
 #include "processeventstableplugin.h"
+#include "audittablerowbuffer.h"
 
+#include <atomic>
 #include <chrono>
-#include <mutex>
 
 namespace zeek {
 struct ProcessEventsTablePlugin::PrivateData final {
-  PrivateData(IZeekConfiguration &configuration_, IZeekLogger &logger_)
-      : configuration(configuration_), logger(logger_) {}
+  PrivateData(IZeekLogger &logger_) : logger(logger_) {}
 
-  IZeekConfiguration &configuration;
   IZeekLogger &logger;
 
-  RowList row_list;
-  std::mutex row_list_mutex;
-  std::size_t max_queued_row_count{0U};
+  AuditTableRowBuffer::Ref row_buffer;
+  std::atomic<std::chrono::steady_clock::time_point> last_query_time;
 };
 
 Status ProcessEventsTablePlugin::create(Ref &obj,
@@ -59,6 +57,7 @@ ProcessEventsTablePlugin::schema() const {
 
       // Present in the AUDIT_EXECVE record(s)
       {"cmdline", IVirtualTable::ColumnType::String},
+      {"cmdline_truncated", IVirtualTable::ColumnType::Integer},
 
       // Present in the AUDIT_PATH record(s)
       {"path", IVirtualTable::ColumnType::String},
@@ -71,66 +70,97 @@ ProcessEventsTablePlugin::schema() const {
       {"cwd", IVirtualTable::ColumnType::String},
 
       // Custom
-      {"time", IVirtualTable::ColumnType::Integer}};
+      {"time", IVirtualTable::ColumnType::Integer},
+
+      // How many identical events have been folded into the row
+      {"count", IVirtualTable::ColumnType::Integer},
+      {"first_time", IVirtualTable::ColumnType::Integer},
+      {"last_time", IVirtualTable::ColumnType::Integer},
+
+      // How many events the row stands for when the table is sampling
+      {"sample_weight", IVirtualTable::ColumnType::Integer},
+
+      // Taken from the process tree
+      {"parent_exe", IVirtualTable::ColumnType::String},
+      {"parent_cmdline", IVirtualTable::ColumnType::String}};
 
   return kTableSchema;
 }
 
 Status ProcessEventsTablePlugin::generateRowList(RowList &row_list) {
-  std::lock_guard<std::mutex> lock(d->row_list_mutex);
-
-  row_list = std::move(d->row_list);
-  d->row_list = {};
+  d->last_query_time = std::chrono::steady_clock::now();
 
+  d->row_buffer->takeRows(row_list);
   return Status::success();
 }
 
 Status ProcessEventsTablePlugin::processEvents(
     const IAudispConsumer::AuditEventList &event_list) {
   RowList generated_row_list;
+  AdaptiveSampler::SerialList serial_list;
+  auto status = Status::success();
 
   for (const auto &audit_event : event_list) {
     Row row;
 
-    auto status = generateRow(row, audit_event);
+    status = generateRow(row, audit_event);
     if (!status.succeeded()) {
-      return status;
+      break;
     }
 
     if (!row.empty()) {
-      {
-        std::lock_guard<std::mutex> lock(d->row_list_mutex);
-        d->row_list.push_back(row);
-      }
-    }
-  }
+      ProcessTree::addParentColumns(row, audit_event);
 
-  if (d->row_list.size() > d->max_queued_row_count) {
+      AuditTableRowBuffer::initializeRow(row);
 
-    std::lock_guard<std::mutex> lock(d->row_list_mutex);
+      generated_row_list.push_back(std::move(row));
+      serial_list.push_back(audit_event.serial);
+    }
+  }
 
-    if (d->row_list.size() > d->max_queued_row_count) {
-      auto rows_to_remove = d->row_list.size() - d->max_queued_row_count;
+  d->row_buffer->pushRows(std::move(generated_row_list), serial_list);
+  return status;
+}
 
-      d->logger.logMessage(IZeekLogger::Severity::Warning,
-                           "process_events: Dropping " +
-                               std::to_string(rows_to_remove) +
-                               " rows (max row count is set to " +
-                               std::to_string(d->max_queued_row_count) + ")");
+std::chrono::steady_clock::time_point
+ProcessEventsTablePlugin::lastQueryTime() const {
+  return d->last_query_time;
+}
 
-      d->row_list.erase(d->row_list.begin(),
-                        std::next(d->row_list.begin(), rows_to_remove));
-    }
-  }
+const AuditEventDispatcher::SyscallTypeList &
+ProcessEventsTablePlugin::syscallTypeList() {
+  static const AuditEventDispatcher::SyscallTypeList kSyscallTypeList = {
+      IAudispConsumer::SyscallRecordData::Type::Execve,
+      IAudispConsumer::SyscallRecordData::Type::ExecveAt,
+      IAudispConsumer::SyscallRecordData::Type::Fork,
+      IAudispConsumer::SyscallRecordData::Type::VFork,
+      IAudispConsumer::SyscallRecordData::Type::Clone};
 
-  return Status::success();
+  return kSyscallTypeList;
 }
 
 ProcessEventsTablePlugin::ProcessEventsTablePlugin(
     IZeekConfiguration &configuration, IZeekLogger &logger)
-    : d(new PrivateData(configuration, logger)) {
+    : d(new PrivateData(logger)) {
+
+  AuditTableRowBuffer::Configuration buffer_configuration;
+  auto status = AuditTableRowBuffer::getConfiguration(
+      buffer_configuration, configuration, name(), schema());
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = AuditTableRowBuffer::create(d->row_buffer, logger, name(),
+                                       buffer_configuration);
 
-  d->max_queued_row_count = d->configuration.maxQueuedRowCount();
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  // New tables are considered active, so that the first query after the
+  // agent has started returns the events collected so far
+  d->last_query_time = std::chrono::steady_clock::now();
 }
 
 Status ProcessEventsTablePlugin::generateRow(
@@ -169,6 +199,7 @@ Status ProcessEventsTablePlugin::generateRow(
   case IAudispConsumer::SyscallRecordData::Type::Open:
   case IAudispConsumer::SyscallRecordData::Type::OpenAt:
   case IAudispConsumer::SyscallRecordData::Type::Create:
+  case IAudispConsumer::SyscallRecordData::Type::Exit:
     return Status::success();
   }
 
@@ -208,16 +239,10 @@ Status ProcessEventsTablePlugin::generateRow(
     }
 
     const auto &execve_data = audit_event.execve_data.value();
-    std::string command_line;
-    for (const auto &parameter : execve_data.argument_list) {
-      if (!command_line.empty()) {
-        command_line.push_back(' ');
-      }
-
-      command_line += "\"" + parameter + "\"";
-    }
-
-    row["cmdline"] = command_line;
+    row["cmdline"] =
+        ProcessTree::generateCommandLine(execve_data.argument_list);
+    row["cmdline_truncated"] =
+        static_cast<std::int64_t>(execve_data.truncated ? 1 : 0);
 
     const auto &path_record = audit_event.path_data.value();
     const auto &last_path_entry = path_record.front();
@@ -242,6 +267,7 @@ Status ProcessEventsTablePlugin::generateRow(
     std::int64_t null_value{0};
 
     row["cmdline"] = {""};
+    row["cmdline_truncated"] = {null_value};
     row["path"] = {""};
     row["mode"] = {null_value};
     row["inode"] = {null_value};
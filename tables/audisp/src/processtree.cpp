@@ -0,0 +1,330 @@
+#include "processtree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <sched.h>
+
+namespace zeek {
+namespace {
+/// \brief The process image, replaced at each execve. Child processes
+///        share the image of their parent until they call execve, and the
+///        events share the image of their parent process
+using ProcessImage = IAudispConsumer::ProcessImageData;
+
+/// \brief A tracked process
+struct ProcessEntry final {
+  /// \brief Parent process id
+  std::int64_t parent_process_id{0};
+
+  /// \brief Audit (login) user id
+  std::int64_t auid{0};
+
+  /// \brief User id
+  std::int64_t uid{0};
+
+  /// \brief Group id
+  std::int64_t gid{0};
+
+  /// \brief When the process has been last updated
+  std::int64_t time{0};
+
+  /// \brief The process image; never null
+  std::shared_ptr<const ProcessImage> image;
+
+  /// \brief The position of the process in the update order list
+  std::list<std::int64_t>::iterator update_order_it;
+};
+
+/// \brief Copies the ids of the calling process from a SYSCALL record
+/// \param entry The process to update
+/// \param syscall_data The SYSCALL record
+/// \param time The current time, in seconds since the epoch
+void updateProcessIds(ProcessEntry &entry,
+                      const IAudispConsumer::SyscallRecordData &syscall_data,
+                      std::int64_t time) {
+  entry.auid = syscall_data.auid;
+  entry.uid = syscall_data.uid;
+  entry.gid = syscall_data.gid;
+  entry.time = time;
+}
+} // namespace
+
+struct ProcessTree::PrivateData final {
+  /// \brief Returns the given process, creating it if necessary, and marks
+  ///        it as the most recently updated one
+  /// \param process_id The process id
+  /// \return The process entry
+  ProcessEntry &updateProcess(std::int64_t process_id);
+
+  /// \brief Removes the given process, if it is known
+  /// \param process_id The process id
+  void removeProcess(std::int64_t process_id);
+
+  std::size_t max_process_count{0U};
+
+  mutable std::mutex mutex;
+  std::unordered_map<std::int64_t, ProcessEntry> process_map;
+
+  // Most recently updated processes first
+  std::list<std::int64_t> update_order;
+};
+
+Status ProcessTree::create(Ref &obj, std::size_t max_process_count) {
+  try {
+    obj.reset(new ProcessTree(max_process_count));
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+ProcessTree::~ProcessTree() {}
+
+void ProcessTree::processEvents(IAudispConsumer::AuditEventList &event_list) {
+
+  using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+  auto current_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+
+  auto time = static_cast<std::int64_t>(current_timestamp.count());
+
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  for (auto &audit_event : event_list) {
+    const auto &syscall_data = audit_event.syscall_data;
+
+    // The parent is captured before the event is applied, so that the rows
+    // are not affected by what the following events of the batch do (such
+    // as the parent calling execve or exit_group)
+    auto parent_it = d->process_map.find(syscall_data.parent_process_id);
+    if (parent_it != d->process_map.end()) {
+      audit_event.parent_image = parent_it->second.image;
+    } else {
+      audit_event.parent_image.reset();
+    }
+
+    switch (syscall_data.type) {
+    case SyscallType::Execve:
+    case SyscallType::ExecveAt: {
+      if (!syscall_data.succeeded || !audit_event.execve_data.has_value()) {
+        break;
+      }
+
+      auto image = std::make_shared<ProcessImage>();
+      image->exe = syscall_data.exe;
+      image->cmdline =
+          generateCommandLine(audit_event.execve_data->argument_list);
+
+      if (audit_event.cwd_data.has_value()) {
+        image->cwd = audit_event.cwd_data.value();
+      }
+
+      auto &entry = d->updateProcess(syscall_data.process_id);
+      entry.parent_process_id = syscall_data.parent_process_id;
+      entry.image = std::move(image);
+      updateProcessIds(entry, syscall_data, time);
+
+      break;
+    }
+
+    case SyscallType::Fork:
+    case SyscallType::VFork:
+    case SyscallType::Clone: {
+      // The exit code is the id of the new process, as seen by the parent
+      if (!syscall_data.succeeded || syscall_data.exit_code <= 0) {
+        break;
+      }
+
+      // New threads share the process id of their parent
+      if (syscall_data.type == SyscallType::Clone) {
+        auto clone_flags = std::strtoull(syscall_data.a0.c_str(), nullptr, 16);
+        if ((clone_flags & CLONE_THREAD) != 0U) {
+          break;
+        }
+      }
+
+      // The parent may have been started before the agent
+      auto &parent_entry = d->updateProcess(syscall_data.process_id);
+      parent_entry.parent_process_id = syscall_data.parent_process_id;
+      updateProcessIds(parent_entry, syscall_data, time);
+
+      if (!parent_entry.image) {
+        auto image = std::make_shared<ProcessImage>();
+        image->exe = syscall_data.exe;
+
+        parent_entry.image = std::move(image);
+      }
+
+      auto image = parent_entry.image;
+
+      auto &child_entry = d->updateProcess(syscall_data.exit_code);
+      child_entry.parent_process_id = syscall_data.process_id;
+      child_entry.image = std::move(image);
+      updateProcessIds(child_entry, syscall_data, time);
+
+      break;
+    }
+
+    case SyscallType::Exit:
+      d->removeProcess(syscall_data.process_id);
+      break;
+
+    case SyscallType::Bind:
+    case SyscallType::Connect:
+    case SyscallType::Open:
+    case SyscallType::OpenAt:
+    case SyscallType::Create:
+      break;
+    }
+  }
+}
+
+bool ProcessTree::getProcess(Process &process,
+                             std::int64_t process_id) const {
+  process = {};
+
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  auto process_it = d->process_map.find(process_id);
+  if (process_it == d->process_map.end()) {
+    return false;
+  }
+
+  const auto &entry = process_it->second;
+
+  process.process_id = process_id;
+  process.parent_process_id = entry.parent_process_id;
+  process.auid = entry.auid;
+  process.uid = entry.uid;
+  process.gid = entry.gid;
+  process.exe = entry.image->exe;
+  process.cmdline = entry.image->cmdline;
+  process.cwd = entry.image->cwd;
+  process.time = entry.time;
+
+  return true;
+}
+
+void ProcessTree::getProcessList(ProcessList &process_list) const {
+  process_list = {};
+
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    process_list.reserve(d->process_map.size());
+
+    for (const auto &p : d->process_map) {
+      const auto &entry = p.second;
+
+      Process process;
+      process.process_id = p.first;
+      process.parent_process_id = entry.parent_process_id;
+      process.auid = entry.auid;
+      process.uid = entry.uid;
+      process.gid = entry.gid;
+      process.exe = entry.image->exe;
+      process.cmdline = entry.image->cmdline;
+      process.cwd = entry.image->cwd;
+      process.time = entry.time;
+
+      process_list.push_back(std::move(process));
+    }
+  }
+
+  std::sort(process_list.begin(), process_list.end(),
+            [](const Process &lhs, const Process &rhs) {
+              return lhs.process_id < rhs.process_id;
+            });
+}
+
+void ProcessTree::addParentColumns(
+    IVirtualTable::Row &row, const IAudispConsumer::AuditEvent &audit_event) {
+
+  if (!audit_event.parent_image) {
+    row["parent_exe"] = {""};
+    row["parent_cmdline"] = {""};
+
+    return;
+  }
+
+  const auto &image = *audit_event.parent_image;
+  row["parent_exe"] = image.exe;
+  row["parent_cmdline"] = image.cmdline;
+}
+
+std::string ProcessTree::generateCommandLine(
+    const std::vector<std::string> &argument_list) {
+
+  std::size_t command_line_size{0U};
+  for (const auto &argument : argument_list) {
+    command_line_size += argument.size() + 3U;
+  }
+
+  std::string command_line;
+  command_line.reserve(command_line_size);
+
+  for (const auto &argument : argument_list) {
+    if (!command_line.empty()) {
+      command_line.push_back(' ');
+    }
+
+    command_line.push_back('"');
+    command_line.append(argument);
+    command_line.push_back('"');
+  }
+
+  return command_line;
+}
+
+ProcessTree::ProcessTree(std::size_t max_process_count) : d(new PrivateData) {
+  if (max_process_count == 0U) {
+    throw Status::failure("The process limit must be greater than 0");
+  }
+
+  d->max_process_count = max_process_count;
+}
+
+ProcessEntry &ProcessTree::PrivateData::updateProcess(std::int64_t process_id) {
+  auto process_it = process_map.find(process_id);
+  if (process_it != process_map.end()) {
+    auto &entry = process_it->second;
+    update_order.splice(update_order.begin(), update_order,
+                        entry.update_order_it);
+
+    return entry;
+  }
+
+  // Processes whose exit_group event has been lost would otherwise stay
+  // around forever
+  if (process_map.size() >= max_process_count) {
+    process_map.erase(update_order.back());
+    update_order.pop_back();
+  }
+
+  update_order.push_front(process_id);
+
+  auto &entry = process_map[process_id];
+  entry.update_order_it = update_order.begin();
+
+  return entry;
+}
+
+void ProcessTree::PrivateData::removeProcess(std::int64_t process_id) {
+  auto process_it = process_map.find(process_id);
+  if (process_it == process_map.end()) {
+    return;
+  }
+
+  update_order.erase(process_it->second.update_order_it);
+  process_map.erase(process_it);
+}
+} // namespace zeek
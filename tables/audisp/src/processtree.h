@@ -0,0 +1,108 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zeek/iaudispconsumer.h>
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief An in-memory model of the running processes, indexed by process
+///        id. It is updated from the execve, fork, vfork, clone and
+///        exit_group events, so that other rows can be enriched with the
+///        process lineage without reading /proc
+class ProcessTree final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to a ProcessTree object
+  using Ref = std::unique_ptr<ProcessTree>;
+
+  /// \brief A single process
+  struct Process final {
+    /// \brief Process id
+    std::int64_t process_id{0};
+
+    /// \brief Parent process id
+    std::int64_t parent_process_id{0};
+
+    /// \brief Audit (login) user id
+    std::int64_t auid{0};
+
+    /// \brief User id
+    std::int64_t uid{0};
+
+    /// \brief Group id
+    std::int64_t gid{0};
+
+    /// \brief Executable path
+    std::string exe;
+
+    /// \brief Command line, in the same format used by process_events;
+    ///        empty when the process has not been seen calling execve
+    std::string cmdline;
+
+    /// \brief Working directory at the time of the last execve
+    std::string cwd;
+
+    /// \brief When the process has been last updated, in seconds since the
+    ///        epoch
+    std::int64_t time{0};
+  };
+
+  /// \brief A list of processes
+  using ProcessList = std::vector<Process>;
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param max_process_count How many processes are tracked at most; the
+  ///        ones that have not been updated for the longest time are
+  ///        evicted first
+  /// \return A Status object
+  static Status create(Ref &obj, std::size_t max_process_count);
+
+  /// \brief Destructor
+  ~ProcessTree();
+
+  /// \brief Updates the model from the given events, one at a time and in
+  ///        order; events for other syscalls do not change it. Each event
+  ///        is given the image its parent process had when the event was
+  ///        reached, before the later events of the batch are applied
+  /// \param event_list The list of Audit events, updated on return
+  void processEvents(IAudispConsumer::AuditEventList &event_list);
+
+  /// \brief Looks up a single process
+  /// \param process Where the process is stored
+  /// \param process_id The process id
+  /// \return True if the process is known
+  bool getProcess(Process &process, std::int64_t process_id) const;
+
+  /// \brief Returns all the known processes, sorted by process id
+  /// \param process_list Where the processes are stored
+  void getProcessList(ProcessList &process_list) const;
+
+  /// \brief Sets the parent_exe and parent_cmdline columns of the given row
+  ///        from the parent image recorded by processEvents(); both are
+  ///        empty when the parent process is not known
+  /// \param row The row to update
+  /// \param audit_event The event the row has been generated from
+  static void addParentColumns(IVirtualTable::Row &row,
+                               const IAudispConsumer::AuditEvent &audit_event);
+
+  /// \brief Joins the execve arguments into a single command line
+  /// \param argument_list The execve arguments
+  /// \return The command line, with each argument enclosed in quotes
+  static std::string
+  generateCommandLine(const std::vector<std::string> &argument_list);
+
+  ProcessTree(const ProcessTree &) = delete;
+  ProcessTree &operator=(const ProcessTree &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param max_process_count How many processes are tracked at most
+  ProcessTree(std::size_t max_process_count);
+};
+} // namespace zeek
@@ -0,0 +1,82 @@
+#include "processtreetableplugin.h"
+
+namespace zeek {
+struct ProcessTreeTablePlugin::PrivateData final {
+  PrivateData(const ProcessTree &process_tree_)
+      : process_tree(process_tree_) {}
+
+  const ProcessTree &process_tree;
+};
+
+Status ProcessTreeTablePlugin::create(Ref &obj,
+                                      const ProcessTree &process_tree) {
+  try {
+    auto ptr = new ProcessTreeTablePlugin(process_tree);
+    obj.reset(ptr);
+
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+ProcessTreeTablePlugin::~ProcessTreeTablePlugin() {}
+
+const std::string &ProcessTreeTablePlugin::name() const {
+  static const std::string kTableName{"process_tree"};
+
+  return kTableName;
+}
+
+const ProcessTreeTablePlugin::Schema &ProcessTreeTablePlugin::schema() const {
+  static const Schema kTableSchema = {
+      {"pid", IVirtualTable::ColumnType::Integer},
+      {"ppid", IVirtualTable::ColumnType::Integer},
+      {"auid", IVirtualTable::ColumnType::Integer},
+      {"uid", IVirtualTable::ColumnType::Integer},
+      {"gid", IVirtualTable::ColumnType::Integer},
+      {"exe", IVirtualTable::ColumnType::String},
+      {"cmdline", IVirtualTable::ColumnType::String},
+      {"cwd", IVirtualTable::ColumnType::String},
+      {"time", IVirtualTable::ColumnType::Integer}};
+
+  return kTableSchema;
+}
+
+Status ProcessTreeTablePlugin::generateRowList(RowList &row_list) {
+  ProcessTree::ProcessList process_list;
+  d->process_tree.getProcessList(process_list);
+
+  generateRowList(row_list, process_list);
+  return Status::success();
+}
+
+void ProcessTreeTablePlugin::generateRowList(
+    RowList &row_list, const ProcessTree::ProcessList &process_list) {
+
+  row_list = {};
+  row_list.reserve(process_list.size());
+
+  for (const auto &process : process_list) {
+    Row row;
+    row["pid"] = process.process_id;
+    row["ppid"] = process.parent_process_id;
+    row["auid"] = process.auid;
+    row["uid"] = process.uid;
+    row["gid"] = process.gid;
+    row["exe"] = process.exe;
+    row["cmdline"] = process.cmdline;
+    row["cwd"] = process.cwd;
+    row["time"] = process.time;
+
+    row_list.push_back(std::move(row));
+  }
+}
+
+ProcessTreeTablePlugin::ProcessTreeTablePlugin(const ProcessTree &process_tree)
+    : d(new PrivateData(process_tree)) {}
+} // namespace zeek
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "processtree.h"
+
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief Provides the process_tree table, with the processes currently
+///        tracked by the process tree
+class ProcessTreeTablePlugin final : public IVirtualTable {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param process_tree The process model presented by the table
+  /// \return A Status object
+  static Status create(Ref &obj, const ProcessTree &process_tree);
+
+  /// \brief Destructor
+  virtual ~ProcessTreeTablePlugin() override;
+
+  /// \return The table name
+  virtual const std::string &name() const override;
+
+  /// \return The table schema
+  virtual const Schema &schema() const override;
+
+  /// \brief Generates one row for each tracked process
+  /// \param row_list Where the generated rows are stored
+  /// \return A Status object
+  virtual Status generateRowList(RowList &row_list) override;
+
+  /// \brief Generates the rows from the given process list
+  /// \param row_list Where the generated rows are stored
+  /// \param process_list The tracked processes
+  static void generateRowList(RowList &row_list,
+                              const ProcessTree::ProcessList &process_list);
+
+protected:
+  /// \brief Constructor
+  /// \param process_tree The process model presented by the table
+  ProcessTreeTablePlugin(const ProcessTree &process_tree);
+};
+} // namespace zeek
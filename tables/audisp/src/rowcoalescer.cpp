@@ -0,0 +1,346 @@
+#include "rowcoalescer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace zeek {
+namespace {
+/// \brief The columns maintained by the coalescer, never used as keys
+const std::vector<std::string> kTimeColumnList = {"time", "count",
+                                                  "first_time", "last_time"};
+
+/// \brief The tables that support coalescing, and can appear in the
+///        audisp_coalescing_key_list setting
+const std::vector<std::string> kCoalescingTableNameList = {
+    "process_events", "socket_events", "file_events"};
+
+/// \brief A folded row, waiting for its window to close
+struct PendingRow final {
+  /// \brief The first row that has been received
+  IVirtualTable::Row row;
+
+  /// \brief The key built from the row
+  std::string key;
+
+  /// \brief How many identical rows have been received
+  std::int64_t count{0};
+
+  /// \brief When the first row has been received
+  std::int64_t first_time{0};
+
+  /// \brief When the last row has been received
+  std::int64_t last_time{0};
+};
+
+/// \brief Returns the integer stored in the given column
+/// \param row The row to inspect
+/// \param column_name The column name
+/// \return The column value, or 0 if it is not set or is not an integer
+std::int64_t getIntegerColumn(const IVirtualTable::Row &row,
+                              const std::string &column_name) {
+  auto column_it = row.find(column_name);
+  if (column_it == row.end() || !column_it->second.has_value()) {
+    return 0;
+  }
+
+  const auto *value = std::get_if<std::int64_t>(&column_it->second.value());
+  return value != nullptr ? *value : 0;
+}
+
+/// \brief Appends a single column value to a row key. Each value is
+///        tagged with its type, and strings are prefixed with their size,
+///        so that different rows can't produce the same key
+/// \param key The key to update
+/// \param value The column value
+void appendKeyValue(std::string &key,
+                    const IVirtualTable::OptionalVariant &value) {
+  if (!value.has_value()) {
+    key.push_back('n');
+    return;
+  }
+
+  const auto &variant = value.value();
+
+  if (const auto *integer = std::get_if<std::int64_t>(&variant)) {
+    char buffer[sizeof(std::int64_t)];
+    std::memcpy(buffer, integer, sizeof(buffer));
+
+    key.push_back('i');
+    key.append(buffer, sizeof(buffer));
+
+  } else if (const auto *string = std::get_if<std::string>(&variant)) {
+    auto size = string->size();
+
+    char buffer[sizeof(size)];
+    std::memcpy(buffer, &size, sizeof(buffer));
+
+    key.push_back('s');
+    key.append(buffer, sizeof(buffer));
+    key.append(*string);
+
+  } else {
+    auto real = std::get<double>(variant);
+
+    char buffer[sizeof(double)];
+    std::memcpy(buffer, &real, sizeof(buffer));
+
+    key.push_back('d');
+    key.append(buffer, sizeof(buffer));
+  }
+}
+} // namespace
+
+struct RowCoalescer::PrivateData final {
+  /// \brief Builds the key of the given row
+  /// \param key Where the key is stored
+  /// \param row The row
+  void generateKey(std::string &key, const IVirtualTable::Row &row) const;
+
+  /// \brief Releases the oldest pending row
+  /// \param output Where the released row is appended
+  void releaseOldestRow(IVirtualTable::RowList &output);
+
+  /// \brief Releases the pending rows whose window has closed
+  /// \param output Where the released rows are appended
+  /// \param current_time The current time, in seconds since the epoch
+  void releaseExpiredRows(IVirtualTable::RowList &output,
+                          std::int64_t current_time);
+
+  std::int64_t window{0};
+  KeyColumnList key_column_list;
+  std::size_t max_pending_row_count{0U};
+
+  mutable std::mutex mutex;
+
+  // Oldest rows first; the map keys point to the keys stored in the list
+  std::list<PendingRow> pending_row_list;
+  std::unordered_map<std::string_view, std::list<PendingRow>::iterator>
+      pending_row_map;
+
+  // Reused for the lookups, so that a folded row does not allocate
+  std::string key_buffer;
+};
+
+Status RowCoalescer::create(Ref &obj, std::chrono::seconds window,
+                            const KeyColumnList &key_column_list,
+                            std::size_t max_pending_row_count) {
+  try {
+    obj.reset(
+        new RowCoalescer(window, key_column_list, max_pending_row_count));
+    return Status::success();
+
+  } catch (const std::bad_alloc &) {
+    return Status::failure("Memory allocation failure");
+
+  } catch (const Status &status) {
+    return status;
+  }
+}
+
+RowCoalescer::~RowCoalescer() {}
+
+void RowCoalescer::processRows(IVirtualTable::RowList &output,
+                               IVirtualTable::RowList row_list,
+                               std::int64_t current_time) {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  // Rows whose window has already closed must not absorb the new ones
+  d->releaseExpiredRows(output, current_time);
+
+  for (auto &row : row_list) {
+    auto &key = d->key_buffer;
+    d->generateKey(key, row);
+
+    auto time = getIntegerColumn(row, "time");
+
+    auto pending_row_it = d->pending_row_map.find(key);
+    if (pending_row_it != d->pending_row_map.end()) {
+      auto &pending_row = *pending_row_it->second;
+      ++pending_row.count;
+      pending_row.last_time = std::max(pending_row.last_time, time);
+
+      continue;
+    }
+
+    if (d->pending_row_list.size() >= d->max_pending_row_count) {
+      d->releaseOldestRow(output);
+    }
+
+    PendingRow pending_row;
+    pending_row.row = std::move(row);
+    pending_row.key = key;
+    pending_row.count = 1;
+    pending_row.first_time = time;
+    pending_row.last_time = time;
+
+    d->pending_row_list.push_back(std::move(pending_row));
+
+    auto list_it = std::prev(d->pending_row_list.end());
+    d->pending_row_map.emplace(list_it->key, list_it);
+  }
+
+  d->releaseExpiredRows(output, current_time);
+}
+
+void RowCoalescer::takeExpiredRows(IVirtualTable::RowList &output,
+                                   std::int64_t current_time) {
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  d->releaseExpiredRows(output, current_time);
+}
+
+std::size_t RowCoalescer::pendingRowCount() const {
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->pending_row_list.size();
+}
+
+std::int64_t RowCoalescer::currentTime() {
+  auto current_timestamp = std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+
+  return static_cast<std::int64_t>(current_timestamp.count());
+}
+
+void RowCoalescer::initializeRow(IVirtualTable::Row &row) {
+  auto time = getIntegerColumn(row, "time");
+
+  row["count"] = static_cast<std::int64_t>(1);
+  row["first_time"] = time;
+  row["last_time"] = time;
+}
+
+Status RowCoalescer::getKeyColumnList(
+    KeyColumnList &key_column_list,
+    const std::vector<std::string> &configured_key_list,
+    const std::string &table_name, const IVirtualTable::Schema &schema) {
+
+  key_column_list = {};
+
+  for (const auto &entry : configured_key_list) {
+    auto separator_index = entry.find('=');
+    if (separator_index == std::string::npos) {
+      return Status::failure("Invalid audisp_coalescing_key_list entry: " +
+                             entry);
+    }
+
+    auto entry_table_name = entry.substr(0U, separator_index);
+    if (std::find(kCoalescingTableNameList.begin(),
+                  kCoalescingTableNameList.end(),
+                  entry_table_name) == kCoalescingTableNameList.end()) {
+      return Status::failure("Unknown table in audisp_coalescing_key_list: " +
+                             entry_table_name);
+    }
+
+    if (entry_table_name != table_name) {
+      continue;
+    }
+
+    std::size_t column_start = separator_index + 1U;
+
+    while (column_start <= entry.size()) {
+      auto column_end = entry.find(',', column_start);
+      if (column_end == std::string::npos) {
+        column_end = entry.size();
+      }
+
+      auto column_name = entry.substr(column_start, column_end - column_start);
+      column_start = column_end + 1U;
+
+      if (schema.count(column_name) == 0U) {
+        return Status::failure(
+            "Unknown column in audisp_coalescing_key_list: " + table_name +
+            "." + column_name);
+      }
+
+      if (std::find(kTimeColumnList.begin(), kTimeColumnList.end(),
+                    column_name) != kTimeColumnList.end()) {
+        return Status::failure(
+            "The time columns can't be used as audisp_coalescing_key_list "
+            "keys: " +
+            table_name + "." + column_name);
+      }
+
+      key_column_list.push_back(std::move(column_name));
+    }
+  }
+
+  return Status::success();
+}
+
+RowCoalescer::RowCoalescer(std::chrono::seconds window,
+                           const KeyColumnList &key_column_list,
+                           std::size_t max_pending_row_count)
+    : d(new PrivateData) {
+
+  if (window.count() <= 0) {
+    throw Status::failure("The coalescing window must be greater than 0");
+  }
+
+  if (max_pending_row_count == 0U) {
+    throw Status::failure("The pending row limit must be greater than 0");
+  }
+
+  d->window = static_cast<std::int64_t>(window.count());
+  d->key_column_list = key_column_list;
+  d->max_pending_row_count = max_pending_row_count;
+}
+
+void RowCoalescer::PrivateData::generateKey(
+    std::string &key, const IVirtualTable::Row &row) const {
+
+  key.clear();
+
+  if (!key_column_list.empty()) {
+    for (const auto &column_name : key_column_list) {
+      auto column_it = row.find(column_name);
+      if (column_it == row.end()) {
+        appendKeyValue(key, {});
+      } else {
+        appendKeyValue(key, column_it->second);
+      }
+    }
+
+    return;
+  }
+
+  // Rows of the same table have the same columns, so the names are not
+  // needed to tell them apart
+  for (const auto &p : row) {
+    if (std::find(kTimeColumnList.begin(), kTimeColumnList.end(), p.first) !=
+        kTimeColumnList.end()) {
+      continue;
+    }
+
+    appendKeyValue(key, p.second);
+  }
+}
+
+void RowCoalescer::PrivateData::releaseOldestRow(
+    IVirtualTable::RowList &output) {
+
+  auto &pending_row = pending_row_list.front();
+  pending_row_map.erase(pending_row.key);
+
+  auto &row = pending_row.row;
+  row["count"] = pending_row.count;
+  row["first_time"] = pending_row.first_time;
+  row["last_time"] = pending_row.last_time;
+
+  output.push_back(std::move(row));
+  pending_row_list.pop_front();
+}
+
+void RowCoalescer::PrivateData::releaseExpiredRows(
+    IVirtualTable::RowList &output, std::int64_t current_time) {
+
+  while (!pending_row_list.empty() &&
+         pending_row_list.front().first_time + window <= current_time) {
+    releaseOldestRow(output);
+  }
+}
+} // namespace zeek
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <zeek/ivirtualtable.h>
+
+namespace zeek {
+/// \brief Folds identical rows, received within a configurable time window,
+///        into a single row. The folded row keeps the values of the first
+///        row, and carries the count, first_time and last_time columns
+class RowCoalescer final {
+  struct PrivateData;
+  std::unique_ptr<PrivateData> d;
+
+public:
+  /// \brief A unique_ptr to a RowCoalescer object
+  using Ref = std::unique_ptr<RowCoalescer>;
+
+  /// \brief The columns that identify identical rows
+  using KeyColumnList = std::vector<std::string>;
+
+  /// \brief Factory method
+  /// \param obj Where the created object is stored
+  /// \param window How long a folded row is held, starting from the first
+  ///        row; must be greater than zero
+  /// \param key_column_list The columns compared to find identical rows;
+  ///        when empty, all the columns but the time ones are compared
+  /// \param max_pending_row_count How many folded rows can be held; when
+  ///        the limit is reached, the oldest one is released early
+  /// \return A Status object
+  static Status create(Ref &obj, std::chrono::seconds window,
+                       const KeyColumnList &key_column_list,
+                       std::size_t max_pending_row_count);
+
+  /// \brief Destructor
+  ~RowCoalescer();
+
+  /// \brief Folds the given rows into the pending ones
+  /// \param output Where the rows whose window has closed are appended
+  /// \param row_list The new rows, already initialized with initializeRow
+  /// \param current_time The current time, in seconds since the epoch
+  void processRows(IVirtualTable::RowList &output,
+                   IVirtualTable::RowList row_list, std::int64_t current_time);
+
+  /// \brief Releases the rows whose window has closed
+  /// \param output Where the released rows are appended
+  /// \param current_time The current time, in seconds since the epoch
+  void takeExpiredRows(IVirtualTable::RowList &output,
+                       std::int64_t current_time);
+
+  /// \return How many folded rows are waiting for their window to close
+  std::size_t pendingRowCount() const;
+
+  /// \return The current time, in seconds since the epoch, like the time
+  ///         column of the audisp tables
+  static std::int64_t currentTime();
+
+  /// \brief Sets the count column to 1, and the first_time and last_time
+  ///        columns to the value of the time column
+  /// \param row The row to update
+  static void initializeRow(IVirtualTable::Row &row);
+
+  /// \brief Returns the key columns configured for the given table. Entries
+  ///        for tables that do not support coalescing are rejected
+  /// \param key_column_list Where the key columns are stored; empty if the
+  ///        table is not listed
+  /// \param configured_key_list The audisp_coalescing_key_list setting, in
+  ///        the "<table>=<column>,<column>,..." format
+  /// \param table_name The table name
+  /// \param schema The table schema, used to validate the column names
+  /// \return A Status object
+  static Status
+  getKeyColumnList(KeyColumnList &key_column_list,
+                   const std::vector<std::string> &configured_key_list,
+                   const std::string &table_name,
+                   const IVirtualTable::Schema &schema);
+
+  RowCoalescer(const RowCoalescer &) = delete;
+  RowCoalescer &operator=(const RowCoalescer &) = delete;
+
+protected:
+  /// \brief Constructor
+  /// \param window How long a folded row is held
+  /// \param key_column_list The columns compared to find identical rows
+  /// \param max_pending_row_count How many folded rows can be held
+  RowCoalescer(std::chrono::seconds window,
+               const KeyColumnList &key_column_list,
+               std::size_t max_pending_row_count);
+};
+} // namespace zeek
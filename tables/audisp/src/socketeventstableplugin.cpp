@@ -1,19 +1,17 @@
 #include "socketeventstableplugin.h"
+#include "audittablerowbuffer.h"
 
+#include <atomic>
 #include <chrono>
-#include <mutex>
 
 namespace zeek {
 struct SocketEventsTablePlugin::PrivateData final {
-  PrivateData(IZeekConfiguration &configuration_, IZeekLogger &logger_)
-      : configuration(configuration_), logger(logger_) {}
+  PrivateData(IZeekLogger &logger_) : logger(logger_) {}
 
-  IZeekConfiguration &configuration;
   IZeekLogger &logger;
 
-  RowList row_list;
-  std::mutex row_list_mutex;
-  std::size_t max_queued_row_count{0U};
+  AuditTableRowBuffer::Ref row_buffer;
+  std::atomic<std::chrono::steady_clock::time_point> last_query_time;
 };
 
 Status SocketEventsTablePlugin::create(Ref &obj,
@@ -60,65 +58,94 @@ const SocketEventsTablePlugin::Schema &SocketEventsTablePlugin::schema() const {
       {"remote_address", IVirtualTable::ColumnType::String},
       {"local_port", IVirtualTable::ColumnType::Integer},
       {"remote_port", IVirtualTable::ColumnType::Integer},
-      {"time", IVirtualTable::ColumnType::Integer}};
+      {"time", IVirtualTable::ColumnType::Integer},
+
+      // How many identical events have been folded into the row
+      {"count", IVirtualTable::ColumnType::Integer},
+      {"first_time", IVirtualTable::ColumnType::Integer},
+      {"last_time", IVirtualTable::ColumnType::Integer},
+
+      // How many events the row stands for when the table is sampling
+      {"sample_weight", IVirtualTable::ColumnType::Integer},
+
+      // Taken from the process tree
+      {"parent_exe", IVirtualTable::ColumnType::String},
+      {"parent_cmdline", IVirtualTable::ColumnType::String}};
 
   return kTableSchema;
 }
 
 Status SocketEventsTablePlugin::generateRowList(RowList &row_list) {
-  std::lock_guard<std::mutex> lock(d->row_list_mutex);
-
-  row_list = std::move(d->row_list);
-  d->row_list = {};
+  d->last_query_time = std::chrono::steady_clock::now();
 
+  d->row_buffer->takeRows(row_list);
   return Status::success();
 }
 
 Status SocketEventsTablePlugin::processEvents(
     const IAudispConsumer::AuditEventList &event_list) {
   RowList generated_row_list;
+  AdaptiveSampler::SerialList serial_list;
+  auto status = Status::success();
 
   for (const auto &audit_event : event_list) {
     Row row;
 
-    auto status = generateRow(row, audit_event);
+    status = generateRow(row, audit_event);
     if (!status.succeeded()) {
-      return status;
+      break;
     }
 
     if (!row.empty()) {
-      {
-        std::lock_guard<std::mutex> lock(d->row_list_mutex);
-        d->row_list.push_back(row);
-      }
+      ProcessTree::addParentColumns(row, audit_event);
+
+      AuditTableRowBuffer::initializeRow(row);
+
+      generated_row_list.push_back(std::move(row));
+      serial_list.push_back(audit_event.serial);
     }
   }
 
-  if (d->row_list.size() > d->max_queued_row_count) {
-
-    auto rows_to_remove = d->row_list.size() - d->max_queued_row_count;
+  d->row_buffer->pushRows(std::move(generated_row_list), serial_list);
+  return status;
+}
 
-    d->logger.logMessage(IZeekLogger::Severity::Warning,
-                         "socket_events: Dropping " +
-                             std::to_string(rows_to_remove) +
-                             " rows (max row count is set to " +
-                             std::to_string(d->max_queued_row_count) + ")");
+std::chrono::steady_clock::time_point
+SocketEventsTablePlugin::lastQueryTime() const {
+  return d->last_query_time;
+}
 
-    {
-      std::lock_guard<std::mutex> lock(d->row_list_mutex);
-      d->row_list.erase(d->row_list.begin(),
-                        std::next(d->row_list.begin(), rows_to_remove));
-    }
-  }
+const AuditEventDispatcher::SyscallTypeList &
+SocketEventsTablePlugin::syscallTypeList() {
+  static const AuditEventDispatcher::SyscallTypeList kSyscallTypeList = {
+      IAudispConsumer::SyscallRecordData::Type::Bind,
+      IAudispConsumer::SyscallRecordData::Type::Connect};
 
-  return Status::success();
+  return kSyscallTypeList;
 }
 
 SocketEventsTablePlugin::SocketEventsTablePlugin(
     IZeekConfiguration &configuration, IZeekLogger &logger)
-    : d(new PrivateData(configuration, logger)) {
+    : d(new PrivateData(logger)) {
+
+  AuditTableRowBuffer::Configuration buffer_configuration;
+  auto status = AuditTableRowBuffer::getConfiguration(
+      buffer_configuration, configuration, name(), schema());
+
+  if (!status.succeeded()) {
+    throw status;
+  }
+
+  status = AuditTableRowBuffer::create(d->row_buffer, logger, name(),
+                                       buffer_configuration);
+
+  if (!status.succeeded()) {
+    throw status;
+  }
 
-  d->max_queued_row_count = d->configuration.maxQueuedRowCount();
+  // New tables are considered active, so that the first query after the
+  // agent has started returns the events collected so far
+  d->last_query_time = std::chrono::steady_clock::now();
 }
 
 Status SocketEventsTablePlugin::generateRow(
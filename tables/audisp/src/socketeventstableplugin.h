@@ -1,5 +1,8 @@
 #pragma once
 
+#include "auditeventdispatcher.h"
+#include "processtree.h"
+
 #include <zeek/iaudispconsumer.h>
 #include <zeek/ivirtualtable.h>
 #include <zeek/izeekconfiguration.h>
@@ -40,6 +43,12 @@ public:
   /// \return A Status object
   Status processEvents(const IAudispConsumer::AuditEventList &event_list);
 
+  /// \return When the table has been queried for the last time
+  std::chrono::steady_clock::time_point lastQueryTime() const;
+
+  /// \return The syscall types whose events are presented by this table
+  static const AuditEventDispatcher::SyscallTypeList &syscallTypeList();
+
   /// \brief Generates a new row from the given Audit event
   /// \param row Where the generated row is stored
   /// \param audit_event The source Audit event
@@ -0,0 +1,162 @@
+#include "adaptivesampler.h"
+
+#include <algorithm>
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+const std::string kTableName{"process_events"};
+
+// The rows only differ by their event serial number, like identical events
+// received within the same second
+IVirtualTable::RowList generateRowList(std::size_t row_count) {
+  IVirtualTable::RowList row_list;
+
+  for (std::size_t i = 0U; i < row_count; ++i) {
+    IVirtualTable::Row row;
+    row["pid"] = static_cast<std::int64_t>(1000);
+    row["exe"] = {"/usr/bin/curl"};
+    row["time"] = static_cast<std::int64_t>(1000);
+
+    AdaptiveSampler::initializeRow(row);
+    row_list.push_back(std::move(row));
+  }
+
+  return row_list;
+}
+
+AdaptiveSampler::SerialList generateSerialList(std::size_t row_count) {
+  AdaptiveSampler::SerialList serial_list;
+
+  for (std::size_t i = 0U; i < row_count; ++i) {
+    serial_list.push_back(static_cast<std::uint64_t>(5000U + i));
+  }
+
+  return serial_list;
+}
+} // namespace
+
+TEST_CASE("Event hashing", "[AdaptiveSampler]") {
+  auto first_hash = AdaptiveSampler::hashEvent(kTableName, 1U);
+  CHECK(first_hash == AdaptiveSampler::hashEvent(kTableName, 1U));
+
+  CHECK(first_hash != AdaptiveSampler::hashEvent(kTableName, 2U));
+  CHECK(first_hash != AdaptiveSampler::hashEvent("socket_events", 1U));
+}
+
+TEST_CASE("Adaptive sampling", "[AdaptiveSampler]") {
+  AdaptiveSampler::Ref adaptive_sampler;
+  auto status =
+      AdaptiveSampler::create(adaptive_sampler, kTableName, 1000U, 50U);
+  REQUIRE(status.succeeded());
+
+  const std::size_t kRowCount{4096U};
+  const auto kSerialList = generateSerialList(kRowCount);
+
+  SECTION("All rows are kept while the queue is below the threshold") {
+    auto row_list = generateRowList(kRowCount);
+
+    CHECK(adaptive_sampler->processRows(row_list, kSerialList, 499U) == 0U);
+    CHECK(row_list.size() == kRowCount);
+    CHECK(adaptive_sampler->sampleWeight() == 1);
+
+    CHECK(std::get<std::int64_t>(row_list.at(0).at("sample_weight").value()) ==
+          1);
+  }
+
+  SECTION("The sample rate follows the queue usage") {
+    auto row_list = generateRowList(kRowCount);
+    auto discarded_row_count =
+        adaptive_sampler->processRows(row_list, kSerialList, 500U);
+
+    CHECK(adaptive_sampler->sampleWeight() == 2);
+    CHECK(discarded_row_count + row_list.size() == kRowCount);
+
+    // The selection is random enough to keep about half of the identical
+    // rows
+    CHECK(row_list.size() > kRowCount / 2U - kRowCount / 16U);
+    CHECK(row_list.size() < kRowCount / 2U + kRowCount / 16U);
+
+    for (const auto &row : row_list) {
+      CHECK(std::get<std::int64_t>(row.at("sample_weight").value()) == 2);
+    }
+
+    row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(row_list, kSerialList, 1000U);
+    CHECK(adaptive_sampler->sampleWeight() ==
+          AdaptiveSampler::kMaxSampleWeight);
+
+    row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(row_list, kSerialList, 2000U);
+    CHECK(adaptive_sampler->sampleWeight() ==
+          AdaptiveSampler::kMaxSampleWeight);
+  }
+
+  SECTION("Events kept at a lower rate are also kept at a higher one") {
+    std::vector<std::uint64_t> high_rate_serial_list;
+    std::vector<std::uint64_t> low_rate_serial_list;
+
+    for (auto serial : kSerialList) {
+      auto event_hash = AdaptiveSampler::hashEvent(kTableName, serial);
+
+      if ((event_hash & 1U) == 0U) {
+        high_rate_serial_list.push_back(serial);
+      }
+
+      if ((event_hash & 7U) == 0U) {
+        low_rate_serial_list.push_back(serial);
+      }
+    }
+
+    auto high_rate_row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(high_rate_row_list, kSerialList, 500U);
+    REQUIRE(adaptive_sampler->sampleWeight() == 2);
+    CHECK(high_rate_row_list.size() == high_rate_serial_list.size());
+
+    auto low_rate_row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(low_rate_row_list, kSerialList, 620U);
+    REQUIRE(adaptive_sampler->sampleWeight() == 8);
+    CHECK(low_rate_row_list.size() == low_rate_serial_list.size());
+
+    for (auto serial : low_rate_serial_list) {
+      CHECK(std::find(high_rate_serial_list.begin(),
+                      high_rate_serial_list.end(),
+                      serial) != high_rate_serial_list.end());
+    }
+  }
+
+  SECTION("Rows without a serial number are kept") {
+    auto row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(row_list, {}, 1000U);
+
+    CHECK(row_list.size() == kRowCount);
+  }
+
+  SECTION("Full capture resumes once the queue has drained") {
+    auto row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(row_list, kSerialList, 900U);
+
+    row_list = generateRowList(kRowCount);
+    adaptive_sampler->processRows(row_list, kSerialList, 300U);
+    CHECK(adaptive_sampler->sampleWeight() == 2);
+
+    row_list = generateRowList(kRowCount);
+    CHECK(adaptive_sampler->processRows(row_list, kSerialList, 249U) == 0U);
+    CHECK(adaptive_sampler->sampleWeight() == 1);
+  }
+}
+
+TEST_CASE("Invalid sampler settings", "[AdaptiveSampler]") {
+  AdaptiveSampler::Ref adaptive_sampler;
+
+  CHECK(!AdaptiveSampler::create(adaptive_sampler, kTableName, 0U, 50U)
+             .succeeded());
+
+  CHECK(!AdaptiveSampler::create(adaptive_sampler, kTableName, 1000U, 0U)
+             .succeeded());
+
+  CHECK(!AdaptiveSampler::create(adaptive_sampler, kTableName, 1000U, 101U)
+             .succeeded());
+}
+} // namespace zeek
@@ -0,0 +1,40 @@
+#include "audispfilterrulestableplugin.h"
+#include "utils.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+SCENARIO("Row generation in the audisp_filter_rules table",
+         "[AudispFilterRulesTablePlugin]") {
+
+  GIVEN("the counters of two filter rules") {
+    IAudispConsumer::FilterRuleCounterList counter_list(2U);
+    counter_list.at(0).rule = "exclude exe=/usr/bin/ls";
+    counter_list.at(0).match_count = 15U;
+    counter_list.at(1).rule = "include uid=1000";
+
+    WHEN("generating the table rows") {
+      IVirtualTable::RowList row_list;
+      AudispFilterRulesTablePlugin::generateRowList(row_list, counter_list);
+
+      THEN("one row is generated for each rule, in rule order") {
+        REQUIRE(row_list.size() == 2U);
+
+        // clang-format off
+        validateRow(row_list.at(0), {
+          { "position", 0 },
+          { "rule", "exclude exe=/usr/bin/ls" },
+          { "matched", 15 }
+        });
+
+        validateRow(row_list.at(1), {
+          { "position", 1 },
+          { "rule", "include uid=1000" },
+          { "matched", 0 }
+        });
+        // clang-format on
+      }
+    }
+  }
+}
+} // namespace zeek
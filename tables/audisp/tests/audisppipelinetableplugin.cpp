@@ -0,0 +1,65 @@
+#include "audisppipelinetableplugin.h"
+#include "utils.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+SCENARIO("Row generation in the audisp_pipeline table",
+         "[AudispPipelineTablePlugin]") {
+
+  GIVEN("the metrics of the table stage") {
+    IAudispConsumer::PipelineStageMetrics metrics;
+    metrics.name = "tables";
+    metrics.queue_depth = 12U;
+    metrics.queue_capacity = 1024U;
+    metrics.processed_count = 3000U;
+    metrics.dropped_count = 7U;
+
+    WHEN("generating the table row") {
+      IVirtualTable::Row row;
+      auto status = AudispPipelineTablePlugin::generateRow(
+          row, metrics, 1000U, std::chrono::milliseconds(500));
+
+      REQUIRE(status.succeeded());
+
+      THEN("the counters are copied and the throughput is per second") {
+        // clang-format off
+        const ExpectedValueList kExpectedColumnList = {
+          { "stage", "tables" },
+          { "queue_depth", 12 },
+          { "queue_capacity", 1024 },
+          { "processed", 3000 },
+          { "dropped", 7 }
+        };
+        // clang-format on
+
+        validateRow(row, kExpectedColumnList);
+
+        const auto &throughput = row.at("throughput").value();
+        REQUIRE(std::get<double>(throughput) == Approx(4000.0));
+      }
+    }
+
+    WHEN("no time has passed since the previous query") {
+      IVirtualTable::Row row;
+      auto status = AudispPipelineTablePlugin::generateRow(
+          row, metrics, 1000U, std::chrono::milliseconds(0));
+
+      REQUIRE(status.succeeded());
+
+      THEN("the throughput is zero") {
+        const auto &throughput = row.at("throughput").value();
+        REQUIRE(std::get<double>(throughput) == 0.0);
+      }
+    }
+
+    WHEN("the processed count has decreased") {
+      IVirtualTable::Row row;
+      auto status = AudispPipelineTablePlugin::generateRow(
+          row, metrics, 5000U, std::chrono::milliseconds(500));
+
+      THEN("row generation fails") { REQUIRE(!status.succeeded()); }
+    }
+  }
+}
+} // namespace zeek
@@ -0,0 +1,162 @@
+#include "auditeventdispatcher.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+class DummyLogger final : public IZeekLogger {
+public:
+  virtual void logMessage(Severity, const std::string &) override {
+    ++message_count;
+  }
+
+  std::size_t message_count{0U};
+};
+
+IAudispConsumer::AuditEvent
+generateAuditEvent(IAudispConsumer::SyscallRecordData::Type type) {
+  IAudispConsumer::AuditEvent audit_event;
+  audit_event.syscall_data.type = type;
+
+  return audit_event;
+}
+} // namespace
+
+SCENARIO("Audit event dispatching", "[AuditEventDispatcher]") {
+  using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+  DummyLogger logger;
+  AuditEventDispatcher dispatcher(logger, std::chrono::seconds(60));
+
+  std::vector<SyscallType> process_event_list;
+  std::vector<SyscallType> socket_event_list;
+
+  auto process_last_query_time = std::chrono::steady_clock::now();
+  auto socket_last_query_time = std::chrono::steady_clock::now();
+
+  auto status = dispatcher.registerTable(
+      "process_events", {SyscallType::Execve, SyscallType::Fork},
+      [&](const IAudispConsumer::AuditEventList &event_list) {
+        for (const auto &audit_event : event_list) {
+          process_event_list.push_back(audit_event.syscall_data.type);
+        }
+
+        return Status::success();
+      },
+      [&]() { return process_last_query_time; });
+
+  REQUIRE(status.succeeded());
+
+  status = dispatcher.registerTable(
+      "socket_events", {SyscallType::Connect},
+      [&](const IAudispConsumer::AuditEventList &event_list) {
+        for (const auto &audit_event : event_list) {
+          socket_event_list.push_back(audit_event.syscall_data.type);
+        }
+
+        return Status::failure("Test failure");
+      },
+      [&]() { return socket_last_query_time; });
+
+  REQUIRE(status.succeeded());
+
+  GIVEN("a list of mixed events") {
+    IAudispConsumer::AuditEventList event_list = {
+        generateAuditEvent(SyscallType::Execve),
+        generateAuditEvent(SyscallType::Connect),
+        generateAuditEvent(SyscallType::Open),
+        generateAuditEvent(SyscallType::Fork)};
+
+    WHEN("all the tables are active") {
+      dispatcher.dispatch(event_list);
+
+      THEN("each table only receives its own events") {
+        REQUIRE(event_list.empty());
+
+        IAudispConsumer::PipelineStageMetrics metrics;
+        dispatcher.getMetrics(metrics);
+
+        REQUIRE(metrics.name == "dispatcher");
+        REQUIRE(metrics.processed_count == 3U);
+        REQUIRE(metrics.dropped_count == 0U);
+
+        REQUIRE(process_event_list ==
+                std::vector<SyscallType>{SyscallType::Execve,
+                                         SyscallType::Fork});
+
+        REQUIRE(socket_event_list ==
+                std::vector<SyscallType>{SyscallType::Connect});
+
+        REQUIRE(logger.message_count == 1U);
+      }
+    }
+
+    WHEN("a table has not been queried for too long") {
+      socket_last_query_time -= std::chrono::seconds(120);
+      dispatcher.dispatch(event_list);
+
+      THEN("it receives no events, and they are counted as dropped") {
+        REQUIRE(process_event_list.size() == 2U);
+        REQUIRE(socket_event_list.empty());
+        REQUIRE(logger.message_count == 0U);
+
+        IAudispConsumer::PipelineStageMetrics metrics;
+        dispatcher.getMetrics(metrics);
+
+        REQUIRE(metrics.processed_count == 2U);
+        REQUIRE(metrics.dropped_count == 1U);
+      }
+    }
+  }
+
+  GIVEN("a table that handles an already owned syscall type") {
+    status = dispatcher.registerTable(
+        "file_events", {SyscallType::Open, SyscallType::Fork},
+        [](const IAudispConsumer::AuditEventList &) {
+          return Status::success();
+        },
+        []() { return std::chrono::steady_clock::now(); });
+
+    THEN("registration fails") { REQUIRE(!status.succeeded()); }
+  }
+}
+
+SCENARIO("Audit event dispatching without an activity timeout",
+         "[AuditEventDispatcher]") {
+  using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+  DummyLogger logger;
+  AuditEventDispatcher dispatcher(logger, std::chrono::seconds(0));
+
+  std::size_t process_event_count{0U};
+
+  auto status = dispatcher.registerTable(
+      "process_events", {SyscallType::Execve},
+      [&](const IAudispConsumer::AuditEventList &event_list) {
+        process_event_count += event_list.size();
+        return Status::success();
+      },
+      []() { return std::chrono::steady_clock::time_point{}; });
+
+  REQUIRE(status.succeeded());
+
+  GIVEN("a table that has never been queried") {
+    IAudispConsumer::AuditEventList event_list = {
+        generateAuditEvent(SyscallType::Execve),
+        generateAuditEvent(SyscallType::Execve)};
+
+    WHEN("dispatching events") {
+      dispatcher.dispatch(event_list);
+
+      THEN("the table still receives them") {
+        REQUIRE(process_event_count == 2U);
+
+        IAudispConsumer::PipelineStageMetrics metrics;
+        dispatcher.getMetrics(metrics);
+
+        REQUIRE(metrics.dropped_count == 0U);
+      }
+    }
+  }
+}
+} // namespace zeek
@@ -0,0 +1,138 @@
+#include "audittablerowbuffer.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+class DummyLogger final : public IZeekLogger {
+public:
+  virtual void logMessage(Severity, const std::string &) override {
+    ++message_count;
+  }
+
+  std::size_t message_count{0U};
+};
+
+IVirtualTable::Row generateRow(std::int64_t pid) {
+  IVirtualTable::Row row;
+  row["syscall"] = {"open"};
+  row["pid"] = pid;
+  row["time"] = RowCoalescer::currentTime();
+
+  AuditTableRowBuffer::initializeRow(row);
+  return row;
+}
+
+void pushRows(AuditTableRowBuffer &row_buffer,
+              IVirtualTable::RowList row_list) {
+  static std::uint64_t next_serial{1U};
+
+  AdaptiveSampler::SerialList serial_list;
+  for (std::size_t i = 0U; i < row_list.size(); ++i) {
+    serial_list.push_back(next_serial);
+    ++next_serial;
+  }
+
+  row_buffer.pushRows(std::move(row_list), serial_list);
+}
+
+std::int64_t getIntegerColumn(const IVirtualTable::Row &row,
+                              const std::string &column_name) {
+  return std::get<std::int64_t>(row.at(column_name).value());
+}
+} // namespace
+
+TEST_CASE("Audit table row buffer", "[AuditTableRowBuffer]") {
+  DummyLogger logger;
+
+  AuditTableRowBuffer::Configuration configuration;
+  configuration.max_queued_row_count = 4U;
+
+  AuditTableRowBuffer::Ref row_buffer;
+  IVirtualTable::RowList row_list;
+
+  SECTION("Rows that do not fit in the queue are dropped") {
+    auto status = AuditTableRowBuffer::create(row_buffer, logger,
+                                              "test_events", configuration);
+    REQUIRE(status.succeeded());
+
+    pushRows(*row_buffer, {generateRow(1), generateRow(2), generateRow(3)});
+    CHECK(logger.message_count == 0U);
+
+    pushRows(*row_buffer, {generateRow(4), generateRow(5), generateRow(6)});
+    CHECK(logger.message_count == 1U);
+
+    row_buffer->takeRows(row_list);
+    REQUIRE(row_list.size() == 4U);
+
+    for (std::size_t i = 0U; i < row_list.size(); ++i) {
+      CHECK(getIntegerColumn(row_list.at(i), "pid") ==
+            static_cast<std::int64_t>(i + 1U));
+    }
+
+    row_buffer->takeRows(row_list);
+    CHECK(row_list.empty());
+  }
+
+  SECTION("Rows are sampled when the queue usage is high") {
+    configuration.max_queued_row_count = 1024U;
+    configuration.sampling_threshold = 50U;
+
+    auto status = AuditTableRowBuffer::create(row_buffer, logger,
+                                              "test_events", configuration);
+    REQUIRE(status.succeeded());
+
+    IVirtualTable::RowList new_row_list;
+    for (std::int64_t pid = 0; pid < 600; ++pid) {
+      new_row_list.push_back(generateRow(pid));
+    }
+
+    // The queue is empty, so the whole batch is captured
+    pushRows(*row_buffer, new_row_list);
+    CHECK(logger.message_count == 0U);
+
+    // The queue is past the threshold now; the rows that are kept stand
+    // for the discarded ones
+    pushRows(*row_buffer, new_row_list);
+    CHECK(logger.message_count == 1U);
+
+    row_buffer->takeRows(row_list);
+    REQUIRE(row_list.size() > 600U);
+    REQUIRE(row_list.size() < 1024U);
+
+    CHECK(getIntegerColumn(row_list.front(), "sample_weight") == 1);
+    CHECK(getIntegerColumn(row_list.back(), "sample_weight") > 1);
+
+    // Full capture resumes once the queue has been drained
+    pushRows(*row_buffer, {generateRow(1)});
+    CHECK(logger.message_count == 2U);
+
+    row_buffer->takeRows(row_list);
+    REQUIRE(row_list.size() == 1U);
+    CHECK(getIntegerColumn(row_list.at(0), "sample_weight") == 1);
+  }
+
+  SECTION("Identical rows are coalesced before being queued") {
+    configuration.max_queued_row_count = 2U;
+    configuration.coalescing_window = std::chrono::seconds(60);
+
+    auto status = AuditTableRowBuffer::create(row_buffer, logger,
+                                              "test_events", configuration);
+    REQUIRE(status.succeeded());
+
+    pushRows(*row_buffer, {generateRow(1), generateRow(1), generateRow(2)});
+
+    row_buffer->takeRows(row_list);
+    CHECK(row_list.empty());
+
+    // The coalescer holds as many rows as the queue, and releases the
+    // oldest one early once it is full
+    pushRows(*row_buffer, {generateRow(3)});
+
+    row_buffer->takeRows(row_list);
+    REQUIRE(row_list.size() == 1U);
+    CHECK(getIntegerColumn(row_list.at(0), "pid") == 1);
+    CHECK(getIntegerColumn(row_list.at(0), "count") == 2);
+  }
+}
+} // namespace zeek
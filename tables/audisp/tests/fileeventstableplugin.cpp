@@ -57,13 +57,21 @@ SCENARIO("Row generation in the file_events table", "[FileEventsTablePlugin]") {
         },
 
         // Sockaddr data
-        {}
+        {},
+
+      // Parent image
+      {}
     };
     // clang-format on
 
     WHEN("generating a table row") {
+      PathNormalizer::Ref path_normalizer;
+      auto status = PathNormalizer::create(path_normalizer, 16U);
+      REQUIRE(status.succeeded());
+
       IVirtualTable::Row row;
-      auto status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent);
+      status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent,
+                                                  *path_normalizer);
 
       REQUIRE(status.succeeded());
 
@@ -132,12 +140,20 @@ SCENARIO("Row generation in the file_events table", "[FileEventsTablePlugin]") {
         },
 
         // Sockaddr data
-        {}
+        {},
+
+      // Parent image
+      {}
     };
     // clang-format on
     WHEN("generating a table row") {
+      PathNormalizer::Ref path_normalizer;
+      auto status = PathNormalizer::create(path_normalizer, 16U);
+      REQUIRE(status.succeeded());
+
       IVirtualTable::Row row;
-      auto status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent);
+      status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent,
+                                                  *path_normalizer);
 
       REQUIRE(status.succeeded());
 
@@ -207,12 +223,20 @@ SCENARIO("Row generation in the file_events table", "[FileEventsTablePlugin]") {
         },
 
         // Sockaddr data
-        {}
+        {},
+
+      // Parent image
+      {}
     };
     // clang-format on
     WHEN("generating a table row") {
+      PathNormalizer::Ref path_normalizer;
+      auto status = PathNormalizer::create(path_normalizer, 16U);
+      REQUIRE(status.succeeded());
+
       IVirtualTable::Row row;
-      auto status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent);
+      status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent,
+                                                  *path_normalizer);
 
       REQUIRE(status.succeeded());
 
@@ -289,12 +313,20 @@ SCENARIO("Row generation in the file_events table", "[FileEventsTablePlugin]") {
         },
 
         // Sockaddr data
-        {}
+        {},
+
+      // Parent image
+      {}
     };
     // clang-format on
     WHEN("generating a table row") {
+      PathNormalizer::Ref path_normalizer;
+      auto status = PathNormalizer::create(path_normalizer, 16U);
+      REQUIRE(status.succeeded());
+
       IVirtualTable::Row row;
-      auto status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent);
+      status = FileEventsTablePlugin::generateRow(row, kCreateAuditEvent,
+                                                  *path_normalizer);
 
       REQUIRE(status.succeeded());
 
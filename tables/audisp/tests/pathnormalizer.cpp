@@ -0,0 +1,84 @@
+#include "pathnormalizer.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+std::string normalizePath(const std::string &path) {
+  std::string output;
+  PathNormalizer::appendPath(output, path);
+
+  return output;
+}
+} // namespace
+
+TEST_CASE("Lexical path normalization", "[PathNormalizer]") {
+  CHECK(normalizePath("/") == "/");
+  CHECK(normalizePath("//etc///passwd") == "/etc/passwd");
+  CHECK(normalizePath("/etc/./ssh/") == "/etc/ssh");
+  CHECK(normalizePath("/usr/lib/../bin/bash") == "/usr/bin/bash");
+  CHECK(normalizePath("/usr/..") == "/");
+  CHECK(normalizePath("/../../etc") == "/etc");
+  CHECK(normalizePath("") == "");
+  CHECK(normalizePath(".") == "");
+  CHECK(normalizePath("a/./b/../c") == "a/c");
+  CHECK(normalizePath("../a/..") == "..");
+  CHECK(normalizePath("a/../../b") == "../b");
+
+  std::string output{"/home/user"};
+  PathNormalizer::appendPath(output, "../other/./file.txt");
+  CHECK(output == "/home/other/file.txt");
+}
+
+TEST_CASE("Quote removal", "[PathNormalizer]") {
+  CHECK(PathNormalizer::stripQuotes("\"/etc\"") == "/etc");
+  CHECK(PathNormalizer::stripQuotes("\"\"") == "");
+  CHECK(PathNormalizer::stripQuotes("\"") == "\"");
+  CHECK(PathNormalizer::stripQuotes("/etc") == "/etc");
+}
+
+TEST_CASE("Path resolution", "[PathNormalizer]") {
+  PathNormalizer::Ref path_normalizer;
+  auto status = PathNormalizer::create(path_normalizer, 2U);
+  REQUIRE(status.succeeded());
+
+  SECTION("Absolute paths ignore the working directory") {
+    CHECK(path_normalizer->resolve("/home/user", "/etc//hosts") ==
+          "/etc/hosts");
+
+    CHECK(path_normalizer->resolve("/root", "/etc//hosts") == "/etc/hosts");
+  }
+
+  SECTION("Relative paths are joined with the working directory") {
+    CHECK(path_normalizer->resolve("\"/home/user/\"", "\"../file.txt\"") ==
+          "/home/file.txt");
+
+    CHECK(path_normalizer->resolve("/home/user", "file.txt") ==
+          "/home/user/file.txt");
+
+    CHECK(path_normalizer->resolve("/root", "file.txt") == "/root/file.txt");
+  }
+
+  SECTION("Cached paths are returned without being rebuilt") {
+    const auto &first_path = path_normalizer->resolve("/tmp", "a");
+    const auto &second_path = path_normalizer->resolve("/tmp", "a");
+
+    CHECK(&first_path == &second_path);
+    CHECK(second_path == "/tmp/a");
+  }
+
+  SECTION("Full caches are emptied") {
+    CHECK(path_normalizer->resolve("/tmp", "a") == "/tmp/a");
+    CHECK(path_normalizer->resolve("/tmp", "b") == "/tmp/b");
+    CHECK(path_normalizer->resolve("/var", "c") == "/var/c");
+    CHECK(path_normalizer->resolve("/usr", "d") == "/usr/d");
+    CHECK(path_normalizer->resolve("/tmp", "a") == "/tmp/a");
+  }
+}
+
+TEST_CASE("Invalid cache size", "[PathNormalizer]") {
+  PathNormalizer::Ref path_normalizer;
+  auto status = PathNormalizer::create(path_normalizer, 0U);
+  CHECK(!status.succeeded());
+}
+} // namespace zeek
@@ -64,6 +64,9 @@ SCENARIO("Row generation in the process_events table",
       },
 
       // Sockaddr data
+      {},
+
+      // Parent image
       {}
     };
     // clang-format on
@@ -88,6 +91,7 @@ SCENARIO("Row generation in the process_events table",
             {"exe", kExecveAuditEvent.syscall_data.exe},
             {"exit", kExecveAuditEvent.syscall_data.exit_code},
             {"cmdline", "\"-c\" \"echo hello world!\""},
+            {"cmdline_truncated", static_cast<std::int64_t>(0)},
             {"path", "/usr/bin/bash"},
             {"mode", static_cast<std::int64_t>(0755)},
             {"ouid", static_cast<std::int64_t>(0)},
@@ -134,6 +138,9 @@ SCENARIO("Row generation in the process_events table",
       { },
 
       // Sockaddr data
+      {},
+
+      // Parent image
       {}
     };
     // clang-format on
@@ -157,6 +164,7 @@ SCENARIO("Row generation in the process_events table",
             {"exe", kForkAuditEvent.syscall_data.exe},
             {"exit", kForkAuditEvent.syscall_data.exit_code},
             {"cmdline", {""}},
+            {"cmdline_truncated", static_cast<std::int64_t>(0)},
             {"path", {""}},
             {"mode", static_cast<std::int64_t>(0)},
             {"ouid", static_cast<std::int64_t>(0)},
@@ -202,6 +210,9 @@ SCENARIO("Row generation in the process_events table",
       { },
 
       // Sockaddr data
+      {},
+
+      // Parent image
       {}
     };
     // clang-format on
@@ -226,6 +237,7 @@ SCENARIO("Row generation in the process_events table",
             {"exe", kVForkAuditEvent.syscall_data.exe},
             {"exit", kVForkAuditEvent.syscall_data.exit_code},
             {"cmdline", {""}},
+            {"cmdline_truncated", static_cast<std::int64_t>(0)},
             {"path", {""}},
             {"mode", static_cast<std::int64_t>(0)},
             {"ouid", static_cast<std::int64_t>(0)},
@@ -271,6 +283,9 @@ SCENARIO("Row generation in the process_events table",
       { },
 
       // Sockaddr data
+      {},
+
+      // Parent image
       {}
     };
     // clang-format on
@@ -295,6 +310,7 @@ SCENARIO("Row generation in the process_events table",
             {"exe", kCloneAuditEvent.syscall_data.exe},
             {"exit", kCloneAuditEvent.syscall_data.exit_code},
             {"cmdline", {""}},
+            {"cmdline_truncated", static_cast<std::int64_t>(0)},
             {"path", {""}},
             {"mode", static_cast<std::int64_t>(0)},
             {"ouid", static_cast<std::int64_t>(0)},
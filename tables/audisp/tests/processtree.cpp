@@ -0,0 +1,202 @@
+#include "processtree.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+using SyscallType = IAudispConsumer::SyscallRecordData::Type;
+
+IAudispConsumer::AuditEvent generateAuditEvent(SyscallType type,
+                                               std::int64_t process_id,
+                                               std::int64_t parent_process_id,
+                                               std::int64_t exit_code = 0) {
+  IAudispConsumer::AuditEvent audit_event;
+  audit_event.syscall_data.type = type;
+  audit_event.syscall_data.process_id = process_id;
+  audit_event.syscall_data.parent_process_id = parent_process_id;
+  audit_event.syscall_data.exit_code = exit_code;
+  audit_event.syscall_data.succeeded = true;
+  audit_event.syscall_data.uid = 1000;
+  audit_event.syscall_data.exe = "/usr/bin/bash";
+  audit_event.syscall_data.a0 = "1200011";
+
+  return audit_event;
+}
+
+IAudispConsumer::AuditEvent
+generateExecveEvent(std::int64_t process_id, std::int64_t parent_process_id,
+                    const std::string &exe,
+                    const std::vector<std::string> &argument_list) {
+
+  auto audit_event =
+      generateAuditEvent(SyscallType::Execve, process_id, parent_process_id);
+
+  audit_event.syscall_data.exe = exe;
+
+  IAudispConsumer::ExecveRecordData execve_data;
+  execve_data.argc = static_cast<int>(argument_list.size());
+  execve_data.argument_list = argument_list;
+
+  audit_event.execve_data = std::move(execve_data);
+  audit_event.cwd_data = "/home/user";
+
+  return audit_event;
+}
+
+std::string getParentExe(const IAudispConsumer::AuditEvent &audit_event) {
+  IVirtualTable::Row row;
+  ProcessTree::addParentColumns(row, audit_event);
+
+  return std::get<std::string>(row.at("parent_exe").value());
+}
+} // namespace
+
+SCENARIO("Process tracking", "[ProcessTree]") {
+  ProcessTree::Ref process_tree;
+  auto status = ProcessTree::create(process_tree, 3U);
+  REQUIRE(status.succeeded());
+
+  GIVEN("a shell that forks and executes a command") {
+    IAudispConsumer::AuditEventList event_list = {
+        generateAuditEvent(SyscallType::Clone, 100, 1, 101),
+        generateExecveEvent(101, 100, "/usr/bin/curl",
+                            {"curl", "example.com"})};
+
+    process_tree->processEvents(event_list);
+
+    THEN("both the parent and the child are tracked") {
+      ProcessTree::Process process;
+      REQUIRE(process_tree->getProcess(process, 100));
+      REQUIRE(process.parent_process_id == 1);
+      REQUIRE(process.exe == "/usr/bin/bash");
+      REQUIRE(process.cmdline.empty());
+
+      REQUIRE(process_tree->getProcess(process, 101));
+      REQUIRE(process.parent_process_id == 100);
+      REQUIRE(process.uid == 1000);
+      REQUIRE(process.exe == "/usr/bin/curl");
+      REQUIRE(process.cmdline == "\"curl\" \"example.com\"");
+      REQUIRE(process.cwd == "/home/user");
+    }
+
+    WHEN("the command forks again") {
+      event_list = {generateAuditEvent(SyscallType::Fork, 101, 100, 102),
+                    generateAuditEvent(SyscallType::Connect, 102, 101)};
+
+      process_tree->processEvents(event_list);
+
+      THEN("the child shares the image of its parent") {
+        ProcessTree::Process process;
+        REQUIRE(process_tree->getProcess(process, 102));
+        REQUIRE(process.parent_process_id == 101);
+        REQUIRE(process.exe == "/usr/bin/curl");
+        REQUIRE(process.cmdline == "\"curl\" \"example.com\"");
+
+        IVirtualTable::Row row;
+        ProcessTree::addParentColumns(row, event_list.at(1));
+
+        REQUIRE(std::get<std::string>(row.at("parent_exe").value()) ==
+                "/usr/bin/curl");
+
+        REQUIRE(std::get<std::string>(row.at("parent_cmdline").value()) ==
+                "\"curl\" \"example.com\"");
+      }
+    }
+
+    WHEN("the command exits") {
+      event_list = {generateAuditEvent(SyscallType::Exit, 101, 100)};
+      process_tree->processEvents(event_list);
+
+      THEN("it is removed") {
+        ProcessTree::Process process;
+        REQUIRE(!process_tree->getProcess(process, 101));
+        REQUIRE(process_tree->getProcess(process, 100));
+
+        // Events of its children no longer have a known parent
+        event_list = {generateAuditEvent(SyscallType::Connect, 102, 101)};
+        process_tree->processEvents(event_list);
+
+        REQUIRE(getParentExe(event_list.at(0)).empty());
+      }
+    }
+
+    WHEN("more processes than the limit are started") {
+      event_list = {generateAuditEvent(SyscallType::Fork, 100, 1, 103),
+                    generateAuditEvent(SyscallType::Fork, 100, 1, 104)};
+
+      process_tree->processEvents(event_list);
+
+      THEN("the least recently updated process is evicted") {
+        ProcessTree::ProcessList process_list;
+        process_tree->getProcessList(process_list);
+
+        REQUIRE(process_list.size() == 3U);
+        REQUIRE(process_list.at(0).process_id == 100);
+        REQUIRE(process_list.at(1).process_id == 103);
+        REQUIRE(process_list.at(2).process_id == 104);
+      }
+    }
+  }
+
+  GIVEN("events that do not create new processes") {
+    auto thread_event = generateAuditEvent(SyscallType::Clone, 100, 1, 101);
+    thread_event.syscall_data.a0 = "3d0f00";
+
+    auto failed_fork_event = generateAuditEvent(SyscallType::Fork, 100, 1, -11);
+    failed_fork_event.syscall_data.succeeded = false;
+
+    IAudispConsumer::AuditEventList event_list = {thread_event,
+                                                  failed_fork_event};
+
+    process_tree->processEvents(event_list);
+
+    THEN("nothing is tracked") {
+      ProcessTree::ProcessList process_list;
+      process_tree->getProcessList(process_list);
+
+      REQUIRE(process_list.empty());
+    }
+  }
+
+  GIVEN("a batch where the parent changes after forking") {
+    // The parent forks, the child calls execve and connects, then the
+    // parent calls execve and finally exit_group, while the child is
+    // still running
+    IAudispConsumer::AuditEventList event_list = {
+        generateExecveEvent(100, 1, "/usr/bin/bash", {"bash"}),
+        generateAuditEvent(SyscallType::Fork, 100, 1, 101),
+        generateExecveEvent(101, 100, "/usr/bin/curl",
+                            {"curl", "example.com"}),
+        generateAuditEvent(SyscallType::Connect, 101, 100),
+        generateExecveEvent(100, 1, "/usr/bin/vim", {"vim"}),
+        generateAuditEvent(SyscallType::Connect, 101, 100),
+        generateAuditEvent(SyscallType::Exit, 100, 1),
+        generateAuditEvent(SyscallType::Connect, 101, 100)};
+
+    process_tree->processEvents(event_list);
+
+    THEN("each event has the parent image it had at that point") {
+      REQUIRE(getParentExe(event_list.at(0)).empty());
+      REQUIRE(getParentExe(event_list.at(1)).empty());
+
+      REQUIRE(getParentExe(event_list.at(2)) == "/usr/bin/bash");
+      REQUIRE(getParentExe(event_list.at(3)) == "/usr/bin/bash");
+
+      IVirtualTable::Row row;
+      ProcessTree::addParentColumns(row, event_list.at(3));
+      REQUIRE(std::get<std::string>(row.at("parent_cmdline").value()) ==
+              "\"bash\"");
+
+      REQUIRE(getParentExe(event_list.at(5)) == "/usr/bin/vim");
+      REQUIRE(getParentExe(event_list.at(7)).empty());
+    }
+
+    THEN("the tree has the state after the whole batch") {
+      ProcessTree::Process process;
+      REQUIRE(!process_tree->getProcess(process, 100));
+      REQUIRE(process_tree->getProcess(process, 101));
+      REQUIRE(process.exe == "/usr/bin/curl");
+    }
+  }
+}
+} // namespace zeek
@@ -0,0 +1,60 @@
+#include "processtreetableplugin.h"
+#include "utils.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+SCENARIO("Row generation in the process_tree table",
+         "[ProcessTreeTablePlugin]") {
+
+  GIVEN("a list of tracked processes") {
+    ProcessTree::ProcessList process_list(2U);
+    process_list.at(0).process_id = 100;
+    process_list.at(0).parent_process_id = 1;
+    process_list.at(0).exe = "/usr/bin/bash";
+    process_list.at(0).time = 1572891138;
+
+    process_list.at(1).process_id = 101;
+    process_list.at(1).parent_process_id = 100;
+    process_list.at(1).uid = 1000;
+    process_list.at(1).exe = "/usr/bin/curl";
+    process_list.at(1).cmdline = "\"curl\" \"example.com\"";
+    process_list.at(1).cwd = "/home/user";
+
+    WHEN("generating the table rows") {
+      IVirtualTable::RowList row_list;
+      ProcessTreeTablePlugin::generateRowList(row_list, process_list);
+
+      THEN("one row is generated for each process") {
+        REQUIRE(row_list.size() == 2U);
+
+        // clang-format off
+        validateRow(row_list.at(0), {
+          { "pid", 100 },
+          { "ppid", 1 },
+          { "auid", 0 },
+          { "uid", 0 },
+          { "gid", 0 },
+          { "exe", "/usr/bin/bash" },
+          { "cmdline", "" },
+          { "cwd", "" },
+          { "time", 1572891138 }
+        });
+
+        validateRow(row_list.at(1), {
+          { "pid", 101 },
+          { "ppid", 100 },
+          { "auid", 0 },
+          { "uid", 1000 },
+          { "gid", 0 },
+          { "exe", "/usr/bin/curl" },
+          { "cmdline", "\"curl\" \"example.com\"" },
+          { "cwd", "/home/user" },
+          { "time", 0 }
+        });
+        // clang-format on
+      }
+    }
+  }
+}
+} // namespace zeek
@@ -0,0 +1,191 @@
+#include "rowcoalescer.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+const IVirtualTable::Schema kTestSchema = {
+    {"syscall", IVirtualTable::ColumnType::String},
+    {"pid", IVirtualTable::ColumnType::Integer},
+    {"path", IVirtualTable::ColumnType::String},
+    {"time", IVirtualTable::ColumnType::Integer},
+    {"count", IVirtualTable::ColumnType::Integer},
+    {"first_time", IVirtualTable::ColumnType::Integer},
+    {"last_time", IVirtualTable::ColumnType::Integer}};
+
+IVirtualTable::Row generateRow(std::int64_t pid, const std::string &path,
+                               std::int64_t time) {
+  IVirtualTable::Row row;
+  row["syscall"] = {"open"};
+  row["pid"] = pid;
+  row["path"] = path;
+  row["time"] = time;
+
+  RowCoalescer::initializeRow(row);
+  return row;
+}
+
+std::int64_t getIntegerColumn(const IVirtualTable::Row &row,
+                              const std::string &column_name) {
+  return std::get<std::int64_t>(row.at(column_name).value());
+}
+} // namespace
+
+TEST_CASE("Row initialization", "[RowCoalescer]") {
+  auto row = generateRow(100, "/etc/hosts", 1000);
+
+  CHECK(getIntegerColumn(row, "count") == 1);
+  CHECK(getIntegerColumn(row, "first_time") == 1000);
+  CHECK(getIntegerColumn(row, "last_time") == 1000);
+}
+
+TEST_CASE("Row coalescing", "[RowCoalescer]") {
+  RowCoalescer::Ref row_coalescer;
+  auto status =
+      RowCoalescer::create(row_coalescer, std::chrono::seconds(10), {}, 2U);
+
+  REQUIRE(status.succeeded());
+
+  IVirtualTable::RowList output;
+
+  SECTION("Identical rows are folded until the window closes") {
+    row_coalescer->processRows(output,
+                               {generateRow(100, "/etc/hosts", 1000),
+                                generateRow(100, "/etc/hosts", 1002),
+                                generateRow(100, "/etc/hosts", 1005)},
+                               1005);
+
+    CHECK(output.empty());
+    CHECK(row_coalescer->pendingRowCount() == 1U);
+
+    row_coalescer->takeExpiredRows(output, 1009);
+    CHECK(output.empty());
+
+    row_coalescer->takeExpiredRows(output, 1010);
+    REQUIRE(output.size() == 1U);
+
+    const auto &row = output.at(0);
+    CHECK(getIntegerColumn(row, "count") == 3);
+    CHECK(getIntegerColumn(row, "first_time") == 1000);
+    CHECK(getIntegerColumn(row, "last_time") == 1005);
+    CHECK(getIntegerColumn(row, "time") == 1000);
+    CHECK(row_coalescer->pendingRowCount() == 0U);
+  }
+
+  SECTION("Different rows are kept apart, oldest first") {
+    row_coalescer->processRows(output,
+                               {generateRow(100, "/etc/hosts", 1000),
+                                generateRow(101, "/etc/hosts", 1001),
+                                generateRow(100, "/etc/hosts", 1001)},
+                               1001);
+
+    CHECK(row_coalescer->pendingRowCount() == 2U);
+
+    row_coalescer->takeExpiredRows(output, 2000);
+    REQUIRE(output.size() == 2U);
+
+    CHECK(getIntegerColumn(output.at(0), "pid") == 100);
+    CHECK(getIntegerColumn(output.at(0), "count") == 2);
+    CHECK(getIntegerColumn(output.at(1), "pid") == 101);
+    CHECK(getIntegerColumn(output.at(1), "count") == 1);
+  }
+
+  SECTION("The oldest row is released early when the limit is reached") {
+    row_coalescer->processRows(output,
+                               {generateRow(100, "/etc/hosts", 1000),
+                                generateRow(101, "/etc/hosts", 1000),
+                                generateRow(102, "/etc/hosts", 1000)},
+                               1000);
+
+    REQUIRE(output.size() == 1U);
+    CHECK(getIntegerColumn(output.at(0), "pid") == 100);
+    CHECK(row_coalescer->pendingRowCount() == 2U);
+  }
+
+  SECTION("A new window is started after the previous one has closed") {
+    row_coalescer->processRows(output, {generateRow(100, "/etc/hosts", 1000)},
+                               1000);
+
+    row_coalescer->processRows(output, {generateRow(100, "/etc/hosts", 1020)},
+                               1020);
+
+    REQUIRE(output.size() == 1U);
+    CHECK(getIntegerColumn(output.at(0), "count") == 1);
+    CHECK(row_coalescer->pendingRowCount() == 1U);
+  }
+}
+
+TEST_CASE("Row coalescing with key columns", "[RowCoalescer]") {
+  RowCoalescer::Ref row_coalescer;
+  auto status = RowCoalescer::create(row_coalescer, std::chrono::seconds(10),
+                                     {"syscall", "pid"}, 16U);
+
+  REQUIRE(status.succeeded());
+
+  IVirtualTable::RowList output;
+  row_coalescer->processRows(output,
+                             {generateRow(100, "/etc/hosts", 1000),
+                              generateRow(100, "/etc/passwd", 1001),
+                              generateRow(101, "/etc/hosts", 1002)},
+                             1002);
+
+  row_coalescer->takeExpiredRows(output, 1012);
+  REQUIRE(output.size() == 2U);
+
+  CHECK(std::get<std::string>(output.at(0).at("path").value()) ==
+        "/etc/hosts");
+
+  CHECK(getIntegerColumn(output.at(0), "count") == 2);
+  CHECK(getIntegerColumn(output.at(1), "count") == 1);
+}
+
+TEST_CASE("Key column configuration", "[RowCoalescer]") {
+  RowCoalescer::KeyColumnList key_column_list;
+
+  auto status = RowCoalescer::getKeyColumnList(
+      key_column_list,
+      {"socket_events=pid,remote_address", "file_events=pid,path"},
+      "file_events", kTestSchema);
+
+  REQUIRE(status.succeeded());
+  CHECK(key_column_list == RowCoalescer::KeyColumnList{"pid", "path"});
+
+  status = RowCoalescer::getKeyColumnList(
+      key_column_list, {"socket_events=pid"}, "file_events", kTestSchema);
+
+  REQUIRE(status.succeeded());
+  CHECK(key_column_list.empty());
+
+  for (const auto &configured_key :
+       {"file_events", "file_events=", "file_events=pid,,path",
+        "file_events=inode", "file_events=time", "file_event=pid",
+        "=pid"}) {
+
+    status = RowCoalescer::getKeyColumnList(
+        key_column_list, {configured_key}, "file_events", kTestSchema);
+
+    CHECK(!status.succeeded());
+  }
+
+  // Misspelled table names are reported by every table, not only by the
+  // one that was meant
+  status = RowCoalescer::getKeyColumnList(
+      key_column_list, {"file_events=pid", "sockets_events=pid"},
+      "file_events", kTestSchema);
+
+  CHECK(!status.succeeded());
+}
+
+TEST_CASE("Invalid coalescer settings", "[RowCoalescer]") {
+  RowCoalescer::Ref row_coalescer;
+  auto status =
+      RowCoalescer::create(row_coalescer, std::chrono::seconds(0), {}, 16U);
+
+  CHECK(!status.succeeded());
+
+  status =
+      RowCoalescer::create(row_coalescer, std::chrono::seconds(10), {}, 0U);
+
+  CHECK(!status.succeeded());
+}
+} // namespace zeek
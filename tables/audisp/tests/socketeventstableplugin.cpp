@@ -40,9 +40,13 @@ SCENARIO("Row generation in the socket_events table",
         {
           2,
           443,
-          "127.0.0.1"
+          "127.0.0.1",
+          {{127, 0, 0, 1}}
         }
-      }
+      },
+
+      // Parent image
+      {}
     };
     // clang-format on
 
@@ -114,9 +118,13 @@ SCENARIO("Row generation in the socket_events table",
         {
           2,
           8080,
-          "0.0.0.0"
+          "0.0.0.0",
+          {{0, 0, 0, 0}}
         }
-      }
+      },
+
+      // Parent image
+      {}
     };
     // clang-format on
 
@@ -0,0 +1,40 @@
+#include "backoff.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+TEST_CASE("Exponential backoff", "[ExponentialBackoff]") {
+  const std::chrono::milliseconds kBaseDelay{1000};
+  const std::chrono::milliseconds kMaxDelay{8000};
+
+  ExponentialBackoff backoff(kBaseDelay, kMaxDelay, 1U);
+
+  SECTION("Delays grow exponentially, with jitter, up to the cap") {
+    std::chrono::milliseconds expected_step = kBaseDelay;
+
+    for (std::uint32_t i = 0U; i < 10U; ++i) {
+      auto delay = backoff.nextDelay();
+
+      CHECK(delay >= expected_step / 2);
+      CHECK(delay <= expected_step);
+
+      expected_step = std::min(expected_step * 2, kMaxDelay);
+    }
+
+    CHECK(backoff.attemptCount() == 10U);
+  }
+
+  SECTION("Resetting restarts from the base delay") {
+    for (std::uint32_t i = 0U; i < 10U; ++i) {
+      backoff.nextDelay();
+    }
+
+    backoff.reset();
+    CHECK(backoff.attemptCount() == 0U);
+
+    auto delay = backoff.nextDelay();
+    CHECK(delay >= kBaseDelay / 2);
+    CHECK(delay <= kBaseDelay);
+  }
+}
+} // namespace zeek
@@ -0,0 +1,126 @@
+#include "differentialstore.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+namespace {
+bool compareRows(const IVirtualDatabase::OutputRow &row1,
+                 const IVirtualDatabase::OutputRow &row2) {
+  if (row1.size() != row2.size()) {
+    return false;
+  }
+
+  for (std::size_t i = 0U; i < row1.size(); ++i) {
+    if (row1.at(i).name != row2.at(i).name ||
+        row1.at(i).data != row2.at(i).data) {
+      return false;
+    }
+  }
+
+  return true;
+}
+} // namespace
+
+TEST_CASE("Differential state serialization", "[DifferentialStore]") {
+  DifferentialStore::Entry entry;
+  entry.task.type = QueryScheduler::Task::Type::AddScheduledQuery;
+  entry.task.query = "SELECT * FROM processes";
+  entry.task.response_event = "ZeekAgent::process_event";
+  entry.task.response_topic = "/zeek/test";
+  entry.task.cookie = "cookie";
+  entry.task.interval = 10U;
+  entry.task.update_type = QueryScheduler::Task::UpdateType::Both;
+  entry.task.key_column_list = {"pid", "name"};
+
+  // clang-format off
+  ZeekConnection::DifferentialData differential_data = {
+    {
+      2U,
+
+      {
+        { "pid", std::int64_t{1} },
+        { "name", std::string("init") },
+        { "cpu", 0.5 },
+        { "parent", std::nullopt }
+      }
+    },
+
+    {
+      1U,
+
+      {
+        { "pid", std::int64_t{-2} },
+        { "name", std::string("") },
+        { "cpu", 100.0 },
+        { "parent", std::int64_t{1} }
+      }
+    }
+  };
+  // clang-format on
+
+  entry.differential_data =
+      std::make_shared<const ZeekConnection::DifferentialData>(
+          differential_data);
+
+  DifferentialStore::EntryList entry_list = {entry};
+
+  std::string buffer;
+  auto status = DifferentialStore::serialize(buffer, entry_list);
+  REQUIRE(status.succeeded());
+
+  SECTION("Serialized entries can be restored") {
+    DifferentialStore::EntryList restored_entry_list;
+    status = DifferentialStore::deserialize(restored_entry_list, buffer);
+    REQUIRE(status.succeeded());
+
+    REQUIRE(restored_entry_list.size() == 1U);
+    const auto &restored_entry = restored_entry_list.at(0U);
+
+    CHECK(restored_entry.task.type == entry.task.type);
+    CHECK(restored_entry.task.query == entry.task.query);
+    CHECK(restored_entry.task.response_event == entry.task.response_event);
+    CHECK(restored_entry.task.response_topic == entry.task.response_topic);
+    CHECK(restored_entry.task.cookie == entry.task.cookie);
+    CHECK(restored_entry.task.interval == entry.task.interval);
+    CHECK(restored_entry.task.update_type == entry.task.update_type);
+    CHECK(restored_entry.task.key_column_list == entry.task.key_column_list);
+
+    REQUIRE(restored_entry.differential_data != nullptr);
+
+    const auto &restored_differential_data = *restored_entry.differential_data;
+    REQUIRE(restored_differential_data.size() == 2U);
+
+    for (const auto &differential_data_p : differential_data) {
+      auto row_it = restored_differential_data.find(differential_data_p.first);
+
+      REQUIRE(row_it != restored_differential_data.end());
+      CHECK(compareRows(row_it->second, differential_data_p.second));
+    }
+  }
+
+  SECTION("Truncated or damaged buffers are rejected") {
+    DifferentialStore::EntryList restored_entry_list;
+
+    auto truncated_buffer = buffer.substr(0U, buffer.size() - 1U);
+    status =
+        DifferentialStore::deserialize(restored_entry_list, truncated_buffer);
+
+    CHECK(!status.succeeded());
+    CHECK(restored_entry_list.empty());
+
+    auto damaged_buffer = buffer;
+    damaged_buffer[0] = 'X';
+
+    status =
+        DifferentialStore::deserialize(restored_entry_list, damaged_buffer);
+    CHECK(!status.succeeded());
+  }
+
+  SECTION("One-shot queries can not be persisted") {
+    entry_list.at(0U).task.type = QueryScheduler::Task::Type::ExecuteQuery;
+
+    status = DifferentialStore::serialize(buffer, entry_list);
+    CHECK(!status.succeeded());
+  }
+}
+} // namespace zeek
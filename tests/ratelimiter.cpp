@@ -0,0 +1,126 @@
+#include "ratelimiter.h"
+
+#include <catch2/catch.hpp>
+
+namespace zeek {
+TEST_CASE("Token buckets", "[RateLimiter]") {
+  auto now = std::chrono::steady_clock::now();
+
+  SECTION("A zero rate disables the limit") {
+    TokenBucket bucket;
+
+    for (std::size_t i = 0U; i < 1000U; ++i) {
+      REQUIRE(bucket.available(1000U, now));
+      bucket.consume(1000U);
+    }
+  }
+
+  SECTION("Tokens are refilled over time, up to the capacity") {
+    TokenBucket bucket(10U);
+
+    for (std::size_t i = 0U; i < 10U; ++i) {
+      REQUIRE(bucket.available(1U, now));
+      bucket.consume(1U);
+    }
+
+    CHECK(!bucket.available(1U, now));
+
+    now += std::chrono::milliseconds(500);
+    CHECK(bucket.available(5U, now));
+    CHECK(!bucket.available(6U, now));
+
+    now += std::chrono::seconds(10);
+    CHECK(bucket.available(10U, now));
+  }
+
+  SECTION("Requests larger than the capacity are accepted by a full bucket") {
+    TokenBucket bucket(10U);
+
+    REQUIRE(bucket.available(100U, now));
+    bucket.consume(100U);
+
+    now += std::chrono::seconds(1);
+    CHECK(!bucket.available(1U, now));
+
+    now += std::chrono::seconds(9);
+    CHECK(bucket.available(1U, now));
+  }
+}
+
+TEST_CASE("Rate limiter", "[RateLimiter]") {
+  auto now = std::chrono::steady_clock::now();
+
+  RateLimiter::Configuration configuration;
+  configuration.max_rows_per_second = 20U;
+  configuration.max_topic_rows_per_second = 10U;
+  configuration.max_topic_bytes_per_second = 1000U;
+
+  RateLimiter rate_limiter(configuration);
+
+  SECTION("Each topic has its own limits") {
+    for (std::size_t i = 0U; i < 10U; ++i) {
+      REQUIRE(rate_limiter.acquire("/topic/1", "query_1", 1U, now));
+      REQUIRE(rate_limiter.acquire("/topic/2", "query_2", 1U, now));
+    }
+
+    CHECK(!rate_limiter.acquire("/topic/1", "query_1", 1U, now));
+    CHECK(!rate_limiter.acquire("/topic/2", "query_2", 1U, now));
+
+    auto drop_counter_map = rate_limiter.takeDropCounters();
+    REQUIRE(drop_counter_map.size() == 2U);
+    CHECK(drop_counter_map.at("query_1").response_topic == "/topic/1");
+    CHECK(drop_counter_map.at("query_1").row_count == 1U);
+    CHECK(drop_counter_map.at("query_1").byte_count == 1U);
+
+    CHECK(rate_limiter.takeDropCounters().empty());
+  }
+
+  SECTION("Drops are counted per query") {
+    for (std::size_t i = 0U; i < 10U; ++i) {
+      REQUIRE(rate_limiter.acquire("/topic/1", "query_1", 1U, now));
+    }
+
+    CHECK(!rate_limiter.acquire("/topic/1", "query_1", 1U, now));
+    CHECK(!rate_limiter.acquire("/topic/1", "query_2", 1U, now));
+    CHECK(!rate_limiter.acquire("/topic/1", "query_2", 1U, now));
+
+    auto drop_counter_map = rate_limiter.takeDropCounters();
+    REQUIRE(drop_counter_map.size() == 2U);
+    CHECK(drop_counter_map.at("query_1").row_count == 1U);
+    CHECK(drop_counter_map.at("query_2").row_count == 2U);
+    CHECK(drop_counter_map.at("query_2").response_topic == "/topic/1");
+  }
+
+  SECTION("Deferred rows are not counted as dropped") {
+    for (std::size_t i = 0U; i < 10U; ++i) {
+      REQUIRE(rate_limiter.tryAcquire("/topic/1", 1U, now));
+    }
+
+    CHECK(!rate_limiter.tryAcquire("/topic/1", 1U, now));
+    CHECK(rate_limiter.takeDropCounters().empty());
+
+    // Both kinds of requests share the same buckets
+    CHECK(!rate_limiter.acquire("/topic/1", "query_1", 1U, now));
+    CHECK(rate_limiter.takeDropCounters().size() == 1U);
+  }
+
+  SECTION("The global limit is shared by all topics") {
+    for (std::size_t i = 0U; i < 20U; ++i) {
+      auto topic = "/topic/" + std::to_string(i);
+      REQUIRE(rate_limiter.acquire(topic, topic, 1U, now));
+    }
+
+    CHECK(!rate_limiter.acquire("/topic/new", "query_new", 1U, now));
+  }
+
+  SECTION("Rejected rows do not consume the tokens of the other limits") {
+    REQUIRE(rate_limiter.acquire("/topic/1", "query_1", 1000U, now));
+    CHECK(!rate_limiter.acquire("/topic/1", "query_1", 1000U, now));
+
+    for (std::size_t i = 0U; i < 19U; ++i) {
+      auto topic = "/topic/" + std::to_string(i + 2U);
+      REQUIRE(rate_limiter.acquire(topic, topic, 1U, now));
+    }
+  }
+}
+} // namespace zeek
@@ -134,4 +134,503 @@ TEST_CASE("Query differentials", "[ZeekConnection]") {
   REQUIRE(diff_output.added_row_list.size() == 1U);
   REQUIRE(diff_output.removed_row_list.size() == 2U);
 }
+
+TEST_CASE("Keyed query differentials", "[ZeekConnection]") {
+  // clang-format off
+  static const IVirtualDatabase::QueryOutput kQueryOutput01 = {
+    {
+      { "pid", std::int64_t{1} },
+      { "name", "init" },
+      { "user_time", std::int64_t{100} }
+    },
+
+    {
+      { "pid", std::int64_t{2} },
+      { "name", "kthreadd" },
+      { "user_time", std::int64_t{200} }
+    }
+  };
+  // clang-format on
+
+  // clang-format off
+  static const IVirtualDatabase::QueryOutput kQueryOutput02 = {
+    // Row 1 (updated)
+    {
+      { "pid", std::int64_t{1} },
+      { "name", "init" },
+      { "user_time", std::int64_t{150} }
+    },
+
+    // Row 2 (ignored)
+    {
+      { "pid", std::int64_t{2} },
+      { "name", "kthreadd" },
+      { "user_time", std::int64_t{200} }
+    },
+
+    // Row 3 (added)
+    {
+      { "pid", std::int64_t{3} },
+      { "name", "bash" },
+      { "user_time", std::int64_t{0} }
+    }
+  };
+  // clang-format on
+
+  ZeekConnection::DifferentialContext diff_context;
+
+  QueryScheduler::TaskOutput task_output;
+  task_output.response_topic = "DummyResponseTopic";
+  task_output.response_event = "DummyResponseEvent";
+  task_output.cookie = "DummyCookie";
+  task_output.update_type = QueryScheduler::Task::UpdateType::Both;
+  task_output.key_column_list = {"pid"};
+
+  ZeekConnection::DifferentialOutput diff_output;
+
+  task_output.query_output = kQueryOutput01;
+  auto status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                     task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.added_row_list.size() == 2U);
+  REQUIRE(diff_output.removed_row_list.empty());
+  REQUIRE(diff_output.updated_row_list.empty());
+
+  // The changed row is reported as an update, carrying the key and the
+  // changed column only
+  task_output.query_output = kQueryOutput02;
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.added_row_list.size() == 1U);
+  REQUIRE(diff_output.removed_row_list.empty());
+  REQUIRE(diff_output.updated_row_list.size() == 1U);
+
+  const auto &updated_row = diff_output.updated_row_list.at(0U);
+  REQUIRE(updated_row.size() == 3U);
+
+  REQUIRE(updated_row.at(0U).data.has_value());
+  CHECK(std::get<std::int64_t>(updated_row.at(0U).data.value()) == 1);
+
+  CHECK(!updated_row.at(1U).data.has_value());
+
+  REQUIRE(updated_row.at(2U).data.has_value());
+  CHECK(std::get<std::int64_t>(updated_row.at(2U).data.value()) == 150);
+
+  // A column that becomes NULL can not be told apart from the unchanged
+  // ones, so the whole row is removed and added again
+  task_output.query_output = kQueryOutput02;
+  task_output.query_output.at(0U).at(1U).data = std::nullopt;
+
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.updated_row_list.empty());
+  REQUIRE(diff_output.added_row_list.size() == 1U);
+  REQUIRE(diff_output.removed_row_list.size() == 1U);
+
+  CHECK(!diff_output.added_row_list.at(0U).at(1U).data.has_value());
+
+  REQUIRE(diff_output.removed_row_list.at(0U).at(1U).data.has_value());
+  CHECK(std::get<std::string>(
+            diff_output.removed_row_list.at(0U).at(1U).data.value()) ==
+        "init");
+
+  // A column that stops being NULL is a regular update
+  task_output.update_type = QueryScheduler::Task::UpdateType::Added;
+  task_output.query_output = kQueryOutput02;
+
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.updated_row_list.size() == 1U);
+  REQUIRE(diff_output.added_row_list.empty());
+  REQUIRE(diff_output.removed_row_list.empty());
+
+  // Subscriptions that only track added rows just get the new row
+
+  task_output.query_output.at(0U).at(1U).data = std::nullopt;
+
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.updated_row_list.empty());
+  REQUIRE(diff_output.added_row_list.size() == 1U);
+  REQUIRE(diff_output.removed_row_list.empty());
+
+  task_output.update_type = QueryScheduler::Task::UpdateType::Both;
+
+  // Rows sharing the same key can not be tracked
+  task_output.query_output = kQueryOutput01;
+  task_output.query_output.push_back(kQueryOutput01.at(0U));
+
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(!status.succeeded());
+
+  // Key columns must be part of the query output
+  task_output.query_output = kQueryOutput01;
+  task_output.key_column_list = {"ppid"};
+
+  status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                task_output);
+
+  REQUIRE(!status.succeeded());
+}
+
+TEST_CASE("Session resumption", "[ZeekConnection]") {
+  // clang-format off
+  static const IVirtualDatabase::QueryOutput kQueryOutput01 = {
+    {
+      { "pid", std::int64_t{1} },
+      { "name", "init" }
+    },
+
+    {
+      { "pid", std::int64_t{2} },
+      { "name", "kthreadd" }
+    }
+  };
+  // clang-format on
+
+  QueryScheduler::Task task;
+  task.type = QueryScheduler::Task::Type::AddScheduledQuery;
+  task.query = "SELECT pid, name FROM processes;";
+  task.response_topic = "DummyResponseTopic";
+  task.response_event = "DummyResponseEvent";
+  task.cookie = "DummyCookie";
+  task.interval = 10U;
+  task.update_type = QueryScheduler::Task::UpdateType::Both;
+
+  QueryScheduler::TaskOutput task_output;
+  task_output.response_topic = task.response_topic;
+  task_output.response_event = task.response_event;
+  task_output.cookie = task.cookie;
+  task_output.update_type = task.update_type;
+  task_output.query_output = kQueryOutput01;
+
+  ZeekConnection::SessionContext session_context;
+  QueryScheduler::TaskQueue task_queue;
+
+  auto resumed = ZeekConnection::reconcileScheduledTask(session_context,
+                                                        task_queue, task);
+
+  REQUIRE(!resumed);
+  REQUIRE(task_queue.size() == 1U);
+  REQUIRE(session_context.active_subscription_map.size() == 1U);
+
+  // The same subscription sent by a different server is ignored
+  ZeekConnection::reconcileScheduledTask(session_context, task_queue, task);
+  REQUIRE(task_queue.size() == 1U);
+
+  task_queue.clear();
+
+  ZeekConnection::DifferentialOutput diff_output;
+  auto status = ZeekConnection::computeSubscriptionDifferentials(
+      session_context, diff_output, task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.added_row_list.size() == 2U);
+
+  // The connection is lost; the output produced in the meantime is
+  // discarded without touching the differential state
+  ZeekConnection::suspendSubscriptions(session_context);
+  REQUIRE(session_context.active_subscription_map.empty());
+  REQUIRE(session_context.resuming_subscription_map.size() == 1U);
+
+  task_output.query_output = {kQueryOutput01.at(0U)};
+
+  status = ZeekConnection::computeSubscriptionDifferentials(
+      session_context, diff_output, task_output);
+
+  REQUIRE(status.succeeded());
+  REQUIRE(diff_output.added_row_list.empty());
+  REQUIRE(diff_output.removed_row_list.empty());
+  REQUIRE(session_context.differential_context.size() == 1U);
+  REQUIRE(session_context.differential_context.begin()->second->size() == 2U);
+
+  SECTION("A subscription renewed in time is resumed") {
+    resumed = ZeekConnection::reconcileScheduledTask(session_context,
+                                                     task_queue, task);
+
+    REQUIRE(resumed);
+
+    REQUIRE(task_queue.empty());
+    REQUIRE(session_context.active_subscription_map.size() == 1U);
+    REQUIRE(session_context.resuming_subscription_map.empty());
+
+    // Only what has changed while disconnected is sent
+    status = ZeekConnection::computeSubscriptionDifferentials(
+        session_context, diff_output, task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.empty());
+    REQUIRE(diff_output.removed_row_list.size() == 1U);
+  }
+
+  SECTION("A changed subscription starts from a clean state") {
+    auto changed_task = task;
+    changed_task.interval = 20U;
+
+    ZeekConnection::reconcileScheduledTask(session_context, task_queue,
+                                           changed_task);
+
+    REQUIRE(task_queue.size() == 2U);
+    CHECK(task_queue.at(0U).type ==
+          QueryScheduler::Task::Type::RemoveScheduledQuery);
+
+    CHECK(task_queue.at(1U).type ==
+          QueryScheduler::Task::Type::AddScheduledQuery);
+
+    CHECK(task_queue.at(1U).interval == 20U);
+    REQUIRE(session_context.differential_context.empty());
+
+    status = ZeekConnection::computeSubscriptionDifferentials(
+        session_context, diff_output, task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    REQUIRE(diff_output.removed_row_list.empty());
+  }
+
+  SECTION("A subscription that is not renewed in time is removed") {
+    auto expired_count = ZeekConnection::expireSuspendedSubscriptions(
+        session_context, task_queue);
+
+    REQUIRE(expired_count == 1U);
+    REQUIRE(task_queue.size() == 1U);
+    CHECK(task_queue.at(0U).type ==
+          QueryScheduler::Task::Type::RemoveScheduledQuery);
+
+    REQUIRE(session_context.resuming_subscription_map.empty());
+    REQUIRE(session_context.differential_context.empty());
+
+    // Subscribing again schedules the query from scratch, and the full
+    // results are sent
+    task_queue.clear();
+    ZeekConnection::reconcileScheduledTask(session_context, task_queue, task);
+
+    REQUIRE(task_queue.size() == 1U);
+    CHECK(task_queue.at(0U).type ==
+          QueryScheduler::Task::Type::AddScheduledQuery);
+
+    status = ZeekConnection::computeSubscriptionDifferentials(
+        session_context, diff_output, task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+  }
+
+  SECTION("A removed subscription produces no output") {
+    auto removal_task = task;
+    removal_task.type = QueryScheduler::Task::Type::RemoveScheduledQuery;
+
+    ZeekConnection::reconcileScheduledTask(session_context, task_queue,
+                                           removal_task);
+
+    REQUIRE(task_queue.size() == 1U);
+    REQUIRE(session_context.resuming_subscription_map.empty());
+    REQUIRE(session_context.differential_context.empty());
+
+    status = ZeekConnection::computeSubscriptionDifferentials(
+        session_context, diff_output, task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.empty());
+    REQUIRE(session_context.differential_context.empty());
+  }
+}
+
+TEST_CASE("Differentials with dropped rows", "[ZeekConnection]") {
+  // clang-format off
+  static const IVirtualDatabase::QueryOutput kQueryOutput01 = {
+    {
+      { "pid", std::int64_t{1} },
+      { "user_time", std::int64_t{100} }
+    },
+
+    {
+      { "pid", std::int64_t{2} },
+      { "user_time", std::int64_t{200} }
+    }
+  };
+  // clang-format on
+
+  auto getPid = [](const IVirtualDatabase::OutputRow &row) -> std::int64_t {
+    return std::get<std::int64_t>(row.at(0U).data.value());
+  };
+
+  // Drops every row of the given process
+  auto dropPid = [&getPid](std::int64_t pid) -> ZeekConnection::RowFilter {
+    return [pid, &getPid](const IVirtualDatabase::OutputRow &row) -> bool {
+      return getPid(row) != pid;
+    };
+  };
+
+  ZeekConnection::DifferentialContext diff_context;
+  ZeekConnection::DifferentialOutput diff_output;
+
+  QueryScheduler::TaskOutput task_output;
+  task_output.response_topic = "DummyResponseTopic";
+  task_output.response_event = "DummyResponseEvent";
+  task_output.cookie = "DummyCookie";
+  task_output.update_type = QueryScheduler::Task::UpdateType::Both;
+
+  SECTION("Whole-row differentials") {
+    // The dropped row is added on the next run
+    task_output.query_output = kQueryOutput01;
+
+    auto status = ZeekConnection::computeDifferentials(
+        diff_context, diff_output, task_output, dropPid(2));
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    CHECK(getPid(diff_output.added_row_list.at(0U)) == 1);
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    CHECK(getPid(diff_output.added_row_list.at(0U)) == 2);
+
+    // Both rows change; the dropped addition and the dropped removal are
+    // both sent again on the next run
+    task_output.query_output.at(0U).at(1U).data = std::int64_t{150};
+    task_output.query_output.at(1U).at(1U).data = std::int64_t{250};
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output, dropPid(2));
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    REQUIRE(diff_output.removed_row_list.size() == 1U);
+    CHECK(getPid(diff_output.added_row_list.at(0U)) == 1);
+    CHECK(getPid(diff_output.removed_row_list.at(0U)) == 1);
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    REQUIRE(diff_output.removed_row_list.size() == 1U);
+    CHECK(getPid(diff_output.added_row_list.at(0U)) == 2);
+    CHECK(getPid(diff_output.removed_row_list.at(0U)) == 2);
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.empty());
+    REQUIRE(diff_output.removed_row_list.empty());
+  }
+
+  SECTION("Keyed differentials") {
+    task_output.key_column_list = {"pid"};
+    task_output.query_output = kQueryOutput01;
+
+    auto status = ZeekConnection::computeDifferentials(
+        diff_context, diff_output, task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.added_row_list.size() == 2U);
+
+    // The dropped update is sent on the next run, with the values that
+    // have changed since the last update that was published
+    task_output.query_output.at(0U).at(1U).data = std::int64_t{150};
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output, dropPid(1));
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.updated_row_list.empty());
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.updated_row_list.size() == 1U);
+    CHECK(getPid(diff_output.updated_row_list.at(0U)) == 1);
+
+    // The dropped removal is sent on the next run
+    task_output.query_output.pop_back();
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output, dropPid(2));
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.removed_row_list.empty());
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.removed_row_list.size() == 1U);
+    CHECK(getPid(diff_output.removed_row_list.at(0U)) == 2);
+
+    // A replaced row whose addition is dropped is added on the next run
+    task_output.query_output.at(0U).at(1U).data = std::nullopt;
+
+    auto drop_count = 0U;
+    status = ZeekConnection::computeDifferentials(
+        diff_context, diff_output, task_output,
+        [&drop_count](const IVirtualDatabase::OutputRow &row) -> bool {
+          if (row.at(1U).data.has_value()) {
+            return true;
+          }
+
+          ++drop_count;
+          return false;
+        });
+
+    REQUIRE(status.succeeded());
+    REQUIRE(drop_count == 1U);
+    REQUIRE(diff_output.removed_row_list.size() == 1U);
+    REQUIRE(diff_output.added_row_list.empty());
+
+    status = ZeekConnection::computeDifferentials(diff_context, diff_output,
+                                                  task_output);
+
+    REQUIRE(status.succeeded());
+    REQUIRE(diff_output.removed_row_list.empty());
+    REQUIRE(diff_output.added_row_list.size() == 1U);
+    REQUIRE(diff_output.updated_row_list.empty());
+  }
+}
+TEST_CASE("One-shot query deduplication", "[ZeekConnection]") {
+  ZeekConnection::SessionContext session_context;
+
+  QueryScheduler::Task task;
+  task.type = QueryScheduler::Task::Type::ExecuteQuery;
+  task.query = "SELECT * FROM processes";
+  task.response_topic = "DummyResponseTopic";
+  task.response_event = "DummyResponseEvent";
+  task.cookie = "DummyCookie";
+
+  auto now = std::chrono::steady_clock::now();
+
+  REQUIRE(ZeekConnection::acceptOneShotTask(session_context, task, now));
+
+  // The same query sent by another server is ignored
+  CHECK(!ZeekConnection::acceptOneShotTask(session_context, task,
+                                           now + std::chrono::seconds(1)));
+
+  // A different cookie identifies a different request
+  auto other_task = task;
+  other_task.cookie = "OtherDummyCookie";
+
+  CHECK(ZeekConnection::acceptOneShotTask(session_context, other_task, now));
+
+  // Once the window has elapsed, the query is executed again
+  CHECK(ZeekConnection::acceptOneShotTask(session_context, task,
+                                          now + std::chrono::seconds(60)));
+
+  CHECK(session_context.recent_one_shot_query_map.size() == 1U);
+}
 } // namespace zeek